@@ -3,58 +3,196 @@
 #include <BRepPrimAPI_MakeBox.hxx>
 #include <BRepPrimAPI_MakeCylinder.hxx>
 #include <BRepAlgoAPI_Fuse.hxx>
+#include <BRepBndLib.hxx>
+#include <Bnd_Box.hxx>
+#include <BRep_Builder.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopTools_ListOfShape.hxx>
 #include <BRepBuilderAPI_MakeFace.hxx>
 #include <BRepPrimAPI_MakePrism.hxx>
 #include <TopExp_Explorer.hxx>
 #include <TopAbs_ShapeEnum.hxx>
 #include <gp_Vec.hxx>
+#include <Message_ProgressScope.hxx>
+
+#include <Trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
 
 namespace KernelAPI
 {
+namespace
+{
+thread_local ThreadStats t_stats;
+thread_local int         t_depth = 0;
+
+// Times the outermost KernelAPI call of the current thread
+class CallTimer
+{
+public:
+  CallTimer()
+  {
+    if (t_depth++ == 0) m_start = std::chrono::steady_clock::now();
+  }
+  ~CallTimer()
+  {
+    if (--t_depth != 0) return;
+    t_stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    ++t_stats.calls;
+  }
+  CallTimer(const CallTimer&) = delete;
+  CallTimer& operator=(const CallTimer&) = delete;
+
+private:
+  std::chrono::steady_clock::time_point m_start;
+};
+} // namespace
+
+ThreadStats threadStats()
+{
+  return t_stats;
+}
+
 // Box: OCCT builder returns a closed solid with 6 planar faces
 TopoDS_Shape makeBox(double dx, double dy, double dz)
 {
+  CallTimer timer;
+  CAD_TRACE_SCOPE("kernel", "KernelAPI::makeBox");
   return BRepPrimAPI_MakeBox(dx, dy, dz).Shape();
 }
 
 // Cylinder: oriented along +Z (two caps + lateral cylindrical face)
 TopoDS_Shape makeCylinder(double radius, double height)
 {
+  CallTimer timer;
+  CAD_TRACE_SCOPE("kernel", "KernelAPI::makeCylinder");
   return BRepPrimAPI_MakeCylinder(radius, height).Shape();
 }
 
 // Fuse: unified solid (may produce shells if inputs are not solids)
 TopoDS_Shape fuse(const TopoDS_Shape& a, const TopoDS_Shape& b)
 {
+  CallTimer timer;
+  CAD_TRACE_SCOPE("kernel", "KernelAPI::fuse");
   return BRepAlgoAPI_Fuse(a, b).Shape();
 }
 
+// N-ary fuse: first shape is the argument, the rest are tools of the same builder
+TopoDS_Shape fuse(const std::vector<TopoDS_Shape>& shapes, const Message_ProgressRange& theRange)
+{
+  CallTimer timer;
+  CAD_TRACE_SCOPE("kernel", "KernelAPI::fuse");
+  if (shapes.empty()) return TopoDS_Shape();
+  if (shapes.size() == 1) return shapes.front();
+
+  TopTools_ListOfShape args, tools;
+  args.Append(shapes.front());
+  for (std::size_t i = 1; i < shapes.size(); ++i) tools.Append(shapes[i]);
+
+  BRepAlgoAPI_Fuse op;
+  op.SetArguments(args);
+  op.SetTools(tools);
+  op.SetRunParallel(true);
+  op.Build(theRange);
+  if (theRange.UserBreak()) return TopoDS_Shape();
+  return op.IsDone() ? op.Shape() : TopoDS_Shape();
+}
+
+TopoDS_Shape fuseClustered(const std::vector<TopoDS_Shape>& shapes, const Message_ProgressRange& theRange)
+{
+  CallTimer timer;
+  CAD_TRACE_SCOPE("kernel", "KernelAPI::fuseClustered");
+  const std::size_t n = shapes.size();
+  if (n <= 1) return n == 0 ? TopoDS_Shape() : shapes.front();
+
+  std::vector<Bnd_Box> boxes(n);
+  std::vector<double>  xmin(n), xmax(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    BRepBndLib::Add(shapes[i], boxes[i]);
+    Standard_Real y0 = 0, z0 = 0, y1 = 0, z1 = 0;
+    boxes[i].Get(xmin[i], y0, z0, xmax[i], y1, z1);
+  }
+
+  // Union-find over shapes whose boxes overlap (sweep along X to skip far-apart pairs)
+  std::vector<std::size_t> parent(n);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&](std::size_t i) {
+    while (parent[i] != i) { parent[i] = parent[parent[i]]; i = parent[i]; }
+    return i;
+  };
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return xmin[a] < xmin[b]; });
+  std::vector<std::size_t> active;
+  for (std::size_t i : order)
+  {
+    active.erase(std::remove_if(active.begin(), active.end(), [&](std::size_t a) { return xmax[a] < xmin[i]; }),
+                 active.end());
+    for (std::size_t a : active)
+    {
+      if (!boxes[a].IsOut(boxes[i]))
+      {
+        const std::size_t ra = find(a), ri = find(i);
+        if (ra != ri) parent[std::max(ra, ri)] = std::min(ra, ri);
+      }
+    }
+    active.push_back(i);
+  }
+
+  // Gather clusters in order of their first member; members stay in input order
+  std::vector<std::vector<TopoDS_Shape>> clusters;
+  std::vector<int> clusterOfRoot(n, -1);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const std::size_t r = find(i);
+    if (clusterOfRoot[r] < 0)
+    {
+      clusterOfRoot[r] = static_cast<int>(clusters.size());
+      clusters.emplace_back();
+    }
+    clusters[static_cast<std::size_t>(clusterOfRoot[r])].push_back(shapes[i]);
+  }
+  if (clusters.size() == 1) return fuse(clusters.front(), theRange);
+
+  Message_ProgressScope scope(theRange, "Fuse clusters", static_cast<double>(clusters.size()));
+  BRep_Builder    builder;
+  TopoDS_Compound result;
+  builder.MakeCompound(result);
+  for (const auto& c : clusters)
+  {
+    const TopoDS_Shape part = fuse(c, scope.Next());
+    if (scope.UserBreak()) return TopoDS_Shape();
+    if (!part.IsNull()) builder.Add(result, part);
+  }
+  return result;
+}
+
 // Extrude a set of wires along +Z by a given distance
-TopoDS_Shape extrude(const std::vector<TopoDS_Wire>& wires, double distance)
+TopoDS_Shape extrude(const std::vector<TopoDS_Wire>& wires, double distance, const Message_ProgressRange& theRange)
 {
+  CallTimer timer;
+  CAD_TRACE_SCOPE("kernel", "KernelAPI::extrude");
   if (wires.empty() || distance == 0.0)
   {
     return TopoDS_Shape();
   }
 
-  TopoDS_Shape result;
+  std::vector<TopoDS_Shape> prisms;
+  prisms.reserve(wires.size());
   const gp_Vec dir(0.0, 0.0, distance);
 
   for (const TopoDS_Wire& w : wires)
   {
+    if (theRange.UserBreak()) return TopoDS_Shape();
     if (w.IsNull()) { continue; }
     TopoDS_Face face = BRepBuilderAPI_MakeFace(w);
     if (face.IsNull()) { continue; }
-    TopoDS_Shape prism = BRepPrimAPI_MakePrism(face, dir).Shape();
-    if (result.IsNull())
-    {
-      result = prism;
-    }
-    else
-    {
-      result = BRepAlgoAPI_Fuse(result, prism).Shape();
-    }
+    prisms.push_back(BRepPrimAPI_MakePrism(face, dir).Shape());
   }
-  return result;
+  // The fuse dominates; it reports to the caller's range directly
+  return fuseClustered(prisms, theRange);
 }
 }
@@ -1,10 +1,14 @@
 // Minimal kernel API: thin wrappers over OCCT BRepPrimAPI/BRepAlgoAPI (no Qt deps)
 #pragma once
 
+#include <Message_ProgressRange.hxx>
 #include <TopoDS_Shape.hxx>
 #include <TopoDS_Wire.hxx>
+#include <cstddef>
 #include <vector>
 
+// Long operations take an optional Message_ProgressRange: when its indicator reports UserBreak(),
+// they stop early and return a null shape (cooperative cancellation of background recomputes).
 namespace KernelAPI
 {
   // Create a box primitive with edges aligned to XYZ axes
@@ -15,8 +19,28 @@ namespace KernelAPI
   // Boolean fuse (union) of two shapes; returns the combined solid
   TopoDS_Shape fuse(const TopoDS_Shape& a, const TopoDS_Shape& b);
 
+  // N-ary boolean fuse: all shapes go to a single builder running in OCCT parallel mode
+  TopoDS_Shape fuse(const std::vector<TopoDS_Shape>& shapes,
+                    const Message_ProgressRange& theRange = Message_ProgressRange());
+
+  // Fuse after splitting the inputs into clusters of overlapping bounding boxes
+  // - Disjoint clusters are never intersected; each overlapping cluster uses one n-ary fuse
+  // - Several clusters are returned as a compound in order of their first input
+  TopoDS_Shape fuseClustered(const std::vector<TopoDS_Shape>& shapes,
+                             const Message_ProgressRange& theRange = Message_ProgressRange());
+
   // Linear extrusion (prism) of one or more planar profile wires along +Z by a distance
-  // - Each wire is treated independently and the resulting prisms are fused
+  // - Each wire is treated independently and the resulting prisms are fused (see fuseClustered)
   // - Input wires are assumed to lie in the XY plane (Z=0)
-  TopoDS_Shape extrude(const std::vector<TopoDS_Wire>& wires, double distance);
+  TopoDS_Shape extrude(const std::vector<TopoDS_Wire>& wires, double distance,
+                       const Message_ProgressRange& theRange = Message_ProgressRange());
+
+  // Wall time spent inside KernelAPI calls by the calling thread since it started; nested calls
+  // (extrude -> fuseClustered -> fuse) are counted once. Profilers diff two readings.
+  struct ThreadStats
+  {
+    double      seconds{0.0};
+    std::size_t calls{0};
+  };
+  ThreadStats threadStats();
 }
@@ -1,50 +1,118 @@
 #include "DocumentItem.h"
+#include "IdAllocator.h"
 
+#include <array>
 #include <atomic>
+#include <cstddef>
 #include <mutex>
 
 namespace {
-static std::atomic<DocumentItem::Id>& nextId()
+// Factories register from static initializers; the first create() freezes the table, after which
+// lookups are plain reads of immutable slots (no lock on the load path)
+struct FactorySlot
 {
-  static std::atomic<DocumentItem::Id> v{1};
-  return v;
+  DocumentItem::Kind     kind{};
+  DocumentItem::CreateFn fn;
+};
+
+constexpr std::size_t kMaxFactories = 32;
+
+struct FactoryTable
+{
+  std::array<FactorySlot, kMaxFactories> slots;
+  std::size_t                            count{0};
+  std::atomic<bool>                      frozen{false};
+  std::mutex                             mutex; // registration only
+};
+
+static FactoryTable& factories()
+{
+  static FactoryTable t;
+  return t;
 }
 
-static std::unordered_map<DocumentItem::Kind, DocumentItem::CreateFn>& registry()
+static const FactorySlot* findSlot(const FactoryTable& t, DocumentItem::Kind k)
 {
-  static std::unordered_map<DocumentItem::Kind, DocumentItem::CreateFn> r;
-  return r;
+  for (std::size_t i = 0; i < t.count; ++i)
+  {
+    if (t.slots[i].kind == k) return &t.slots[i];
+  }
+  return nullptr;
 }
 
-static std::mutex registryMutex;
+// Persisted id handed to the item under construction by create(k, existingId), so loading
+// never draws (and wastes) ids from the allocator
+thread_local DocumentItem::Id t_adoptId = 0;
 }
 
 DocumentItem::DocumentItem()
-  : m_id(nextId().fetch_add(1))
+  : m_id(t_adoptId != 0 ? t_adoptId : IdAllocator::current().allocate()),
+    m_revision(nextRevision())
 {
+  t_adoptId = 0;
 }
 
 DocumentItem::DocumentItem(DocumentItem::Id existingId)
-  : m_id(existingId)
+  : m_id(existingId),
+    m_revision(nextRevision())
 {
-  // keep next id ahead
-  DocumentItem::Id cur = nextId().load();
-  if (existingId >= cur) {
-    nextId().store(existingId + 1);
+  IdAllocator::current().reserve(existingId);
+}
+
+std::uint64_t DocumentItem::nextRevision()
+{
+  static std::atomic<std::uint64_t> s_revision{0};
+  return s_revision.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+bool DocumentItem::registerFactory(DocumentItem::Kind k, DocumentItem::CreateFn fn)
+{
+  FactoryTable& t = factories();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  if (t.frozen.load(std::memory_order_relaxed)) return false;
+  if (FactorySlot* slot = const_cast<FactorySlot*>(findSlot(t, k)))
+  {
+    slot->fn = std::move(fn);
+    return true;
   }
+  if (t.count == kMaxFactories) return false;
+  t.slots[t.count].kind = k;
+  t.slots[t.count].fn   = std::move(fn);
+  ++t.count;
+  return true;
+}
+
+void DocumentItem::freezeFactories()
+{
+  FactoryTable& t = factories();
+  if (t.frozen.load(std::memory_order_acquire)) return;
+  std::lock_guard<std::mutex> lock(t.mutex);
+  t.frozen.store(true, std::memory_order_release);
+}
+
+bool DocumentItem::factoriesFrozen()
+{
+  return factories().frozen.load(std::memory_order_acquire);
 }
 
-void DocumentItem::registerFactory(DocumentItem::Kind k, DocumentItem::CreateFn fn)
+static DocumentItem* createRaw(DocumentItem::Kind k)
 {
-  std::lock_guard<std::mutex> lock(registryMutex);
-  registry()[k] = std::move(fn);
+  DocumentItem::freezeFactories();
+  const FactorySlot* slot = findSlot(factories(), k);
+  return slot != nullptr ? slot->fn() : nullptr;
 }
 
 std::shared_ptr<DocumentItem> DocumentItem::create(DocumentItem::Kind k)
 {
-  std::lock_guard<std::mutex> lock(registryMutex);
-  auto& reg = registry();
-  auto it = reg.find(k);
-  if (it == reg.end()) return nullptr;
-  return (it->second)();
+  return std::shared_ptr<DocumentItem>(createRaw(k));
+}
+
+Handle(DocumentItem) DocumentItem::create(DocumentItem::Kind k, DocumentItem::Id existingId)
+{
+  t_adoptId = existingId;
+  Handle(DocumentItem) item = createRaw(k);
+  t_adoptId = 0;
+  if (item.IsNull()) return item;
+  IdAllocator::current().reserve(existingId);
+  return item;
 }
@@ -4,7 +4,6 @@
 #include <functional>
 #include <memory>
 #include <string>
-#include <unordered_map>
 
 #include <Standard_DefineHandle.hxx>
 #include <Standard_Transient.hxx>
@@ -28,6 +27,10 @@ public:
 
   Id id() const { return m_id; }
 
+  // Edit stamp: renewed whenever serialized inputs change (undo snapshots compare it). Stamps come
+  // from one process-wide counter, so a revision also identifies the object it was read from.
+  std::uint64_t revision() const { return m_revision; }
+
   // Every item reports its kind for factory-driven reconstruction
   virtual Kind kind() const = 0;
 
@@ -36,17 +39,30 @@ public:
   virtual void        deserialize(const std::string& data) = 0;
 
   // Factory registration and creation for document load
-  using CreateFn = std::function<std::shared_ptr<DocumentItem>()>;
+  // Factories return a new, unowned item; callers wrap it in a Handle or std::shared_ptr
+  // Registration happens at static initialization; the first create() (or freezeFactories())
+  // freezes the table so concurrent loads look factories up without locking.
+  // registerFactory() returns false once frozen.
+  using CreateFn = std::function<DocumentItem*()>;
 
-  static void registerFactory(Kind k, CreateFn fn);
+  static bool registerFactory(Kind k, CreateFn fn);
+  static void freezeFactories();
+  static bool factoriesFrozen();
   static std::shared_ptr<DocumentItem> create(Kind k);
+  // Create an item that keeps a persisted id (document load); null handle for unknown kinds
+  static Handle(DocumentItem) create(Kind k, Id existingId);
 
 protected:
-  DocumentItem();
-  explicit DocumentItem(Id existingId);
+  DocumentItem();                      // new id from IdAllocator::current()
+  explicit DocumentItem(Id existingId); // persisted id, reserved in IdAllocator::current()
+
+  void touch() { m_revision = nextRevision(); }
 
 private:
-  Id m_id{0};
+  static std::uint64_t nextRevision();
+
+  Id            m_id{0};
+  std::uint64_t m_revision{0};
 };
 
 // Enable OCCT handle for DocumentItem
@@ -0,0 +1,28 @@
+#include "IdAllocator.h"
+
+namespace
+{
+thread_local IdAllocator* t_current = nullptr;
+}
+
+IdAllocator& IdAllocator::global()
+{
+  static IdAllocator alloc;
+  return alloc;
+}
+
+IdAllocator& IdAllocator::current()
+{
+  return t_current != nullptr ? *t_current : global();
+}
+
+IdAllocator::Scope::Scope(IdAllocator& alloc)
+  : m_prev(t_current)
+{
+  t_current = &alloc;
+}
+
+IdAllocator::Scope::~Scope()
+{
+  t_current = m_prev;
+}
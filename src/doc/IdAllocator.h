@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Monotonic source of DocumentItem ids
+// - allocate() and reserve() are lock-free and safe to call from any thread
+// - Each Document owns one, so documents loaded or edited concurrently never share a counter
+// - DocumentItem constructors draw from the calling thread's scoped allocator (see Scope),
+//   falling back to the process-wide global() one
+class IdAllocator
+{
+public:
+  using Id = std::uint64_t;
+
+  explicit IdAllocator(Id first = 1) : m_next(first) {}
+  IdAllocator(const IdAllocator& other) : m_next(other.peekNext()) {}
+  IdAllocator& operator=(const IdAllocator& other)
+  {
+    m_next.store(other.peekNext(), std::memory_order_relaxed);
+    return *this;
+  }
+
+  Id allocate() { return m_next.fetch_add(1, std::memory_order_relaxed); }
+
+  // Keep future ids above a persisted one (atomic fetch-max)
+  void reserve(Id id)
+  {
+    Id cur = m_next.load(std::memory_order_relaxed);
+    while (id >= cur && !m_next.compare_exchange_weak(cur, id + 1, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  Id peekNext() const { return m_next.load(std::memory_order_relaxed); }
+
+  static IdAllocator& global();
+  static IdAllocator& current(); // innermost Scope of this thread, else global()
+
+  // Route id allocation of the current thread to 'alloc' for the lifetime of the scope
+  class Scope
+  {
+  public:
+    explicit Scope(IdAllocator& alloc);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    IdAllocator* m_prev;
+  };
+
+private:
+  std::atomic<Id> m_next;
+};
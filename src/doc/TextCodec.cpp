@@ -0,0 +1,182 @@
+#include "TextCodec.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+namespace
+{
+bool isSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+template <class Int>
+bool parseInteger(std::string_view s, Int& v)
+{
+  if (s.empty()) return false;
+  const char* first = s.data();
+  const char* last  = s.data() + s.size();
+  if (*first == '+' && ++first != last && (*first == '+' || *first == '-')) return false; // "+-3"
+  const auto res = std::from_chars(first, last, v);
+  return res.ec == std::errc() && res.ptr == last;
+}
+
+// strtod over a whole token; its out-of-range results are right (HUGE_VAL on overflow, a
+// denormal or signed zero on underflow) where from_chars only reports the error
+bool parseStrtod(const char* first, const char* last, double& v)
+{
+  const std::size_t n = static_cast<std::size_t>(last - first);
+  char              small[64];
+  std::string       large;
+  char*             buf = small;
+  if (n >= sizeof(small))
+  {
+    large.assign(first, n);
+    buf = large.data();
+  }
+  else
+  {
+    std::memcpy(small, first, n);
+    small[n] = '\0';
+  }
+  char* end = nullptr;
+  v         = std::strtod(buf, &end);
+  return end == buf + n;
+}
+} // namespace
+
+std::size_t TextCodec::format(double v, char* buf, std::size_t size)
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  const auto res = std::to_chars(buf, buf + size, v);
+  return res.ec == std::errc() ? static_cast<std::size_t>(res.ptr - buf) : 0;
+#else
+  // 17 significant digits always round-trip, though not always in the shortest form
+  const int n = std::snprintf(buf, size, "%.17g", v);
+  return (n > 0 && static_cast<std::size_t>(n) < size) ? static_cast<std::size_t>(n) : 0;
+#endif
+}
+
+bool TextCodec::parse(std::string_view s, double& v)
+{
+  if (s.empty()) return false;
+  const char* first = s.data();
+  const char* last  = s.data() + s.size();
+  if (*first == '+' && ++first != last && (*first == '+' || *first == '-')) return false; // "+-3"
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  const auto res = std::from_chars(first, last, v);
+  // Out-of-range literals take strtod's value instead of failing the whole blob: overflow
+  // saturates to +-inf, underflow goes to a denormal or zero
+  if (res.ec == std::errc::result_out_of_range && res.ptr == last) return parseStrtod(first, last, v);
+  return res.ec == std::errc() && res.ptr == last;
+#else
+  if (first == last) return false;
+  return parseStrtod(first, last, v);
+#endif
+}
+
+bool TextCodec::parse(std::string_view s, int& v)           { return parseInteger(s, v); }
+bool TextCodec::parse(std::string_view s, std::int64_t& v)  { return parseInteger(s, v); }
+bool TextCodec::parse(std::string_view s, std::uint64_t& v) { return parseInteger(s, v); }
+
+TextCodec::Writer& TextCodec::Writer::num(double v)
+{
+  char buf[32];
+  m_out.append(buf, format(v, buf, sizeof(buf)));
+  return *this;
+}
+
+TextCodec::Writer& TextCodec::Writer::num(std::int64_t v)
+{
+  char buf[24];
+  const auto res = std::to_chars(buf, buf + sizeof(buf), v);
+  m_out.append(buf, static_cast<std::size_t>(res.ptr - buf));
+  return *this;
+}
+
+TextCodec::Writer& TextCodec::Writer::num(std::uint64_t v)
+{
+  char buf[24];
+  const auto res = std::to_chars(buf, buf + sizeof(buf), v);
+  m_out.append(buf, static_cast<std::size_t>(res.ptr - buf));
+  return *this;
+}
+
+TextCodec::Writer& TextCodec::Writer::escaped(std::string_view s)
+{
+  for (char c : s)
+  {
+    if (c == '\n') { m_out.append("\\n", 2); continue; }
+    if (c == '\\' || c == '=') m_out.push_back('\\');
+    m_out.push_back(c);
+  }
+  return *this;
+}
+
+bool TextCodec::LineReader::next(std::string_view& line)
+{
+  while (!m_rest.empty())
+  {
+    const std::size_t eol = m_rest.find('\n');
+    line   = m_rest.substr(0, eol);
+    m_rest = (eol == std::string_view::npos) ? std::string_view() : m_rest.substr(eol + 1);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    if (!line.empty()) return true;
+  }
+  return false;
+}
+
+bool TextCodec::TokenReader::next(std::string_view& token)
+{
+  std::size_t i = 0;
+  while (i < m_rest.size() && isSpace(m_rest[i])) ++i;
+  std::size_t j = i;
+  while (j < m_rest.size() && !isSpace(m_rest[j])) ++j;
+  token  = m_rest.substr(i, j - i);
+  m_rest = m_rest.substr(j);
+  return !token.empty();
+}
+
+bool TextCodec::TokenReader::next(char& c)
+{
+  // Like 'is >> c': the first non-space character, even when more follow
+  std::size_t i = 0;
+  while (i < m_rest.size() && isSpace(m_rest[i])) ++i;
+  if (i == m_rest.size()) return false;
+  c      = m_rest[i];
+  m_rest = m_rest.substr(i + 1);
+  return true;
+}
+
+bool TextCodec::splitKeyValue(std::string_view line, std::string_view& key, std::string_view& value)
+{
+  bool esc = false;
+  for (std::size_t i = 0; i < line.size(); ++i)
+  {
+    if (!esc && line[i] == '=')
+    {
+      key   = line.substr(0, i);
+      value = line.substr(i + 1);
+      return true;
+    }
+    esc = (!esc && line[i] == '\\');
+  }
+  return false;
+}
+
+void TextCodec::unescape(std::string_view value, std::string& out)
+{
+  out.clear();
+  out.reserve(value.size());
+  bool esc = false;
+  for (char c : value)
+  {
+    if (!esc && c == '\\') { esc = true; continue; }
+    out.push_back(esc && c == 'n' ? '\n' : c);
+    esc = false;
+  }
+}
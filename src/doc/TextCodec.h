@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Allocation-free helpers for the line-based DocumentItem::serialize() format
+// - Numbers use std::to_chars/std::from_chars: doubles are written in the shortest form that
+//   parses back to the same value (no 6-digit ostream truncation)
+// - Readers work on std::string_view slices of the input blob; nothing is copied per line
+// - Blobs written by the previous ostream/stod based code parse unchanged
+// When the standard library lacks floating-point to_chars/from_chars, %.17g/strtod are used instead.
+class TextCodec
+{
+public:
+  // Appends to a caller-owned string
+  class Writer
+  {
+  public:
+    explicit Writer(std::string& out) : m_out(out) {}
+
+    Writer& text(std::string_view s) { m_out.append(s.data(), s.size()); return *this; }
+    Writer& ch(char c) { m_out.push_back(c); return *this; }
+    Writer& num(double v);
+    Writer& num(std::int64_t v);
+    Writer& num(std::uint64_t v);
+    Writer& num(int v) { return num(static_cast<std::int64_t>(v)); }
+    Writer& escaped(std::string_view s); // escapes '\', '=' and newlines for key=value lines
+
+    // "key=value\n" helpers
+    template <class T>
+    Writer& field(std::string_view key, T value) { return text(key).ch('=').num(value).ch('\n'); }
+
+  private:
+    std::string& m_out;
+  };
+
+  // Iterates '\n' separated lines (a trailing '\r' is dropped)
+  class LineReader
+  {
+  public:
+    explicit LineReader(std::string_view data) : m_rest(data) {}
+    bool next(std::string_view& line);
+
+  private:
+    std::string_view m_rest;
+  };
+
+  // Iterates whitespace separated tokens
+  class TokenReader
+  {
+  public:
+    explicit TokenReader(std::string_view data) : m_rest(data) {}
+    bool next(std::string_view& token);
+    bool next(double& v) { std::string_view t; return next(t) && parse(t, v); }
+    bool next(int& v) { std::string_view t; return next(t) && parse(t, v); }
+    bool next(std::int64_t& v) { std::string_view t; return next(t) && parse(t, v); }
+    bool next(std::uint64_t& v) { std::string_view t; return next(t) && parse(t, v); }
+    bool next(char& c);
+
+  private:
+    std::string_view m_rest;
+  };
+
+  // Split "key=value" at the first unescaped '='; value stays escaped (see unescape)
+  static bool splitKeyValue(std::string_view line, std::string_view& key, std::string_view& value);
+  static void unescape(std::string_view value, std::string& out);
+
+  // Calls fn(key, rawValue) for every key=value line of a blob
+  template <class Fn>
+  static void forEachKeyValue(std::string_view data, Fn&& fn)
+  {
+    LineReader lines(data);
+    std::string_view line, key, value;
+    while (lines.next(line))
+    {
+      if (splitKeyValue(line, key, value)) fn(key, value);
+    }
+  }
+
+  // Whole-token parsers: false on empty input, trailing characters or overflow
+  static bool parse(std::string_view s, double& v);
+  static bool parse(std::string_view s, int& v);
+  static bool parse(std::string_view s, std::int64_t& v);
+  static bool parse(std::string_view s, std::uint64_t& v);
+
+  // Shortest round-trip text for a double (exposed for tests and tools)
+  static std::size_t format(double v, char* buf, std::size_t size);
+};
@@ -8,9 +8,12 @@
 
 #include <Standard_Version.hxx>
 
+#include <Trace.h>
+
 int main(int argc, char** argv)
 {
   QApplication app(argc, argv);
+  Trace::setThreadName("main");
 
   QCoreApplication::setApplicationName("Parametric CAD Skeleton");
   QCoreApplication::setOrganizationName("OpenCASCADE");
@@ -0,0 +1,262 @@
+#include "BackgroundRecompute.h"
+
+#include <ExtrudeFeature.h>
+#include <MoveFeature.h>
+#include <Sketch.h>
+#include <IdAllocator.h>
+
+#include <Message_ProgressIndicator.hxx>
+#include <Message_ProgressScope.hxx>
+#include <Trace.h>
+
+#include <chrono>
+#include <unordered_set>
+
+namespace
+{
+// Reports a break as soon as a newer job was requested (or the owner shuts down)
+class CancelIndicator : public Message_ProgressIndicator
+{
+public:
+  CancelIndicator(const std::atomic<std::uint64_t>& latest, std::uint64_t generation, const std::atomic<bool>& stop)
+    : m_latest(latest), m_generation(generation), m_stop(stop)
+  {
+  }
+
+  Standard_Boolean UserBreak() override { return m_stop.load() || m_latest.load() != m_generation; }
+  void Show(const Message_ProgressScope&, const Standard_Boolean) override {}
+
+private:
+  const std::atomic<std::uint64_t>& m_latest;
+  std::uint64_t                     m_generation;
+  const std::atomic<bool>&          m_stop;
+};
+} // namespace
+
+BackgroundRecompute::BackgroundRecompute(std::function<void()> onReady)
+  : m_onReady(std::move(onReady))
+{
+  m_worker = std::thread([this]() { run(); });
+}
+
+BackgroundRecompute::~BackgroundRecompute()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  if (m_worker.joinable()) m_worker.join();
+}
+
+std::unique_ptr<BackgroundRecompute::Job> BackgroundRecompute::snapshot(const Document& doc)
+{
+  CAD_TRACE_SCOPE("model", "BackgroundRecompute::snapshot");
+  auto job = std::make_unique<Job>();
+  job->doc = std::make_unique<Document>();
+  Document& copy = *job->doc;
+  copy.setResultCache(doc.resultCache()); // thread-safe; hits from earlier jobs are reused
+  copy.setRecomputeThreads(doc.recomputeThreads());
+  copy.setProfiling(doc.profiling());
+  copy.setEvaluationMode(doc.evaluationMode());
+  // Copies keep the persisted ids inside the snapshot's own id space
+  IdAllocator::Scope ids(copy.ids());
+
+  std::unordered_map<const Sketch*, std::shared_ptr<Sketch>> sketchCopies;
+  auto copySketch = [&sketchCopies](const std::shared_ptr<Sketch>& sk) {
+    auto [it, isNew] = sketchCopies.emplace(sk.get(), nullptr);
+    if (isNew)
+    {
+      it->second = std::make_shared<Sketch>(sk->id());
+      it->second->deserialize(sk->serialize());
+    }
+    return it->second;
+  };
+  for (const auto& sk : doc.sketches()) copy.addSketch(copySketch(sk));
+
+  std::vector<std::pair<Handle(MoveFeature), Handle(MoveFeature)>> moves; // (live, copy)
+  for (Timeline::Iterator it(doc.items()); it.More(); it.Next())
+  {
+    const Handle(DocumentItem)& live = it.Value();
+    Handle(DocumentItem) item = DocumentItem::create(live->kind(), live->id());
+    if (item.IsNull()) continue;
+    item->deserialize(live->serialize());
+    Origin& origin  = job->origins[live->id()];
+    origin.revision = live->revision();
+    if (Handle(Feature) f = Handle(Feature)::DownCast(live); !f.IsNull())
+    {
+      Handle(Feature) fc = Handle(Feature)::DownCast(item);
+      Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f);
+      origin.dirty    = f->isDirty();
+      origin.deferred = !mf.IsNull() && mf->isDeferred();
+      // Up-to-date results are carried over, so only stale features run
+      if (!f->isDirty())
+      {
+        if (!mf.IsNull() && mf->isDeferred())
+          Handle(MoveFeature)::DownCast(fc)->defer();
+        else
+          fc->copyResultFrom(*f); // evicted results stay evicted in the copy
+        fc->clearDirty();
+      }
+      if (!mf.IsNull()) moves.emplace_back(mf, Handle(MoveFeature)::DownCast(fc));
+      Handle(ExtrudeFeature) ef = Handle(ExtrudeFeature)::DownCast(f);
+      if (!ef.IsNull() && ef->sketch()) Handle(ExtrudeFeature)::DownCast(fc)->bindSketch(copySketch(ef->sketch()));
+    }
+    copy.addItem(item);
+  }
+  // Runtime-only move links (no sourceId) are re-bound to the copied source
+  for (const auto& [live, mc] : moves)
+  {
+    if (mc->sourceId() != 0 || live->source().IsNull()) continue;
+    mc->bindSource(Handle(Feature)::DownCast(copy.findItem(live->source()->id())));
+  }
+  // Rolled-back features are not recomputed by the snapshot either
+  if (doc.hasRollback()) copy.setRollbackPosition(doc.rollbackPosition());
+  return job;
+}
+
+std::uint64_t BackgroundRecompute::request(const Document& doc)
+{
+  std::unique_ptr<Job> job = snapshot(doc);
+  std::uint64_t generation = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Bumping the generation makes the running job's indicator report a break
+    generation      = ++m_latest;
+    job->generation = generation;
+    if (m_pending) ++m_stats.superseded;
+    m_pending = std::move(job);
+    ++m_stats.requested;
+  }
+  m_cv.notify_all();
+  return generation;
+}
+
+void BackgroundRecompute::cancel()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_latest;
+    if (m_pending) ++m_stats.superseded;
+    m_pending.reset();
+  }
+  m_cv.notify_all();
+}
+
+BackgroundRecompute::Result BackgroundRecompute::execute(Job& job)
+{
+  Result result;
+  result.generation = job.generation;
+  Document& copy = *job.doc;
+
+  // Features whose result the snapshot recompute produced (executed or cache hit)
+  std::unordered_set<DocumentItem::Id> produced;
+  copy.addChangeListener([&produced](const Document::ChangeSet& cs) {
+    produced.insert(cs.modified.begin(), cs.modified.end());
+  });
+  Handle(CancelIndicator) indicator = new CancelIndicator(m_latest, job.generation, m_stop);
+  copy.recompute(indicator->Start());
+  result.stats     = copy.lastRecomputeStats();
+  result.cancelled = result.stats.cancelled > 0;
+  result.profile   = copy.lastProfile();
+
+  for (Timeline::FeatureView::Iterator it(copy.features()); it.More(); it.Next())
+  {
+    const Handle(Feature)& f = it.Value();
+    if (f->isDirty()) continue; // not needed, or cancelled
+    Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f);
+    const bool    deferred = !mf.IsNull() && mf->isDeferred();
+    const Origin& origin   = job.origins[f->id()];
+    // New results: produced by this recompute, or stale live features it cleaned (collapsed links)
+    if (produced.count(f->id()) == 0 && !origin.dirty && deferred == origin.deferred) continue;
+    Entry e;
+    e.id       = f->id();
+    e.revision = origin.revision;
+    e.deferred = deferred;
+    if (!deferred) e.shape = f->shape();
+    result.entries.push_back(std::move(e));
+  }
+  return result;
+}
+
+void BackgroundRecompute::run()
+{
+  Trace::setThreadName("background recompute");
+  for (;;)
+  {
+    std::unique_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this]() { return m_stop || m_pending; });
+      if (m_stop) return;
+      job       = std::move(m_pending);
+      m_running = true;
+    }
+    auto result = std::make_shared<Result>(execute(*job));
+    job.reset();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++(result->cancelled ? m_stats.cancelled : m_stats.completed);
+    }
+    // Partial results of a cancelled job are still valid for the features that finished
+    if (!result->entries.empty() || result->profile)
+    {
+      while (!m_results.push(result))
+      {
+        if (m_stop) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running = false;
+    }
+    m_cv.notify_all();
+    if (m_onReady) m_onReady();
+  }
+}
+
+std::size_t BackgroundRecompute::apply(Document& doc)
+{
+  CAD_TRACE_SCOPE("model", "BackgroundRecompute::apply");
+  std::size_t adopted = 0, discarded = 0;
+  std::shared_ptr<Result> result;
+  while (m_results.pop(result))
+  {
+    for (const Entry& e : result->entries)
+    {
+      if (doc.adoptResult(e.id, e.revision, e.shape, e.deferred))
+        ++adopted;
+      else
+        ++discarded;
+    }
+    if (result->profile && !result->cancelled) doc.setLastProfile(result->profile);
+  }
+  if (adopted != 0)
+  {
+    doc.enforceResultBudget();
+    doc.notifyChanges();
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats.adopted += adopted;
+  m_stats.discarded += discarded;
+  return adopted;
+}
+
+bool BackgroundRecompute::waitIdle(int timeoutMs)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  auto idle = [this]() { return !m_pending && !m_running; };
+  if (timeoutMs < 0)
+  {
+    m_cv.wait(lock, idle);
+    return true;
+  }
+  return m_cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), idle);
+}
+
+BackgroundRecompute::Stats BackgroundRecompute::stats() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
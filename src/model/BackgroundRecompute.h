@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Document.h"
+#include "SpscQueue.h"
+
+#include <DocumentItem.h>
+#include <TopoDS_Shape.hxx>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Recompute on a worker thread against an isolated snapshot of a Document
+// - request() copies the timeline and sketches (blobs, up-to-date shapes, dirty flags) on the
+//   calling thread; the worker only touches the copy, so the document stays editable and keeps
+//   displaying its last good shapes
+// - A newer request() cancels the running job cooperatively: its Message_ProgressIndicator
+//   reports UserBreak(), kernel operations stop early and remaining features are skipped.
+//   A request still waiting for the worker is replaced without running
+// - Finished (or partially finished) results travel to the owning thread through a lock-free
+//   SPSC queue; apply() adopts those whose item revision is unchanged and notifies listeners once
+// - Shapes are shared read-only between the document and the snapshot (TopoDS_Shape handles)
+class BackgroundRecompute
+{
+public:
+  // Result of one feature, keyed by the live item's revision at snapshot time
+  struct Entry
+  {
+    DocumentItem::Id id{0};
+    std::uint64_t    revision{0};
+    TopoDS_Shape     shape;
+    bool             deferred{false}; // collapsed move link (see MoveFeature::defer)
+  };
+
+  struct Result
+  {
+    std::uint64_t            generation{0};
+    bool                     cancelled{false};
+    Document::RecomputeStats stats;
+    std::vector<Entry>       entries;
+    std::shared_ptr<const RecomputeProfile> profile; // when the document profiles recomputes
+  };
+
+  struct Stats
+  {
+    std::size_t requested{0}; // request() calls
+    std::size_t completed{0}; // jobs that ran to the end
+    std::size_t cancelled{0}; // jobs interrupted by a newer request or cancel()
+    std::size_t superseded{0}; // requests replaced before the worker picked them up
+    std::size_t adopted{0};   // results taken over by apply()
+    std::size_t discarded{0}; // results dropped because the item changed or disappeared meanwhile
+  };
+
+  // 'onReady' runs on the worker thread after each job; use it to wake the owning thread
+  // (e.g. a queued Qt call to apply()). It must not touch the document.
+  explicit BackgroundRecompute(std::function<void()> onReady = std::function<void()>());
+  ~BackgroundRecompute(); // cancels the running job and joins the worker
+  BackgroundRecompute(const BackgroundRecompute&) = delete;
+  BackgroundRecompute& operator=(const BackgroundRecompute&) = delete;
+
+  // Snapshot 'doc' and schedule its recompute; returns the job generation
+  std::uint64_t request(const Document& doc);
+  // Cancel the running job and drop the waiting one
+  void cancel();
+  // Owning thread: adopt queued results into 'doc'; returns the number of adopted entries
+  std::size_t apply(Document& doc);
+  // Block until no job is waiting or running (false on timeout)
+  bool waitIdle(int timeoutMs = -1);
+
+  std::uint64_t latestGeneration() const { return m_latest.load(); }
+  Stats stats() const;
+
+private:
+  // Live item state at snapshot time
+  struct Origin
+  {
+    std::uint64_t revision{0};
+    bool          dirty{false};
+    bool          deferred{false};
+  };
+  struct Job
+  {
+    std::uint64_t                                generation{0};
+    std::unique_ptr<Document>                    doc;
+    std::unordered_map<DocumentItem::Id, Origin> origins;
+  };
+
+  static std::unique_ptr<Job> snapshot(const Document& doc);
+  Result execute(Job& job);
+  void   run();
+
+  std::function<void()>          m_onReady;
+  std::atomic<std::uint64_t>     m_latest{0};
+  std::atomic<bool>              m_stop{false};
+  SpscQueue<std::shared_ptr<Result>, 16> m_results;
+
+  mutable std::mutex      m_mutex; // guards m_pending, m_running, m_stats
+  std::condition_variable m_cv;
+  std::unique_ptr<Job>    m_pending;
+  bool                    m_running{false};
+  Stats                   m_stats;
+  std::thread             m_worker;
+};
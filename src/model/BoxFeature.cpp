@@ -8,7 +8,7 @@ IMPLEMENT_STANDARD_RTTIEXT(BoxFeature, Feature)
 
 namespace {
 const bool kBoxFeatureReg = [](){
-  DocumentItem::registerFactory(DocumentItem::Kind::BoxFeature, [](){ return std::shared_ptr<DocumentItem>(new BoxFeature()); });
+  DocumentItem::registerFactory(DocumentItem::Kind::BoxFeature, []() -> DocumentItem* { return new BoxFeature(); });
   return true;
 }();
 }
@@ -29,7 +29,7 @@ double BoxFeature::dz() const
   return Feature::paramAsDouble(params(), Feature::ParamKey::Dz, 0.0);
 }
 
-void BoxFeature::execute()
+void BoxFeature::execute(const Message_ProgressRange&)
 {
   m_shape = KernelAPI::makeBox(dx(), dy(), dz());
 }
@@ -12,9 +12,13 @@ class BoxFeature : public Feature
   DEFINE_STANDARD_RTTIEXT(BoxFeature, Feature)
 
 public:
-  BoxFeature() = default;
+  // Parameter schema: box extents along X, Y, Z
+  static constexpr ParamSpec kParamSchema[] = {{ParamKey::Dx, 0.0}, {ParamKey::Dy, 0.0}, {ParamKey::Dz, 0.0}};
+  ParamSchema paramSchema() const override { return kParamSchema; }
 
-  BoxFeature(double dx, double dy, double dz) { setSize(dx, dy, dz); }
+  BoxFeature() { resetParams(); }
+
+  BoxFeature(double dx, double dy, double dz) : BoxFeature() { setSize(dx, dy, dz); }
 
   // Parameter accessors (backed by Feature::params())
   void setSize(double dx, double dy, double dz)
@@ -24,18 +28,18 @@ public:
     setDz(dz);
   }
 
-  void setDx(double dx) { params()[Feature::ParamKey::Dx] = dx; }
+  void setDx(double dx) { params().set(Feature::ParamKey::Dx, dx); }
 
-  void setDy(double dy) { params()[Feature::ParamKey::Dy] = dy; }
+  void setDy(double dy) { params().set(Feature::ParamKey::Dy, dy); }
 
-  void setDz(double dz) { params()[Feature::ParamKey::Dz] = dz; }
+  void setDz(double dz) { params().set(Feature::ParamKey::Dz, dz); }
 
   double dx() const;
   double dy() const;
   double dz() const;
 
   // Feature API
-  void execute() override;
+  void execute(const Message_ProgressRange& theRange = Message_ProgressRange()) override;
 
   // DocumentItem
   Kind kind() const override { return Kind::BoxFeature; }
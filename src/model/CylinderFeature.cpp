@@ -8,7 +8,7 @@ IMPLEMENT_STANDARD_RTTIEXT(CylinderFeature, Feature)
 
 namespace {
 const bool kCylinderFeatureReg = [](){
-  DocumentItem::registerFactory(DocumentItem::Kind::CylinderFeature, [](){ return std::shared_ptr<DocumentItem>(new CylinderFeature()); });
+  DocumentItem::registerFactory(DocumentItem::Kind::CylinderFeature, []() -> DocumentItem* { return new CylinderFeature(); });
   return true;
 }();
 }
@@ -24,7 +24,7 @@ double CylinderFeature::height() const
   return Feature::paramAsDouble(params(), Feature::ParamKey::Height, 0.0);
 }
 
-void CylinderFeature::execute()
+void CylinderFeature::execute(const Message_ProgressRange&)
 {
   m_shape = KernelAPI::makeCylinder(radius(), height());
 }
@@ -12,8 +12,12 @@ class CylinderFeature : public Feature
   DEFINE_STANDARD_RTTIEXT(CylinderFeature, Feature)
 
 public:
-  CylinderFeature() = default;
-  CylinderFeature(double radius, double height) { set(radius, height); }
+  // Parameter schema: radius and height along +Z
+  static constexpr ParamSpec kParamSchema[] = {{ParamKey::Radius, 0.0}, {ParamKey::Height, 0.0}};
+  ParamSchema paramSchema() const override { return kParamSchema; }
+
+  CylinderFeature() { resetParams(); }
+  CylinderFeature(double radius, double height) : CylinderFeature() { set(radius, height); }
 
   void set(double radius, double height)
   {
@@ -21,13 +25,13 @@ public:
     setHeight(height);
   }
 
-  void setRadius(double r) { params()[Feature::ParamKey::Radius] = r; }
-  void setHeight(double h) { params()[Feature::ParamKey::Height] = h; }
+  void setRadius(double r) { params().set(Feature::ParamKey::Radius, r); }
+  void setHeight(double h) { params().set(Feature::ParamKey::Height, h); }
 
   double radius() const;
   double height() const;
 
-  void execute() override;
+  void execute(const Message_ProgressRange& theRange = Message_ProgressRange()) override;
 
   // DocumentItem
   Kind kind() const override { return Kind::CylinderFeature; }
@@ -2,145 +2,901 @@
 #include <ExtrudeFeature.h>
 #include <MoveFeature.h>
 #include <Sketch.h>
+#include "TaskGraph.h"
+#include "FeatureResultCache.h"
+#include "MemoryReport.h"
+
+#include <KernelAPI.h>
+#include <Message_ProgressScope.hxx>
+#include <OSD_Chronometer.hxx>
+#include <TopExp.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <Trace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace
+{
+// Profiler readings taken around one recompute task (see Document::setProfiling)
+struct TaskClock
+{
+  std::chrono::steady_clock::time_point wall;
+  double                                cpu{0.0};
+  KernelAPI::ThreadStats                kernel;
+
+  static double threadCpu()
+  {
+    Standard_Real user = 0.0, system = 0.0;
+    OSD_Chronometer::GetThreadCPU(user, system);
+    return user + system;
+  }
+  void start()
+  {
+    wall   = std::chrono::steady_clock::now();
+    cpu    = threadCpu();
+    kernel = KernelAPI::threadStats();
+  }
+  void stop(RecomputeProfile::Entry& e, const TopoDS_Shape& result) const
+  {
+    const KernelAPI::ThreadStats k = KernelAPI::threadStats();
+    e.wallMs      = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall).count();
+    e.cpuMs       = (threadCpu() - cpu) * 1000.0;
+    e.kernelMs    = (k.seconds - kernel.seconds) * 1000.0;
+    e.kernelCalls = k.calls - kernel.calls;
+    if (result.IsNull()) return;
+    TopTools_IndexedMapOfShape faces, edges, vertices;
+    TopExp::MapShapes(result, TopAbs_FACE, faces);
+    TopExp::MapShapes(result, TopAbs_EDGE, edges);
+    TopExp::MapShapes(result, TopAbs_VERTEX, vertices);
+    e.faces    = faces.Extent();
+    e.edges    = edges.Extent();
+    e.vertices = vertices.Extent();
+  }
+};
+
+// A feature that ran before its dependency was registered holds no result; binding the
+// dependency late must make it run again
+bool lacksResult(const Handle(Feature)& f)
+{
+  if (!f->heldShape().IsNull() || f->isEvicted()) return false;
+  Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f);
+  return mf.IsNull() || !mf->isDeferred();
+}
+} // namespace
 
 void Document::clear()
 {
   m_items.Clear();
+  m_resident.clear();
   m_registry.clear();
   m_sketchList.clear();
-  m_featuresCache.Clear();
-  m_featuresCacheDirty = true;
+  m_graphDirty = true;
+  m_rollback   = false;
+  m_rollbackId = 0;
 }
 
-void Document::addItem(const Handle(DocumentItem)& item)
+bool Document::addItem(const Handle(DocumentItem)& item)
 {
-  if (!item.IsNull())
+  if (!m_items.Append(item)) return false;
+  m_ids.reserve(item->id());
+  m_graphDirty = true;
+  return true;
+}
+
+bool Document::insertItem(int index1, const Handle(DocumentItem)& item)
+{
+  if (!m_items.InsertBefore(index1, item)) return false;
+  m_ids.reserve(item->id());
+  m_graphDirty = true;
+  return true;
+}
+
+bool Document::addFeature(const Handle(Feature)& f)
+{
+  if (f.IsNull()) return false;
+  if (!hasRollback()) return addItem(Handle(DocumentItem)(f));
+  if (!insertItem(rollbackPosition() + 1, Handle(DocumentItem)(f))) return false;
+  m_rollbackId = f->id();
+  return true;
+}
+
+void Document::setRollbackPosition(int index1)
+{
+  const int  before = rollbackPosition();
+  const bool on     = index1 >= 0 && index1 < m_items.Size();
+  m_rollback   = on;
+  m_rollbackId = on && index1 > 0 ? m_items.Value(index1)->id() : 0;
+  const int after = rollbackPosition();
+  if (m_listeners.empty()) return;
+  // Features between the old and the new marker appear or disappear, and so do the sources
+  // their Moves suppress
+  for (int i = std::min(before, after) + 1; i <= std::max(before, after); ++i)
   {
-    m_items.Append(item);
-    m_featuresCacheDirty = true;
+    const Handle(DocumentItem)& item = m_items.Value(i);
+    if (Handle(Feature)::DownCast(item).IsNull()) continue;
+    m_resultChanged.insert(item->id());
+    if (Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(item); !mf.IsNull() && mf->sourceId() != 0)
+      m_resultChanged.insert(mf->sourceId());
   }
 }
 
-void Document::insertItem(int index1, const Handle(DocumentItem)& item)
+void Document::unmarkRollback(int index1)
 {
-  if (item.IsNull()) return;
-  if (index1 < 1) index1 = 1;
-  if (index1 > m_items.Size() + 1) index1 = m_items.Size() + 1;
-  m_items.InsertBefore(index1, item);
-  m_featuresCacheDirty = true;
+  // The marker steps back onto the preceding item when its own item is removed
+  if (!m_rollback || m_rollbackId != m_items.Value(index1)->id()) return;
+  m_rollbackId = index1 > 1 ? m_items.Value(index1 - 1)->id() : 0;
 }
 
-const NCollection_Sequence<Handle(Feature)>& Document::features() const
+bool Document::hasRollback() const
 {
-  if (m_featuresCacheDirty)
+  // A marker whose item left the timeline (e.g. a transaction rollback) no longer applies
+  return m_rollback && (m_rollbackId == 0 || m_items.Contains(m_rollbackId));
+}
+
+int Document::rollbackPosition() const
+{
+  if (!hasRollback()) return m_items.Size();
+  return m_rollbackId == 0 ? 0 : m_items.IndexOf(m_rollbackId);
+}
+
+bool Document::isRolledBack(DocumentItem::Id id) const
+{
+  if (!hasRollback()) return false;
+  const int index = m_items.IndexOf(id);
+  return index > rollbackPosition();
+}
+
+bool Document::isDisplayed(const Handle(Feature)& f) const
+{
+  if (isRolledBack(f->id())) return false;
+  if (!f->isSuppressed()) return true;
+  if (!hasRollback()) return false;
+  // Feature consumers are Moves; the suppression they imply lapses with the last active one
+  const std::vector<DocumentItem::Id> moves = dependents(f->id());
+  if (moves.empty()) return false;
+  for (DocumentItem::Id id : moves)
+  {
+    if (!isRolledBack(id)) return false;
+  }
+  return true;
+}
+
+std::vector<DocumentItem::Id> Document::checkpoints() const
+{
+  std::vector<DocumentItem::Id> pinned;
+  if (m_checkpointMs <= 0.0) return pinned;
+  // Replay cost of rebuilding each result from the nearest resident result up its chain;
+  // displayed results stay resident anyway and restart the count for free
+  std::unordered_map<DocumentItem::Id, double> replay;
+  for (Timeline::FeatureView::Iterator it(m_items.features()); it.More(); it.Next())
   {
-    m_featuresCache.Clear();
-    for (NCollection_Sequence<Handle(DocumentItem)>::Iterator it(m_items); it.More(); it.Next())
+    const Handle(Feature)& f = it.Value();
+    auto   ms   = m_executeMs.find(f->id());
+    double cost = ms == m_executeMs.end() ? 0.0 : ms->second;
+    if (Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f); !mf.IsNull() && !mf->source().IsNull())
     {
-      const Handle(DocumentItem)& di = it.Value();
-      if (Handle(Feature) f = Handle(Feature)::DownCast(di); !f.IsNull()) {
-        m_featuresCache.Append(f);
-      }
+      auto up = replay.find(mf->source()->id());
+      if (up != replay.end()) cost += up->second;
     }
-    m_featuresCacheDirty = false;
+    if (isDisplayed(f))
+    {
+      cost = 0.0;
+    }
+    else if (cost >= m_checkpointMs)
+    {
+      pinned.push_back(f->id());
+      cost = 0.0;
+    }
+    replay[f->id()] = cost;
+  }
+  return pinned;
+}
+
+void Document::recompute(const Message_ProgressRange& theRange)
+{
+  CAD_TRACE_SCOPE("model", "Document::recompute");
+  if (m_txnDepth > 0)
+  {
+    // Batched edits: a single recompute runs at the outermost commitTransaction()
+    return;
+  }
+  if (m_scheduler)
+  {
+    m_scheduler(*this);
+    notifyChanges();
+    return;
+  }
+  if (m_evaluationMode == EvaluationMode::OnDemand)
+  {
+    // Nothing is displayed by default: results are pulled with evaluate()
+    const std::unordered_set<DocumentItem::Id> none;
+    run(&none, theRange);
+  }
+  else
+  {
+    run(nullptr, theRange);
   }
-  return m_featuresCache;
 }
 
-void Document::recompute()
+void Document::evaluate(const std::vector<DocumentItem::Id>& ids, const Message_ProgressRange& theRange)
 {
-  // Map already-executed features by id for downstream dependency resolution
-  std::unordered_map<DocumentItem::Id, Handle(Feature)> featureById;
-  for (NCollection_Sequence<Handle(DocumentItem)>::Iterator it(m_items); it.More(); it.Next()) {
-    const Handle(DocumentItem)& di = it.Value();
-    Handle(Feature) f = Handle(Feature)::DownCast(di);
-    if (f.IsNull()) continue;
-    if (!f.IsNull() && !f->isSuppressed()) {
-      // Resolve dependencies for known feature types
-      if (Handle(ExtrudeFeature) ef = Handle(ExtrudeFeature)::DownCast(f); !ef.IsNull())
+  CAD_TRACE_SCOPE("model", "Document::evaluate");
+  const std::unordered_set<DocumentItem::Id> demand(ids.begin(), ids.end());
+  run(&demand, theRange);
+}
+
+void Document::run(const std::unordered_set<DocumentItem::Id>* demand, const Message_ProgressRange& theRange)
+{
+  const auto startTime = std::chrono::steady_clock::now();
+
+  // Flatten features in timeline order; upstream[i] is the index of the feature consumed by
+  // features[i] (MoveFeature source), or -1 when there is none inside this document.
+  std::vector<Handle(Feature)> feats;
+  std::vector<int>             upstream;
+  // Map already-visited features by id for downstream dependency resolution
+  std::unordered_map<DocumentItem::Id, int> featureIndex;
+  for (Timeline::FeatureView::Iterator it(m_items.features()); it.More(); it.Next())
+  {
+    const Handle(Feature)& f = it.Value();
+    // Resolve dependencies for known feature types
+    if (Handle(ExtrudeFeature) ef = Handle(ExtrudeFeature)::DownCast(f); !ef.IsNull())
+    {
+      if (!ef->sketch() && ef->sketchId() != 0)
       {
-        if (!ef->sketch() && ef->sketchId() != 0)
+        if (auto sk = findSketch(ef->sketchId()))
         {
-          if (auto sk = findSketch(ef->sketchId()))
-          {
-            ef->setSketch(sk);
-          }
+          ef->bindSketch(sk);
+          if (lacksResult(ef)) ef->markDirty();
         }
       }
-      // Resolve MoveFeature source by id; allow using suppressed sources as providers
-      if (Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f); !mf.IsNull())
+    }
+    int up = -1;
+    // Resolve MoveFeature source by id among previous items; suppressed sources are valid providers
+    if (Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f); !mf.IsNull())
+    {
+      if (mf->source().IsNull() && mf->sourceId() != 0)
+      {
+        auto fit = featureIndex.find(mf->sourceId());
+        if (fit != featureIndex.end())
+        {
+          mf->bindSource(feats[fit->second]);
+          if (lacksResult(mf)) mf->markDirty();
+        }
+      }
+      if (!mf->source().IsNull())
       {
-        if (mf->source().IsNull() && mf->sourceId() != 0)
+        auto fit = featureIndex.find(mf->source()->id());
+        if (fit != featureIndex.end() && feats[fit->second] == mf->source())
         {
-          Handle(Feature) src;
-          auto fit = featureById.find(mf->sourceId());
-          if (fit != featureById.end())
-          {
-            src = fit->second;
-          }
-          if (src.IsNull())
-          {
-            // search previous items for a feature with the same id (even if suppressed)
-            for (NCollection_Sequence<Handle(DocumentItem)>::Iterator jt(m_items); jt.More(); jt.Next())
-            {
-              const Handle(DocumentItem)& prev = jt.Value();
-              if (prev == di) break; // stop at current
-              Handle(Feature) pf = Handle(Feature)::DownCast(prev);
-              if (!pf.IsNull() && pf->id() == mf->sourceId()) { src = pf; break; }
-            }
-          }
-          if (!src.IsNull())
-          {
-            // ensure source has valid shape, even if suppressed
-            if (src->shape().IsNull()) { src->execute(); }
-            mf->setSource(src);
-          }
+          up = fit->second;
         }
       }
-      f->execute();
-      // cache executed (non-suppressed and also MoveFeature) for downstream consumers
-      featureById[f->id()] = f;
+    }
+    featureIndex[f->id()] = static_cast<int>(feats.size());
+    feats.push_back(f);
+    upstream.push_back(up);
+  }
+
+  // Content keys for the result cache: own inputs chained with the upstream key (0 = not cacheable,
+  // e.g. a move whose source lives outside this document). inputHash() is memoized per revision,
+  // so unchanged features cost a lookup here, not a walk of their sketch
+  std::vector<std::uint64_t> keys;
+  if (m_resultCache)
+  {
+    keys.resize(feats.size(), 0);
+    for (std::size_t i = 0; i < feats.size(); ++i)
+    {
+      Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(feats[i]);
+      if (upstream[i] < 0 && !mf.IsNull() && !mf->source().IsNull()) continue;
+      if (upstream[i] >= 0 && keys[upstream[i]] == 0) continue;
+      InputHasher h;
+      h.add(feats[i]->inputHash());
+      if (upstream[i] >= 0) h.add(keys[upstream[i]]);
+      keys[i] = h.value();
+    }
+  }
+  rebuildGraph();
+
+  const std::size_t n = feats.size();
+  // A suppressed move read by exactly one consumer is a collapsible chain link: the consumer
+  // composes the link's transform instead of waiting for the link's own result
+  std::vector<int> consumerCount(n, 0);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    if (upstream[i] >= 0) ++consumerCount[upstream[i]];
+  }
+  // Demanded features: the explicit request, or every displayed (unsuppressed, active) feature
+  std::vector<char> demanded(n, 0);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    demanded[i] = demand ? demand->count(feats[i]->id()) != 0 : isDisplayed(feats[i]);
+  }
+  std::vector<char> collapsible(n, 0);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    // An explicitly requested link needs its own result
+    collapsible[i] = feats[i]->isSuppressed() && upstream[i] >= 0 && consumerCount[i] == 1
+                  && !Handle(MoveFeature)::DownCast(feats[i]).IsNull() && !demanded[i];
+  }
+
+  // Forward pass: a feature is stale when dirty or when its upstream is stale; a deferred link
+  // that can no longer be collapsed has to be materialized
+  std::vector<char> stale(n, 0);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(feats[i]);
+    stale[i] = feats[i]->isDirty() || (upstream[i] >= 0 && stale[upstream[i]])
+            || (!mf.IsNull() && mf->isDeferred() && !collapsible[i]);
+  }
+  // Backward pass: a feature is needed when demanded, or when a needed consumer reads it
+  std::vector<char> needed(n, 0);
+  for (std::size_t i = n; i-- > 0;)
+  {
+    if (demanded[i]) needed[i] = 1;
+    if (needed[i] && upstream[i] >= 0) needed[upstream[i]] = 1;
+  }
+
+  // Collect features to execute; needed features that are up to date are reused as-is
+  RecomputeStats           stats;
+  std::vector<std::size_t> tasks;
+  std::vector<int>         taskOf(n, -1);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    if (!stale[i])
+    {
+      if (needed[i]) ++stats.skipped;
+      continue;
+    }
+    if (!needed[i])
+    {
+      // Keep staleness so the feature re-executes once something needs it
+      if (!feats[i]->isDirty()) feats[i]->markDirty();
+      ++stats.notNeeded;
+      continue;
+    }
+    if (collapsible[i])
+    {
+      // Folded into the consumer's composed transform below
+      feats[i]->clearDirty();
+      continue;
+    }
+    taskOf[i] = static_cast<int>(tasks.size());
+    tasks.push_back(i);
+  }
+
+  // Moves reading a collapsed link start from the first non-collapsible ancestor (chain root);
+  // the links in between drop their results and are materialized lazily if ever read
+  std::vector<int>     chainRoot(tasks.size(), -1);
+  std::vector<gp_Trsf> chainTrsf(tasks.size());
+  for (std::size_t t = 0; t < tasks.size(); ++t)
+  {
+    const std::size_t i = tasks[t];
+    if (upstream[i] < 0 || !collapsible[upstream[i]]) continue;
+    gp_Trsf composed = Handle(MoveFeature)::DownCast(feats[i])->transform();
+    int     r        = upstream[i];
+    while (collapsible[r])
+    {
+      Handle(MoveFeature) link = Handle(MoveFeature)::DownCast(feats[r]);
+      // An up-to-date link already holds its result: start from there
+      if (!stale[r] && !link->isDeferred()) break;
+      composed.Multiply(link->transform());
+      link->defer();
+      ++stats.collapsed;
+      r = upstream[r];
+    }
+    chainRoot[t] = r;
+    chainTrsf[t] = composed;
+  }
+
+  // Schedule along the DAG: a move waits for its source; extrudes sharing a sketch are chained
+  // because Sketch keeps a mutable connectivity cache while exporting wires
+  TaskGraph graph(tasks.size());
+  std::unordered_map<const Sketch*, std::size_t> lastSketchUser;
+  for (std::size_t t = 0; t < tasks.size(); ++t)
+  {
+    const std::size_t i  = tasks[t];
+    const int         up = chainRoot[t] >= 0 ? chainRoot[t] : upstream[i];
+    if (up >= 0 && taskOf[up] >= 0)
+    {
+      graph.addEdge(static_cast<std::size_t>(taskOf[up]), t);
+    }
+    if (Handle(ExtrudeFeature) ef = Handle(ExtrudeFeature)::DownCast(feats[i]); !ef.IsNull() && ef->sketch())
+    {
+      auto [it, isNew] = lastSketchUser.emplace(ef->sketch().get(), t);
+      if (!isNew)
+      {
+        graph.addEdge(it->second, t);
+        it->second = t;
+      }
     }
   }
+  // Upstream results read by tasks are rebuilt here if evicted: lazy rematerialization is not
+  // safe from parallel workers sharing a source
+  for (std::size_t t = 0; t < tasks.size(); ++t)
+  {
+    const int up = chainRoot[t] >= 0 ? chainRoot[t] : upstream[tasks[t]];
+    if (up >= 0 && taskOf[up] < 0 && feats[up]->isEvicted()) feats[up]->shape();
+  }
+
+  // One progress step per task, split up front: ranges are handed to worker threads, the
+  // indicator is only polled for UserBreak() and incremented (thread-safe in OCCT)
+  Message_ProgressScope progress(theRange, "Recompute", static_cast<double>(std::max<std::size_t>(tasks.size(), 1)));
+  std::vector<Message_ProgressRange> ranges;
+  ranges.reserve(tasks.size());
+  for (std::size_t t = 0; t < tasks.size(); ++t) ranges.push_back(progress.Next());
+  std::vector<char>        done(tasks.size(), 0);
+  std::vector<char>        hit(tasks.size(), 0);
+  std::vector<double>      executeMs(tasks.size(), 0.0);
+  std::vector<RecomputeProfile::Entry> samples(m_profiling ? tasks.size() : 0);
+  std::atomic<std::size_t> cacheHits{0};
+  std::atomic<std::size_t> cancelled{0};
+  graph.run(
+    [&](std::size_t t) {
+      const Handle(Feature)& f = feats[tasks[t]];
+      CAD_TRACE_SCOPE("feature", f->DynamicType()->Name());
+      if (progress.UserBreak())
+      {
+        ++cancelled;
+        return;
+      }
+      TaskClock clock;
+      if (!samples.empty()) clock.start();
+      f->discardEvicted(); // recomputed below
+      const std::uint64_t key = keys.empty() ? 0 : keys[tasks[t]];
+      TopoDS_Shape cached;
+      if (key != 0 && m_resultCache->find(key, cached))
+      {
+        f->setShape(cached);
+        ++cacheHits;
+        hit[t] = 1;
+      }
+      else
+      {
+        const auto executeStart = std::chrono::steady_clock::now();
+        if (chainRoot[t] >= 0)
+          Handle(MoveFeature)::DownCast(f)->executeComposed(feats[chainRoot[t]]->shape(), chainTrsf[t]);
+        else
+          f->execute(ranges[t]);
+        executeMs[t] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - executeStart).count();
+        if (progress.UserBreak())
+        {
+          // Possibly interrupted inside the kernel: neither cached nor marked up to date
+          ++cancelled;
+          return;
+        }
+        if (key != 0) m_resultCache->insert(key, f->shape());
+      }
+      f->clearDirty();
+      done[t] = 1;
+      if (!samples.empty()) clock.stop(samples[t], f->shape());
+    },
+    m_recomputeThreads);
+  stats.cacheHits = cacheHits;
+  stats.cancelled = cancelled;
+  stats.executed  = tasks.size() - stats.cacheHits - stats.cancelled;
+  m_lastStats = stats;
+  m_totalExecuted += stats.executed;
+
+  if (m_profiling)
+  {
+    auto profile = std::make_shared<RecomputeProfile>();
+    profile->threads = std::max(1, m_recomputeThreads);
+    profile->entries.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const int                t = taskOf[i];
+      RecomputeProfile::Entry e = t >= 0 ? samples[static_cast<std::size_t>(t)] : RecomputeProfile::Entry();
+      e.id   = feats[i]->id();
+      e.type = feats[i]->DynamicType()->Name();
+      e.name = feats[i]->name().ToCString();
+      if (t >= 0)
+        e.outcome = !done[t] ? RecomputeProfile::Outcome::Cancelled
+                  : hit[t]   ? RecomputeProfile::Outcome::CacheHit
+                             : RecomputeProfile::Outcome::Executed;
+      else if (!stale[i])
+        e.outcome = RecomputeProfile::Outcome::UpToDate;
+      else if (!needed[i])
+        e.outcome = RecomputeProfile::Outcome::NotNeeded;
+      else
+        e.outcome = RecomputeProfile::Outcome::Collapsed;
+      profile->entries.push_back(std::move(e));
+    }
+    profile->totalWallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    m_profile = std::move(profile);
+  }
+
+  if (!m_listeners.empty())
+  {
+    for (std::size_t t = 0; t < tasks.size(); ++t)
+    {
+      if (done[t]) m_resultChanged.insert(feats[tasks[t]]->id());
+    }
+  }
+  ++m_useTick;
+  for (std::size_t t = 0; t < tasks.size(); ++t)
+  {
+    if (!done[t]) continue;
+    if (!hit[t]) m_executeMs[feats[tasks[t]]->id()] = executeMs[t];
+    m_lastUse[feats[tasks[t]]->id()] = m_useTick;
+    const int up = chainRoot[t] >= 0 ? chainRoot[t] : upstream[tasks[t]];
+    if (up >= 0) m_lastUse[feats[up]->id()] = m_useTick;
+  }
+  enforceResultBudget();
+  notifyChanges();
 }
 
-void Document::removeLast()
+std::size_t Document::residentResultBytes()
 {
-  if (!m_items.IsEmpty())
+  std::unordered_map<DocumentItem::Id, ResidentResult> next;
+  next.reserve(m_resident.size());
+  std::unordered_set<const void*> counted;
+  std::size_t                     total = 0;
+  for (Timeline::FeatureView::Iterator it(m_items.features()); it.More(); it.Next())
   {
-    m_items.Remove(m_items.Size());
-    m_featuresCacheDirty = true;
+    const Handle(Feature)& f = it.Value();
+    total += f->compactedBytes();
+    const TopoDS_Shape& shape = f->heldShape();
+    if (shape.IsNull()) continue;
+    // Moves relocate their source's TShape: count it once. Sub-shapes shared between distinct
+    // results are counted per result, so the total bounds the MemoryReport total from above
+    ResidentResult r{shape.TShape(), 0};
+    auto known = m_resident.find(f->id());
+    if (known != m_resident.end() && known->second.tshape == r.tshape)
+    {
+      r.bytes = known->second.bytes;
+    }
+    else
+    {
+      r.bytes = MemoryReport::estimate(shape).total();
+      ++m_evictionStats.estimated;
+    }
+    if (counted.insert(r.tshape.get()).second) total += r.bytes;
+    next.emplace(f->id(), std::move(r));
   }
+  m_resident.swap(next);
+  return total;
 }
 
-void Document::removeFeature(const Handle(Feature)& f)
+std::size_t Document::enforceResultBudget()
+{
+  if (m_resultBudget == 0)
+  {
+    m_resident.clear();
+    return 0;
+  }
+  std::size_t resident = residentResultBytes();
+  std::size_t released = 0;
+  if (resident > m_resultBudget)
+  {
+    // Exclusive bytes per feature need the sharing analysis of the full report
+    const MemoryReport report = MemoryReport::build(*this);
+    resident                  = report.features.total() + report.compacted;
+    struct Candidate
+    {
+      Handle(Feature) feature;
+      std::size_t     bytes;
+      std::uint64_t   lastUse;
+    };
+    std::vector<Candidate> candidates;
+    std::size_t            index = 0;
+    const std::vector<DocumentItem::Id>        pinnedList = checkpoints();
+    const std::unordered_set<DocumentItem::Id> pinned(pinnedList.begin(), pinnedList.end());
+    for (Timeline::FeatureView::Iterator it(m_items.features()); it.More(); it.Next(), ++index)
+    {
+      const Handle(Feature)& f = it.Value();
+      const std::size_t bytes  = report.entries[index].exclusive;
+      // Displayed results stay resident (the viewer holds them anyway), checkpoints bound the
+      // replay of evicted consumers; shared ones free nothing
+      if (isDisplayed(f) || pinned.count(f->id()) != 0 || f->heldShape().IsNull() || bytes == 0) continue;
+      auto use = m_lastUse.find(f->id());
+      candidates.push_back(Candidate{f, bytes, use == m_lastUse.end() ? 0 : use->second});
+    }
+    // Stale results first, then least recently used, larger first on ties
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+      if (a.feature->isDirty() != b.feature->isDirty()) return a.feature->isDirty();
+      if (a.lastUse != b.lastUse) return a.lastUse < b.lastUse;
+      return a.bytes > b.bytes;
+    });
+    for (const Candidate& c : candidates)
+    {
+      if (resident <= m_resultBudget) break;
+      const std::size_t blob  = c.feature->evictShape(m_evictionMode == EvictionMode::Compact);
+      m_resident.erase(c.feature->id()); // let the released TShape go
+      const std::size_t freed = c.bytes > blob ? c.bytes - blob : 0;
+      resident -= freed;
+      released += freed;
+      ++m_evictionStats.evicted;
+      if (blob != 0) ++m_evictionStats.compacted;
+    }
+  }
+  m_evictionStats.residentBytes = resident;
+  m_evictionStats.releasedBytes += released;
+  return released;
+}
+
+Document::EvictionStats Document::evictionStats() const
+{
+  EvictionStats st  = m_evictionStats;
+  st.rematerialized = 0;
+  st.compactBytes   = 0;
+  for (Timeline::FeatureView::Iterator it(m_items.features()); it.More(); it.Next())
+  {
+    st.rematerialized += it.Value()->rematerializeCount();
+    st.compactBytes += it.Value()->compactedBytes();
+  }
+  return st;
+}
+
+bool Document::adoptResult(DocumentItem::Id id, std::uint64_t revision, const TopoDS_Shape& shape, bool deferred)
+{
+  Handle(Feature) f = Handle(Feature)::DownCast(m_items.Find(id));
+  if (f.IsNull() || f->revision() != revision) return false;
+  Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f);
+  if (!mf.IsNull() && mf->source().IsNull() && mf->sourceId() != 0)
+  {
+    // A deferred link materializes from its source on access
+    mf->bindSource(Handle(Feature)::DownCast(m_items.Find(mf->sourceId())));
+  }
+  if (deferred && !mf.IsNull())
+    mf->defer();
+  else
+    f->setShape(shape);
+  f->clearDirty();
+  m_resultChanged.insert(id);
+  return true;
+}
+
+int Document::addChangeListener(ChangeListener fn)
+{
+  // The first listener starts from the current state; later ones share the same baseline
+  if (m_listeners.empty()) snapshotSeen();
+  const int token = m_nextListener++;
+  m_listeners.emplace_back(token, std::move(fn));
+  return token;
+}
+
+void Document::removeChangeListener(int token)
+{
+  m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(),
+                                   [token](const auto& l) { return l.first == token; }),
+                    m_listeners.end());
+}
+
+void Document::snapshotSeen()
+{
+  m_seen.clear();
+  m_seen.reserve(static_cast<std::size_t>(m_items.Size()));
+  for (Timeline::Iterator it(m_items); it.More(); it.Next())
+  {
+    m_seen.emplace(it.Value()->id(), Seen{it.Value(), it.Value()->revision()});
+  }
+  m_seenSketches.clear();
+  for (const auto& sk : m_sketchList) m_seenSketches.emplace_back(sk, sk->revision());
+  m_resultChanged.clear();
+}
+
+void Document::notifyChanges()
+{
+  CAD_TRACE_SCOPE("model", "Document::notifyChanges");
+  if (m_txnDepth > 0) return;
+  if (m_listeners.empty())
+  {
+    m_resultChanged.clear();
+    return;
+  }
+
+  // Diff against the last notified state: O(n) hash lookups, no geometry is touched
+  ChangeSet cs;
+  std::unordered_map<DocumentItem::Id, Seen> seen;
+  seen.reserve(static_cast<std::size_t>(m_items.Size()));
+  for (Timeline::Iterator it(m_items); it.More(); it.Next())
+  {
+    const Handle(DocumentItem)& item = it.Value();
+    const DocumentItem::Id      id   = item->id();
+    auto old = m_seen.find(id);
+    if (old == m_seen.end())
+    {
+      cs.added.push_back(id);
+    }
+    else
+    {
+      if (old->second.item != item || old->second.revision != item->revision() || m_resultChanged.count(id) != 0)
+        cs.modified.push_back(id);
+      m_seen.erase(old);
+    }
+    seen.emplace(id, Seen{item, item->revision()});
+  }
+  for (const auto& kv : m_seen) cs.removed.push_back(kv.first);
+  std::sort(cs.removed.begin(), cs.removed.end());
+  m_seen.swap(seen);
+
+  cs.sketchesChanged = m_seenSketches.size() != m_sketchList.size();
+  for (std::size_t i = 0; !cs.sketchesChanged && i < m_sketchList.size(); ++i)
+  {
+    cs.sketchesChanged = m_seenSketches[i].first != m_sketchList[i]
+                      || m_seenSketches[i].second != m_sketchList[i]->revision();
+  }
+  if (cs.sketchesChanged)
+  {
+    m_seenSketches.clear();
+    for (const auto& sk : m_sketchList) m_seenSketches.emplace_back(sk, sk->revision());
+  }
+  m_resultChanged.clear();
+
+  if (cs.empty()) return;
+  // Copy: a listener may add or remove listeners
+  const auto listeners = m_listeners;
+  for (const auto& l : listeners) l.second(cs);
+}
+
+void Document::beginTransaction()
+{
+  if (m_txnDepth++ > 0) return;
+  m_txnAborted = false;
+  // Rollback state: item blobs and results, so in-place edits can be reverted too
+  m_txnItems.clear();
+  m_txnItems.reserve(static_cast<std::size_t>(m_items.Size()));
+  for (Timeline::Iterator it(m_items); it.More(); it.Next())
+  {
+    TxnItem t;
+    t.item     = it.Value();
+    t.revision = t.item->revision();
+    t.blob     = t.item->serialize();
+    if (Handle(Feature) f = Handle(Feature)::DownCast(t.item); !f.IsNull())
+    {
+      t.shape = f->heldShape(); // an evicted result is recomputed after a rollback
+      t.dirty = f->isDirty() || f->isEvicted();
+      Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f);
+      t.deferred = !mf.IsNull() && mf->isDeferred();
+    }
+    m_txnItems.push_back(std::move(t));
+  }
+  m_txnSketches.clear();
+  for (const auto& sk : m_sketchList) m_txnSketches.push_back(TxnSketch{sk, sk->revision(), sk->serialize()});
+  m_txnRegistry   = m_registry;
+  m_txnRollback   = m_rollback;
+  m_txnRollbackId = m_rollbackId;
+}
+
+bool Document::commitTransaction()
+{
+  if (m_txnDepth == 0) return false;
+  if (m_txnAborted)
+  {
+    // The snapshot was restored by the rollback; the remaining levels only close
+    if (--m_txnDepth == 0) m_txnAborted = false;
+    return false;
+  }
+  if (--m_txnDepth > 0) return true;
+  m_txnItems.clear();
+  m_txnSketches.clear();
+  m_txnRegistry.clear();
+  // One recompute for the whole batch; it delivers the single ChangeSet
+  recompute();
+  return true;
+}
+
+void Document::rollbackTransaction()
 {
-  if (f.IsNull()) return;
-  for (int i = 1; i <= m_items.Size(); ++i)
+  if (m_txnDepth == 0) return;
+  // The first rollback restores the snapshot; enclosing levels then only close
+  const bool restored = m_txnAborted;
+  m_txnAborted        = --m_txnDepth > 0;
+  if (restored) return;
+  m_items.Clear();
+  for (TxnItem& t : m_txnItems)
   {
-    Handle(Feature) fi = Handle(Feature)::DownCast(m_items.Value(i));
-    if (!fi.IsNull() && fi == f)
+    if (t.item->revision() != t.revision)
     {
-      m_items.Remove(i);
-      m_featuresCacheDirty = true;
-      break;
+      t.item->deserialize(t.blob);
+      if (Handle(Feature) f = Handle(Feature)::DownCast(t.item); !f.IsNull())
+      {
+        // A folded link holds no result of its own; restoring its null shape would make it a chain root
+        if (t.deferred)
+          Handle(MoveFeature)::DownCast(f)->defer();
+        else
+          f->setShape(t.shape);
+        if (!t.dirty) f->clearDirty();
+      }
     }
+    m_items.Append(t.item);
+  }
+  m_sketchList.clear();
+  for (TxnSketch& t : m_txnSketches)
+  {
+    if (t.sketch->revision() != t.revision) t.sketch->deserialize(t.blob);
+    m_sketchList.push_back(t.sketch);
+  }
+  m_registry.swap(m_txnRegistry);
+  m_rollback   = m_txnRollback;
+  m_rollbackId = m_txnRollbackId;
+  m_txnItems.clear();
+  m_txnSketches.clear();
+  m_txnRegistry.clear();
+  m_graphDirty = true;
+}
+
+void Document::markDirty(const Handle(Feature)& f)
+{
+  if (!f.IsNull()) f->markDirty();
+}
+
+void Document::markDirty(DocumentItem::Id featureId)
+{
+  if (Handle(Feature) f = Handle(Feature)::DownCast(m_items.Find(featureId)); !f.IsNull())
+  {
+    f->markDirty();
+  }
+}
+
+void Document::markSketchDirty(DocumentItem::Id sketchId)
+{
+  // Consumers of a sketch are extrudes; their own consumers follow via staleness in recompute()
+  for (DocumentItem::Id consumer : dependents(sketchId))
+  {
+    markDirty(consumer);
+  }
+}
+
+std::vector<DocumentItem::Id> Document::dependents(DocumentItem::Id id) const
+{
+  if (m_graphDirty) rebuildGraph();
+  auto it = m_consumers.find(id);
+  if (it == m_consumers.end()) return {};
+  return it->second;
+}
+
+void Document::rebuildGraph() const
+{
+  m_consumers.clear();
+  for (Timeline::FeatureView::Iterator it(m_items.features()); it.More(); it.Next())
+  {
+    const Handle(Feature)& f = it.Value();
+    DocumentItem::Id up = 0;
+    if (Handle(ExtrudeFeature) ef = Handle(ExtrudeFeature)::DownCast(f); !ef.IsNull())
+      up = ef->sketchId();
+    else if (Handle(MoveFeature) mf = Handle(MoveFeature)::DownCast(f); !mf.IsNull())
+      up = mf->source().IsNull() ? mf->sourceId() : mf->source()->id();
+    if (up != 0) m_consumers[up].push_back(f->id());
   }
+  m_graphDirty = false;
 }
 
-void Document::addItem(const std::shared_ptr<DocumentItem>& item)
+void Document::removeLast()
 {
-  if (!item) return;
-  m_registry[item->id()] = item;
+  if (!m_items.IsEmpty())
+  {
+    unmarkRollback(m_items.Size());
+    m_items.Remove(m_items.Size());
+    m_graphDirty = true;
+  }
 }
 
-void Document::addSketch(const std::shared_ptr<Sketch>& s)
+void Document::removeFeature(const Handle(Feature)& f)
 {
-  if (!s) return;
+  if (f.IsNull() || m_items.Find(f->id()).get() != f.get()) return;
+  unmarkRollback(m_items.IndexOf(f->id()));
+  m_items.Remove(f->id());
+  m_graphDirty = true;
+}
+
+bool Document::addItem(const std::shared_ptr<DocumentItem>& item)
+{
+  if (!item || !m_registry.emplace(item->id(), item).second) return false;
+  m_ids.reserve(item->id());
+  return true;
+}
+
+bool Document::addSketch(const std::shared_ptr<Sketch>& s)
+{
+  // Register in the generic item registry for dependency resolution
+  if (!s || !m_registry.emplace(s->id(), s).second) return false;
+  m_ids.reserve(s->id());
   // Preserve insertion order for sketches
   m_sketchList.push_back(s);
-  // Register in the generic item registry for dependency resolution
-  m_registry[s->id()] = s;
+  return true;
 }
 
 std::shared_ptr<Sketch> Document::findSketch(DocumentItem::Id id) const
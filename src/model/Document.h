@@ -1,14 +1,21 @@
 #pragma once
 
 #include "Feature.h"
-#include <NCollection_Sequence.hxx>
+#include "RecomputeProfile.h"
+#include "Timeline.h"
 
 #include <DocumentItem.h>
+#include <IdAllocator.h>
+#include <functional>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 class Sketch;
+class FeatureResultCache;
 
 // Minimal parametric document: ordered list of features and recompute
 class Document
@@ -17,32 +24,286 @@ public:
   void clear();                                               // Remove all items
 
   // Timeline manipulation (ordered history)
-  void addItem(const Handle(DocumentItem)& item);             // Append an item
-  void insertItem(int index1, const Handle(DocumentItem)& item); // Insert at 1-based index
-  const NCollection_Sequence<Handle(DocumentItem)>& items() const { return m_items; }
-
-  // Convenience helpers for features
-  void addFeature(const Handle(Feature)& f) { addItem(Handle(DocumentItem)(f)); }
-  const NCollection_Sequence<Handle(Feature)>& features() const; // Filtered view of items()
-  void recompute();                                           // Execute features in order
+  // Edits return false, leaving the timeline unchanged, when the item is null or its id is taken
+  bool addItem(const Handle(DocumentItem)& item);             // Append an item
+  bool insertItem(int index1, const Handle(DocumentItem)& item); // Insert at 1-based index
+  const Timeline& items() const { return m_items; }
+  Handle(DocumentItem) findItem(DocumentItem::Id id) const { return m_items.Find(id); } // O(1) timeline lookup
+  int indexOf(DocumentItem::Id id) const { return m_items.IndexOf(id); } // 1-based position, 0 if absent
+
+  // Convenience helpers for features. With a rollback marker, addFeature() inserts right after it
+  // and moves the marker onto the new feature, so later items stay rolled back.
+  bool addFeature(const Handle(Feature)& f);
+  Timeline::FeatureView features() const { return m_items.features(); } // Live filtered view of items()
+  // Execute dirty features and their consumers. Cancellable: once theRange's indicator reports
+  // UserBreak(), tasks not started are skipped and interrupted ones keep their dirty flag.
+  void recompute(const Message_ProgressRange& theRange = Message_ProgressRange());
+
+  // Pull-based evaluation: bring only 'ids' and their transitive upstream closure up to date,
+  // suppressed ones included; stale features outside the closure stay dirty until requested.
+  // Up-to-date results are reused, so overlapping requests execute each feature once per change.
+  // Runs synchronously (no scheduler) and notifies like recompute().
+  void evaluate(const std::vector<DocumentItem::Id>& ids,
+                const Message_ProgressRange& theRange = Message_ProgressRange());
+
+  // Eager (default): recompute() demands every displayed (unsuppressed) feature.
+  // OnDemand: recompute() executes nothing; the viewer and exporters evaluate() what they need.
+  enum class EvaluationMode
+  {
+    Eager,
+    OnDemand,
+  };
+  void           setEvaluationMode(EvaluationMode mode) { m_evaluationMode = mode; }
+  EvaluationMode evaluationMode() const { return m_evaluationMode; }
+
+  // Rollback marker: the document shows the model as of a timeline position. Items after the
+  // marker keep their results but are neither displayed nor recomputed; they stay stale until the
+  // marker passes them again. Moving the marker executes nothing by itself: the following
+  // recompute() reuses held results and replays only what went stale meanwhile (evicted results
+  // rebuild from the nearest checkpoint). Rolled-back features are reported as modified.
+  void setRollbackPosition(int index1);  // last active item, 0 = before the first; -1 or >= Size(): none
+  void clearRollback() { setRollbackPosition(-1); }
+  bool hasRollback() const;
+  int  rollbackPosition() const;         // number of active items (items().Size() without marker)
+  bool isRolledBack(DocumentItem::Id id) const;
+  // Active and unsuppressed. A source suppressed by its Moves shows again while every one of
+  // them is behind the marker
+  bool isDisplayed(const Handle(Feature)& f) const;
+
+  // Checkpoints: with a result budget, results of suppressed and rolled-back features may be
+  // evicted. Walking each upstream chain, a result is pinned (kept resident) once rebuilding it
+  // from the previous resident result would replay more than 'ms' of measured execute() time,
+  // so spacing adapts to feature cost: dense over expensive features, sparse over cheap ones.
+  // 0 disables pinning.
+  void   setCheckpointInterval(double ms) { m_checkpointMs = ms; }
+  double checkpointInterval() const { return m_checkpointMs; }
+  std::vector<DocumentItem::Id> checkpoints() const; // pinned results, in timeline order
   void removeLast();                                          // Pop last item
   void removeFeature(const Handle(Feature)& f);               // Remove by handle (first match)
 
-  // Register and query DocumentItems (e.g., sketches) for dependency resolution
-  void addItem(const std::shared_ptr<DocumentItem>& item);
-  void addSketch(const std::shared_ptr<Sketch>& s);           // convenience wrapper
+  // Register and query DocumentItems (e.g., sketches) for dependency resolution; like the
+  // timeline edits, registration returns false when the item is null or its id is registered
+  bool addItem(const std::shared_ptr<DocumentItem>& item);
+  bool addSketch(const std::shared_ptr<Sketch>& s);           // convenience wrapper
   std::shared_ptr<Sketch> findSketch(DocumentItem::Id id) const;
   std::vector<std::shared_ptr<Sketch>> sketches() const;      // list registered sketches
 
+  // Per-document id space: every added item is reserved here, so items created under
+  // IdAllocator::Scope(doc.ids()) continue this document's sequence independently of other documents
+  IdAllocator& ids() { return m_ids; }
+  const IdAllocator& ids() const { return m_ids; }
+
+  // Incremental recompute: a dependency DAG is built from ExtrudeFeature::sketchId() and
+  // MoveFeature::sourceId() links; only dirty features and their downstream consumers re-execute.
+  // Chains of suppressed moves with a single consumer are collapsed into one composed transform.
+  void markDirty(const Handle(Feature)& f);                   // mark a single feature dirty
+  void markDirty(DocumentItem::Id featureId);                 // same, by id
+  void markSketchDirty(DocumentItem::Id sketchId);            // mark all features consuming the sketch
+  std::vector<DocumentItem::Id> dependents(DocumentItem::Id id) const; // direct downstream consumers
+
+  // Counters reported by the last recompute() call
+  struct RecomputeStats
+  {
+    std::size_t executed{0}; // features whose execute() ran
+    std::size_t skipped{0};  // features reused as up to date
+    std::size_t collapsed{0}; // suppressed move links folded into a composed chain transform
+    std::size_t cacheHits{0}; // stale features whose result came from the result cache
+    std::size_t cancelled{0}; // stale features left dirty because the recompute was cancelled
+    std::size_t notNeeded{0}; // stale features left dirty because nothing demanded them
+  };
+  const RecomputeStats& lastRecomputeStats() const { return m_lastStats; }
+
+  // Parallel recompute: independent timeline branches run on a worker pool once their upstream
+  // results are ready. 1 (default) or less keeps the deterministic single-threaded path.
+  void setRecomputeThreads(int nbThreads) { m_recomputeThreads = nbThreads; }
+  int  recomputeThreads() const { return m_recomputeThreads; }
+  std::size_t totalExecuted() const { return m_totalExecuted; } // execute() calls since construction
+
+  // Result memoization: stale features look up their result by content key (kind, params, link
+  // inputs, upstream keys) before executing. Null (default) disables; a cache may be shared.
+  void setResultCache(const std::shared_ptr<FeatureResultCache>& cache) { m_resultCache = cache; }
+  const std::shared_ptr<FeatureResultCache>& resultCache() const { return m_resultCache; }
+
+  // Profiling: when enabled, each recompute() records a RecomputeProfile (per-feature wall, CPU
+  // and KernelAPI time, topology counts, cache hits). Off by default; null until recorded.
+  void setProfiling(bool on) { m_profiling = on; }
+  bool profiling() const { return m_profiling; }
+  const std::shared_ptr<const RecomputeProfile>& lastProfile() const { return m_profile; }
+  // Profile measured on a copy of this document (BackgroundRecompute::apply)
+  void setLastProfile(std::shared_ptr<const RecomputeProfile> profile) { m_profile = std::move(profile); }
+
+  // Result memory budget: after each recompute, results of suppressed features (move sources,
+  // intermediate links, stale results nobody needs) are evicted coldest first until the estimated
+  // result memory (compacted blobs included) fits. Evicted shapes are dropped or compacted to a
+  // BinTools blob; shape() rebuilds them when a consumer or the viewer asks. The resident total
+  // keeps each result's estimate until the result changes; only an overrun builds the full
+  // MemoryReport, so only bytes no other feature shares count as released. 0 (default) disables.
+  enum class EvictionMode
+  {
+    Drop,    // rebuild by execute() (reads upstream shapes)
+    Compact, // keep a BinTools blob; rebuild by reading it
+  };
+  void setResultBudget(std::size_t bytes, EvictionMode mode = EvictionMode::Compact)
+  {
+    m_resultBudget = bytes;
+    m_evictionMode = mode;
+  }
+  std::size_t  resultBudget() const { return m_resultBudget; }
+  EvictionMode evictionMode() const { return m_evictionMode; }
+  // Evict until the budget holds (recompute() calls it); returns the estimated bytes released
+  std::size_t enforceResultBudget();
+
+  struct EvictionStats
+  {
+    std::size_t evicted{0};        // results released so far
+    std::size_t compacted{0};      // of which kept as a blob
+    std::size_t rematerialized{0}; // evicted results of current features rebuilt on access
+    std::size_t releasedBytes{0};  // estimated bytes released so far (blob sizes deducted)
+    std::size_t residentBytes{0};  // estimated result memory after the last enforcement
+    std::size_t estimated{0};      // results walked to (re)estimate their footprint so far
+    std::size_t compactBytes{0};   // blob bytes currently held
+  };
+  EvictionStats evictionStats() const;
+
+  // Asynchronous mode: when a scheduler is set, recompute() hands the document to it (e.g.
+  // BackgroundRecompute::request) instead of executing, then notifies structural changes at once.
+  // Features keep their last good shapes until results are adopted with adoptResult().
+  using RecomputeScheduler = std::function<void(Document&)>;
+  void setRecomputeScheduler(RecomputeScheduler fn) { m_scheduler = std::move(fn); }
+  bool hasRecomputeScheduler() const { return static_cast<bool>(m_scheduler); }
+
+  // Adopt a result computed on a copy of this document. Ignored (false) when the feature was
+  // removed or edited since (revision differs). 'deferred' marks a collapsed move link.
+  bool adoptResult(DocumentItem::Id id, std::uint64_t revision, const TopoDS_Shape& shape, bool deferred = false);
+
+  // Change notification: listeners receive what changed since the previous notification.
+  // recompute() notifies when it finishes; notifyChanges() does so explicitly (e.g. after undo).
+  struct ChangeSet
+  {
+    std::vector<DocumentItem::Id> added;    // timeline items, in timeline order
+    std::vector<DocumentItem::Id> removed;
+    std::vector<DocumentItem::Id> modified; // inputs edited, result recomputed or object replaced
+    bool sketchesChanged{false};            // sketches() registry or a registered sketch changed
+    bool empty() const { return added.empty() && removed.empty() && modified.empty() && !sketchesChanged; }
+  };
+  using ChangeListener = std::function<void(const ChangeSet&)>;
+  int  addChangeListener(ChangeListener fn);  // returns a token; starts from the current state
+  void removeChangeListener(int token);
+  void notifyChanges();
+
+  // Transactions batch edits: inside one, recompute() and notifications are deferred, so the
+  // outermost commitTransaction() runs a single recompute and delivers a single ChangeSet.
+  // rollbackTransaction() restores the timeline, sketch registry and item states (cached shapes
+  // included) as of the outermost beginTransaction(), without notifying. A rollback at any depth
+  // aborts the whole batch: the enclosing levels stay open until they end, and their
+  // commitTransaction() returns false instead of recomputing. Edits made after the abort are not
+  // rolled back.
+  void beginTransaction();
+  bool commitTransaction(); // false when the batch was aborted by a rollback
+  void rollbackTransaction();
+  bool inTransaction() const { return m_txnDepth > 0; }
+  bool transactionAborted() const { return m_txnAborted; }
+
+  // Scoped transaction: rolls back unless commit() was called (e.g. when an edit throws)
+  class Transaction
+  {
+  public:
+    explicit Transaction(Document& doc) : m_doc(doc) { m_doc.beginTransaction(); }
+    ~Transaction() { if (!m_done) m_doc.rollbackTransaction(); }
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+    bool commit() { m_done = true; return m_doc.commitTransaction(); }
+
+  private:
+    Document& m_doc;
+    bool      m_done{false};
+  };
+
 private:
-  // Ordered document history (sketches, features, etc.)
-  NCollection_Sequence<Handle(DocumentItem)> m_items;
-  // Cached filtered view for features()
-  mutable NCollection_Sequence<Handle(Feature)> m_featuresCache;
-  mutable bool m_featuresCacheDirty{true};
+  void rebuildGraph() const;                                  // refresh m_consumers from timeline links
+  // Shared body of recompute()/evaluate(): demand == nullptr means every displayed feature
+  void run(const std::unordered_set<DocumentItem::Id>* demand, const Message_ProgressRange& theRange);
+  void unmarkRollback(int index1); // item index1 is about to be removed
+
+  // Ordered document history (sketches, features, etc.) with id index and feature view
+  Timeline m_items;
+  IdAllocator m_ids;
 
   // Item registry for non-handle items used for dependency resolution (e.g., sketches held as std::shared_ptr)
   std::unordered_map<DocumentItem::Id, std::shared_ptr<DocumentItem>> m_registry;
   // Ordered list of sketches preserving insertion order
   std::vector<std::shared_ptr<Sketch>> m_sketchList;
+
+  // Dependency DAG: upstream id (feature or sketch) -> consumer feature ids, in timeline order
+  mutable std::unordered_map<DocumentItem::Id, std::vector<DocumentItem::Id>> m_consumers;
+  mutable bool m_graphDirty{true};
+
+  // Change tracking: state as of the last notification, and features whose result changed since
+  struct Seen
+  {
+    Handle(DocumentItem) item;
+    std::uint64_t        revision{0};
+  };
+  void snapshotSeen();
+  std::vector<std::pair<int, ChangeListener>>      m_listeners;
+  int                                              m_nextListener{1};
+  std::unordered_map<DocumentItem::Id, Seen>       m_seen;
+  std::vector<std::pair<std::shared_ptr<Sketch>, std::uint64_t>> m_seenSketches;
+  std::unordered_set<DocumentItem::Id>             m_resultChanged;
+
+  // Open transaction: depth, deferred work and the state to restore on rollback
+  struct TxnItem
+  {
+    Handle(DocumentItem) item;
+    std::uint64_t        revision{0};
+    std::string          blob;
+    TopoDS_Shape         shape;
+    bool                 dirty{false};
+    bool                 deferred{false}; // collapsed move link: restored by defer(), not setShape()
+  };
+  struct TxnSketch
+  {
+    std::shared_ptr<Sketch> sketch;
+    std::uint64_t           revision{0};
+    std::string             blob;
+  };
+  int                    m_txnDepth{0};
+  bool                   m_txnAborted{false};
+  std::vector<TxnItem>   m_txnItems;
+  std::vector<TxnSketch> m_txnSketches;
+  std::unordered_map<DocumentItem::Id, std::shared_ptr<DocumentItem>> m_txnRegistry;
+  bool                   m_txnRollback{false};
+  DocumentItem::Id       m_txnRollbackId{0};
+
+  // Rollback marker: last active item (0 = before the first item)
+  bool             m_rollback{false};
+  DocumentItem::Id m_rollbackId{0};
+
+  RecomputeScheduler m_scheduler;
+  EvaluationMode     m_evaluationMode{EvaluationMode::Eager};
+  bool               m_profiling{false};
+  std::shared_ptr<const RecomputeProfile> m_profile;
+
+  std::size_t                                  m_resultBudget{0};
+  EvictionMode                                 m_evictionMode{EvictionMode::Compact};
+  EvictionStats                                m_evictionStats;
+  std::uint64_t                                m_useTick{0};
+  std::unordered_map<DocumentItem::Id, std::uint64_t> m_lastUse; // recompute tick a result was last produced or read
+  // Footprint estimate of each held result, keyed by its TShape: re-estimated only when it changes.
+  // The handle pins the TShape so its address cannot be reused by a later result; entries are
+  // replaced at each enforcement and dropped for evicted results
+  struct ResidentResult
+  {
+    Handle(TopoDS_TShape) tshape;
+    std::size_t           bytes{0};
+  };
+  std::unordered_map<DocumentItem::Id, ResidentResult> m_resident;
+  std::size_t residentResultBytes(); // held results (shared TShapes once) plus compacted blobs
+  double                                       m_checkpointMs{20.0};
+  std::unordered_map<DocumentItem::Id, double> m_executeMs; // wall time of the last execute()
+
+  RecomputeStats m_lastStats;
+  int            m_recomputeThreads{1};
+  std::size_t    m_totalExecuted{0};
+  std::shared_ptr<FeatureResultCache> m_resultCache;
 };
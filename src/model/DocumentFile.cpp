@@ -0,0 +1,356 @@
+#include "DocumentFile.h"
+
+#include "Document.h"
+#include "Feature.h"
+#include "TaskGraph.h"
+#include <IdAllocator.h>
+#include <Sketch.h>
+
+#include <BinTools.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <streambuf>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+const char kMagic[8] = {'C', 'A', 'D', 'D', 'O', 'C', 'B', '1'};
+
+// Entries per load task: large enough to amortize scheduling, small enough to balance workers
+constexpr std::size_t kLoadChunk = 256;
+
+void putU32(std::string& out, std::uint32_t v)
+{
+  for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFFu));
+}
+
+void putU64(std::string& out, std::uint64_t v)
+{
+  for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFFu));
+}
+
+std::uint32_t getU32(const char* p)
+{
+  std::uint32_t v = 0;
+  for (int i = 3; i >= 0; --i) v = (v << 8) | static_cast<unsigned char>(p[i]);
+  return v;
+}
+
+std::uint64_t getU64(const char* p)
+{
+  std::uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) v = (v << 8) | static_cast<unsigned char>(p[i]);
+  return v;
+}
+
+// Read-only stream over a mapped byte range (no copy for BinTools::Read)
+class MemoryStreamBuf : public std::streambuf
+{
+public:
+  MemoryStreamBuf(const char* data, std::size_t size)
+  {
+    char* p = const_cast<char*>(data);
+    setg(p, p, p + size);
+  }
+};
+
+struct PendingEntry
+{
+  DocumentFile::Entry entry;
+  std::string         payload;
+  std::string         shape;
+};
+} // namespace
+
+bool DocumentFile::save(const Document& doc, const std::string& path, bool withShapes)
+{
+  std::vector<PendingEntry> pending;
+  pending.reserve(static_cast<std::size_t>(doc.items().Size()) + doc.sketches().size());
+  for (Timeline::Iterator it(doc.items()); it.More(); it.Next())
+  {
+    const Handle(DocumentItem)& item = it.Value();
+    PendingEntry p;
+    p.entry.id   = item->id();
+    p.entry.kind = item->kind();
+    p.entry.role = Role::TimelineItem;
+    p.payload    = item->serialize();
+    if (withShapes)
+    {
+      // Stale results are left out: loaded shapes are taken as up to date
+      if (Handle(Feature) f = Handle(Feature)::DownCast(item); !f.IsNull() && !f->isDirty() && !f->shape().IsNull())
+      {
+        std::ostringstream os;
+        BinTools::Write(f->shape(), os);
+        p.shape = os.str();
+      }
+    }
+    pending.push_back(std::move(p));
+  }
+  for (const auto& sk : doc.sketches())
+  {
+    PendingEntry p;
+    p.entry.id   = sk->id();
+    p.entry.kind = sk->kind();
+    p.entry.role = Role::Sketch;
+    p.payload    = sk->serialize();
+    pending.push_back(std::move(p));
+  }
+
+  // Header and index first, then payloads in entry order
+  std::uint64_t offset = kHeaderSize + kEntrySize * pending.size();
+  std::string head;
+  head.reserve(static_cast<std::size_t>(offset));
+  head.append(kMagic, sizeof(kMagic));
+  putU32(head, kVersion);
+  putU32(head, withShapes ? kFlagShapes : 0u);
+  putU64(head, pending.size());
+  putU64(head, kHeaderSize);
+  for (PendingEntry& p : pending)
+  {
+    p.entry.payloadOffset = offset;
+    p.entry.payloadSize   = p.payload.size();
+    offset += p.payload.size();
+    p.entry.shapeOffset = p.shape.empty() ? 0 : offset;
+    p.entry.shapeSize   = p.shape.size();
+    offset += p.shape.size();
+
+    putU64(head, p.entry.id);
+    putU32(head, static_cast<std::uint32_t>(p.entry.kind));
+    putU32(head, static_cast<std::uint32_t>(p.entry.role));
+    putU64(head, p.entry.payloadOffset);
+    putU64(head, p.entry.payloadSize);
+    putU64(head, p.entry.shapeOffset);
+    putU64(head, p.entry.shapeSize);
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) return false;
+  out.write(head.data(), static_cast<std::streamsize>(head.size()));
+  for (const PendingEntry& p : pending)
+  {
+    out.write(p.payload.data(), static_cast<std::streamsize>(p.payload.size()));
+    out.write(p.shape.data(), static_cast<std::streamsize>(p.shape.size()));
+  }
+  return static_cast<bool>(out);
+}
+
+DocumentFile::~DocumentFile()
+{
+  close();
+}
+
+bool DocumentFile::open(const std::string& path)
+{
+  close();
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+  {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) return false;
+  const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr)
+  {
+    CloseHandle(mapping);
+    return false;
+  }
+  m_mapHandle = mapping;
+  m_data      = static_cast<const char*>(view);
+  m_size      = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    ::close(fd);
+    return false;
+  }
+  void* view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED) return false;
+  m_data = static_cast<const char*>(view);
+  m_size = static_cast<std::size_t>(st.st_size);
+#endif
+
+  // Validate header and index bounds; item payloads are checked when loaded
+  if (m_size < kHeaderSize || std::memcmp(m_data, kMagic, sizeof(kMagic)) != 0
+      || getU32(m_data + 8) != kVersion)
+  {
+    close();
+    return false;
+  }
+  m_flags       = getU32(m_data + 12);
+  m_count       = getU64(m_data + 16);
+  m_indexOffset = getU64(m_data + 24);
+  if (m_indexOffset > m_size || m_count > (m_size - m_indexOffset) / kEntrySize)
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void DocumentFile::close()
+{
+  if (m_data != nullptr)
+  {
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(static_cast<HANDLE>(m_mapHandle));
+#else
+    ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+  }
+  m_data      = nullptr;
+  m_size      = 0;
+  m_count     = 0;
+  m_flags     = 0;
+  m_mapHandle = nullptr;
+  m_loaded    = 0;
+  m_idIndex.reset();
+}
+
+DocumentFile::Entry DocumentFile::entry(std::size_t index) const
+{
+  Entry e;
+  if (index >= size()) return e;
+  const char* p   = m_data + m_indexOffset + index * kEntrySize;
+  e.id            = getU64(p);
+  e.kind          = static_cast<DocumentItem::Kind>(getU32(p + 8));
+  e.role          = static_cast<Role>(getU32(p + 12));
+  e.payloadOffset = getU64(p + 16);
+  e.payloadSize   = getU64(p + 24);
+  e.shapeOffset   = getU64(p + 32);
+  e.shapeSize     = getU64(p + 40);
+  return e;
+}
+
+int DocumentFile::indexOf(DocumentItem::Id id) const
+{
+  if (!m_idIndex)
+  {
+    m_idIndex = std::make_unique<std::unordered_map<DocumentItem::Id, int>>();
+    m_idIndex->reserve(size());
+    for (std::size_t i = 0; i < size(); ++i)
+    {
+      // Timeline entries win over registry copies sharing the same id
+      m_idIndex->emplace(getU64(m_data + m_indexOffset + i * kEntrySize), static_cast<int>(i));
+    }
+  }
+  auto it = m_idIndex->find(id);
+  return it == m_idIndex->end() ? -1 : it->second;
+}
+
+std::string DocumentFile::payload(const Entry& e) const
+{
+  if (e.payloadOffset > m_size || e.payloadSize > m_size - e.payloadOffset) return std::string();
+  return std::string(m_data + e.payloadOffset, static_cast<std::size_t>(e.payloadSize));
+}
+
+Handle(DocumentItem) DocumentFile::loadItem(std::size_t index) const
+{
+  if (index >= size()) return Handle(DocumentItem)();
+  const Entry e = entry(index);
+  Handle(DocumentItem) item = DocumentItem::create(e.kind, e.id);
+  if (item.IsNull()) return item;
+  ++m_loaded;
+  item->deserialize(payload(e));
+  if (Handle(Feature) f = Handle(Feature)::DownCast(item); !f.IsNull() && e.shapeSize != 0)
+  {
+    const TopoDS_Shape shape = loadShape(index);
+    if (!shape.IsNull())
+    {
+      f->setShape(shape);
+      f->clearDirty();
+    }
+  }
+  return item;
+}
+
+std::shared_ptr<Sketch> DocumentFile::loadSketch(std::size_t index) const
+{
+  const Entry e = entry(index);
+  if (index >= size() || e.kind != DocumentItem::Kind::Sketch) return nullptr;
+  ++m_loaded;
+  auto sk = std::make_shared<Sketch>(e.id);
+  sk->deserialize(payload(e));
+  return sk;
+}
+
+TopoDS_Shape DocumentFile::loadShape(std::size_t index) const
+{
+  TopoDS_Shape shape;
+  const Entry e = entry(index);
+  if (e.shapeSize == 0 || e.shapeOffset > m_size || e.shapeSize > m_size - e.shapeOffset) return shape;
+  MemoryStreamBuf buf(m_data + e.shapeOffset, static_cast<std::size_t>(e.shapeSize));
+  std::istream is(&buf);
+  BinTools::Read(shape, is);
+  return shape;
+}
+
+bool DocumentFile::loadInto(Document& doc, int nbThreads) const
+{
+  if (!isOpen()) return false;
+  const std::size_t n = size();
+  std::vector<Handle(DocumentItem)>    items(n);
+  std::vector<std::shared_ptr<Sketch>> sketches(n);
+
+  // Parse + construct in parallel; each worker routes id reservations to the target document
+  IdAllocator& ids = doc.ids();
+  TaskGraph graph((n + kLoadChunk - 1) / kLoadChunk);
+  graph.run([&](std::size_t chunk) {
+    IdAllocator::Scope scope(ids);
+    const std::size_t end = std::min(n, (chunk + 1) * kLoadChunk);
+    for (std::size_t i = chunk * kLoadChunk; i < end; ++i)
+    {
+      if (entry(i).role == Role::Sketch)
+        sketches[i] = loadSketch(i);
+      else
+        items[i] = loadItem(i);
+    }
+  }, nbThreads);
+
+  // Validate before touching the document: a failed load leaves it as it was. A null entry
+  // failed to parse; the timeline and the sketch registry each need unique ids.
+  std::unordered_set<DocumentItem::Id> itemIds, sketchIds;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const bool ok = entry(i).role == Role::Sketch
+                  ? sketches[i] && sketchIds.insert(sketches[i]->id()).second
+                  : !items[i].IsNull() && itemIds.insert(items[i]->id()).second;
+    if (!ok) return false;
+  }
+
+  // Timeline edits are serial and in file order, so the result does not depend on nbThreads
+  doc.clear();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    if (entry(i).role == Role::Sketch)
+      doc.addSketch(sketches[i]);
+    else
+      doc.addItem(items[i]);
+  }
+  return true;
+}
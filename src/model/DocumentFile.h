@@ -0,0 +1,98 @@
+#pragma once
+
+#include <DocumentItem.h>
+#include <TopoDS_Shape.hxx>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class Document;
+class Sketch;
+
+// Binary, indexed container for a whole Document
+//
+// Layout (all integers little-endian):
+//   Header  (32 bytes): magic "CADDOCB1", u32 version, u32 flags, u64 entry count, u64 index offset
+//   Index   (48 bytes per entry): u64 id, u32 kind, u32 role, u64 payload offset, u64 payload size,
+//                                 u64 shape offset, u64 shape size (0 when no shape is embedded)
+//   Data    payloads (DocumentItem::serialize() blobs) and optional OCCT binary BRep shapes
+//
+// Entries are stored in timeline order, followed by registered sketches (role Sketch).
+// Reading maps the file into memory; open() only validates the header and the index, so large
+// documents are opened without touching item data until loadItem() asks for it.
+class DocumentFile
+{
+public:
+  enum class Role : std::uint32_t
+  {
+    TimelineItem = 1, // Document::items()
+    Sketch       = 2, // Document::sketches() registry
+  };
+
+  struct Entry
+  {
+    DocumentItem::Id   id{0};
+    DocumentItem::Kind kind{DocumentItem::Kind::Sketch};
+    Role               role{Role::TimelineItem};
+    std::uint64_t      payloadOffset{0};
+    std::uint64_t      payloadSize{0};
+    std::uint64_t      shapeOffset{0};
+    std::uint64_t      shapeSize{0};
+  };
+
+  // Write 'doc' to 'path'; withShapes embeds up-to-date feature results (with on-demand evaluation,
+  // Document::evaluate() the exported features first). Returns false on I/O error.
+  static bool save(const Document& doc, const std::string& path, bool withShapes = false);
+
+  DocumentFile() = default;
+  ~DocumentFile();
+  DocumentFile(const DocumentFile&) = delete;
+  DocumentFile& operator=(const DocumentFile&) = delete;
+
+  // Map a file and validate header + index; false for missing, truncated or foreign files
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return m_data != nullptr; }
+
+  std::size_t size() const { return static_cast<std::size_t>(m_count); }
+  Entry       entry(std::size_t index) const;              // decoded from the mapped index
+  int         indexOf(DocumentItem::Id id) const;          // -1 when absent (builds an id map once)
+  bool        hasShapes() const { return (m_flags & kFlagShapes) != 0; }
+
+  // Materialize one item; features get their embedded shape (when present) and are left clean.
+  // New ids are reserved in IdAllocator::current(); safe to call concurrently
+  Handle(DocumentItem) loadItem(std::size_t index) const;
+  std::shared_ptr<Sketch> loadSketch(std::size_t index) const; // registry sketches (shared ownership)
+  TopoDS_Shape loadShape(std::size_t index) const;         // null when not embedded
+
+  // Replace the contents of 'doc' with every entry of this file
+  // Items are parsed and constructed on nbThreads workers (TaskGraph), then appended in file order;
+  // persisted ids are reserved in doc.ids() only, so concurrent loads into different documents
+  // neither share nor perturb an id counter. Thread-safe for distinct target documents.
+  // Returns false, leaving 'doc' unchanged, when an entry fails to parse or repeats an id.
+  bool loadInto(Document& doc, int nbThreads = 1) const;
+
+  // Number of loadItem()/loadSketch() calls since open() (lazy-loading diagnostics)
+  std::size_t loadedItems() const { return m_loaded.load(std::memory_order_relaxed); }
+
+  static constexpr std::uint32_t kVersion     = 1;
+  static constexpr std::uint32_t kFlagShapes  = 1u;
+  static constexpr std::size_t   kHeaderSize  = 32;
+  static constexpr std::size_t   kEntrySize   = 48;
+
+private:
+  std::string payload(const Entry& e) const;
+
+  const char*   m_data{nullptr};
+  std::size_t   m_size{0};
+  std::uint64_t m_count{0};
+  std::uint64_t m_indexOffset{0};
+  std::uint32_t m_flags{0};
+  void*         m_mapHandle{nullptr}; // platform mapping object (Windows)
+  mutable std::atomic<std::size_t> m_loaded{0};
+  mutable std::unique_ptr<std::unordered_map<DocumentItem::Id, int>> m_idIndex;
+};
@@ -1,15 +1,16 @@
 #include "ExtrudeFeature.h"
+#include "FeatureResultCache.h"
 
 #include <KernelAPI.h>
 #include <Sketch.h>
+#include <TextCodec.h>
 #include <variant>
-#include <sstream>
 
 IMPLEMENT_STANDARD_RTTIEXT(ExtrudeFeature, Feature)
 
 namespace {
 const bool kExtrudeFeatureReg = [](){
-  DocumentItem::registerFactory(DocumentItem::Kind::ExtrudeFeature, [](){ return std::shared_ptr<DocumentItem>(new ExtrudeFeature()); });
+  DocumentItem::registerFactory(DocumentItem::Kind::ExtrudeFeature, []() -> DocumentItem* { return new ExtrudeFeature(); });
   return true;
 }();
 }
@@ -20,7 +21,7 @@ double ExtrudeFeature::distance() const
   return Feature::paramAsDouble(params(), Feature::ParamKey::Distance, 0.0);
 }
 
-void ExtrudeFeature::execute()
+void ExtrudeFeature::execute(const Message_ProgressRange& theRange)
 {
   if (!m_sketch)
   {
@@ -28,30 +29,63 @@ void ExtrudeFeature::execute()
     return;
   }
   const auto wires = m_sketch->toOcctWires();
-  m_shape = KernelAPI::extrude(wires, distance());
+  m_shape = KernelAPI::extrude(wires, distance(), theRange);
 }
 
-// Append base Feature encoding + extrude-specific fields
-std::string ExtrudeFeature::serialize() const
+std::uint64_t ExtrudeFeature::inputHash() const
 {
-  std::ostringstream os;
-  os << Feature::serialize();
-  os << "sketchId=" << m_sketchId << "\n";
-  return os.str();
+  const std::uint64_t sketchRevision = m_sketch ? m_sketch->revision() : 0;
+  if (m_hash != 0 && m_hashRevision == revision() && m_hashSketchRevision == sketchRevision) return m_hash;
+  m_hash               = hashInputs();
+  m_hashRevision       = revision();
+  m_hashSketchRevision = sketchRevision;
+  return m_hash;
 }
 
-void ExtrudeFeature::deserialize(const std::string& data)
+std::uint64_t ExtrudeFeature::hashInputs() const
 {
-  Feature::deserialize(data);
-  std::size_t pos = 0;
-  while (pos < data.size())
+  InputHasher h;
+  h.add(Feature::inputHash());
+  if (!m_sketch) return h.value();
+  // Profile content rather than the sketch id: an edited sketch must not hit an old result
+  for (const Sketch::Curve& c : m_sketch->curves())
   {
-    std::size_t eol = data.find('\n', pos);
-    std::string line = data.substr(pos, eol == std::string::npos ? std::string::npos : eol - pos);
-    pos = (eol == std::string::npos) ? data.size() : eol + 1;
-    if (line.rfind("sketchId=", 0) == 0)
+    h.add(static_cast<int>(c.type));
+    if (c.type == Sketch::CurveType::Line)
     {
-      m_sketchId = static_cast<DocumentItem::Id>(std::stoull(line.substr(9)));
+      h.add(c.line.p1.X()); h.add(c.line.p1.Y());
+      h.add(c.line.p2.X()); h.add(c.line.p2.Y());
     }
+    else
+    {
+      h.add(c.arc.center.X()); h.add(c.arc.center.Y());
+      h.add(c.arc.p1.X()); h.add(c.arc.p1.Y());
+      h.add(c.arc.p2.X()); h.add(c.arc.p2.Y());
+      h.add(c.arc.clockwise);
+    }
+  }
+  for (const Sketch::Constraint& k : m_sketch->constraints())
+  {
+    h.add(static_cast<int>(k.type));
+    h.add(static_cast<std::uint64_t>(k.a.curve)); h.add(k.a.endIndex);
+    h.add(static_cast<std::uint64_t>(k.b.curve)); h.add(k.b.endIndex);
+    h.add(k.value); h.add(k.point.X()); h.add(k.point.Y());
   }
+  return h.value();
+}
+
+// Append base Feature encoding + extrude-specific fields
+std::string ExtrudeFeature::serialize() const
+{
+  std::string out = Feature::serialize();
+  TextCodec::Writer(out).field("sketchId", m_sketchId);
+  return out;
+}
+
+void ExtrudeFeature::deserialize(const std::string& data)
+{
+  Feature::deserialize(data);
+  TextCodec::forEachKeyValue(data, [this](std::string_view key, std::string_view val) {
+    if (key == "sketchId") TextCodec::parse(val, m_sketchId);
+  });
 }
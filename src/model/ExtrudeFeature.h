@@ -17,28 +17,43 @@ class ExtrudeFeature : public Feature
   DEFINE_STANDARD_RTTIEXT(ExtrudeFeature, Feature)
 
 public:
-  ExtrudeFeature() = default;
+  // Parameter schema: extrusion distance along +Z
+  static constexpr ParamSpec kParamSchema[] = {{ParamKey::Distance, 0.0}};
+  ParamSchema paramSchema() const override { return kParamSchema; }
+
+  ExtrudeFeature() { resetParams(); }
 
   // ID-based constructor for upstream reference
   ExtrudeFeature(DocumentItem::Id sketchId, double distance)
-    : m_sketchId(sketchId) { setDistance(distance); }
+    : ExtrudeFeature() { m_sketchId = sketchId; setDistance(distance); }
 
-  void setSketch(const std::shared_ptr<Sketch>& sk) { m_sketch = sk; }
+  void setSketch(const std::shared_ptr<Sketch>& sk) { m_sketch = sk; markDirty(); }
+  // Attach the runtime sketch matching sketchId() (link resolution) without invalidating the result
+  void bindSketch(const std::shared_ptr<Sketch>& sk) { m_sketch = sk; }
   const std::shared_ptr<Sketch>& sketch() const { return m_sketch; }
 
   // ID-based linkage for serialization-friendly dependency tracking
-  void setSketchId(DocumentItem::Id id) { m_sketchId = id; }
+  void setSketchId(DocumentItem::Id id) { m_sketchId = id; markDirty(); }
   DocumentItem::Id sketchId() const { return m_sketchId; }
 
-  void setDistance(double d) { params()[Feature::ParamKey::Distance] = d; }
+  void setDistance(double d) { params().set(Feature::ParamKey::Distance, d); }
   double distance() const;
 
-  void execute() override;
+  void execute(const Message_ProgressRange& theRange = Message_ProgressRange()) override;
+  std::uint64_t inputHash() const override; // params + sketch geometry and constraints
 
 private:
   std::shared_ptr<Sketch> m_sketch; // runtime profile (optional)
   DocumentItem::Id        m_sketchId{0}; // persistent reference
 
+  // inputHash() memo: the profile is walked again only when this feature or its sketch changes
+  // revision (revisions are process-wide, so a different sketch never matches)
+  mutable std::uint64_t m_hash{0};
+  mutable std::uint64_t m_hashRevision{0};
+  mutable std::uint64_t m_hashSketchRevision{0};
+
+  std::uint64_t hashInputs() const;
+
 public:
   // DocumentItem
   Kind kind() const override { return Kind::ExtrudeFeature; }
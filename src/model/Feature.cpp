@@ -1,112 +1,151 @@
 #include "Feature.h"
+#include "FeatureResultCache.h"
+
+#include <TextCodec.h>
+
+#include <BinTools.hxx>
 
 #include <sstream>
+
 #include <string>
 #include <utility>
 
 IMPLEMENT_STANDARD_RTTIEXT(Feature, DocumentItem)
 // Very simple key=value; encoding for base fields and params; not robust JSON.
-// Keys: name, suppressed, p_<keyIndex> for numeric params (int/double), s_<keyIndex> for string params
-static std::string escape(const std::string& s)
-{
-  std::string out; out.reserve(s.size());
-  for (char c : s) { if (c == '\\' || c == '=') out.push_back('\\'); out.push_back(c); }
-  return out;
-}
-
+// Keys: name, suppressed, p_<keyIndex> for double params, i_<keyIndex> for int params,
+// s_<keyIndex> for string params. Older blobs wrote ints as p_ and still load (as doubles).
 static std::string toString(const TCollection_AsciiString& s)
 {
   return std::string(s.ToCString());
 }
 
-static TCollection_AsciiString toAscii(const std::string& s)
-{
-  return TCollection_AsciiString(s.c_str());
-}
-
 std::string Feature::serialize() const
 {
-  std::ostringstream os;
-  os << "name=" << escape(toString(m_name)) << "\n";
-  os << "suppressed=" << (m_suppressed ? 1 : 0) << "\n";
-  for (const auto& kv : m_params)
-  {
-    const int keyIdx = static_cast<int>(kv.first);
-    if (std::holds_alternative<int>(kv.second))
+  std::string out;
+  out.reserve(64 + 24 * m_params.size());
+  TextCodec::Writer w(out);
+  w.text("name=").escaped(m_name.ToCString()).ch('\n');
+  w.field("suppressed", m_suppressed ? 1 : 0);
+  m_params.forEach([&w](ParamKey key, const ParamValue& value) {
+    const int keyIdx = static_cast<int>(key);
+    if (std::holds_alternative<int>(value))
     {
-      os << "p_" << keyIdx << '=' << std::get<int>(kv.second) << "\n";
+      w.text("i_").num(keyIdx).ch('=').num(std::get<int>(value)).ch('\n');
     }
-    else if (std::holds_alternative<double>(kv.second))
+    else if (std::holds_alternative<double>(value))
     {
-      os << "p_" << keyIdx << '=' << std::get<double>(kv.second) << "\n";
+      w.text("p_").num(keyIdx).ch('=').num(std::get<double>(value)).ch('\n');
     }
     else
     {
-      os << "s_" << keyIdx << '=' << escape(toString(std::get<TCollection_AsciiString>(kv.second))) << "\n";
+      w.text("s_").num(keyIdx).ch('=').escaped(std::get<TCollection_AsciiString>(value).ToCString()).ch('\n');
     }
-  }
-  return os.str();
+  });
+  return out;
 }
 
 void Feature::deserialize(const std::string& data)
 {
-  m_params.clear();
-  std::string key, val;
-  std::size_t pos = 0;
-  while (pos < data.size())
-  {
-    std::size_t eol = data.find('\n', pos);
-    std::string line = data.substr(pos, eol == std::string::npos ? std::string::npos : eol - pos);
-    pos = (eol == std::string::npos) ? data.size() : eol + 1;
-    if (line.empty()) continue;
-    std::size_t eq = std::string::npos;
-    bool esc = false;
-    for (std::size_t i = 0; i < line.size(); ++i)
+  resetParams();
+  m_dirty = true;
+  touch();
+  std::string text; // scratch for escaped values, reused across lines
+  TextCodec::forEachKeyValue(data, [&](std::string_view key, std::string_view val) {
+    int idx = -1;
+    const bool indexed = key.size() > 2 && key[1] == '_' && TextCodec::parse(key.substr(2), idx)
+                         && idx >= 0 && idx < static_cast<int>(kParamKeyCount);
+    if (key == "name")
     {
-      if (!esc && line[i] == '=') { eq = i; break; }
-      esc = (!esc && line[i] == '\\');
+      TextCodec::unescape(val, text);
+      m_name = TCollection_AsciiString(text.c_str());
     }
-    if (eq == std::string::npos) continue;
-    key = line.substr(0, eq);
-    val.clear();
-    esc = false;
-    for (std::size_t i = eq + 1; i < line.size(); ++i)
+    else if (key == "suppressed") m_suppressed = (val == "1");
+    else if (!indexed) return;
+    else if (key[0] == 'p')
     {
-      char c = line[i];
-      if (!esc && c == '\\') { esc = true; continue; }
-      val.push_back(c); esc = false;
+      double d = 0.0;
+      if (TextCodec::parse(val, d)) m_params.set(static_cast<ParamKey>(idx), d);
     }
-
-    if (key == "name") m_name = toAscii(val);
-    else if (key == "suppressed") m_suppressed = (val == "1");
-    else if (key.rfind("p_", 0) == 0)
+    else if (key[0] == 'i')
     {
-      int idx = std::stoi(key.substr(2));
-      // try parse as double, then as int
-      try {
-        double d = std::stod(val);
-        m_params[static_cast<ParamKey>(idx)] = d;
-      } catch (...) {
-        try { int i = std::stoi(val); m_params[static_cast<ParamKey>(idx)] = i; } catch (...) {}
-      }
+      int i = 0;
+      if (TextCodec::parse(val, i)) m_params.set(static_cast<ParamKey>(idx), i);
     }
-    else if (key.rfind("s_", 0) == 0)
+    else if (key[0] == 's')
     {
-      int idx = std::stoi(key.substr(2));
-      m_params[static_cast<ParamKey>(idx)] = toAscii(val);
+      TextCodec::unescape(val, text);
+      m_params.set(static_cast<ParamKey>(idx), TCollection_AsciiString(text.c_str()));
     }
+  });
+}
+
+std::uint64_t Feature::inputHash() const
+{
+  InputHasher h;
+  h.add(static_cast<int>(kind()));
+  // forEach visits keys in ascending order, so equal parameters always hash alike
+  m_params.forEach([&h](ParamKey key, const ParamValue& value) {
+    h.add(static_cast<int>(key));
+    h.add(static_cast<int>(value.index()));
+    if (std::holds_alternative<int>(value))
+      h.add(std::get<int>(value));
+    else if (std::holds_alternative<double>(value))
+      h.add(std::get<double>(value));
+    else
+      h.add(toString(std::get<TCollection_AsciiString>(value)));
+  });
+  return h.value();
+}
+
+void Feature::resetParams()
+{
+  m_params.clear();
+  for (const ParamSpec& spec : paramSchema())
+  {
+    m_params.set(spec.key, spec.defaultValue);
   }
 }
 
-double Feature::paramAsDouble(const ParamMap& pm, ParamKey key, double defVal)
+std::size_t Feature::evictShape(bool compact)
 {
-  auto it = pm.find(key);
-  if (it == pm.end())
-    return defVal;
-  const ParamValue& v = it->second;
-  if (std::holds_alternative<double>(v))
-    return std::get<double>(v);
-  if (std::holds_alternative<int>(v))
-    return static_cast<double>(std::get<int>(v));
-  return defVal;
+  m_compacted.reset();
+  // A stale result is never rebuilt from its blob
+  if (compact && !m_dirty && !m_shape.IsNull())
+  {
+    std::ostringstream os;
+    BinTools::Write(m_shape, os);
+    m_compacted = std::make_shared<const std::string>(os.str());
+  }
+  m_shape.Nullify();
+  m_evicted.store(true, std::memory_order_release);
+  return compactedBytes();
+}
+
+void Feature::copyResultFrom(const Feature& other)
+{
+  m_shape     = other.m_shape;
+  m_evicted.store(other.isEvicted(), std::memory_order_release);
+  m_compacted = other.m_compacted;
+}
+
+void Feature::rematerialize() const
+{
+  std::lock_guard<std::mutex> lock(m_rebuildMutex);
+  if (!m_evicted.load(std::memory_order_relaxed)) return; // rebuilt by another reader
+  // Rebuilding restores the result the feature already had; only this reader writes it
+  Feature* self = const_cast<Feature*>(this);
+  std::shared_ptr<const std::string> blob = std::move(self->m_compacted);
+  // A blob of a stale result is never kept (evictShape); upstream shapes read by execute() may
+  // be stale too, hence the dirty flag stays
+  if (blob && !m_dirty)
+  {
+    std::istringstream is(*blob);
+    BinTools::Read(self->m_shape, is);
+  }
+  else
+  {
+    self->execute();
+  }
+  ++m_rematerialized;
+  m_evicted.store(false, std::memory_order_release);
 }
@@ -1,15 +1,20 @@
 #pragma once
 
+#include <Message_ProgressRange.hxx>
 #include <Standard_DefineHandle.hxx>
 #include <Standard_Transient.hxx>
 #include <TopoDS_Shape.hxx>
 #include <TCollection_AsciiString.hxx>
 
-#include <unordered_map>
-#include <variant>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include <DocumentItem.h>
+#include "ParamStore.h"
 
 class Feature;
 DEFINE_STANDARD_HANDLE(Feature, Standard_Transient)
@@ -37,34 +42,99 @@ public:
     Rz,
   };
 
-  struct ParamKeyHash
+  static constexpr std::size_t kParamKeyCount = static_cast<std::size_t>(ParamKey::Rz) + 1;
+
+  using ParamMap   = ParamStore<ParamKey, kParamKeyCount>; // inline storage indexed by ParamKey
+  using ParamValue = ParamMap::Value;                      // numeric or string param
+
+  // Compile-time parameter schema: each concrete type lists the keys it reads and their defaults
+  struct ParamSpec
   {
-    std::size_t operator()(ParamKey k) const noexcept { return static_cast<std::size_t>(k); }
+    ParamKey key;
+    double   defaultValue;
+  };
+  struct ParamSchema
+  {
+    const ParamSpec* first{nullptr};
+    std::size_t      count{0};
+
+    ParamSchema() = default;
+    template <std::size_t M>
+    constexpr ParamSchema(const ParamSpec (&specs)[M]) : first(specs), count(M) {}
+    const ParamSpec* begin() const { return first; }
+    const ParamSpec* end() const { return first + count; }
   };
-
-  using ParamValue = std::variant<int, double, TCollection_AsciiString>;     // numeric or string param
-  using ParamMap   = std::unordered_map<ParamKey, ParamValue, ParamKeyHash>; // keyed parameter map
 
   virtual ~Feature() = default;
 
-  // Compute the resulting shape using current parameters
-  virtual void execute() = 0;
+  // Compute the resulting shape using current parameters. Long kernel operations observe
+  // theRange: once its indicator reports UserBreak() the result is incomplete and must be discarded.
+  virtual void execute(const Message_ProgressRange& theRange = Message_ProgressRange()) = 0;
+
+  // Access computed shape; an evicted result is rematerialized first. Concurrent readers of one
+  // evicted result are safe: the first rebuilds it under a lock, the others wait for it
+  virtual const TopoDS_Shape& shape() const
+  {
+    if (m_evicted.load(std::memory_order_acquire)) rematerialize();
+    return m_shape;
+  }
 
-  // Access computed shape
-  virtual const TopoDS_Shape& shape() const { return m_shape; }
+  // Adopt a previously computed result instead of calling execute() (FeatureResultCache hit)
+  virtual void setShape(const TopoDS_Shape& s)
+  {
+    m_shape = s;
+    discardEvicted();
+  }
+
+  // Result eviction (Document::setResultBudget): the shape is released, optionally keeping a
+  // BinTools blob of it. The next shape() call rebuilds it from the blob or by execute(); a
+  // result that went stale meanwhile is executed from the current inputs and stays dirty, so
+  // the next recompute still runs it. Returns the blob size (0 when dropped).
+  std::size_t evictShape(bool compact);
+  bool        isEvicted() const { return m_evicted.load(std::memory_order_acquire); }
+  // Forget the evicted state without rebuilding (the result is about to be recomputed)
+  void discardEvicted()
+  {
+    m_evicted.store(false, std::memory_order_relaxed);
+    m_compacted.reset();
+  }
+  std::size_t compactedBytes() const { return m_compacted ? m_compacted->size() : 0; }
+  std::size_t rematerializeCount() const { return m_rematerialized; }
+  // Held result without rematerializing (null while evicted)
+  const TopoDS_Shape& heldShape() const { return m_shape; }
+  // Take over another feature's result, evicted state included (snapshot copies)
+  void copyResultFrom(const Feature& other);
+
+  // Stable hash of everything execute() reads besides the upstream result: kind and parameters,
+  // extended by subclasses with link-specific inputs. Never returns 0.
+  virtual std::uint64_t inputHash() const;
 
   // Optional: basic name and parameter accessors
   const TCollection_AsciiString& name() const { return m_name; }
 
-  void setName(const TCollection_AsciiString& theName) { m_name = theName; }
+  void setName(const TCollection_AsciiString& theName) { m_name = theName; touch(); }
+
+  // Declared parameters of the concrete type (empty for the abstract base)
+  virtual ParamSchema paramSchema() const { return ParamSchema(); }
 
   const ParamMap& params() const { return m_params; }
 
-  ParamMap& params() { return m_params; }
+  // Mutable access marks the feature dirty: any parameter edit invalidates the result
+  ParamMap& params()
+  {
+    m_dirty = true;
+    touch();
+    return m_params;
+  }
 
   // Suppression flag: suppressed features are skipped during recompute and not displayed
   bool isSuppressed() const { return m_suppressed; }
-  void setSuppressed(bool on) { m_suppressed = on; }
+  void setSuppressed(bool on) { m_suppressed = on; touch(); }
+
+  // Dirty flag: set when inputs change, cleared by Document::recompute() after execute()
+  bool isDirty() const { return m_dirty; }
+  void markDirty() { m_dirty = true; touch(); }
+  void clearDirty() { m_dirty = false; }
 
   // DocumentItem interface
   // Base Feature encodes common fields: name, suppressed flag, and params
@@ -77,7 +147,19 @@ protected:
   ParamMap                m_params;
   TopoDS_Shape            m_shape; // resulting shape
   bool                    m_suppressed = false; // execution/display suppressed
+  bool                    m_dirty = true; // result out of date with respect to inputs
+  mutable std::atomic<bool> m_evicted{false}; // m_shape released by evictShape()
+  std::shared_ptr<const std::string> m_compacted; // BinTools blob of the evicted shape (optional)
+  mutable std::size_t     m_rematerialized = 0;
+  mutable std::mutex      m_rebuildMutex; // serializes rematerialize()
+
+  // Rebuild an evicted result (blob, or execute() reading upstream shapes); m_evicted is
+  // cleared only once m_shape holds the result
+  void rematerialize() const;
+
+  // Reset parameters to the schema defaults (concrete constructors and deserialize)
+  void resetParams();
 
   // Helper: read numeric parameter as double (accepts int/double; otherwise returns defVal)
-  static double paramAsDouble(const ParamMap& pm, ParamKey key, double defVal);
+  static double paramAsDouble(const ParamMap& pm, ParamKey key, double defVal) { return pm.asDouble(key, defVal); }
 };
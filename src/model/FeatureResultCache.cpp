@@ -0,0 +1,115 @@
+#include "FeatureResultCache.h"
+
+#include <TopExp.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+namespace
+{
+// Average footprint of one sub-shape (TShape, geometry handle, list nodes) in the B-Rep
+constexpr std::size_t kBytesPerSubShape = 256;
+} // namespace
+
+FeatureResultCache::FeatureResultCache(std::size_t budgetBytes)
+  : m_budget(budgetBytes)
+{
+}
+
+bool FeatureResultCache::find(std::uint64_t key, TopoDS_Shape& shape)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_index.find(key);
+  if (it == m_index.end())
+  {
+    ++m_stats.misses;
+    return false;
+  }
+  m_lru.splice(m_lru.begin(), m_lru, it->second);
+  shape = it->second->shape;
+  ++m_stats.hits;
+  return true;
+}
+
+void FeatureResultCache::insert(std::uint64_t key, const TopoDS_Shape& shape)
+{
+  const std::size_t bytes = estimateBytes(shape);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (bytes > m_budget) return;
+  auto it = m_index.find(key);
+  if (it != m_index.end())
+  {
+    m_stats.bytes -= it->second->bytes;
+    it->second->shape = shape;
+    it->second->bytes = bytes;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+  }
+  else
+  {
+    m_lru.push_front(Entry{key, shape, bytes});
+    m_index.emplace(key, m_lru.begin());
+  }
+  m_stats.bytes += bytes;
+  ++m_stats.inserts;
+  evictToBudget();
+  m_stats.entries = m_index.size();
+}
+
+void FeatureResultCache::setBudget(std::size_t budgetBytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_budget = budgetBytes;
+  evictToBudget();
+  m_stats.entries = m_index.size();
+}
+
+void FeatureResultCache::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_lru.clear();
+  m_index.clear();
+  m_stats.bytes   = 0;
+  m_stats.entries = 0;
+}
+
+FeatureResultCache::Stats FeatureResultCache::stats() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+void FeatureResultCache::resetStats()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const std::size_t entries = m_stats.entries, bytes = m_stats.bytes;
+  m_stats         = Stats();
+  m_stats.entries = entries;
+  m_stats.bytes   = bytes;
+}
+
+std::vector<TopoDS_Shape> FeatureResultCache::shapes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<TopoDS_Shape> out;
+  out.reserve(m_lru.size());
+  for (const Entry& e : m_lru) out.push_back(e.shape);
+  return out;
+}
+
+std::size_t FeatureResultCache::estimateBytes(const TopoDS_Shape& shape)
+{
+  if (shape.IsNull()) return kBytesPerSubShape;
+  TopTools_IndexedMapOfShape subShapes;
+  TopExp::MapShapes(shape, subShapes);
+  return static_cast<std::size_t>(subShapes.Extent() + 1) * kBytesPerSubShape;
+}
+
+void FeatureResultCache::evictToBudget()
+{
+  while (m_stats.bytes > m_budget && !m_lru.empty())
+  {
+    const Entry& victim = m_lru.back();
+    m_stats.bytes -= victim.bytes;
+    m_index.erase(victim.key);
+    m_lru.pop_back();
+    ++m_stats.evictions;
+  }
+}
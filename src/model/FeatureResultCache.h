@@ -0,0 +1,105 @@
+#pragma once
+
+#include <TopoDS_Shape.hxx>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Stable 64-bit FNV-1a accumulator for feature input hashes
+// - Doubles are hashed by bit pattern (with -0.0 folded onto 0.0), so equal parameters give equal keys
+// - Values are stable across runs and platforms of the same endianness
+class InputHasher
+{
+public:
+  void addBytes(const void* data, std::size_t size)
+  {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      m_hash ^= p[i];
+      m_hash *= 1099511628211ull;
+    }
+  }
+  void add(std::uint64_t v) { addBytes(&v, sizeof(v)); }
+  void add(int v) { add(static_cast<std::uint64_t>(static_cast<std::int64_t>(v))); }
+  void add(bool v) { add(static_cast<std::uint64_t>(v ? 1 : 0)); }
+  void add(double v)
+  {
+    if (v == 0.0) v = 0.0;
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &v, sizeof(bits));
+    add(bits);
+  }
+  void add(const std::string& s)
+  {
+    add(static_cast<std::uint64_t>(s.size()));
+    addBytes(s.data(), s.size());
+  }
+
+  // Never 0: Document uses 0 for "not cacheable"
+  std::uint64_t value() const { return m_hash == 0 ? 1 : m_hash; }
+
+private:
+  std::uint64_t m_hash{14695981039346656037ull};
+};
+
+// Content-addressed memo of feature results shared across recomputes (and document rebuilds)
+// - Key: hash of feature kind, parameters, link-specific inputs and upstream keys (see Feature::inputHash)
+// - Entries are evicted least-recently-used first once the memory budget is exceeded
+// - Shape memory is estimated from the number of distinct sub-shapes; results sharing B-Rep with
+//   other entries (relocated moves) are therefore over-counted, which only makes eviction earlier
+// - Thread-safe: lookups and inserts may come from parallel recompute workers
+class FeatureResultCache
+{
+public:
+  struct Stats
+  {
+    std::size_t hits{0};
+    std::size_t misses{0};
+    std::size_t inserts{0};
+    std::size_t evictions{0};
+    std::size_t entries{0};
+    std::size_t bytes{0};   // estimated memory held by cached shapes
+  };
+
+  explicit FeatureResultCache(std::size_t budgetBytes = 256u << 20);
+
+  // Lookup: on hit copies the cached result into 'shape' and marks the entry most recently used
+  bool find(std::uint64_t key, TopoDS_Shape& shape);
+  // Store a result; entries larger than the whole budget are not kept
+  void insert(std::uint64_t key, const TopoDS_Shape& shape);
+
+  void        setBudget(std::size_t budgetBytes);
+  std::size_t budget() const { return m_budget; }
+  void        clear();
+
+  Stats stats() const;
+  void  resetStats();
+  // Copies of all cached results, most recently used first (memory reporting)
+  std::vector<TopoDS_Shape> shapes() const;
+
+  // Rough per-shape memory estimate used for the budget
+  static std::size_t estimateBytes(const TopoDS_Shape& shape);
+
+private:
+  struct Entry
+  {
+    std::uint64_t key;
+    TopoDS_Shape  shape;
+    std::size_t   bytes;
+  };
+
+  void evictToBudget(); // requires m_mutex
+
+  mutable std::mutex m_mutex;
+  std::list<Entry>   m_lru; // front = most recently used
+  std::unordered_map<std::uint64_t, std::list<Entry>::iterator> m_index;
+  std::size_t m_budget;
+  Stats       m_stats;
+};
@@ -0,0 +1,260 @@
+#include "MemoryReport.h"
+
+#include "Document.h"
+#include "FeatureResultCache.h"
+#include "UndoStack.h"
+
+#include <BRep_Tool.hxx>
+#include <Geom2d_BSplineCurve.hxx>
+#include <Geom_BSplineCurve.hxx>
+#include <Geom_BSplineSurface.hxx>
+#include <Geom_BezierCurve.hxx>
+#include <Geom_BezierSurface.hxx>
+#include <Geom_OffsetSurface.hxx>
+#include <Geom_RectangularTrimmedSurface.hxx>
+#include <Geom_TrimmedCurve.hxx>
+#include <Poly_Polygon3D.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Iterator.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+// Rough object sizes on a 64-bit build (object header, handles, containers)
+constexpr std::size_t kTShapeBytes    = 64;  // TopoDS_TShape + child list head
+constexpr std::size_t kTVertexBytes   = 96;  // point, tolerance, point representations
+constexpr std::size_t kTEdgeBytes     = 128; // tolerance, flags, curve representation list
+constexpr std::size_t kTFaceBytes     = 128; // surface handle, location, triangulation list
+constexpr std::size_t kChildBytes     = 48;  // TopoDS_Shape in a list node
+constexpr std::size_t kCurveRepBytes  = 64;  // BRep_Curve3D / BRep_CurveOnSurface record
+constexpr std::size_t kElementaryBytes = 128; // lines, circles, planes, cylinders, ...
+
+enum class Category
+{
+  Topology,
+  Geometry,
+  Mesh
+};
+
+struct Object
+{
+  std::size_t bytes{0};
+  Category    category{Category::Topology};
+};
+
+using ObjectMap = std::unordered_map<const void*, Object>;
+
+void addTo(MemoryReport::Bytes& b, const Object& o)
+{
+  switch (o.category)
+  {
+    case Category::Topology: b.topology += o.bytes; break;
+    case Category::Geometry: b.geometry += o.bytes; break;
+    case Category::Mesh: b.mesh += o.bytes; break;
+  }
+}
+
+// Walks a shape once, recording every distinct object it references
+class Collector
+{
+public:
+  explicit Collector(ObjectMap& out) : m_out(out) {}
+
+  void shape(const TopoDS_Shape& s)
+  {
+    if (s.IsNull()) return;
+    const TopAbs_ShapeEnum type = s.ShapeType();
+    std::size_t bytes = type == TopAbs_VERTEX ? kTVertexBytes
+                      : type == TopAbs_EDGE   ? kTEdgeBytes
+                      : type == TopAbs_FACE   ? kTFaceBytes
+                                              : kTShapeBytes;
+    bytes += static_cast<std::size_t>(s.NbChildren()) * kChildBytes;
+    if (!add(s.TShape().get(), bytes, Category::Topology)) return; // shared: already walked
+
+    if (type == TopAbs_FACE)
+    {
+      const TopoDS_Face& face = TopoDS::Face(s);
+      TopLoc_Location loc;
+      surface(BRep_Tool::Surface(face, loc));
+      const Handle(Poly_Triangulation)& tri = BRep_Tool::Triangulation(face, loc);
+      if (!tri.IsNull())
+      {
+        std::size_t perNode = 24; // gp_Pnt
+        if (tri->HasUVNodes()) perNode += 16;
+        if (tri->HasNormals()) perNode += 12;
+        add(tri.get(), 96 + static_cast<std::size_t>(tri->NbNodes()) * perNode
+                         + static_cast<std::size_t>(tri->NbTriangles()) * 12, Category::Mesh);
+      }
+      // P-curves live on the edges but only exist per (edge, face) pair. Planar faces may have
+      // none stored: BRep_Tool then builds a temporary one, which holds no memory of the shape
+      for (TopExp_Explorer ex(face, TopAbs_EDGE); ex.More(); ex.Next())
+      {
+        double f = 0.0, l = 0.0;
+        Standard_Boolean isStored = Standard_False;
+        const Handle(Geom2d_Curve) pc = BRep_Tool::CurveOnSurface(TopoDS::Edge(ex.Current()), face, f, l, &isStored);
+        if (pc.IsNull() || !isStored) continue;
+        std::size_t pcBytes = kCurveRepBytes + kElementaryBytes / 2;
+        if (Handle(Geom2d_BSplineCurve) bs = Handle(Geom2d_BSplineCurve)::DownCast(pc); !bs.IsNull())
+          pcBytes = kCurveRepBytes + 128 + static_cast<std::size_t>(bs->NbPoles()) * 16
+                  + static_cast<std::size_t>(bs->NbKnots()) * 12;
+        add(pc.get(), pcBytes, Category::Geometry);
+      }
+    }
+    else if (type == TopAbs_EDGE)
+    {
+      const TopoDS_Edge& edge = TopoDS::Edge(s);
+      TopLoc_Location loc;
+      double f = 0.0, l = 0.0;
+      curve(BRep_Tool::Curve(edge, loc, f, l));
+      const Handle(Poly_Polygon3D)& poly = BRep_Tool::Polygon3D(edge, loc);
+      if (!poly.IsNull()) add(poly.get(), 64 + static_cast<std::size_t>(poly->NbNodes()) * 32, Category::Mesh);
+    }
+
+    for (TopoDS_Iterator it(s, false, false); it.More(); it.Next()) shape(it.Value());
+  }
+
+private:
+  bool add(const void* key, std::size_t bytes, Category category)
+  {
+    return m_out.emplace(key, Object{bytes, category}).second;
+  }
+
+  void curve(const Handle(Geom_Curve)& c)
+  {
+    if (c.IsNull()) return;
+    if (Handle(Geom_TrimmedCurve) tc = Handle(Geom_TrimmedCurve)::DownCast(c); !tc.IsNull())
+    {
+      if (add(c.get(), kCurveRepBytes + 64, Category::Geometry)) curve(tc->BasisCurve());
+      return;
+    }
+    std::size_t bytes = kCurveRepBytes + kElementaryBytes;
+    if (Handle(Geom_BSplineCurve) bs = Handle(Geom_BSplineCurve)::DownCast(c); !bs.IsNull())
+      bytes = kCurveRepBytes + 160 + static_cast<std::size_t>(bs->NbPoles()) * (bs->IsRational() ? 32 : 24)
+            + static_cast<std::size_t>(bs->NbKnots()) * 12;
+    else if (Handle(Geom_BezierCurve) bz = Handle(Geom_BezierCurve)::DownCast(c); !bz.IsNull())
+      bytes = kCurveRepBytes + 96 + static_cast<std::size_t>(bz->NbPoles()) * 32;
+    add(c.get(), bytes, Category::Geometry);
+  }
+
+  void surface(const Handle(Geom_Surface)& s)
+  {
+    if (s.IsNull()) return;
+    if (Handle(Geom_RectangularTrimmedSurface) ts = Handle(Geom_RectangularTrimmedSurface)::DownCast(s); !ts.IsNull())
+    {
+      if (add(s.get(), 96, Category::Geometry)) surface(ts->BasisSurface());
+      return;
+    }
+    if (Handle(Geom_OffsetSurface) os = Handle(Geom_OffsetSurface)::DownCast(s); !os.IsNull())
+    {
+      if (add(s.get(), 128, Category::Geometry)) surface(os->BasisSurface());
+      return;
+    }
+    std::size_t bytes = kElementaryBytes;
+    if (Handle(Geom_BSplineSurface) bs = Handle(Geom_BSplineSurface)::DownCast(s); !bs.IsNull())
+      bytes = 256 + static_cast<std::size_t>(bs->NbUPoles()) * static_cast<std::size_t>(bs->NbVPoles()) * 32
+            + static_cast<std::size_t>(bs->NbUKnots() + bs->NbVKnots()) * 12;
+    else if (Handle(Geom_BezierSurface) bz = Handle(Geom_BezierSurface)::DownCast(s); !bz.IsNull())
+      bytes = 128 + static_cast<std::size_t>(bz->NbUPoles()) * static_cast<std::size_t>(bz->NbVPoles()) * 32;
+    add(s.get(), bytes, Category::Geometry);
+  }
+
+  ObjectMap& m_out;
+};
+
+// Objects of 'shapes' not present in 'known'; they are added to 'known'
+MemoryReport::Bytes unseen(const std::vector<TopoDS_Shape>& shapes, ObjectMap& known)
+{
+  ObjectMap objects;
+  Collector collector(objects);
+  for (const TopoDS_Shape& s : shapes) collector.shape(s);
+  MemoryReport::Bytes bytes;
+  for (const auto& [key, obj] : objects)
+  {
+    if (known.emplace(key, obj).second) addTo(bytes, obj);
+  }
+  return bytes;
+}
+} // namespace
+
+const MemoryReport::Entry* MemoryReport::find(DocumentItem::Id id) const
+{
+  for (const Entry& e : entries)
+  {
+    if (e.id == id) return &e;
+  }
+  return nullptr;
+}
+
+std::vector<const MemoryReport::Entry*> MemoryReport::top(std::size_t n) const
+{
+  std::vector<const Entry*> out;
+  out.reserve(entries.size());
+  for (const Entry& e : entries) out.push_back(&e);
+  n = std::min(n, out.size());
+  std::partial_sort(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(n), out.end(),
+                    [](const Entry* a, const Entry* b) { return a->attributed > b->attributed; });
+  out.resize(n);
+  return out;
+}
+
+MemoryReport::Bytes MemoryReport::estimate(const TopoDS_Shape& shape)
+{
+  ObjectMap objects;
+  Collector(objects).shape(shape);
+  Bytes bytes;
+  for (const auto& [key, obj] : objects) addTo(bytes, obj);
+  return bytes;
+}
+
+MemoryReport MemoryReport::build(const Document& doc, const UndoStack* undo)
+{
+  MemoryReport report;
+  // Pass 1: objects of each feature result, and how many features reference each object
+  std::vector<ObjectMap> perFeature;
+  std::unordered_map<const void*, std::size_t> refs;
+  for (Timeline::FeatureView::Iterator it(doc.features()); it.More(); it.Next())
+  {
+    const Handle(Feature)& f = it.Value();
+    Entry e;
+    e.id         = f->id();
+    e.type       = f->DynamicType()->Name();
+    e.name       = f->name().ToCString();
+    e.suppressed = f->isSuppressed();
+    e.evicted    = f->isEvicted();
+    e.compacted  = f->compactedBytes();
+    report.compacted += e.compacted;
+    // Held shape only: reading a deferred or evicted result would materialize it
+    ObjectMap objects;
+    Collector(objects).shape(f->heldShape());
+    for (const auto& kv : objects) ++refs[kv.first];
+    e.objects = objects.size();
+    report.entries.push_back(std::move(e));
+    perFeature.push_back(std::move(objects));
+  }
+
+  // Pass 2: split shared objects between their features
+  ObjectMap known;
+  for (std::size_t i = 0; i < perFeature.size(); ++i)
+  {
+    Entry& e = report.entries[i];
+    double attributed = 0.0;
+    for (const auto& [key, obj] : perFeature[i])
+    {
+      addTo(e.reachable, obj);
+      const std::size_t n = refs[key];
+      if (n == 1) e.exclusive += obj.bytes;
+      attributed += static_cast<double>(obj.bytes) / static_cast<double>(n);
+      if (known.emplace(key, obj).second) addTo(report.features, obj);
+    }
+    e.attributed = static_cast<std::size_t>(std::llround(attributed));
+  }
+
+  if (const auto& cache = doc.resultCache()) report.cache = unseen(cache->shapes(), known);
+  if (undo) report.undo = unseen(undo->retainedShapes(), known);
+  return report;
+}
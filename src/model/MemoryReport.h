@@ -0,0 +1,72 @@
+#pragma once
+
+#include <DocumentItem.h>
+#include <TopoDS_Shape.hxx>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Document;
+class UndoStack;
+
+// Approximate heap footprint of the computed shapes a document keeps alive
+// - Counted objects: B-Rep TShapes, geometry (3D curves, surfaces, p-curves) and meshes
+//   (face triangulations, edge polygons). Each is estimated from its type and size and counted
+//   once, however many shapes reference it (moves share their source's TShapes)
+// - Per feature: 'reachable' is everything its result references; 'exclusive' is the part no
+//   other feature references (what dropping the result would free); 'attributed' splits every
+//   shared object evenly between its features, so attributed bytes add up to 'features'
+// - 'cache' and 'undo' count objects kept alive only by the FeatureResultCache or UndoStack snapshots
+// - Deferred (collapsed) move links and evicted results hold no shape and report zero, apart
+//   from the blob an evicted result may keep; a deferred link's on-demand shape is not counted
+struct MemoryReport
+{
+  struct Bytes
+  {
+    std::size_t topology{0}; // TShapes and their sub-shape lists
+    std::size_t geometry{0}; // curves, surfaces, p-curves
+    std::size_t mesh{0};     // triangulations and polygons
+
+    std::size_t total() const { return topology + geometry + mesh; }
+    Bytes&      operator+=(const Bytes& o)
+    {
+      topology += o.topology;
+      geometry += o.geometry;
+      mesh += o.mesh;
+      return *this;
+    }
+  };
+
+  struct Entry
+  {
+    DocumentItem::Id id{0};
+    std::string      type;
+    std::string      name;
+    bool             suppressed{false};
+    bool             evicted{false};  // result released (Document::setResultBudget)
+    std::size_t      compacted{0};    // BinTools blob kept for an evicted result
+    Bytes            reachable;
+    std::size_t      exclusive{0};
+    std::size_t      attributed{0};
+    std::size_t      objects{0}; // distinct objects reachable from the result
+
+    std::size_t shared() const { return reachable.total() - exclusive; }
+  };
+
+  std::vector<Entry> entries; // timeline order
+  Bytes              features;
+  Bytes              cache;
+  Bytes              undo;
+  std::size_t        compacted{0}; // blobs of evicted results
+
+  std::size_t total() const { return features.total() + cache.total() + undo.total() + compacted; }
+  const Entry* find(DocumentItem::Id id) const;
+  // Largest consumers first by attributed bytes (at most n)
+  std::vector<const Entry*> top(std::size_t n) const;
+
+  // 'undo' may be null; the document's result cache is included when set
+  static MemoryReport build(const Document& doc, const UndoStack* undo = nullptr);
+  // Footprint of a single shape on its own
+  static Bytes estimate(const TopoDS_Shape& shape);
+};
@@ -1,75 +1,170 @@
 #include "MoveFeature.h"
+#include "FeatureResultCache.h"
 
 #include <DocumentItem.h>
+#include <TextCodec.h>
 #include <BRepBuilderAPI_Transform.hxx>
 #include <gp_Ax1.hxx>
 #include <gp_Trsf.hxx>
 #include <gp_Quaternion.hxx>
 #include <gp_EulerSequence.hxx>
 #include <gp.hxx>
+#include <Precision.hxx>
+#include <TopLoc_Location.hxx>
 
-#include <sstream>
 #include <cmath>
 
 IMPLEMENT_STANDARD_RTTIEXT(MoveFeature, Feature)
 
 namespace {
 const bool kMoveFeatureReg = [](){
-  DocumentItem::registerFactory(DocumentItem::Kind::MoveFeature, [](){ return std::shared_ptr<DocumentItem>(new MoveFeature()); });
+  DocumentItem::registerFactory(DocumentItem::Kind::MoveFeature, []() -> DocumentItem* { return new MoveFeature(); });
   return true;
 }();
 }
 
-void MoveFeature::execute()
+gp_Trsf MoveFeature::transform() const
 {
+  // If precise delta is provided (from manipulator), use it as-is to avoid
+  // ambiguities of Euler angle decomposition for combined rotations.
+  if (m_delta.Form() != gp_Identity)
+  {
+    return m_delta;
+  }
+  // Fallback: rebuild from params (Euler XYZ + T)
+  gp_Trsf trsf;
+  const double rx = rxDeg() * (M_PI / 180.0);
+  const double ry = ryDeg() * (M_PI / 180.0);
+  const double rz = rzDeg() * (M_PI / 180.0);
+  gp_Quaternion q; q.SetEulerAngles(gp_Intrinsic_XYZ, rx, ry, rz);
+  trsf.SetTransformation(q, gp_Vec(tx(), ty(), tz()));
+  return trsf;
+}
+
+std::uint64_t MoveFeature::inputHash() const
+{
+  InputHasher h;
+  h.add(Feature::inputHash());
+  h.add(m_shareGeometry);
+  if (m_delta.Form() != gp_Identity)
+  {
+    for (int r = 1; r <= 3; ++r)
+    {
+      for (int c = 1; c <= 4; ++c) h.add(m_delta.Value(r, c));
+    }
+  }
+  return h.value();
+}
+
+void MoveFeature::execute(const Message_ProgressRange&)
+{
+  // The evicted state is left to the caller: Document::recompute discards it, rematerialize()
+  // clears it once the result is in place
+  resetDeferred();
   if (m_source.IsNull())
   {
     m_shape = TopoDS_Shape();
     return;
   }
+  m_shape = applyTransform(m_source->shape(), transform());
+}
 
-  // If precise delta is provided (from manipulator), use it as-is to avoid
-  // ambiguities of Euler angle decomposition for combined rotations.
-  gp_Trsf trsf;
-  if (m_delta.Form() != gp_Identity)
+void MoveFeature::executeComposed(const TopoDS_Shape& rootShape, const gp_Trsf& composed)
+{
+  resetDeferred();
+  discardEvicted();
+  m_shape = applyTransform(rootShape, composed);
+}
+
+void MoveFeature::defer()
+{
+  resetDeferred();
+  m_deferred = true;
+  discardEvicted();
+  m_shape.Nullify();
+}
+
+void MoveFeature::resetDeferred()
+{
+  m_deferred = false;
+  m_lazyReady.store(false, std::memory_order_relaxed);
+  m_lazyShape.Nullify();
+}
+
+const TopoDS_Shape& MoveFeature::shape() const
+{
+  if (!m_deferred) return Feature::shape();
+  if (!m_lazyReady.load(std::memory_order_acquire))
   {
-    trsf = m_delta;
+    // Collapsed intermediate link: transform the source once (recurses up through deferred sources)
+    std::lock_guard<std::mutex> lock(m_lazyMutex);
+    if (!m_lazyReady.load(std::memory_order_relaxed))
+    {
+      if (!m_source.IsNull()) m_lazyShape = applyTransform(m_source->shape(), transform());
+      m_lazyReady.store(true, std::memory_order_release);
+    }
   }
-  else
+  return m_lazyShape;
+}
+
+TopoDS_Shape MoveFeature::applyTransform(const TopoDS_Shape& src, const gp_Trsf& trsf) const
+{
+  if (src.IsNull()) return TopoDS_Shape();
+  // Locations only carry rigid motions; scaling or mirroring needs a real geometry copy
+  const bool isRigid = std::abs(trsf.ScaleFactor() - 1.0) <= Precision::Confusion();
+  if (m_shareGeometry && isRigid)
   {
-    // Fallback: rebuild from params (Euler XYZ + T)
-    const double rx = rxDeg() * (M_PI / 180.0);
-    const double ry = ryDeg() * (M_PI / 180.0);
-    const double rz = rzDeg() * (M_PI / 180.0);
-    gp_Quaternion q; q.SetEulerAngles(gp_Intrinsic_XYZ, rx, ry, rz);
-    trsf.SetTransformation(q, gp_Vec(tx(), ty(), tz()));
+    return src.Moved(TopLoc_Location(trsf));
   }
-
-  BRepBuilderAPI_Transform tr(m_source->shape(), trsf, true);
-  m_shape = tr.Shape();
+  BRepBuilderAPI_Transform tr(src, trsf, true);
+  return tr.Shape();
 }
 
 // Append base Feature encoding + move-specific fields
 std::string MoveFeature::serialize() const
 {
-  std::ostringstream os;
-  os << Feature::serialize();
-  os << "sourceId=" << m_sourceId << "\n";
-  return os.str();
+  std::string out = Feature::serialize();
+  TextCodec::Writer w(out);
+  w.field("sourceId", m_sourceId);
+  if (!m_shareGeometry) w.text("share=0\n");
+  if (m_delta.Form() != gp_Identity)
+  {
+    // Exact manipulator delta (3x4 affine part), shortest round-trip form
+    w.text("delta=");
+    for (int r = 1; r <= 3; ++r)
+    {
+      for (int c = 1; c <= 4; ++c) w.num(m_delta.Value(r, c)).ch((r == 3 && c == 4) ? '\n' : ' ');
+    }
+  }
+  return out;
 }
 
 void MoveFeature::deserialize(const std::string& data)
 {
   Feature::deserialize(data);
-  std::size_t pos = 0;
-  while (pos < data.size())
-  {
-    std::size_t eol = data.find('\n', pos);
-    std::string line = data.substr(pos, eol == std::string::npos ? std::string::npos : eol - pos);
-    pos = (eol == std::string::npos) ? data.size() : eol + 1;
-    if (line.rfind("sourceId=", 0) == 0)
+  // Undo and rollback deserialize into live objects: absent fields mean defaults
+  m_sourceId      = 0;
+  m_delta         = gp_Trsf();
+  m_shareGeometry = true;
+  TextCodec::forEachKeyValue(data, [this](std::string_view key, std::string_view val) {
+    if (key == "sourceId")
     {
-      m_sourceId = static_cast<DocumentItem::Id>(std::stoull(line.substr(9)));
+      TextCodec::parse(val, m_sourceId);
     }
-  }
+    else if (key == "share")
+    {
+      m_shareGeometry = (val != "0");
+    }
+    else if (key == "delta")
+    {
+      TextCodec::TokenReader tokens(val);
+      double v[12] = {};
+      bool ok = true;
+      for (double& x : v) ok = ok && tokens.next(x);
+      if (ok)
+      {
+        m_delta.SetValues(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10], v[11]);
+      }
+    }
+  });
 }
@@ -5,6 +5,9 @@
 #include <DocumentItem.h>
 #include <gp_Trsf.hxx>
 
+#include <atomic>
+#include <mutex>
+
 class MoveFeature;
 DEFINE_STANDARD_HANDLE(MoveFeature, Feature)
 
@@ -14,37 +17,46 @@ class MoveFeature : public Feature
   DEFINE_STANDARD_RTTIEXT(MoveFeature, Feature)
 
 public:
-  MoveFeature() = default;
+  // Parameter schema: translation and Euler XYZ rotation in degrees
+  static constexpr ParamSpec kParamSchema[] = {{ParamKey::Tx, 0.0}, {ParamKey::Ty, 0.0}, {ParamKey::Tz, 0.0},
+                                               {ParamKey::Rx, 0.0}, {ParamKey::Ry, 0.0}, {ParamKey::Rz, 0.0}};
+  ParamSchema paramSchema() const override { return kParamSchema; }
+
+  MoveFeature() { resetParams(); }
 
   // Construct with explicit source link and params
   MoveFeature(DocumentItem::Id sourceId,
               double tx, double ty, double tz,
               double rxDeg, double ryDeg, double rzDeg)
-    : m_sourceId(sourceId)
+    : MoveFeature()
   {
+    m_sourceId = sourceId;
     setTranslation(tx, ty, tz);
     setRotation(rxDeg, ryDeg, rzDeg);
   }
 
   // Runtime linkage helpers
-  void setSource(const Handle(Feature)& src) { m_source = src; }
+  void setSource(const Handle(Feature)& src) { m_source = src; markDirty(); }
+  // Attach the runtime source matching sourceId() (link resolution); inputs are unchanged, so the
+  // current result stays valid
+  void bindSource(const Handle(Feature)& src) { m_source = src; }
   Handle(Feature) source() const { return m_source; }
 
-  void setSourceId(DocumentItem::Id id) { m_sourceId = id; }
+  void setSourceId(DocumentItem::Id id) { m_sourceId = id; markDirty(); }
   DocumentItem::Id sourceId() const { return m_sourceId; }
 
   // Param setters/getters
   void setTranslation(double tx, double ty, double tz)
   {
-    params()[Feature::ParamKey::Tx] = tx;
-    params()[Feature::ParamKey::Ty] = ty;
-    params()[Feature::ParamKey::Tz] = tz;
+    params().set(Feature::ParamKey::Tx, tx);
+    params().set(Feature::ParamKey::Ty, ty);
+    params().set(Feature::ParamKey::Tz, tz);
   }
   void setRotation(double rxDeg, double ryDeg, double rzDeg)
   {
-    params()[Feature::ParamKey::Rx] = rxDeg;
-    params()[Feature::ParamKey::Ry] = ryDeg;
-    params()[Feature::ParamKey::Rz] = rzDeg;
+    params().set(Feature::ParamKey::Rx, rxDeg);
+    params().set(Feature::ParamKey::Ry, ryDeg);
+    params().set(Feature::ParamKey::Rz, rzDeg);
   }
 
   double tx() const { return Feature::paramAsDouble(params(), Feature::ParamKey::Tx, 0.0); }
@@ -54,12 +66,36 @@ public:
   double ryDeg() const { return Feature::paramAsDouble(params(), Feature::ParamKey::Ry, 0.0); }
   double rzDeg() const { return Feature::paramAsDouble(params(), Feature::ParamKey::Rz, 0.0); }
 
-  void execute() override;
+  void execute(const Message_ProgressRange& theRange = Message_ProgressRange()) override;
 
   // Provide exact affine delta from interactive manipulator
-  void setDeltaTrsf(const gp_Trsf& t) { m_delta = t; }
+  void setDeltaTrsf(const gp_Trsf& t) { m_delta = t; markDirty(); }
   const gp_Trsf& deltaTrsf() const { return m_delta; }
 
+  // Effective transform: exact delta when provided, otherwise rebuilt from params (Euler XYZ + T)
+  gp_Trsf transform() const;
+
+  // Shared geometry (default): rigid moves only apply a TopLoc_Location to the source shape, so the
+  // result shares the source B-Rep and costs O(1) memory; otherwise the B-Rep is deep-copied
+  void setShareGeometry(bool on) { m_shareGeometry = on; markDirty(); }
+  bool shareGeometry() const { return m_shareGeometry; }
+
+  // Chain collapsing (driven by Document::recompute): the last link of a chain of moves is produced
+  // from the chain root with the composed transform in one step; skipped intermediate links are
+  // deferred. A deferred link builds its shape on first request, under a lock so concurrent
+  // readers see one result; it stays deferred (and cheap to fold again) until it executes
+  void executeComposed(const TopoDS_Shape& rootShape, const gp_Trsf& composed);
+  void defer();
+  bool isDeferred() const { return m_deferred; }
+
+  const TopoDS_Shape& shape() const override;
+  void setShape(const TopoDS_Shape& s) override
+  {
+    resetDeferred();
+    Feature::setShape(s);
+  }
+  std::uint64_t inputHash() const override; // params + exact delta + share mode
+
 public:
   // DocumentItem
   Kind kind() const override { return Kind::MoveFeature; }
@@ -70,4 +106,14 @@ private:
   Handle(Feature)  m_source;   // runtime resolved source feature (optional)
   DocumentItem::Id m_sourceId{0};
   gp_Trsf          m_delta;    // exact transform from manipulator (rotation+translation)
+  bool             m_shareGeometry{true}; // relocate instead of copying for rigid transforms
+  bool             m_deferred{false};     // result skipped by chain collapsing; rebuilt on access
+
+  // Shape of a deferred link, built by the first shape() call
+  mutable std::mutex        m_lazyMutex;
+  mutable std::atomic<bool> m_lazyReady{false};
+  mutable TopoDS_Shape      m_lazyShape;
+
+  void         resetDeferred();
+  TopoDS_Shape applyTransform(const TopoDS_Shape& src, const gp_Trsf& trsf) const;
 };
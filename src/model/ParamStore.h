@@ -0,0 +1,136 @@
+#pragma once
+
+#include <TCollection_AsciiString.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Compact parameter storage indexed by a dense key enum (values 0..N-1)
+// - Numeric values live in an inline array; a bit mask records which keys are set and which hold ints
+// - Strings are rare and kept in a small side list, so numeric-only features never allocate
+// - Reads are an array index plus a bit test: no hashing, no variant visit on the hot path
+template <class Key, std::size_t N>
+class ParamStore
+{
+  static_assert(N <= 32, "ParamStore masks hold at most 32 keys");
+
+public:
+  using Value = std::variant<int, double, TCollection_AsciiString>;
+
+  static constexpr std::size_t capacity() { return N; }
+
+  bool has(Key k) const { return (m_set >> index(k)) & 1u; }
+  bool isString(Key k) const { return has(k) && ((m_isString >> index(k)) & 1u); }
+  bool isInt(Key k) const { return has(k) && ((m_isInt >> index(k)) & 1u); }
+  std::size_t size() const
+  {
+    std::size_t n = 0;
+    for (std::uint32_t m = m_set; m != 0; m &= m - 1) ++n;
+    return n;
+  }
+  bool empty() const { return m_set == 0; }
+
+  void set(Key k, double v)
+  {
+    eraseString(k);
+    const std::uint32_t bit = 1u << index(k);
+    m_num[index(k)] = v;
+    m_set |= bit;
+    m_isInt &= ~bit;
+  }
+  void set(Key k, int v)
+  {
+    set(k, static_cast<double>(v));
+    m_isInt |= 1u << index(k);
+  }
+  void set(Key k, const TCollection_AsciiString& v)
+  {
+    const std::uint32_t bit = 1u << index(k);
+    m_set |= bit;
+    m_isInt &= ~bit;
+    m_isString |= bit;
+    for (auto& kv : m_strings)
+    {
+      if (kv.first == k) { kv.second = v; return; }
+    }
+    m_strings.emplace_back(k, v);
+  }
+  void set(Key k, const Value& v)
+  {
+    std::visit([&](const auto& x) { set(k, x); }, v);
+  }
+
+  void erase(Key k)
+  {
+    eraseString(k);
+    const std::uint32_t bit = 1u << index(k);
+    m_set &= ~bit;
+    m_isInt &= ~bit;
+  }
+  void clear()
+  {
+    m_set = m_isInt = m_isString = 0;
+    m_strings.clear();
+  }
+
+  // Numeric read: int/double values convert; strings and unset keys give defVal
+  double asDouble(Key k, double defVal) const
+  {
+    const std::uint32_t bit = 1u << index(k);
+    return (m_set & ~m_isString & bit) ? m_num[index(k)] : defVal;
+  }
+
+  // Generic read for serialization and tooling; the key must be set
+  Value get(Key k) const
+  {
+    if (isString(k))
+    {
+      for (const auto& kv : m_strings)
+      {
+        if (kv.first == k) return kv.second;
+      }
+    }
+    if (isInt(k)) return static_cast<int>(m_num[index(k)]);
+    return m_num[index(k)];
+  }
+
+  // Visit set keys in ascending key order: fn(Key, const Value&)
+  template <class Fn>
+  void forEach(Fn&& fn) const
+  {
+    for (std::uint32_t m = m_set; m != 0; m &= m - 1)
+    {
+      const Key k = static_cast<Key>(lowestBit(m));
+      fn(k, get(k));
+    }
+  }
+
+private:
+  static std::size_t index(Key k) { return static_cast<std::size_t>(k); }
+  static unsigned lowestBit(std::uint32_t m)
+  {
+    unsigned i = 0;
+    while (!(m & 1u)) { m >>= 1; ++i; }
+    return i;
+  }
+  void eraseString(Key k)
+  {
+    const std::uint32_t bit = 1u << index(k);
+    if (!(m_isString & bit)) return;
+    m_isString &= ~bit;
+    m_strings.erase(std::remove_if(m_strings.begin(), m_strings.end(),
+                                   [k](const auto& kv) { return kv.first == k; }),
+                    m_strings.end());
+  }
+
+  std::array<double, N> m_num{};
+  std::uint32_t         m_set{0};
+  std::uint32_t         m_isInt{0};
+  std::uint32_t         m_isString{0};
+  std::vector<std::pair<Key, TCollection_AsciiString>> m_strings; // rare
+};
@@ -0,0 +1,92 @@
+#include "RecomputeProfile.h"
+
+#include <JsonString.h>
+#include <TextCodec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+// Milliseconds rounded to microseconds keep the report short
+double roundMs(double ms)
+{
+  return std::round(ms * 1000.0) / 1000.0;
+}
+
+} // namespace
+
+const char* RecomputeProfile::outcomeName(Outcome o)
+{
+  switch (o)
+  {
+    case Outcome::UpToDate: return "upToDate";
+    case Outcome::Executed: return "executed";
+    case Outcome::CacheHit: return "cacheHit";
+    case Outcome::Collapsed: return "collapsed";
+    case Outcome::NotNeeded: return "notNeeded";
+    case Outcome::Cancelled: return "cancelled";
+  }
+  return "unknown";
+}
+
+const RecomputeProfile::Entry* RecomputeProfile::find(DocumentItem::Id id) const
+{
+  for (const Entry& e : entries)
+  {
+    if (e.id == id) return &e;
+  }
+  return nullptr;
+}
+
+std::vector<const RecomputeProfile::Entry*> RecomputeProfile::slowest(std::size_t n) const
+{
+  std::vector<const Entry*> out;
+  out.reserve(entries.size());
+  for (const Entry& e : entries) out.push_back(&e);
+  n = std::min(n, out.size());
+  std::partial_sort(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(n), out.end(),
+                    [](const Entry* a, const Entry* b) { return a->wallMs > b->wallMs; });
+  out.resize(n);
+  return out;
+}
+
+std::string RecomputeProfile::toJson() const
+{
+  std::string out;
+  out.reserve(64 + entries.size() * 200);
+  TextCodec::Writer w(out);
+  w.text("{\"totalWallMs\":").num(roundMs(totalWallMs)).text(",\"threads\":").num(threads).text(",\"features\":[");
+  for (std::size_t i = 0; i < entries.size(); ++i)
+  {
+    const Entry& e = entries[i];
+    w.text(i == 0 ? "\n  {" : ",\n  {");
+    w.text("\"id\":").num(static_cast<std::uint64_t>(e.id));
+    w.text(",\"type\":");
+    Json::appendString(out, e.type);
+    w.text(",\"name\":");
+    Json::appendString(out, e.name);
+    w.text(",\"outcome\":\"").text(outcomeName(e.outcome)).ch('"');
+    w.text(",\"cacheHit\":").text(e.cacheHit() ? "true" : "false");
+    w.text(",\"wallMs\":").num(roundMs(e.wallMs));
+    w.text(",\"cpuMs\":").num(roundMs(e.cpuMs));
+    w.text(",\"kernelMs\":").num(roundMs(e.kernelMs));
+    w.text(",\"kernelCalls\":").num(static_cast<std::uint64_t>(e.kernelCalls));
+    w.text(",\"faces\":").num(e.faces);
+    w.text(",\"edges\":").num(e.edges);
+    w.text(",\"vertices\":").num(e.vertices);
+    w.ch('}');
+  }
+  w.text(entries.empty() ? "]}\n" : "\n]}\n");
+  return out;
+}
+
+bool RecomputeProfile::writeJson(const std::string& path) const
+{
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  if (!os) return false;
+  const std::string json = toJson();
+  os.write(json.data(), static_cast<std::streamsize>(json.size()));
+  return static_cast<bool>(os);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <DocumentItem.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Per-feature measurements of one Document::recompute() (see Document::setProfiling)
+// - Every timeline feature gets an entry, in timeline order, with what recompute did to it
+// - Times of features that produced a result: wall and thread CPU time of the task, and the wall
+//   time spent inside KernelAPI calls; topology counts are those of the produced shape
+// - With parallel recompute, per-feature wall times overlap; totalWallMs is the elapsed time
+struct RecomputeProfile
+{
+  enum class Outcome
+  {
+    UpToDate,  // result reused as-is
+    Executed,  // execute() ran
+    CacheHit,  // result taken from the FeatureResultCache
+    Collapsed, // suppressed move link folded into its consumer's transform
+    NotNeeded, // stale but neither displayed nor read by a displayed feature
+    Cancelled, // left dirty by a cancelled recompute
+  };
+
+  struct Entry
+  {
+    DocumentItem::Id id{0};
+    std::string      type;     // feature class name
+    std::string      name;     // user-visible name (may be empty)
+    Outcome          outcome{Outcome::UpToDate};
+    double           wallMs{0.0};
+    double           cpuMs{0.0};    // user + system CPU time of the executing thread
+    double           kernelMs{0.0}; // wall time inside KernelAPI calls
+    std::size_t      kernelCalls{0};
+    int              faces{0};
+    int              edges{0};
+    int              vertices{0};
+
+    bool cacheHit() const { return outcome == Outcome::CacheHit; }
+    bool produced() const { return outcome == Outcome::Executed || outcome == Outcome::CacheHit; }
+  };
+
+  std::vector<Entry> entries;
+  double             totalWallMs{0.0};
+  int                threads{1};
+
+  const Entry* find(DocumentItem::Id id) const;
+  // Entries with the largest wall time first (at most n)
+  std::vector<const Entry*> slowest(std::size_t n) const;
+
+  // JSON report: {"totalWallMs":..,"threads":..,"features":[{..}, ..]}
+  std::string toJson() const;
+  bool        writeJson(const std::string& path) const;
+
+  static const char* outcomeName(Outcome o);
+};
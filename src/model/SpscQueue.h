@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread
+// - Ring buffer of Capacity slots (power of two); head is written by the producer only, tail by
+//   the consumer only, so each side needs one acquire load and one release store per operation
+// - Both indices grow monotonically; the slot is index & (Capacity - 1)
+// - T must be default constructible and move assignable; a popped slot is reset to T()
+template <class T, std::size_t Capacity>
+class SpscQueue
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // Producer: moves from 'value' only on success; false when full
+  bool push(T& value)
+  {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == Capacity) return false;
+    m_slots[head & (Capacity - 1)] = std::move(value);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: false when empty
+  bool pop(T& out)
+  {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) return false;
+    T& slot = m_slots[tail & (Capacity - 1)];
+    out  = std::move(slot);
+    slot = T(); // release what the slot held before the producer may reuse it
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently with push()/pop()
+  bool empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+  std::size_t size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+  static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+  std::array<T, Capacity> m_slots;
+  // Separate cache lines: producer and consumer do not invalidate each other's index
+  alignas(64) std::atomic<std::size_t> m_head{0}; // next slot to write
+  alignas(64) std::atomic<std::size_t> m_tail{0}; // next slot to read
+};
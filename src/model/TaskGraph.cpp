@@ -0,0 +1,85 @@
+#include "TaskGraph.h"
+
+#include <Trace.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+TaskGraph::TaskGraph(std::size_t size)
+  : m_succ(size),
+    m_predCount(size, 0)
+{
+}
+
+void TaskGraph::addEdge(std::size_t from, std::size_t to)
+{
+  m_succ[from].push_back(to);
+  ++m_predCount[to];
+}
+
+void TaskGraph::run(const std::function<void(std::size_t)>& task, int nbThreads) const
+{
+  const std::size_t n = size();
+  if (n == 0) return;
+  if (nbThreads <= 1 || n == 1)
+  {
+    // Deterministic fallback: index order is topological since edges point forward
+    for (std::size_t i = 0; i < n; ++i) task(i);
+    return;
+  }
+
+  std::vector<int> pending(m_predCount);
+  // Min-heap keeps dispatch close to timeline order
+  std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t>> ready;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    if (pending[i] == 0) ready.push(i);
+  }
+
+  std::mutex              mutex;
+  std::condition_variable cv;
+  std::size_t             done = 0;
+  std::exception_ptr      error;
+
+  auto worker = [&]() {
+    Trace::setThreadName("recompute worker");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+      cv.wait(lock, [&]() { return !ready.empty() || done == n || error; });
+      if (done == n || error) return;
+      const std::size_t i = ready.top();
+      ready.pop();
+      lock.unlock();
+      std::exception_ptr taskError;
+      try
+      {
+        task(i);
+      }
+      catch (...)
+      {
+        taskError = std::current_exception();
+      }
+      lock.lock();
+      ++done;
+      if (taskError && !error) error = taskError;
+      for (std::size_t s : m_succ[i])
+      {
+        if (--pending[s] == 0) ready.push(s);
+      }
+      cv.notify_all();
+    }
+  };
+
+  const std::size_t nbWorkers = std::min<std::size_t>(static_cast<std::size_t>(nbThreads), n);
+  std::vector<std::thread> pool;
+  pool.reserve(nbWorkers);
+  for (std::size_t t = 0; t < nbWorkers; ++t) pool.emplace_back(worker);
+  for (std::thread& th : pool) th.join();
+  if (error) std::rethrow_exception(error);
+}
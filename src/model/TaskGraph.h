@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Minimal dependency-counting scheduler used by Document::recompute()
+// - Tasks are identified by index [0, size()); an edge (a -> b) makes b wait for a
+// - run() dispatches ready tasks to a pool of worker threads, lowest index first
+// - With one thread (or a single task) tasks run inline in index order, which is a
+//   valid topological order as long as edges always point forward
+class TaskGraph
+{
+public:
+  explicit TaskGraph(std::size_t size);
+
+  std::size_t size() const { return m_succ.size(); }
+
+  // Declare that task 'to' depends on task 'from'
+  void addEdge(std::size_t from, std::size_t to);
+
+  // Execute every task once; rethrows the first exception raised by a task after all workers stop
+  void run(const std::function<void(std::size_t)>& task, int nbThreads) const;
+
+private:
+  std::vector<std::vector<std::size_t>> m_succ;    // successors per task
+  std::vector<int>                      m_predCount; // number of predecessors per task
+};
@@ -0,0 +1,236 @@
+#include "Timeline.h"
+
+#include <Standard_OutOfRange.hxx>
+
+void Timeline::Clear()
+{
+  m_nodes.clear();
+  m_free.clear();
+  m_index.clear();
+  m_root = -1;
+}
+
+const Handle(DocumentItem)& Timeline::Value(int index1) const
+{
+  return m_nodes[nodeAt(index1)].item;
+}
+
+bool Timeline::Append(const Handle(DocumentItem)& item)
+{
+  if (item.IsNull() || Contains(item->id())) return false;
+  m_root = merge(m_root, allocate(item));
+  m_nodes[m_root].parent = -1;
+  return true;
+}
+
+bool Timeline::InsertBefore(int index1, const Handle(DocumentItem)& item)
+{
+  if (item.IsNull() || Contains(item->id())) return false;
+  if (index1 < 1) index1 = 1;
+  if (index1 > Size() + 1) index1 = Size() + 1;
+  int left = -1, right = -1;
+  split(m_root, index1 - 1, left, right);
+  m_root = merge(merge(left, allocate(item)), right);
+  m_nodes[m_root].parent = -1;
+  return true;
+}
+
+void Timeline::Remove(int index1)
+{
+  if (index1 < 1 || index1 > Size()) throw Standard_OutOfRange("Timeline::Remove");
+  int left = -1, mid = -1, right = -1;
+  split(m_root, index1 - 1, left, right);
+  split(right, 1, mid, right);
+  m_root = merge(left, right);
+  if (m_root >= 0) m_nodes[m_root].parent = -1;
+  release(mid);
+}
+
+bool Timeline::Remove(DocumentItem::Id id)
+{
+  const int index1 = IndexOf(id);
+  if (index1 == 0) return false;
+  Remove(index1);
+  return true;
+}
+
+Handle(DocumentItem) Timeline::Find(DocumentItem::Id id) const
+{
+  auto it = m_index.find(id);
+  return it == m_index.end() ? Handle(DocumentItem)() : m_nodes[it->second].item;
+}
+
+int Timeline::IndexOf(DocumentItem::Id id) const
+{
+  auto it = m_index.find(id);
+  if (it == m_index.end()) return 0;
+  // Rank = nodes left of the path from the node up to the root
+  int node = it->second;
+  int rank = (m_nodes[node].left >= 0 ? m_nodes[m_nodes[node].left].size : 0) + 1;
+  for (int p = m_nodes[node].parent; p >= 0; node = p, p = m_nodes[p].parent)
+  {
+    if (m_nodes[p].right == node)
+    {
+      rank += (m_nodes[p].left >= 0 ? m_nodes[m_nodes[p].left].size : 0) + 1;
+    }
+  }
+  return rank;
+}
+
+const Handle(Feature)& Timeline::FeatureView::Value(int index1) const
+{
+  const std::deque<Node>& nodes = m_tl->m_nodes;
+  if (index1 < 1 || index1 > Size()) throw Standard_OutOfRange("Timeline::FeatureView::Value");
+  int k = index1;
+  int t = m_tl->m_root;
+  while (true)
+  {
+    const int inLeft = nodes[t].left >= 0 ? nodes[nodes[t].left].features : 0;
+    if (k <= inLeft)
+    {
+      t = nodes[t].left;
+      continue;
+    }
+    const int self = nodes[t].feature.IsNull() ? 0 : 1;
+    if (self && k == inLeft + 1) return nodes[t].feature;
+    k -= inLeft + self;
+    t = nodes[t].right;
+  }
+}
+
+int Timeline::allocate(const Handle(DocumentItem)& item)
+{
+  int node;
+  if (!m_free.empty())
+  {
+    node = m_free.back();
+    m_free.pop_back();
+    m_nodes[node] = Node();
+  }
+  else
+  {
+    node = static_cast<int>(m_nodes.size());
+    m_nodes.emplace_back();
+  }
+  Node& n    = m_nodes[node];
+  n.item     = item;
+  n.feature  = Handle(Feature)::DownCast(item);
+  n.priority = m_rng();
+  n.features = n.feature.IsNull() ? 0 : 1;
+  m_index[item->id()] = node;
+  return node;
+}
+
+void Timeline::release(int node)
+{
+  Node& n = m_nodes[node];
+  m_index.erase(n.item->id());
+  n = Node();
+  m_free.push_back(node);
+}
+
+void Timeline::pull(int node)
+{
+  Node& n    = m_nodes[node];
+  n.size     = 1;
+  n.features = n.feature.IsNull() ? 0 : 1;
+  if (n.left >= 0)
+  {
+    n.size += m_nodes[n.left].size;
+    n.features += m_nodes[n.left].features;
+    m_nodes[n.left].parent = node;
+  }
+  if (n.right >= 0)
+  {
+    n.size += m_nodes[n.right].size;
+    n.features += m_nodes[n.right].features;
+    m_nodes[n.right].parent = node;
+  }
+}
+
+void Timeline::split(int node, int count, int& left, int& right)
+{
+  if (node < 0)
+  {
+    left = right = -1;
+    return;
+  }
+  Node& n = m_nodes[node];
+  const int inLeft = n.left >= 0 ? m_nodes[n.left].size : 0;
+  if (inLeft < count)
+  {
+    int a = -1, b = -1;
+    split(n.right, count - inLeft - 1, a, b);
+    n.right = a;
+    pull(node);
+    left  = node;
+    right = b;
+  }
+  else
+  {
+    int a = -1, b = -1;
+    split(n.left, count, a, b);
+    n.left = b;
+    pull(node);
+    left  = a;
+    right = node;
+  }
+  if (left >= 0) m_nodes[left].parent = -1;
+  if (right >= 0) m_nodes[right].parent = -1;
+}
+
+int Timeline::merge(int left, int right)
+{
+  if (left < 0) return right;
+  if (right < 0) return left;
+  if (m_nodes[left].priority > m_nodes[right].priority)
+  {
+    const int r = merge(m_nodes[left].right, right);
+    m_nodes[left].right = r;
+    pull(left);
+    return left;
+  }
+  const int l = merge(left, m_nodes[right].left);
+  m_nodes[right].left = l;
+  pull(right);
+  return right;
+}
+
+int Timeline::nodeAt(int index1) const
+{
+  if (index1 < 1 || index1 > Size()) throw Standard_OutOfRange("Timeline::Value");
+  int k = index1;
+  int t = m_root;
+  while (true)
+  {
+    const int inLeft = m_nodes[t].left >= 0 ? m_nodes[m_nodes[t].left].size : 0;
+    if (k <= inLeft)
+      t = m_nodes[t].left;
+    else if (k == inLeft + 1)
+      return t;
+    else
+    {
+      k -= inLeft + 1;
+      t = m_nodes[t].right;
+    }
+  }
+}
+
+int Timeline::leftmost(int node) const
+{
+  if (node < 0) return -1;
+  while (m_nodes[node].left >= 0) node = m_nodes[node].left;
+  return node;
+}
+
+int Timeline::successor(int node) const
+{
+  if (m_nodes[node].right >= 0) return leftmost(m_nodes[node].right);
+  int p = m_nodes[node].parent;
+  while (p >= 0 && m_nodes[p].right == node)
+  {
+    node = p;
+    p    = m_nodes[p].parent;
+  }
+  return p;
+}
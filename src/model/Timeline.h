@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Feature.h"
+
+#include <DocumentItem.h>
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// Ordered document history with indexed access
+// - Implicit treap keyed by position: insert/remove at any index and Value(index) in O(log n)
+// - Hash index DocumentItem::Id -> node: find() in O(1), indexOf() in O(log n)
+// - Nodes also count features in their subtree, so features() is a live filtered view
+//   (no rebuild after edits) with O(log n) positional access
+// - Accessors follow NCollection_Sequence (1-based Value/First/Last, Size, Iterator)
+// Item ids are unique within a timeline: appending an id that is already present is rejected.
+class Timeline
+{
+  struct Node;
+
+public:
+  Timeline() = default;
+
+  int  Size() const { return m_root < 0 ? 0 : m_nodes[m_root].size; }
+  bool IsEmpty() const { return m_root < 0; }
+  void Clear();
+
+  const Handle(DocumentItem)& Value(int index1) const;    // 1-based
+  const Handle(DocumentItem)& First() const { return Value(1); }
+  const Handle(DocumentItem)& Last() const { return Value(Size()); }
+
+  // Edits return false when the item is null or its id is already in the timeline
+  bool Append(const Handle(DocumentItem)& item);
+  bool InsertBefore(int index1, const Handle(DocumentItem)& item); // index clamped to [1, Size()+1]
+  void Remove(int index1);
+  bool Remove(DocumentItem::Id id);
+
+  // Id lookup: null handle / 0 when absent
+  Handle(DocumentItem) Find(DocumentItem::Id id) const;
+  int IndexOf(DocumentItem::Id id) const;                 // 1-based position
+  bool Contains(DocumentItem::Id id) const { return m_index.count(id) != 0; }
+
+  // In-order traversal, NCollection style
+  class Iterator
+  {
+  public:
+    explicit Iterator(const Timeline& t) : m_tl(&t), m_node(t.leftmost(t.m_root)) {}
+    bool More() const { return m_node >= 0; }
+    void Next() { m_node = m_tl->successor(m_node); }
+    const Handle(DocumentItem)& Value() const { return m_tl->m_nodes[m_node].item; }
+
+  private:
+    const Timeline* m_tl;
+    int             m_node;
+  };
+
+  // Filtered view over the features of the timeline, in timeline order
+  class FeatureView
+  {
+  public:
+    explicit FeatureView(const Timeline& t) : m_tl(&t) {}
+    int  Size() const { return m_tl->m_root < 0 ? 0 : m_tl->m_nodes[m_tl->m_root].features; }
+    bool IsEmpty() const { return Size() == 0; }
+    const Handle(Feature)& Value(int index1) const;       // 1-based among features
+    const Handle(Feature)& First() const { return Value(1); }
+    const Handle(Feature)& Last() const { return Value(Size()); }
+
+    class Iterator
+    {
+    public:
+      explicit Iterator(const FeatureView& v) : m_tl(v.m_tl), m_node(v.m_tl->leftmost(v.m_tl->m_root)) { skip(); }
+      bool More() const { return m_node >= 0; }
+      void Next() { m_node = m_tl->successor(m_node); skip(); }
+      const Handle(Feature)& Value() const { return m_tl->m_nodes[m_node].feature; }
+
+    private:
+      void skip() { while (m_node >= 0 && m_tl->m_nodes[m_node].feature.IsNull()) m_node = m_tl->successor(m_node); }
+      const Timeline* m_tl;
+      int             m_node;
+    };
+
+  private:
+    const Timeline* m_tl;
+  };
+
+  FeatureView features() const { return FeatureView(*this); }
+
+private:
+  struct Node
+  {
+    Handle(DocumentItem) item;
+    Handle(Feature)      feature; // same object as item when it is a Feature, else null
+    std::uint32_t        priority{0};
+    int                  left{-1};
+    int                  right{-1};
+    int                  parent{-1};
+    int                  size{1};     // nodes in subtree
+    int                  features{0}; // feature nodes in subtree
+  };
+
+  int  allocate(const Handle(DocumentItem)& item);
+  void release(int node);
+  void pull(int node);
+  void split(int node, int count, int& left, int& right); // first 'count' nodes go left
+  int  merge(int left, int right);
+  int  nodeAt(int index1) const;
+  int  leftmost(int node) const;
+  int  successor(int node) const;
+
+  std::deque<Node>                          m_nodes; // deque keeps Value() references stable on growth
+  std::vector<int>                          m_free;
+  std::unordered_map<DocumentItem::Id, int> m_index;
+  int                                       m_root{-1};
+  std::mt19937                              m_rng{0x5eed};
+};
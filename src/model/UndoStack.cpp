@@ -0,0 +1,230 @@
+#include "UndoStack.h"
+
+#include <IdAllocator.h>
+#include <Sketch.h>
+
+#include <unordered_set>
+#include <utility>
+
+namespace
+{
+// Shape and dirty flag of a feature (null/false for other items)
+void resultOf(const DocumentItem& item, TopoDS_Shape& shape, bool& dirty)
+{
+  if (const Feature* f = dynamic_cast<const Feature*>(&item))
+  {
+    // Evicted results are not rebuilt for the history; restoring them recomputes instead
+    shape = f->heldShape();
+    dirty = f->isDirty() || f->isEvicted();
+  }
+  else
+  {
+    shape.Nullify();
+    dirty = false;
+  }
+}
+} // namespace
+
+bool UndoStack::matches(const DocumentItem& item, const Tracked& t) const
+{
+  if (t.revision != item.revision() || !t.state) return false;
+  TopoDS_Shape shape;
+  bool dirty = false;
+  resultOf(item, shape, dirty);
+  return dirty == t.state->dirty && shape.IsEqual(t.state->shape);
+}
+
+std::shared_ptr<const UndoStack::ItemState> UndoStack::stateOf(const Handle(DocumentItem)& handle,
+                                                               const std::shared_ptr<Sketch>& sketch,
+                                                               TrackMap& next)
+{
+  const DocumentItem& item = sketch ? static_cast<const DocumentItem&>(*sketch) : *handle;
+  Tracked t;
+  t.handle   = handle;
+  t.sketch   = sketch;
+  t.revision = item.revision();
+  auto it = m_tracked.find(&item);
+  if (it != m_tracked.end() && matches(item, it->second))
+  {
+    t.state = it->second.state;
+  }
+  else
+  {
+    auto st  = std::make_shared<ItemState>();
+    st->id   = item.id();
+    st->kind = item.kind();
+    st->blob = item.serialize();
+    resultOf(item, st->shape, st->dirty);
+    t.state = std::move(st);
+    ++m_stats.newStates;
+  }
+  std::shared_ptr<const ItemState> state = t.state;
+  next[&item] = std::move(t);
+  return state;
+}
+
+std::shared_ptr<const UndoStack::Snapshot> UndoStack::capture(const Document& doc, const std::string& label)
+{
+  m_stats = Stats();
+  const Snapshot* base = m_history.empty() ? nullptr : m_history[m_current].get();
+  auto snap   = std::make_shared<Snapshot>();
+  snap->label = label;
+  TrackMap next;
+  next.reserve(m_tracked.size() + 16);
+
+  Chunk chunk;
+  auto flush = [&]() {
+    const std::size_t c = snap->items.size();
+    const Chunk* prev = (base && c < base->items.size()) ? base->items[c].get() : nullptr;
+    bool same = prev != nullptr && prev->count == chunk.count;
+    for (std::size_t i = 0; same && i < chunk.count; ++i) same = prev->states[i] == chunk.states[i];
+    if (same)
+    {
+      snap->items.push_back(base->items[c]);
+      ++m_stats.sharedChunks;
+    }
+    else
+    {
+      snap->items.push_back(std::make_shared<const Chunk>(chunk));
+    }
+    chunk = Chunk();
+  };
+  for (Timeline::Iterator it(doc.items()); it.More(); it.Next())
+  {
+    chunk.states[chunk.count++] = stateOf(it.Value(), nullptr, next);
+    if (chunk.count == kChunkSize) flush();
+  }
+  if (chunk.count != 0) flush();
+  snap->itemCount = static_cast<std::size_t>(doc.items().Size());
+
+  for (const auto& sk : doc.sketches())
+  {
+    snap->sketches.push_back(stateOf(Handle(DocumentItem)(), sk, next));
+  }
+
+  m_stats.items  = snap->itemCount + snap->sketches.size();
+  m_stats.chunks = snap->items.size();
+  m_tracked.swap(next);
+  return snap;
+}
+
+void UndoStack::restore(const Snapshot& snap, Document& doc)
+{
+  TrackMap next;
+  next.reserve(snap.itemCount + snap.sketches.size());
+  // Rebuilt items keep their persisted ids inside this document's id space
+  IdAllocator::Scope ids(doc.ids());
+
+  std::vector<Handle(DocumentItem)> items;
+  items.reserve(snap.itemCount);
+  for (const auto& chunk : snap.items)
+  {
+    for (std::size_t i = 0; i < chunk->count; ++i)
+    {
+      const std::shared_ptr<const ItemState>& st = chunk->states[i];
+      Handle(DocumentItem) item = doc.findItem(st->id);
+      auto it = item.IsNull() ? m_tracked.end() : m_tracked.find(item.get());
+      if (it == m_tracked.end() || it->second.state != st || !matches(*item, it->second))
+      {
+        item = DocumentItem::create(st->kind, st->id);
+        if (item.IsNull()) continue;
+        item->deserialize(st->blob);
+        if (Handle(Feature) f = Handle(Feature)::DownCast(item); !f.IsNull())
+        {
+          f->setShape(st->shape);
+          if (!st->dirty) f->clearDirty();
+        }
+      }
+      next[item.get()] = Tracked{item, nullptr, item->revision(), st};
+      items.push_back(item);
+    }
+  }
+
+  std::vector<std::shared_ptr<Sketch>> sketches;
+  sketches.reserve(snap.sketches.size());
+  for (const auto& st : snap.sketches)
+  {
+    std::shared_ptr<Sketch> sk = doc.findSketch(st->id);
+    auto it = sk ? m_tracked.find(sk.get()) : m_tracked.end();
+    if (it == m_tracked.end() || it->second.state != st || !matches(*sk, it->second))
+    {
+      sk = std::make_shared<Sketch>(st->id);
+      sk->deserialize(st->blob);
+    }
+    next[sk.get()] = Tracked{Handle(DocumentItem)(), sk, sk->revision(), st};
+    sketches.push_back(std::move(sk));
+  }
+
+  // The rollback marker is view state, not history: it stays on the last active item that survives
+  std::vector<DocumentItem::Id> active;
+  const bool rolledBack = doc.hasRollback();
+  for (int i = 1; rolledBack && i <= doc.rollbackPosition(); ++i) active.push_back(doc.items().Value(i)->id());
+
+  doc.clear();
+  for (const auto& sk : sketches) doc.addSketch(sk);
+  for (const Handle(DocumentItem)& item : items) doc.addItem(item);
+  if (rolledBack)
+  {
+    int position = 0;
+    for (auto it = active.rbegin(); it != active.rend() && position == 0; ++it) position = doc.indexOf(*it);
+    doc.setRollbackPosition(position);
+  }
+  m_tracked.swap(next);
+}
+
+void UndoStack::reset(const Document& doc)
+{
+  m_history.clear();
+  m_tracked.clear();
+  m_current = 0;
+  m_history.push_back(capture(doc, std::string()));
+}
+
+void UndoStack::commit(const Document& doc, const std::string& label)
+{
+  if (m_history.empty())
+  {
+    reset(doc);
+    return;
+  }
+  std::shared_ptr<const Snapshot> snap = capture(doc, label);
+  m_history.resize(m_current + 1);
+  m_history.push_back(std::move(snap));
+  if (m_history.size() > m_limit) m_history.erase(m_history.begin());
+  m_current = m_history.size() - 1;
+}
+
+bool UndoStack::undo(Document& doc)
+{
+  if (!canUndo()) return false;
+  --m_current;
+  restore(*m_history[m_current], doc);
+  return true;
+}
+
+bool UndoStack::redo(Document& doc)
+{
+  if (!canRedo()) return false;
+  ++m_current;
+  restore(*m_history[m_current], doc);
+  return true;
+}
+
+std::vector<TopoDS_Shape> UndoStack::retainedShapes() const
+{
+  // States are shared between snapshots: visit each once
+  std::unordered_set<const ItemState*> seen;
+  std::vector<TopoDS_Shape>           out;
+  for (const auto& snap : m_history)
+  {
+    for (const auto& chunk : snap->items)
+    {
+      for (std::size_t i = 0; i < chunk->count; ++i)
+      {
+        const ItemState* st = chunk->states[i].get();
+        if (!st->shape.IsNull() && seen.insert(st).second) out.push_back(st->shape);
+      }
+    }
+  }
+  return out;
+}
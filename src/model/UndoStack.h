@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Document.h"
+
+#include <DocumentItem.h>
+#include <TopoDS_Shape.hxx>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Sketch;
+
+// Undo/redo history of a Document made of persistent, structurally shared snapshots
+// - A snapshot records each timeline item and registered sketch as an immutable ItemState:
+//   serialize() blob, computed shape and dirty flag
+// - An item whose revision(), shape and dirty flag did not change since the previous snapshot
+//   reuses its ItemState; runs of kChunkSize unchanged states reuse the whole chunk, so a step
+//   costs memory proportional to what it changed
+// - Shapes are held by TopoDS_Shape (shared TShape): restoring puts the cached results back and
+//   leaves features clean, so undo/redo never recompute
+// - Live items still matching the restored state are reused; others are rebuilt from their blob
+// - The document's rollback marker is not recorded; restoring keeps it on the same item
+// Edits are recorded after the fact: mutate the document, then commit() with a label.
+class UndoStack
+{
+public:
+  struct ItemState
+  {
+    DocumentItem::Id   id{0};
+    DocumentItem::Kind kind{DocumentItem::Kind::Sketch};
+    std::string        blob;
+    TopoDS_Shape       shape;       // features only
+    bool               dirty{false}; // features only
+  };
+
+  static constexpr std::size_t kChunkSize = 32;
+
+  struct Chunk
+  {
+    std::size_t count{0};
+    std::array<std::shared_ptr<const ItemState>, kChunkSize> states;
+  };
+
+  struct Snapshot
+  {
+    std::string                                   label;    // edit that produced this state
+    std::size_t                                   itemCount{0};
+    std::vector<std::shared_ptr<const Chunk>>     items;    // timeline, kChunkSize per chunk
+    std::vector<std::shared_ptr<const ItemState>> sketches; // Document::sketches() registry
+  };
+
+  // Counters of the last commit()/reset()
+  struct Stats
+  {
+    std::size_t items{0};        // timeline items + sketches captured
+    std::size_t newStates{0};    // states serialized for this step (changed or new items)
+    std::size_t chunks{0};       // timeline chunks of the snapshot
+    std::size_t sharedChunks{0}; // chunks reused from the previous snapshot
+  };
+
+  explicit UndoStack(std::size_t limit = 200) : m_limit(limit < 2 ? 2 : limit) {}
+
+  // Forget the history; 'doc' becomes the initial state
+  void reset(const Document& doc);
+  // Record the state after an edit; drops the redo branch
+  void commit(const Document& doc, const std::string& label);
+
+  bool canUndo() const { return m_current > 0; }
+  bool canRedo() const { return m_current + 1 < m_history.size(); }
+  // Restore the previous/next snapshot into 'doc'; false when there is none
+  bool undo(Document& doc);
+  bool redo(Document& doc);
+
+  // Label of the edit undo()/redo() would revert/reapply (empty when unavailable)
+  std::string undoLabel() const { return canUndo() ? m_history[m_current]->label : std::string(); }
+  std::string redoLabel() const { return canRedo() ? m_history[m_current + 1]->label : std::string(); }
+
+  std::size_t size() const { return m_history.size(); }
+  // Distinct feature shapes held by all snapshots (memory reporting)
+  std::vector<TopoDS_Shape> retainedShapes() const;
+  const Stats& lastStats() const { return m_stats; }
+
+private:
+  // Live object -> state it matched when last captured or restored. Holds a reference so the
+  // address cannot be reused by another item while tracked.
+  struct Tracked
+  {
+    Handle(DocumentItem)             handle;
+    std::shared_ptr<Sketch>          sketch;
+    std::uint64_t                    revision{0};
+    std::shared_ptr<const ItemState> state;
+  };
+  using TrackMap = std::unordered_map<const DocumentItem*, Tracked>;
+
+  std::shared_ptr<const Snapshot> capture(const Document& doc, const std::string& label);
+  void restore(const Snapshot& snap, Document& doc);
+  // Exactly one of 'handle'/'sketch' is set (timeline items vs registry sketches)
+  std::shared_ptr<const ItemState> stateOf(const Handle(DocumentItem)& handle,
+                                           const std::shared_ptr<Sketch>& sketch, TrackMap& next);
+  bool matches(const DocumentItem& item, const Tracked& t) const;
+
+  std::vector<std::shared_ptr<const Snapshot>> m_history;
+  std::size_t                                  m_current{0};
+  std::size_t                                  m_limit;
+  TrackMap                                     m_tracked;
+  Stats                                        m_stats;
+};
@@ -0,0 +1,597 @@
+#include "ConstraintSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+// Damping relative to the largest diagonal of J J^T: the floor keeps steps Newton-like, the
+// ceiling gives up on a component that cannot decrease its residual
+constexpr double kMinDamping = 1.0e-12;
+constexpr double kMaxDamping = 1.0e12;
+constexpr double kPi         = 3.14159265358979323846;
+
+int pointsOf(ConstraintSolver::Equation kind)
+{
+  using E = ConstraintSolver::Equation;
+  switch (kind)
+  {
+    case E::FixX:
+    case E::FixY: return 1;
+    case E::OnCircle: return 3;
+    case E::Parallel:
+    case E::Perpendicular:
+    case E::LineTangent:
+    case E::CircleTangent: return 4;
+    default: return 2;
+  }
+}
+
+// Length of (dx, dy) and its direction; (1, 0) for a zero vector
+double unit(double dx, double dy, double& ux, double& uy)
+{
+  const double len = std::sqrt(dx * dx + dy * dy);
+  if (len == 0.0)
+  {
+    ux = 1.0;
+    uy = 0.0;
+    return 0.0;
+  }
+  ux = dx / len;
+  uy = dy / len;
+  return len;
+}
+} // namespace
+
+void ConstraintSolver::clear()
+{
+  m_x.clear();
+  m_rows.clear();
+  m_stats = Stats{};
+}
+
+int ConstraintSolver::addPoint(double x, double y)
+{
+  m_x.push_back(x);
+  m_x.push_back(y);
+  return static_cast<int>(m_x.size() / 2 - 1);
+}
+
+void ConstraintSolver::addEquation(Equation kind, int p0, int p1, int p2, int p3, double value)
+{
+  m_rows.push_back(Row{kind, {p0, p1, p2, p3}, value, false});
+}
+
+int ConstraintSolver::termCount(const Row& r) const
+{
+  return 2 * pointsOf(r.kind);
+}
+
+// Residual of one equation; grad receives its derivatives by x, y of points[0], points[1], ...
+double ConstraintSolver::evaluate(const Row& r, double* g) const
+{
+  auto px = [this, &r](int k) { return m_x[r.points[k] * 2]; };
+  auto py = [this, &r](int k) { return m_x[r.points[k] * 2 + 1]; };
+  switch (r.kind)
+  {
+    case Equation::Distance:
+    {
+      double ux, uy;
+      const double len = unit(px(1) - px(0), py(1) - py(0), ux, uy);
+      g[0] = -ux;
+      g[1] = -uy;
+      g[2] = ux;
+      g[3] = uy;
+      return len - r.value;
+    }
+    case Equation::EqualX:
+      g[0] = 1.0;
+      g[1] = 0.0;
+      g[2] = -1.0;
+      g[3] = 0.0;
+      return px(0) - px(1);
+    case Equation::EqualY:
+      g[0] = 0.0;
+      g[1] = 1.0;
+      g[2] = 0.0;
+      g[3] = -1.0;
+      return py(0) - py(1);
+    case Equation::Parallel:
+    case Equation::Perpendicular:
+    {
+      // Angle from u to w; its gradient never vanishes, unlike the sine or the cross product
+      const double ux = px(1) - px(0), uy = py(1) - py(0);
+      const double wx = px(3) - px(2), wy = py(3) - py(2);
+      const double nu2 = ux * ux + uy * uy, nw2 = wx * wx + wy * wy;
+      if (nu2 == 0.0 || nw2 == 0.0)
+      {
+        std::fill(g, g + 8, 0.0);
+        return 0.0;
+      }
+      double f = std::atan2(ux * wy - uy * wx, ux * wx + uy * wy);
+      if (r.kind == Equation::Parallel)
+      {
+        if (f > kPi / 2) f -= kPi;
+        else if (f < -kPi / 2) f += kPi;
+      }
+      else
+      {
+        f += f < 0.0 ? kPi / 2 : -kPi / 2;
+      }
+      const double dux = uy / nu2, duy = -ux / nu2;
+      const double dwx = -wy / nw2, dwy = wx / nw2;
+      g[0] = -dux;
+      g[1] = -duy;
+      g[2] = dux;
+      g[3] = duy;
+      g[4] = -dwx;
+      g[5] = -dwy;
+      g[6] = dwx;
+      g[7] = dwy;
+      return f;
+    }
+    case Equation::LineTangent:
+    {
+      // |distance of the center from the line| - radius
+      const double ux = px(1) - px(0), uy = py(1) - py(0);
+      const double nu2 = ux * ux + uy * uy;
+      if (nu2 == 0.0)
+      {
+        std::fill(g, g + 8, 0.0);
+        return 0.0;
+      }
+      const double nu   = std::sqrt(nu2);
+      const double ex   = px(2) - px(0), ey = py(2) - py(0);
+      const double dist = (ux * ey - uy * ex) / nu;
+      const double s    = dist < 0.0 ? -1.0 : 1.0;
+      const double dux = s * (ey / nu - dist * ux / nu2), duy = s * (-ex / nu - dist * uy / nu2);
+      const double dex = s * (-uy / nu), dey = s * (ux / nu);
+      double qx, qy;
+      const double radius = unit(px(3) - px(2), py(3) - py(2), qx, qy);
+      g[0] = -dux - dex;
+      g[1] = -duy - dey;
+      g[2] = dux;
+      g[3] = duy;
+      g[4] = dex + qx;
+      g[5] = dey + qy;
+      g[6] = -qx;
+      g[7] = -qy;
+      return s * dist - radius;
+    }
+    case Equation::CircleTangent:
+    {
+      // Center distance - (r1 + r2), or - |r1 - r2| for inner contact
+      double gx, gy, ax, ay, bx, by;
+      const double d  = unit(px(2) - px(0), py(2) - py(0), gx, gy);
+      const double r1 = unit(px(1) - px(0), py(1) - py(0), ax, ay);
+      const double r2 = unit(px(3) - px(2), py(3) - py(2), bx, by);
+      double ka = -1.0, kb = -1.0;
+      if (r.inner)
+      {
+        ka = r1 >= r2 ? -1.0 : 1.0;
+        kb = -ka;
+      }
+      g[0] = -gx - ka * ax;
+      g[1] = -gy - ka * ay;
+      g[2] = ka * ax;
+      g[3] = ka * ay;
+      g[4] = gx - kb * bx;
+      g[5] = gy - kb * by;
+      g[6] = kb * bx;
+      g[7] = kb * by;
+      return d + ka * r1 + kb * r2;
+    }
+    case Equation::OnCircle:
+    {
+      double ax, ay, bx, by;
+      const double r1 = unit(px(1) - px(0), py(1) - py(0), ax, ay);
+      const double r2 = unit(px(2) - px(0), py(2) - py(0), bx, by);
+      g[0] = ax - bx;
+      g[1] = ay - by;
+      g[2] = -ax;
+      g[3] = -ay;
+      g[4] = bx;
+      g[5] = by;
+      return r2 - r1;
+    }
+    case Equation::FixX:
+      g[0] = 1.0;
+      g[1] = 0.0;
+      return px(0) - r.value;
+    case Equation::FixY:
+      g[0] = 0.0;
+      g[1] = 1.0;
+      return py(0) - r.value;
+  }
+  return 0.0;
+}
+
+bool ConstraintSolver::solve(const Options& options)
+{
+  m_stats           = Stats{};
+  m_stats.equations = m_rows.size();
+  const std::size_t points = pointCount();
+
+  // Components: union of the points each equation reads
+  std::vector<int> parent(points);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&parent](int i) {
+    while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  for (Row& r : m_rows)
+  {
+    for (int k = 1; k < pointsOf(r.kind); ++k)
+    {
+      const int a = find(r.points[0]), b = find(r.points[k]);
+      if (a != b) parent[b] = a;
+    }
+    if (r.kind == Equation::CircleTangent)
+    {
+      double g[kMaxTerms];
+      Row outer = r;
+      outer.inner = false;
+      Row inner = r;
+      inner.inner = true;
+      r.inner = std::abs(evaluate(inner, g)) < std::abs(evaluate(outer, g));
+    }
+  }
+
+  // Equations grouped by component (counting sort on the root point)
+  std::vector<std::size_t> start(points + 1, 0);
+  for (const Row& r : m_rows) ++start[find(r.points[0]) + 1];
+  std::partial_sum(start.begin(), start.end(), start.begin());
+  std::vector<std::size_t> fill(start.begin(), start.end() - 1);
+  m_order.resize(m_rows.size());
+  for (std::size_t i = 0; i < m_rows.size(); ++i)
+    m_order[fill[find(m_rows[i].points[0])]++] = static_cast<int>(i);
+
+  m_localOf.assign(points * 2, -1);
+  m_vars.clear();
+  bool converged = true;
+  for (std::size_t p = 0; p < points; ++p)
+  {
+    if (start[p] == start[p + 1]) continue;
+    ++m_stats.components;
+    if (!solveComponent(start[p], start[p + 1], options))
+    {
+      converged = false;
+      ++m_stats.failed;
+    }
+  }
+  double g[kMaxTerms];
+  for (const Row& r : m_rows) m_stats.residual = std::max(m_stats.residual, std::abs(evaluate(r, g)));
+  return converged;
+}
+
+double ConstraintSolver::residuals(std::size_t begin, std::size_t end, std::vector<double>& f) const
+{
+  double g[kMaxTerms];
+  double worst = 0.0;
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    const double v = evaluate(m_rows[m_order[i]], g);
+    f[i - begin]   = v;
+    worst          = std::max(worst, std::abs(v));
+  }
+  return worst;
+}
+
+bool ConstraintSolver::solveComponent(std::size_t begin, std::size_t end, const Options& options)
+{
+  const std::size_t m = end - begin;
+  m_f.resize(m);
+  m_trial.resize(m);
+  if (residuals(begin, end, m_f) <= options.tolerance) return true;
+  analyse(begin, end);
+
+  auto sumSquares = [m](const std::vector<double>& f) {
+    double s = 0.0;
+    for (std::size_t i = 0; i < m; ++i) s += f[i] * f[i];
+    return s;
+  };
+  double cost   = sumSquares(m_f);
+  double scale  = 0.0;  // largest diagonal of J J^T at the start
+  double lambda = 0.0;
+  double onDiag = 0.0;  // damping currently added to m_ax
+  bool   fresh  = true; // the point moved since the last assembly
+  for (int it = 0; it < options.maxIterations; ++it)
+  {
+    if (fresh)
+    {
+      assemble(begin, end);
+      onDiag = 0.0;
+      if (scale == 0.0)
+      {
+        for (std::size_t i = 0; i < m; ++i) scale = std::max(scale, m_ax[m_diag[i]]);
+        if (scale == 0.0) return false; // no equation depends on a point
+        lambda = scale * 1.0e-6;
+      }
+    }
+    for (std::size_t i = 0; i < m; ++i) m_ax[m_diag[i]] += lambda - onDiag;
+    onDiag = lambda;
+    ++m_stats.iterations;
+    if (!factor())
+    {
+      lambda *= 10.0;
+      fresh = false;
+      continue;
+    }
+
+    // y = -(J J^T + lambda I)^-1 f, then step by J^T y
+    for (std::size_t i = 0; i < m; ++i) m_rhs[i] = -m_f[i];
+    solveFactored(m_rhs);
+    for (std::size_t v = 0; v < m_vars.size(); ++v) m_saved[v] = m_x[m_vars[v]];
+    for (std::size_t i = 0; i < m; ++i)
+    {
+      for (int t = 0; t < kMaxTerms; ++t)
+      {
+        const int v = m_termVar[i * kMaxTerms + t];
+        if (v >= 0) m_x[m_vars[v]] += m_jac[i * kMaxTerms + t] * m_rhs[i];
+      }
+    }
+
+    const double worst     = residuals(begin, end, m_trial);
+    const double trialCost = sumSquares(m_trial);
+    if (trialCost < cost)
+    {
+      m_f.swap(m_trial);
+      cost  = trialCost;
+      fresh = true;
+      if (worst <= options.tolerance) return true;
+      lambda = std::max(lambda * 0.1, scale * kMinDamping);
+    }
+    else
+    {
+      for (std::size_t v = 0; v < m_vars.size(); ++v) m_x[m_vars[v]] = m_saved[v];
+      fresh = false;
+      lambda *= 10.0;
+      if (lambda > scale * kMaxDamping) return false;
+    }
+  }
+  return false;
+}
+
+void ConstraintSolver::analyse(std::size_t begin, std::size_t end)
+{
+  const int m = static_cast<int>(end - begin);
+
+  // Local variables in first-use order
+  for (int v : m_vars) m_localOf[v] = -1;
+  m_vars.clear();
+  m_termVar.assign(m * kMaxTerms, -1);
+  m_jac.assign(m * kMaxTerms, 0.0);
+  for (int i = 0; i < m; ++i)
+  {
+    const Row& r = m_rows[m_order[begin + i]];
+    for (int t = 0; t < termCount(r); ++t)
+    {
+      const int gv = r.points[t / 2] * 2 + (t & 1);
+      int&      lv = m_localOf[gv];
+      if (lv < 0)
+      {
+        lv = static_cast<int>(m_vars.size());
+        m_vars.push_back(gv);
+      }
+      m_termVar[i * kMaxTerms + t] = lv;
+    }
+  }
+  const std::size_t nv = m_vars.size();
+
+  // Variable -> equations (each equation once per variable)
+  auto firstUse = [this](int i, int t) {
+    const int* vars = &m_termVar[i * kMaxTerms];
+    return vars[t] >= 0 && std::find(vars, vars + t, vars[t]) == vars + t;
+  };
+  m_varPtr.assign(nv + 1, 0);
+  for (int i = 0; i < m; ++i)
+    for (int t = 0; t < kMaxTerms; ++t)
+      if (firstUse(i, t)) ++m_varPtr[m_termVar[i * kMaxTerms + t] + 1];
+  std::partial_sum(m_varPtr.begin(), m_varPtr.end(), m_varPtr.begin());
+  m_varEq.resize(m_varPtr[nv]);
+  std::vector<int> next(m_varPtr.begin(), m_varPtr.end() - 1);
+  for (int i = 0; i < m; ++i)
+    for (int t = 0; t < kMaxTerms; ++t)
+      if (firstUse(i, t)) m_varEq[next[m_termVar[i * kMaxTerms + t]]++] = i;
+
+  // Pattern of J J^T: equation i couples with every equation reading one of its variables
+  m_flag.assign(m, -1);
+  m_ap.assign(m + 1, 0);
+  m_diag.resize(m);
+  m_ai.clear();
+  for (int i = 0; i < m; ++i)
+  {
+    m_flag[i] = i;
+    m_diag[i] = static_cast<int>(m_ai.size());
+    m_ai.push_back(i);
+    for (int t = 0; t < kMaxTerms; ++t)
+    {
+      const int v = m_termVar[i * kMaxTerms + t];
+      if (v < 0) continue;
+      for (int p = m_varPtr[v]; p < m_varPtr[v + 1]; ++p)
+      {
+        const int e = m_varEq[p];
+        if (m_flag[e] == i) continue;
+        m_flag[e] = i;
+        m_ai.push_back(e);
+      }
+    }
+    m_ap[i + 1] = static_cast<int>(m_ai.size());
+  }
+  m_ax.resize(m_ai.size());
+  order();
+
+  // Symbolic L D L^T: elimination tree and column counts of the permuted matrix
+  m_parent.assign(m, -1);
+  m_lnz.assign(m, 0);
+  m_flag.assign(m, -1);
+  for (int k = 0; k < m; ++k)
+  {
+    m_flag[k] = k;
+    const int kk = m_perm[k];
+    for (int p = m_ap[kk]; p < m_ap[kk + 1]; ++p)
+    {
+      for (int i = m_inv[m_ai[p]]; i < k && m_flag[i] != k; i = m_parent[i])
+      {
+        if (m_parent[i] == -1) m_parent[i] = k;
+        ++m_lnz[i];
+        m_flag[i] = k;
+      }
+    }
+  }
+  m_lp.assign(m + 1, 0);
+  for (int k = 0; k < m; ++k) m_lp[k + 1] = m_lp[k] + m_lnz[k];
+  m_li.resize(m_lp[m]);
+  m_lx.resize(m_li.size());
+  m_d.resize(m);
+  m_y.assign(m, 0.0);
+  m_pattern.resize(m);
+  m_rhs.resize(m);
+  m_dense.assign(nv, 0.0);
+  m_saved.resize(nv);
+}
+
+void ConstraintSolver::order()
+{
+  // Reverse Cuthill-McKee: breadth-first from a far, low-degree equation, neighbours by degree
+  const int m = static_cast<int>(m_ap.size()) - 1;
+  auto degree = [this](int i) { return m_ap[i + 1] - m_ap[i]; };
+  m_perm.clear();
+  m_inv.assign(m, -1);
+  m_flag.assign(m, -1);
+  m_pattern.resize(m);
+  for (int seed = 0; seed < m; ++seed)
+  {
+    if (m_inv[seed] >= 0) continue;
+    // Start from the lowest-degree equation of the last breadth-first level from the seed
+    int head = 0, tail = 0, level = 0;
+    m_pattern[tail++] = seed;
+    m_flag[seed]      = seed;
+    while (head < tail)
+    {
+      level = head;
+      for (const int levelEnd = tail; head < levelEnd; ++head)
+      {
+        const int i = m_pattern[head];
+        for (int p = m_ap[i]; p < m_ap[i + 1]; ++p)
+        {
+          const int e = m_ai[p];
+          if (m_flag[e] == seed) continue;
+          m_flag[e]         = seed;
+          m_pattern[tail++] = e;
+        }
+      }
+    }
+    const int start = *std::min_element(m_pattern.begin() + level, m_pattern.begin() + tail,
+                                        [&degree](int a, int b) { return degree(a) < degree(b); });
+
+    const std::size_t first = m_perm.size();
+    m_perm.push_back(start);
+    m_inv[start] = 0;
+    for (std::size_t h = first; h < m_perm.size(); ++h)
+    {
+      const int         i    = m_perm[h];
+      const std::size_t from = m_perm.size();
+      for (int p = m_ap[i]; p < m_ap[i + 1]; ++p)
+      {
+        const int e = m_ai[p];
+        if (m_inv[e] >= 0) continue;
+        m_inv[e] = 0;
+        m_perm.push_back(e);
+      }
+      std::sort(m_perm.begin() + static_cast<std::ptrdiff_t>(from), m_perm.end(),
+                [&degree](int a, int b) { return degree(a) != degree(b) ? degree(a) < degree(b) : a < b; });
+    }
+  }
+  std::reverse(m_perm.begin(), m_perm.end());
+  for (int k = 0; k < m; ++k) m_inv[m_perm[k]] = k;
+}
+
+void ConstraintSolver::assemble(std::size_t begin, std::size_t end)
+{
+  const std::size_t m = end - begin;
+  for (std::size_t i = 0; i < m; ++i)
+    evaluate(m_rows[m_order[begin + i]], &m_jac[i * kMaxTerms]);
+  // (J J^T)_ij = J_i . J_j, with row i scattered over the local variables
+  for (std::size_t i = 0; i < m; ++i)
+  {
+    const int*    vi = &m_termVar[i * kMaxTerms];
+    const double* ji = &m_jac[i * kMaxTerms];
+    for (int t = 0; t < kMaxTerms; ++t)
+      if (vi[t] >= 0) m_dense[vi[t]] += ji[t];
+    for (int p = m_ap[i]; p < m_ap[i + 1]; ++p)
+    {
+      const int     e  = m_ai[p];
+      const int*    ve = &m_termVar[e * kMaxTerms];
+      const double* je = &m_jac[e * kMaxTerms];
+      double        s  = 0.0;
+      for (int t = 0; t < kMaxTerms; ++t)
+        if (ve[t] >= 0) s += m_dense[ve[t]] * je[t];
+      m_ax[p] = s;
+    }
+    for (int t = 0; t < kMaxTerms; ++t)
+      if (vi[t] >= 0) m_dense[vi[t]] = 0.0;
+  }
+}
+
+bool ConstraintSolver::factor()
+{
+  // Up-looking L D L^T: row k of L solves against the rows reached through the elimination tree
+  const int m = static_cast<int>(m_perm.size());
+  for (int k = 0; k < m; ++k)
+  {
+    m_y[k]    = 0.0;
+    m_flag[k] = k;
+    m_lnz[k]  = 0;
+    int       top = m;
+    const int kk  = m_perm[k];
+    for (int p = m_ap[kk]; p < m_ap[kk + 1]; ++p)
+    {
+      int i = m_inv[m_ai[p]];
+      if (i > k) continue;
+      m_y[i] += m_ax[p];
+      int len = 0;
+      for (; m_flag[i] != k; i = m_parent[i])
+      {
+        m_pattern[len++] = i;
+        m_flag[i]        = k;
+      }
+      while (len > 0) m_pattern[--top] = m_pattern[--len];
+    }
+    double d = m_y[k];
+    m_y[k] = 0.0;
+    for (; top < m; ++top)
+    {
+      const int    i  = m_pattern[top];
+      const double yi = m_y[i];
+      m_y[i]          = 0.0;
+      const int p2    = m_lp[i] + m_lnz[i];
+      for (int p = m_lp[i]; p < p2; ++p) m_y[m_li[p]] -= m_lx[p] * yi;
+      const double lki = yi / m_d[i];
+      d -= lki * yi;
+      m_li[p2] = k;
+      m_lx[p2] = lki;
+      ++m_lnz[i];
+    }
+    if (!(d > 0.0)) return false;
+    m_d[k] = d;
+  }
+  return true;
+}
+
+void ConstraintSolver::solveFactored(std::vector<double>& b)
+{
+  const std::size_t m = m_perm.size();
+  for (std::size_t k = 0; k < m; ++k) m_y[k] = b[m_perm[k]];
+  for (std::size_t j = 0; j < m; ++j)
+    for (int p = m_lp[j]; p < m_lp[j + 1]; ++p) m_y[m_li[p]] -= m_lx[p] * m_y[j];
+  for (std::size_t j = 0; j < m; ++j) m_y[j] /= m_d[j];
+  for (std::size_t j = m; j-- > 0;)
+    for (int p = m_lp[j]; p < m_lp[j + 1]; ++p) m_y[j] -= m_lx[p] * m_y[m_li[p]];
+  for (std::size_t k = 0; k < m; ++k) b[m_perm[k]] = m_y[k];
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Damped Newton (Levenberg-Marquardt) solver for 2D geometric equations over point variables
+// - Unknowns are the x/y of points added with addPoint(); each equation reads up to four points
+// - Equations split into independent components (union of shared points); each component runs
+//   its own iteration, so a converged or hopeless component does not hold the others back
+// - A step solves (J J^T + lambda I) y = -f and moves by J^T y: the damped minimum-norm Newton
+//   step, which leaves unconstrained directions alone and tolerates redundant equations. The
+//   matrix is sparse (equations sharing a point); it is ordered by reverse Cuthill-McKee and
+//   factored as L D L^T along its elimination tree, so chains and loops factor in near O(m)
+// - Residuals are lengths, except Parallel/Perpendicular, whose residual is the angle (radians) to
+//   the nearest parallel or perpendicular direction. CircleTangent takes outer or inner contact,
+//   whichever is closer in the starting geometry
+class ConstraintSolver
+{
+public:
+  enum class Equation : std::uint8_t
+  {
+    Distance,       // |p1 - p0| = value
+    EqualX,         // p0.x = p1.x
+    EqualY,         // p0.y = p1.y
+    Parallel,       // lines p0-p1 and p2-p3
+    Perpendicular,  // lines p0-p1 and p2-p3
+    LineTangent,    // line p0-p1 touches the circle about p2 through p3
+    CircleTangent,  // circle about p0 through p1 touches the circle about p2 through p3
+    OnCircle,       // |p2 - p0| = |p1 - p0|
+    FixX,           // p0.x = value
+    FixY,           // p0.y = value
+  };
+
+  struct Options
+  {
+    double tolerance{1.0e-10}; // a component is solved once every |residual| is at most this
+    int    maxIterations{50};  // accepted plus rejected steps, per component
+  };
+
+  struct Stats
+  {
+    std::size_t equations{0};
+    std::size_t components{0};
+    std::size_t iterations{0}; // factorizations over all components
+    std::size_t failed{0};     // components left above the tolerance
+    double      residual{0.0}; // largest |residual| after the solve
+  };
+
+  void clear();
+  int  addPoint(double x, double y);
+  void addEquation(Equation kind, int p0, int p1, int p2 = -1, int p3 = -1, double value = 0.0);
+
+  std::size_t pointCount() const { return m_x.size() / 2; }
+  double      x(int point) const { return m_x[static_cast<std::size_t>(point) * 2]; }
+  double      y(int point) const { return m_x[static_cast<std::size_t>(point) * 2 + 1]; }
+
+  // Moves the points; true when every component converged
+  bool         solve(const Options& options);
+  bool         solve() { return solve(Options()); }
+  const Stats& stats() const { return m_stats; }
+
+private:
+  static constexpr int kMaxTerms = 8; // x and y of up to four points
+
+  struct Row
+  {
+    Equation kind;
+    int      points[4];
+    double   value;
+    bool     inner; // CircleTangent: inner contact
+  };
+
+  int    termCount(const Row& r) const;
+  double evaluate(const Row& r, double* grad) const;
+
+  // One component: equations m_rows[m_order[begin..end)]
+  bool   solveComponent(std::size_t begin, std::size_t end, const Options& options);
+  void   analyse(std::size_t begin, std::size_t end);
+  double residuals(std::size_t begin, std::size_t end, std::vector<double>& f) const;
+  void   assemble(std::size_t begin, std::size_t end); // Jacobian and J J^T at the current point
+  void   order();
+  bool   factor();
+  void   solveFactored(std::vector<double>& b);
+
+  std::vector<double> m_x; // x, y per point
+  std::vector<Row>    m_rows;
+  Stats               m_stats;
+
+  // Components: equations grouped by component in m_order
+  std::vector<int> m_order;
+
+  // Scratch of the current component (local equation index = position in its m_order range)
+  std::vector<int>    m_vars;    // local variable -> global variable
+  std::vector<int>    m_localOf; // global variable -> local variable, -1 outside
+  std::vector<int>    m_termVar; // per equation kMaxTerms local variables (-1 unused)
+  std::vector<double> m_jac;     // per equation kMaxTerms derivatives
+  std::vector<int>    m_varPtr, m_varEq; // CSR: variable -> equations reading it
+  // Symmetric pattern of J J^T in CSC (both triangles) by local equation
+  std::vector<int>    m_ap, m_ai, m_diag;
+  std::vector<double> m_ax;
+  std::vector<int>    m_perm, m_inv; // elimination position -> equation, and back
+  // L D L^T factor
+  std::vector<int>    m_lp, m_li, m_parent, m_lnz, m_flag, m_pattern;
+  std::vector<double> m_lx, m_d, m_y;
+  std::vector<double> m_dense; // per local variable scatter of one Jacobian row
+  std::vector<double> m_f, m_trial, m_rhs, m_saved;
+};
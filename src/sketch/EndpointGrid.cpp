@@ -0,0 +1,105 @@
+#include "EndpointGrid.h"
+
+namespace
+{
+std::size_t bucketsFor(std::size_t points)
+{
+  // Load factor of at most one half
+  std::size_t n = 16;
+  while (n < points * 2) n *= 2;
+  return n;
+}
+} // namespace
+
+void EndpointGrid::reset(double cell, std::size_t expected)
+{
+  m_cell = cell;
+  m_size = 0;
+  m_head.assign(built() ? bucketsFor(expected) : 0, -1);
+  m_next.clear();
+  m_prev.clear();
+  m_indexed.clear();
+  m_x.clear();
+  m_y.clear();
+  m_next.reserve(expected);
+  m_prev.reserve(expected);
+  m_indexed.reserve(expected);
+  m_x.reserve(expected);
+  m_y.reserve(expected);
+}
+
+void EndpointGrid::insert(int key, const gp_Pnt2d& p)
+{
+  if (!built() || key < 0) return;
+  const std::size_t k = static_cast<std::size_t>(key);
+  if (k >= m_indexed.size())
+  {
+    m_next.resize(k + 1, -1);
+    m_prev.resize(k + 1, -1);
+    m_indexed.resize(k + 1, 0);
+    m_x.resize(k + 1, 0.0);
+    m_y.resize(k + 1, 0.0);
+  }
+  if (m_indexed[k]) unlink(key);
+  else ++m_size;
+  m_indexed[k] = 1;
+  m_x[k]       = p.X();
+  m_y[k]       = p.Y();
+  if (m_size * 2 > m_head.size()) rehash(bucketsFor(m_size));
+  else link(key);
+}
+
+void EndpointGrid::move(int key, const gp_Pnt2d& to)
+{
+  if (!built() || key < 0 || static_cast<std::size_t>(key) >= m_indexed.size() || !m_indexed[static_cast<std::size_t>(key)])
+    return;
+  const std::size_t k = static_cast<std::size_t>(key);
+  if (bucketOf(m_x[k], m_y[k]) == bucketOf(to.X(), to.Y()))
+  {
+    m_x[k] = to.X();
+    m_y[k] = to.Y();
+    return;
+  }
+  unlink(key);
+  m_x[k] = to.X();
+  m_y[k] = to.Y();
+  link(key);
+}
+
+void EndpointGrid::erase(int key)
+{
+  if (!built() || key < 0 || static_cast<std::size_t>(key) >= m_indexed.size() || !m_indexed[static_cast<std::size_t>(key)])
+    return;
+  unlink(key);
+  m_indexed[static_cast<std::size_t>(key)] = 0;
+  --m_size;
+}
+
+void EndpointGrid::link(int key)
+{
+  const std::size_t k = static_cast<std::size_t>(key);
+  int&              head = m_head[bucketOf(m_x[k], m_y[k])];
+  m_prev[k] = -1;
+  m_next[k] = head;
+  if (head >= 0) m_prev[static_cast<std::size_t>(head)] = key;
+  head = key;
+}
+
+void EndpointGrid::unlink(int key)
+{
+  const std::size_t k = static_cast<std::size_t>(key);
+  if (m_prev[k] >= 0)
+    m_next[static_cast<std::size_t>(m_prev[k])] = m_next[k];
+  else
+    m_head[bucketOf(m_x[k], m_y[k])] = m_next[k];
+  if (m_next[k] >= 0) m_prev[static_cast<std::size_t>(m_next[k])] = m_prev[k];
+}
+
+void EndpointGrid::rehash(std::size_t buckets)
+{
+  m_head.assign(buckets, -1);
+  for (std::size_t k = 0; k < m_indexed.size(); ++k)
+  {
+    if (m_indexed[k]) link(static_cast<int>(k));
+  }
+}
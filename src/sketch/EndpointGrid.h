@@ -0,0 +1,93 @@
+#pragma once
+
+#include <gp_Pnt2d.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform hash grid over sketch endpoints for tolerance queries
+// - Square cells hashed into a power-of-two bucket table; a bucket chains its points through
+//   flat per-key link arrays, so the index allocates nothing per cell or per point
+// - insert()/move()/erase() are O(1), so the index follows edits instead of being rebuilt
+// - query() visits points within tol of p on each axis by scanning the buckets of the cells the
+//   box overlaps (3x3 when the cell size equals tol)
+// - Keys are small non-negative integers (endpoint keys: curve * 2 + end)
+class EndpointGrid
+{
+public:
+  struct Entry
+  {
+    int    key{-1};
+    double x{0.0};
+    double y{0.0};
+  };
+
+  // Drop all points and use 'cell' (> 0) from now on; 'expected' points pre-size the table
+  void reset(double cell, std::size_t expected = 0);
+  void clear() { reset(0.0); }
+  double      cellSize() const { return m_cell; }
+  bool        built() const { return m_cell > 0.0; }
+  std::size_t size() const { return m_size; }
+
+  void insert(int key, const gp_Pnt2d& p);
+  // Relocate an inserted point; no-op for keys that are not indexed
+  void move(int key, const gp_Pnt2d& to);
+  // Drop a point; no-op for keys that are not indexed
+  void erase(int key);
+
+  template <typename Visitor>
+  void query(const gp_Pnt2d& p, double tol, Visitor visit) const
+  {
+    if (!built() || m_size == 0) return;
+    const std::int64_t x0 = coord(p.X() - tol), x1 = coord(p.X() + tol);
+    const std::int64_t y0 = coord(p.Y() - tol), y1 = coord(p.Y() + tol);
+    // Distinct cells may share a bucket; each bucket is scanned once. The usual box of at most
+    // 3x3 cells stays on the stack
+    const std::size_t        cells = static_cast<std::size_t>((x1 - x0 + 1) * (y1 - y0 + 1));
+    std::size_t              local[9];
+    std::vector<std::size_t> wide;
+    std::size_t*             buckets = local;
+    if (cells > 9)
+    {
+      wide.resize(cells);
+      buckets = wide.data();
+    }
+    std::size_t n = 0;
+    for (std::int64_t cx = x0; cx <= x1; ++cx)
+      for (std::int64_t cy = y0; cy <= y1; ++cy) buckets[n++] = bucketOf(cx, cy);
+    std::sort(buckets, buckets + n);
+    n = static_cast<std::size_t>(std::unique(buckets, buckets + n) - buckets);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const std::size_t b = buckets[i];
+      for (int k = m_head[b]; k >= 0; k = m_next[static_cast<std::size_t>(k)])
+      {
+        const double x = m_x[static_cast<std::size_t>(k)], y = m_y[static_cast<std::size_t>(k)];
+        if (std::abs(x - p.X()) <= tol && std::abs(y - p.Y()) <= tol) visit(Entry{k, x, y});
+      }
+    }
+  }
+
+private:
+  std::int64_t coord(double v) const { return static_cast<std::int64_t>(std::floor(v / m_cell)); }
+  std::size_t  bucketOf(std::int64_t cx, std::int64_t cy) const
+  {
+    const std::uint64_t h = static_cast<std::uint64_t>(cx) * 0x9E3779B97F4A7C15ull ^ static_cast<std::uint64_t>(cy) * 0xC2B2AE3D27D4EB4Full;
+    return static_cast<std::size_t>(h >> 32 ^ h) & (m_head.size() - 1);
+  }
+  std::size_t bucketOf(double x, double y) const { return bucketOf(coord(x), coord(y)); }
+  void        link(int key);
+  void        unlink(int key);
+  void        rehash(std::size_t buckets);
+
+  double              m_cell{0.0};
+  std::size_t         m_size{0};
+  std::vector<int>    m_head;     // bucket -> first key, -1 when empty
+  std::vector<int>    m_next;     // key -> next key in its bucket
+  std::vector<int>    m_prev;     // key -> previous key in its bucket, -1 at the head
+  std::vector<char>   m_indexed;  // key -> inserted
+  std::vector<double> m_x, m_y;   // key -> indexed position
+};
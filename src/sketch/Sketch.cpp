@@ -1,20 +1,22 @@
 #include "Sketch.h"
+#include "WeldKernel.h"
 #include <DocumentItem.h>
-#include <sstream>
+#include <TextCodec.h>
+#include <Trace.h>
 
 IMPLEMENT_STANDARD_RTTIEXT(Sketch, DocumentItem)
 
 namespace {
 const bool kSketchReg = [](){
-  DocumentItem::registerFactory(DocumentItem::Kind::Sketch, [](){ return std::shared_ptr<DocumentItem>(new Sketch()); });
+  DocumentItem::registerFactory(DocumentItem::Kind::Sketch, []() -> DocumentItem* { return new Sketch(); });
   return true;
 }();
 }
 
 #include <cmath>
-#include <deque>
-#include <unordered_set>
 #include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
 
 #include <BRepBuilderAPI_MakeEdge.hxx>
 #include <BRepBuilderAPI_MakeWire.hxx>
@@ -29,482 +31,662 @@ const bool kSketchReg = [](){
 
 namespace
 {
-inline bool nearlyEqual(double a, double b, double tol)
+// Grid cells no smaller than this keep cell coordinates of large sketches in range
+constexpr double kMinGridCell = 1.0e-6;
+
+inline double gridCellFor(double tol)
 {
-  return std::abs(a - b) <= tol;
+  return std::max(tol, kMinGridCell);
 }
+}  // namespace
 
-// Simple 2D k-d tree for range queries (axis-aligned rectangle)
-// Used to find near-coincident endpoints in O(log n + k)
-namespace {
-struct KDPoint
+Sketch::CurveId Sketch::addLine(const gp_Pnt2d& a, const gp_Pnt2d& b)
 {
-  double x{0.0};
-  double y{0.0};
-  int    id{-1}; // external identifier (endpoint index)
-};
+  touch();
+  Curve c;
+  c.type = CurveType::Line;
+  c.line = Line{a, b};
+  return pushCurve(allocateSlot(), c);
+}
 
-struct KDNode
+Sketch::CurveId Sketch::addArc(const gp_Pnt2d& center, const gp_Pnt2d& a, const gp_Pnt2d& b, bool clockwise)
 {
-  int point{-1};     // index into pts
-  int left{-1};
-  int right{-1};
-  int axis{0};       // 0 = X, 1 = Y
-  double minx{0}, maxx{0}, miny{0}, maxy{0};
-};
+  touch();
+  Curve c;
+  c.type = CurveType::Arc;
+  c.arc  = Arc{center, a, b, clockwise};
+  return pushCurve(allocateSlot(), c);
+}
 
-class KDTree2D
+std::uint32_t Sketch::allocateSlot()
 {
-public:
-  explicit KDTree2D(std::vector<KDPoint> pts)
-      : pts_(std::move(pts))
+  if (freeSlots_.empty())
   {
-    if (!pts_.empty())
-    {
-      std::vector<int> idx(pts_.size());
-      for (int i = 0; i < static_cast<int>(pts_.size()); ++i) idx[i] = i;
-      nodes_.reserve(pts_.size());
-      root_ = build(idx.begin(), idx.end(), /*depth*/ 0);
-    }
+    slots_.push_back(Slot{});
+    return static_cast<std::uint32_t>(slots_.size() - 1);
   }
+  const std::uint32_t slot = freeSlots_.back();
+  freeSlots_.pop_back();
+  // A fresh generation invalidates every id the slot handed out before
+  slots_[slot].generation = ++slots_[slot].issued;
+  return slot;
+}
 
-  // Visit all points within axis-aligned rectangle [xmin,xmax] x [ymin,ymax]
-  template <typename Visitor>
-  void rangeQuery(double xmin, double ymin, double xmax, double ymax, Visitor visit) const
+Sketch::CurveId Sketch::pushCurve(std::uint32_t slot, const Curve& c)
+{
+  const std::size_t position = types_.size();
+  const std::size_t key      = position * 2;
+  const gp_Pnt2d&   a        = c.type == CurveType::Line ? c.line.p1 : c.arc.p1;
+  const gp_Pnt2d&   b        = c.type == CurveType::Line ? c.line.p2 : c.arc.p2;
+  types_.push_back(c.type);
+  idSlot_.push_back(slot);
+  if (c.type == CurveType::Arc)
   {
-    if (root_ != -1)
-      rangeQueryRec(root_, xmin, ymin, xmax, ymax, visit);
+    arcSlot_.push_back(static_cast<int>(arcCenters_.size()));
+    arcCenters_.push_back(c.arc.center);
+    arcClockwise_.push_back(c.arc.clockwise ? 1 : 0);
+    arcCurve_.push_back(static_cast<int>(position));
   }
+  else
+  {
+    arcSlot_.push_back(-1);
+  }
+  xs_.push_back(a.X());
+  ys_.push_back(a.Y());
+  xs_.push_back(b.X());
+  ys_.push_back(b.Y());
+  slots_[slot].position = static_cast<std::int32_t>(position);
+  grid_.insert(static_cast<int>(key), a);
+  grid_.insert(static_cast<int>(key + 1), b);
+  if (!fullSolve_)
+  {
+    dirty_.push_back(key);
+    dirty_.push_back(key + 1);
+  }
+  return makeId(slot, slots_[slot].generation);
+}
 
-private:
-  using It = std::vector<int>::iterator;
-
-  int build(It begin, It end, int depth)
+bool Sketch::removeCurve(CurveId id)
+{
+  if (!contains(id))
+    return false;
+  touch();
+  const std::uint32_t slot = slotOf(id);
+  const std::size_t   pos  = static_cast<std::size_t>(slots_[slot].position);
+  const std::size_t   last = types_.size() - 1;
+
+  // Arc data: the last arc moves into the hole
+  if (arcSlot_[pos] >= 0)
   {
-    if (begin == end) return -1;
-    int axis = depth % 2;
-    auto mid = begin + (std::distance(begin, end) / 2);
-    std::nth_element(begin, mid, end, [&](int a, int b){
-      return axis == 0 ? (pts_[a].x < pts_[b].x) : (pts_[a].y < pts_[b].y);
-    });
-
-    int nodeIndex = static_cast<int>(nodes_.size());
-    nodes_.push_back(KDNode{});
-    KDNode& node = nodes_.back();
-    node.axis = axis;
-    node.point = *mid;
-
-    // Build subtrees
-    node.left = build(begin, mid, depth + 1);
-    node.right = build(mid + 1, end, depth + 1);
-
-    // Compute bounding box
-    const KDPoint& p = pts_[node.point];
-    node.minx = node.maxx = p.x;
-    node.miny = node.maxy = p.y;
-    if (node.left != -1)
+    const std::size_t hole    = static_cast<std::size_t>(arcSlot_[pos]);
+    const std::size_t lastArc = arcCenters_.size() - 1;
+    if (hole != lastArc)
     {
-      const KDNode& L = nodes_[node.left];
-      node.minx = std::min(node.minx, L.minx);
-      node.maxx = std::max(node.maxx, L.maxx);
-      node.miny = std::min(node.miny, L.miny);
-      node.maxy = std::max(node.maxy, L.maxy);
+      arcCenters_[hole]   = arcCenters_[lastArc];
+      arcClockwise_[hole] = arcClockwise_[lastArc];
+      arcCurve_[hole]     = arcCurve_[lastArc];
+      arcSlot_[static_cast<std::size_t>(arcCurve_[hole])] = static_cast<int>(hole);
     }
-    if (node.right != -1)
+    arcCenters_.pop_back();
+    arcClockwise_.pop_back();
+    arcCurve_.pop_back();
+  }
+
+  // Curve data: the last curve moves into the hole, keeping storage dense
+  grid_.erase(static_cast<int>(pos * 2));
+  grid_.erase(static_cast<int>(pos * 2 + 1));
+  if (pos != last)
+  {
+    types_[pos]   = types_[last];
+    arcSlot_[pos] = arcSlot_[last];
+    idSlot_[pos]  = idSlot_[last];
+    for (std::size_t e = 0; e < 2; ++e)
     {
-      const KDNode& R = nodes_[node.right];
-      node.minx = std::min(node.minx, R.minx);
-      node.maxx = std::max(node.maxx, R.maxx);
-      node.miny = std::min(node.miny, R.miny);
-      node.maxy = std::max(node.maxy, R.maxy);
+      xs_[pos * 2 + e] = xs_[last * 2 + e];
+      ys_[pos * 2 + e] = ys_[last * 2 + e];
+      grid_.erase(static_cast<int>(last * 2 + e));
+      grid_.insert(static_cast<int>(pos * 2 + e), gp_Pnt2d(xs_[pos * 2 + e], ys_[pos * 2 + e]));
     }
-
-    return nodeIndex;
+    if (arcSlot_[pos] >= 0) arcCurve_[static_cast<std::size_t>(arcSlot_[pos])] = static_cast<int>(pos);
+    slots_[idSlot_[pos]].position = static_cast<std::int32_t>(pos);
   }
+  types_.pop_back();
+  arcSlot_.pop_back();
+  idSlot_.pop_back();
+  xs_.resize(last * 2);
+  ys_.resize(last * 2);
+
+  slots_[slot].position = ~static_cast<std::int32_t>(freeSlots_.size());
+  freeSlots_.push_back(slot);
+
+  // Endpoint keys moved and union-find cannot drop members: the next solve starts over
+  uf_parent_.clear();
+  uf_next_.clear();
+  dirty_.clear();
+  fullSolve_ = true;
+  return true;
+}
 
-  template <typename Visitor>
-  void rangeQueryRec(int nodeIndex, double xmin, double ymin, double xmax, double ymax, Visitor visit) const
-  {
-    const KDNode& node = nodes_[nodeIndex];
-    // If node bounding box does not intersect query rect, prune
-    if (node.maxx < xmin || node.minx > xmax || node.maxy < ymin || node.miny > ymax)
-      return;
+bool Sketch::restoreCurve(CurveId id, const Curve& curve)
+{
+  if (id < 0)
+    return false;
+  const std::uint32_t slot = slotOf(id);
+  if (slot >= slots_.size() || slots_[slot].position >= 0 || generationOf(id) > slots_[slot].issued)
+    return false;
+  touch();
+  // Take the slot off the free list
+  const std::size_t   at    = static_cast<std::size_t>(~slots_[slot].position);
+  const std::uint32_t moved = freeSlots_.back();
+  freeSlots_[at]            = moved;
+  slots_[moved].position    = ~static_cast<std::int32_t>(at);
+  freeSlots_.pop_back();
+
+  slots_[slot].generation = generationOf(id);
+  pushCurve(slot, curve);
+  // Constraints on the curve were skipped while it was gone
+  fullSolve_ = true;
+  return true;
+}
 
-    const KDPoint& p = pts_[node.point];
-    if (p.x >= xmin && p.x <= xmax && p.y >= ymin && p.y <= ymax)
-      visit(p);
+void Sketch::addCoincident(const EndpointRef& a, const EndpointRef& b)
+{
+  denseOf(a.curve); // throws for unknown ids
+  denseOf(b.curve);
+  pushConstraint(Constraint{ConstraintType::Coincident, a, b});
+}
 
-    if (node.left != -1)  rangeQueryRec(node.left, xmin, ymin, xmax, ymax, visit);
-    if (node.right != -1) rangeQueryRec(node.right, xmin, ymin, xmax, ymax, visit);
-  }
+void Sketch::addDistance(const EndpointRef& a, const EndpointRef& b, double distance)
+{
+  denseOf(a.curve); // throws for unknown ids
+  denseOf(b.curve);
+  if (!(distance >= 0.0)) throw std::invalid_argument("Sketch: negative distance");
+  pushConstraint(Constraint{ConstraintType::Distance, a, b, distance});
+}
 
-  std::vector<KDPoint> pts_;
-  std::vector<KDNode>  nodes_;
-  int root_{-1};
-};
-} // namespace
+void Sketch::addHorizontal(CurveId line)
+{
+  requireType(line, CurveType::Line, "Sketch: horizontal needs a line");
+  pushConstraint(Constraint{ConstraintType::Horizontal, EndpointRef{line}, EndpointRef{line}});
+}
 
-inline bool samePoint(const gp_Pnt2d& a, const gp_Pnt2d& b, double tol)
+void Sketch::addVertical(CurveId line)
 {
-  return nearlyEqual(a.X(), b.X(), tol) && nearlyEqual(a.Y(), b.Y(), tol);
+  requireType(line, CurveType::Line, "Sketch: vertical needs a line");
+  pushConstraint(Constraint{ConstraintType::Vertical, EndpointRef{line}, EndpointRef{line}});
 }
-}  // namespace
 
-Sketch::CurveId Sketch::addLine(const gp_Pnt2d& a, const gp_Pnt2d& b)
+void Sketch::addParallel(CurveId line1, CurveId line2)
 {
-  Curve c;
-  c.type = CurveType::Line;
-  c.line = Line{a, b};
-  curves_.push_back(c);
-  return static_cast<CurveId>(curves_.size() - 1);
+  requireType(line1, CurveType::Line, "Sketch: parallel needs lines");
+  requireType(line2, CurveType::Line, "Sketch: parallel needs lines");
+  pushConstraint(Constraint{ConstraintType::Parallel, EndpointRef{line1}, EndpointRef{line2}});
 }
 
-Sketch::CurveId Sketch::addArc(const gp_Pnt2d& center, const gp_Pnt2d& a, const gp_Pnt2d& b, bool clockwise)
+void Sketch::addPerpendicular(CurveId line1, CurveId line2)
 {
-  Curve c;
-  c.type = CurveType::Arc;
-  c.arc = Arc{center, a, b, clockwise};
-  curves_.push_back(c);
-  return static_cast<CurveId>(curves_.size() - 1);
+  requireType(line1, CurveType::Line, "Sketch: perpendicular needs lines");
+  requireType(line2, CurveType::Line, "Sketch: perpendicular needs lines");
+  pushConstraint(Constraint{ConstraintType::Perpendicular, EndpointRef{line1}, EndpointRef{line2}});
 }
 
-void Sketch::addCoincident(const EndpointRef& a, const EndpointRef& b)
+void Sketch::addTangent(CurveId curve1, CurveId curve2)
 {
-  constraints_.push_back(Constraint{ConstraintType::Coincident, a, b});
+  if (curveType(curve1) == CurveType::Line && curveType(curve2) == CurveType::Line)
+    throw std::invalid_argument("Sketch: tangent needs an arc");
+  pushConstraint(Constraint{ConstraintType::Tangent, EndpointRef{curve1}, EndpointRef{curve2}});
 }
 
-void Sketch::solveConstraints(double tol)
+void Sketch::addRadius(CurveId arc, double radius)
+{
+  requireType(arc, CurveType::Arc, "Sketch: radius needs an arc");
+  if (!(radius >= 0.0)) throw std::invalid_argument("Sketch: negative radius");
+  pushConstraint(Constraint{ConstraintType::Radius, EndpointRef{arc}, EndpointRef{arc}, radius});
+}
+
+void Sketch::addFixed(const EndpointRef& r)
+{
+  pushConstraint(Constraint{ConstraintType::Fixed, r, r, 0.0, endpoint(r)});
+}
+
+void Sketch::pushConstraint(const Constraint& c)
+{
+  touch();
+  constraints_.push_back(c);
+  if (c.type != ConstraintType::Coincident) ++geometric_;
+}
+
+void Sketch::requireType(CurveId id, CurveType type, const char* what) const
+{
+  if (curveType(id) != type) throw std::invalid_argument(what);
+}
+
+void Sketch::moveEndpoint(const EndpointRef& r, const gp_Pnt2d& p)
 {
-  // Initialize union-find for all endpoints
-  const std::size_t epCount = curves_.size() * 2;
-  ufInit(epCount);
+  touch();
+  const std::size_t key = endpointKey(r);
+  // Union-find cannot split a cluster: leaving one needs the clusters rebuilt
+  if (key < uf_next_.size() && uf_next_[key] != key) fullSolve_ = true;
+  setEndpoint(key, p);
+  if (!fullSolve_) dirty_.push_back(key);
+}
 
-  // First, union existing near-coincident endpoints using spatial index (k-d tree)
-  if (!curves_.empty())
+void Sketch::solveConstraints(double tol)
+{
+  CAD_TRACE_SCOPE("sketch", "Sketch::solveConstraints");
+  touch();
+  const std::size_t epCount = xs_.size();
+  solveStats_ = SolveStats{};
+  if (!fullSolve_ && tol == solvedTol_ && uf_parent_.size() <= epCount)
   {
-    std::vector<KDPoint> pts;
-    pts.reserve(epCount);
-    for (std::size_t i = 0; i < curves_.size(); ++i)
+    // Incremental: new endpoints join as singletons, then only touched endpoints are welded
+    solveStats_.incremental = true;
+    if (!dirty_.empty() && (!grid_.built() || grid_.cellSize() != gridCellFor(tol))) buildGrid(tol);
+    for (std::size_t i = uf_parent_.size(); i < epCount; ++i)
     {
-      for (int e = 0; e < 2; ++e)
-      {
-        EndpointRef r{static_cast<int>(i), e};
-        const auto p = getEndpoint(r);
-        pts.push_back(KDPoint{p.X(), p.Y(), static_cast<int>(endpointKey(r))});
-      }
+      uf_parent_.push_back(i);
+      uf_next_.push_back(i);
     }
-    KDTree2D kdt(std::move(pts));
+    for (std::size_t key : dirty_) weldEndpoint(key, tol);
+    solveStats_.queried = dirty_.size();
 
-    // For each endpoint, query its neighborhood rectangle [x±tol, y±tol]
-    for (std::size_t i = 0; i < epCount; ++i)
+    std::vector<std::size_t> roots;
+    roots.reserve(dirty_.size() + 2 * (constraints_.size() - solvedConstraints_));
+    for (std::size_t i = solvedConstraints_; i < constraints_.size(); ++i)
     {
-      int cid = static_cast<int>(i);
-      // Re-extract point position
-      int curveIdx = static_cast<int>(i / 2);
-      int endIdx   = static_cast<int>(i % 2);
-      const gp_Pnt2d p = getEndpoint(EndpointRef{curveIdx, endIdx});
-      const double xmin = p.X() - tol, xmax = p.X() + tol;
-      const double ymin = p.Y() - tol, ymax = p.Y() + tol;
-      kdt.rangeQuery(xmin, ymin, xmax, ymax, [&](const KDPoint& q){
-        if (q.id > cid) // avoid duplicate unions
-        {
-          // Match original samePoint semantics (axis-wise tolerance)
-          if (nearlyEqual(p.X(), q.x, tol) && nearlyEqual(p.Y(), q.y, tol))
-          {
-            ufUnion(static_cast<std::size_t>(cid), static_cast<std::size_t>(q.id));
-          }
-        }
-      });
+      const Constraint& c = constraints_[i];
+      if (c.type != ConstraintType::Coincident || !liveConstraint(c))
+        continue;
+      ufUnion(endpointKey(c.a), endpointKey(c.b));
+      roots.push_back(endpointKey(c.a));
     }
+    for (std::size_t key : dirty_) roots.push_back(key);
+    for (std::size_t& key : roots) key = ufFind(key);
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+    for (std::size_t root : roots) averageCluster(root);
+    solveStats_.clusters = roots.size();
   }
-
-  // Apply explicit coincident constraints
-  for (const auto& c : constraints_)
+  else
   {
-    if (c.type != ConstraintType::Coincident)
-      continue;
-    ufUnion(endpointKey(c.a), endpointKey(c.b));
+    // Full: union near-coincident endpoints, then explicit coincident constraints
+    ufInit(epCount);
+    weldCoincident(tol);
+    solveStats_.queried = epCount;
+    for (const auto& c : constraints_)
+    {
+      if (c.type != ConstraintType::Coincident || !liveConstraint(c))
+        continue;
+      ufUnion(endpointKey(c.a), endpointKey(c.b));
+    }
+    for (std::size_t i = 0; i < epCount; ++i)
+    {
+      if (ufFind(i) != i)
+        continue;
+      averageCluster(i);
+      ++solveStats_.clusters;
+    }
+    // Index the welded positions so the next edit pays only for its own lookups
+    buildGrid(tol);
   }
+  dirty_.clear();
+  solvedConstraints_ = constraints_.size();
+  solvedTol_         = tol;
+  fullSolve_         = false;
+  if (geometric_ != 0) solveGeometry();
+}
 
-  // Compute cluster representatives -> average positions of each cluster
-  struct Acc
-  {
-    double x{0}, y{0};
-    std::size_t n{0};
+void Sketch::solveGeometry()
+{
+  // Solver points: one per endpoint cluster (its root key) and one per arc center (~arc slot)
+  solver_.clear();
+  std::vector<std::int64_t>            owner;
+  std::unordered_map<std::int64_t, int> pointOf;
+  pointOf.reserve(geometric_ * 4);
+  auto point = [&](std::int64_t key, const gp_Pnt2d& p) {
+    auto [it, isNew] = pointOf.emplace(key, 0);
+    if (isNew)
+    {
+      it->second = solver_.addPoint(p.X(), p.Y());
+      owner.push_back(key);
+    }
+    return it->second;
+  };
+  auto endPoint = [&](CurveId id, int e) {
+    const std::size_t root = ufFind(denseOf(id) * 2 + static_cast<std::size_t>(e & 1));
+    return point(static_cast<std::int64_t>(root), gp_Pnt2d(xs_[root], ys_[root]));
   };
-  std::unordered_map<std::size_t, Acc> accum;
-  for (std::size_t i = 0; i < curves_.size(); ++i)
+  auto center = [&](CurveId id) {
+    const int slot = arcSlot_[denseOf(id)];
+    return point(~static_cast<std::int64_t>(slot), arcCenters_[static_cast<std::size_t>(slot)]);
+  };
+  using Eq = ConstraintSolver::Equation;
+  for (const Constraint& c : constraints_)
   {
-    for (int e = 0; e < 2; ++e)
+    if (c.type == ConstraintType::Coincident || !liveConstraint(c))
+      continue;
+    // A restored curve may have changed its type: constraints that no longer fit are skipped
+    const bool lineA = curveType(c.a.curve) == CurveType::Line;
+    const bool lineB = curveType(c.b.curve) == CurveType::Line;
+    switch (c.type)
     {
-      EndpointRef r{static_cast<int>(i), e};
-      const auto rep = ufFind(endpointKey(r));
-      const auto p = getEndpoint(r);
-      auto& a = accum[rep];
-      a.x += p.X();
-      a.y += p.Y();
-      a.n += 1;
+      case ConstraintType::Coincident: break;
+      case ConstraintType::Distance:
+        solver_.addEquation(Eq::Distance, endPoint(c.a.curve, c.a.endIndex), endPoint(c.b.curve, c.b.endIndex), -1, -1, c.value);
+        break;
+      case ConstraintType::Horizontal:
+      case ConstraintType::Vertical:
+        if (!lineA) break;
+        solver_.addEquation(c.type == ConstraintType::Horizontal ? Eq::EqualY : Eq::EqualX, endPoint(c.a.curve, 0),
+                            endPoint(c.a.curve, 1));
+        break;
+      case ConstraintType::Parallel:
+      case ConstraintType::Perpendicular:
+        if (!lineA || !lineB) break;
+        solver_.addEquation(c.type == ConstraintType::Parallel ? Eq::Parallel : Eq::Perpendicular, endPoint(c.a.curve, 0),
+                            endPoint(c.a.curve, 1), endPoint(c.b.curve, 0), endPoint(c.b.curve, 1));
+        break;
+      case ConstraintType::Tangent:
+        if (lineA && lineB) break;
+        if (lineA || lineB)
+        {
+          const CurveId line = lineA ? c.a.curve : c.b.curve, arc = lineA ? c.b.curve : c.a.curve;
+          solver_.addEquation(Eq::LineTangent, endPoint(line, 0), endPoint(line, 1), center(arc), endPoint(arc, 0));
+        }
+        else
+        {
+          solver_.addEquation(Eq::CircleTangent, center(c.a.curve), endPoint(c.a.curve, 0), center(c.b.curve),
+                              endPoint(c.b.curve, 0));
+        }
+        break;
+      case ConstraintType::Radius:
+        if (lineA) break;
+        solver_.addEquation(Eq::Distance, center(c.a.curve), endPoint(c.a.curve, 0), -1, -1, c.value);
+        break;
+      case ConstraintType::Fixed:
+      {
+        const int p = endPoint(c.a.curve, c.a.endIndex);
+        solver_.addEquation(Eq::FixX, p, -1, -1, -1, c.point.X());
+        solver_.addEquation(Eq::FixY, p, -1, -1, -1, c.point.Y());
+        break;
+      }
     }
   }
-
-  // Assign averaged positions to each endpoint cluster
-  std::unordered_map<std::size_t, gp_Pnt2d> clusterPoint;
-  clusterPoint.reserve(accum.size());
-  for (const auto& kv : accum)
+  // Arcs with an endpoint in the system keep both endpoints on their circle; this can pull in
+  // further clusters, which are scanned in turn
+  std::vector<char> arcDone(arcCenters_.size(), 0);
+  for (std::size_t k = 0; k < owner.size(); ++k)
   {
-    const auto rep = kv.first;
-    const auto& a = kv.second;
-    clusterPoint.emplace(rep, gp_Pnt2d(a.x / static_cast<double>(a.n), a.y / static_cast<double>(a.n)));
+    if (owner[k] < 0) continue;
+    const std::size_t root = static_cast<std::size_t>(owner[k]);
+    std::size_t       i    = root;
+    do
+    {
+      const int slot = arcSlot_[i / 2];
+      if (slot >= 0 && !arcDone[static_cast<std::size_t>(slot)])
+      {
+        arcDone[static_cast<std::size_t>(slot)] = 1;
+        const CurveId id = curveId(i / 2);
+        solver_.addEquation(Eq::OnCircle, center(id), endPoint(id, 0), endPoint(id, 1));
+      }
+      i = uf_next_[i];
+    } while (i != root);
   }
 
-  // Write back averaged positions to all endpoints according to their cluster
-  for (std::size_t i = 0; i < curves_.size(); ++i)
+  const bool converged  = solver_.solve();
+  const auto& st        = solver_.stats();
+  solveStats_.equations  = st.equations;
+  solveStats_.iterations = st.iterations;
+  solveStats_.converged  = converged;
+  solveStats_.residual   = st.residual;
+
+  // Write back; moved endpoints are welded again by the next solve
+  for (std::size_t k = 0; k < owner.size(); ++k)
   {
-    for (int e = 0; e < 2; ++e)
+    const gp_Pnt2d p(solver_.x(static_cast<int>(k)), solver_.y(static_cast<int>(k)));
+    if (owner[k] < 0)
     {
-      EndpointRef r{static_cast<int>(i), e};
-      const auto rep = ufFind(endpointKey(r));
-      setEndpoint(r, clusterPoint.at(rep));
+      arcCenters_[static_cast<std::size_t>(~owner[k])] = p;
+      continue;
     }
+    const std::size_t root = static_cast<std::size_t>(owner[k]);
+    if (p.X() == xs_[root] && p.Y() == ys_[root]) continue;
+    std::size_t i = root;
+    do
+    {
+      setEndpoint(i, p);
+      dirty_.push_back(i);
+      i = uf_next_[i];
+    } while (i != root);
   }
 }
 
-std::vector<Sketch::Wire> Sketch::computeWires(double tol) const
+void Sketch::averageCluster(std::size_t root)
 {
-  // Build adjacency graph among curves via endpoint coincidence
-  const std::size_t n = curves_.size();
-  std::vector<std::vector<int>> adj(n);
-  // Map from representative endpoint cluster -> curves touching it
-  std::unordered_map<std::size_t, std::vector<int>> clusterCurves;
+  double      x = 0.0, y = 0.0;
+  std::size_t n = 0;
+  std::size_t i = root;
+  do
+  {
+    x += xs_[i];
+    y += ys_[i];
+    ++n;
+    i = uf_next_[i];
+  } while (i != root);
+  if (n == 1)
+    return;
+  const gp_Pnt2d mean(x / static_cast<double>(n), y / static_cast<double>(n));
+  do
+  {
+    setEndpoint(i, mean);
+    i = uf_next_[i];
+  } while (i != root);
+}
+
+Sketch::Incidence Sketch::buildIncidence() const
+{
+  // Dense cluster index per endpoint, numbered by first appearance in endpoint order
+  const int epCount = static_cast<int>(xs_.size());
+  Incidence inc;
+  inc.clusterOf.assign(static_cast<std::size_t>(epCount), -1);
+  std::vector<int> denseOfRep(static_cast<std::size_t>(epCount), -1);
+  int clusters = 0;
+  for (int ep = 0; ep < epCount; ++ep)
+  {
+    int& dense = denseOfRep[ufFind(static_cast<std::size_t>(ep))];
+    if (dense < 0) dense = clusters++;
+    inc.clusterOf[static_cast<std::size_t>(ep)] = dense;
+  }
+  // Counting sort into CSR; scanning endpoints in order keeps each cluster's list ascending
+  inc.offsets.assign(static_cast<std::size_t>(clusters) + 1, 0);
+  for (int c : inc.clusterOf) ++inc.offsets[static_cast<std::size_t>(c) + 1];
+  for (int c = 0; c < clusters; ++c) inc.offsets[c + 1] += inc.offsets[c];
+  inc.incident.resize(static_cast<std::size_t>(epCount));
+  std::vector<int> fill(inc.offsets.begin(), inc.offsets.end() - 1);
+  for (int ep = 0; ep < epCount; ++ep) inc.incident[fill[inc.clusterOf[ep]]++] = ep;
+  return inc;
+}
 
+void Sketch::buildGrid(double tol)
+{
+  grid_.reset(gridCellFor(tol), xs_.size());
+  for (std::size_t i = 0; i < xs_.size(); ++i) grid_.insert(static_cast<int>(i), gp_Pnt2d(xs_[i], ys_[i]));
+}
+
+void Sketch::weldEndpoint(std::size_t key, double tol)
+{
+  grid_.query(gp_Pnt2d(xs_[key], ys_[key]), tol, [&](const EndpointGrid::Entry& q) {
+    if (static_cast<std::size_t>(q.key) != key) ufUnion(key, static_cast<std::size_t>(q.key));
+  });
+}
+
+void Sketch::weldCoincident(double tol)
+{
+  // Union endpoints closer than tol on each axis
+  WeldKernel kernel;
+  kernel.build(xs_.data(), ys_.data(), xs_.size(), gridCellFor(tol));
+  kernel.forEachPair(tol, [this](int a, int b) { ufUnion(static_cast<std::size_t>(a), static_cast<std::size_t>(b)); });
+}
+
+std::vector<Sketch::Wire> Sketch::computeWires(double tol) const
+{
+  const std::size_t n = types_.size();
   // Initialize UF if empty (e.g., computeWires called before solveConstraints)
   if (uf_parent_.size() != n * 2)
   {
-    // build a temporary UF based on geometry-only clustering via k-d tree
+    // build a temporary UF based on geometry-only clustering
     const_cast<Sketch*>(this)->ufInit(n * 2);
-    if (n > 0)
-    {
-      const std::size_t epCount = n * 2;
-      std::vector<KDPoint> pts;
-      pts.reserve(epCount);
-      for (std::size_t i = 0; i < n; ++i)
-      {
-        for (int e = 0; e < 2; ++e)
-        {
-          EndpointRef r{static_cast<int>(i), e};
-          const auto p = getEndpoint(r);
-          pts.push_back(KDPoint{p.X(), p.Y(), static_cast<int>(endpointKey(r))});
-        }
-      }
-      KDTree2D kdt(std::move(pts));
-      for (std::size_t i = 0; i < epCount; ++i)
-      {
-        int cid = static_cast<int>(i);
-        int curveIdx = static_cast<int>(i / 2);
-        int endIdx   = static_cast<int>(i % 2);
-        const gp_Pnt2d p = getEndpoint(EndpointRef{curveIdx, endIdx});
-        const double xmin = p.X() - tol, xmax = p.X() + tol;
-        const double ymin = p.Y() - tol, ymax = p.Y() + tol;
-        kdt.rangeQuery(xmin, ymin, xmax, ymax, [&](const KDPoint& q){
-          if (q.id > cid)
-          {
-            if (nearlyEqual(p.X(), q.x, tol) && nearlyEqual(p.Y(), q.y, tol))
-            {
-              const_cast<Sketch*>(this)->ufUnion(static_cast<std::size_t>(cid), static_cast<std::size_t>(q.id));
-            }
-          }
-        });
-      }
-    }
+    const_cast<Sketch*>(this)->weldCoincident(tol);
   }
+  const Incidence inc = buildIncidence();
 
-  for (int cid = 0; cid < static_cast<int>(n); ++cid)
-  {
-    for (int e = 0; e < 2; ++e)
+  // Union-find over curves: each cluster links its curves to its first one (no clique)
+  std::vector<int> parent(n);
+  for (std::size_t i = 0; i < n; ++i) parent[i] = static_cast<int>(i);
+  auto find = [&parent](int i) {
+    while (parent[i] != i)
     {
-      EndpointRef r{cid, e};
-      const auto rep = ufFind(endpointKey(r));
-      clusterCurves[rep].push_back(cid);
+      parent[i] = parent[parent[i]]; // path halving
+      i = parent[i];
     }
-  }
-
-  // Connect curves that share an endpoint cluster
-  for (const auto& kv : clusterCurves)
+    return i;
+  };
+  const std::size_t clusters = inc.offsets.size() - 1;
+  for (std::size_t c = 0; c < clusters; ++c)
   {
-    const auto& cs = kv.second;
-    for (std::size_t i = 0; i < cs.size(); ++i)
+    int root = find(inc.incident[inc.offsets[c]] / 2);
+    for (int k = inc.offsets[c] + 1; k < inc.offsets[c + 1]; ++k)
     {
-      for (std::size_t j = i + 1; j < cs.size(); ++j)
-      {
-        adj[cs[i]].push_back(cs[j]);
-        adj[cs[j]].push_back(cs[i]);
-      }
+      int other = find(inc.incident[k] / 2);
+      if (other == root) continue;
+      // The smaller id stays root, so a component is rooted at its lowest curve
+      if (other < root) std::swap(root, other);
+      parent[other] = root;
     }
   }
 
-  // BFS to find connected components as wires
-  std::vector<char> visited(n, 0);
+  // Wires ordered by their lowest curve, curves ascending within a wire
+  std::vector<int> wireOf(n, -1);
   std::vector<Wire> wires;
-  for (int i = 0; i < static_cast<int>(n); ++i)
+  for (std::size_t i = 0; i < n; ++i)
   {
-    if (visited[i])
-      continue;
-    // Isolated curve still forms a single-wire component
-    Wire w;
-    std::deque<int> dq;
-    dq.push_back(i);
-    visited[i] = 1;
-    while (!dq.empty())
+    const int root = find(static_cast<int>(i));
+    if (wireOf[root] < 0)
     {
-      int u = dq.front();
-      dq.pop_front();
-      w.curves.push_back(u);
-      for (int v : adj[u])
-      {
-        if (!visited[v])
-        {
-          visited[v] = 1;
-          dq.push_back(v);
-        }
-      }
+      wireOf[root] = static_cast<int>(wires.size());
+      wires.emplace_back();
     }
-    wires.push_back(std::move(w));
+    wires[static_cast<std::size_t>(wireOf[root])].curves.push_back(curveId(i));
   }
   return wires;
 }
 
 std::vector<Sketch::OrderedPath> Sketch::computeOrderedPaths(double tol) const
 {
-  // Build mapping: cluster -> list of (curveId, endIndex)
-  const std::size_t n = curves_.size();
-  std::unordered_map<std::size_t, std::vector<std::pair<int, int>>> clusterRefs;
-
+  const std::size_t n = types_.size();
   // Ensure union-find reflects current coincidences
   if (uf_parent_.size() != n * 2)
   {
     const_cast<Sketch*>(this)->ufInit(n * 2);
   }
-
-  for (int cid = 0; cid < static_cast<int>(n); ++cid)
+  const Incidence inc   = buildIncidence();
+  const auto      wires = computeWires(tol);
+
+  // Clusters are vertices and curves are edges. Odd-degree clusters of a component are paired by
+  // virtual edges except the first and the last, which leaves an Eulerian trail; a Hierholzer walk
+  // covers it and is cut at the virtual edges, giving the minimum number of paths per component.
+  const std::size_t clusters = inc.offsets.size() - 1;
+  std::vector<int> degree(clusters, 0);
+  for (int c : inc.clusterOf) ++degree[static_cast<std::size_t>(c)];
+  std::vector<int>  virtualPeer(clusters, -1); // at most one virtual edge per odd cluster
+  std::vector<char> used(n, 0);
+  std::vector<char> virtualUsed(clusters, 0);  // indexed by the lower cluster of the pair
+  std::vector<int>  next(inc.offsets.begin(), inc.offsets.end() - 1); // per-cluster scan position
+  std::vector<char> seen(clusters, 0);
+
+  // Walk step: (cluster reached, curve taken or -1 for a virtual edge, reversed)
+  struct Step
   {
-    for (int e = 0; e < 2; ++e)
-    {
-      EndpointRef r{cid, e};
-      const auto rep = ufFind(endpointKey(r));
-      clusterRefs[rep].push_back({cid, e});
-    }
-  }
-
-  // Build wires first (connected sets of curves)
-  const auto wires = computeWires(tol);
-
-  // For each wire, create one or more ordered paths that cover all its curves
-  std::vector<OrderedPath> paths;
-  std::vector<char> used(static_cast<std::size_t>(n), 0);
-
-  // Utility to find cluster representative for a curve endpoint
-  auto epCluster = [&](int curveId, int endIndex) -> std::size_t {
-    return ufFind(endpointKey(EndpointRef{curveId, endIndex}));
+    int  cluster;
+    int  curve;
+    bool reversed;
   };
-
+  std::vector<Step>        stack;
+  std::vector<Step>        trail;
+  std::vector<int>         odd;
+  std::vector<OrderedPath> paths;
   for (const auto& w : wires)
   {
-    // Mark all curves in this component as unused
-    for (int cid : w.curves)
-      used[static_cast<std::size_t>(cid)] = 0;
-
-    // Remaining degree per cluster considering only unused curves
-    std::unordered_map<std::size_t, int> degree;
-    for (int cid : w.curves)
+    // Odd clusters of this component, ascending
+    odd.clear();
+    for (CurveId cid : w.curves)
+    {
+      for (int e = 0; e < 2; ++e)
+      {
+        const int c = inc.clusterOf[denseOf(cid) * 2 + static_cast<std::size_t>(e)];
+        if (seen[c]) continue;
+        seen[c] = 1;
+        if (degree[c] % 2 == 1) odd.push_back(c);
+      }
+    }
+    std::sort(odd.begin(), odd.end());
+    for (std::size_t k = 1; k + 2 < odd.size(); k += 2)
     {
-      degree[epCluster(cid, 0)]++;
-      degree[epCluster(cid, 1)]++;
+      virtualPeer[odd[k]]     = odd[k + 1];
+      virtualPeer[odd[k + 1]] = odd[k];
     }
+    // Open trail from the lowest odd cluster, or a circuit from the lowest curve's start
+    const int start = odd.empty() ? inc.clusterOf[denseOf(w.curves.front()) * 2] : odd.front();
 
-    auto pickStartCluster = [&]() -> std::size_t {
-      // Prefer odd-degree cluster for Eulerian path
-      for (const auto& kv : degree)
+    // Iterative Hierholzer: lowest unused curve first, the virtual edge last
+    trail.clear();
+    stack.push_back(Step{start, -1, false});
+    while (!stack.empty())
+    {
+      const int v = stack.back().cluster;
+      int&      k = next[v];
+      while (k < inc.offsets[v + 1] && used[inc.incident[k] / 2]) ++k;
+      if (k < inc.offsets[v + 1])
       {
-        if (kv.second % 2 == 1)
-          return kv.first;
+        const int ep  = inc.incident[k];
+        const int cid = ep / 2;
+        used[cid] = 1;
+        // Leaving through endpoint 0 runs the curve forward
+        stack.push_back(Step{inc.clusterOf[ep ^ 1], cid, (ep & 1) != 0});
+        continue;
       }
-      // Otherwise take any cluster in this component
-      return epCluster(w.curves.front(), 0);
-    };
-
-    // While there are unused curves in this component, build a path
-    std::size_t remaining = w.curves.size();
-    for (int cid : w.curves)
-      if (used[static_cast<std::size_t>(cid)])
-        --remaining;
-
-    while (true)
+      const int peer = virtualPeer[v];
+      if (peer >= 0 && !virtualUsed[std::min(v, peer)])
+      {
+        virtualUsed[std::min(v, peer)] = 1;
+        stack.push_back(Step{peer, -1, false});
+        continue;
+      }
+      trail.push_back(stack.back());
+      stack.pop_back();
+    }
+    // Popped in reverse; each step keeps the direction it was walked in
+    OrderedPath path;
+    for (auto it = trail.rbegin(); it != trail.rend(); ++it)
     {
-      int notUsedCount = 0;
-      for (int cid : w.curves)
-        if (!used[static_cast<std::size_t>(cid)])
-          ++notUsedCount;
-      if (notUsedCount == 0)
-        break;
-
-      OrderedPath path;
-      std::size_t startCluster = pickStartCluster();
-      std::size_t currentCluster = startCluster;
-
-      // Greedy walk: always take the smallest-id unused curve incident to current cluster
-      while (true)
+      if (it->curve >= 0)
       {
-        int nextCurve = -1;
-        int nextEndIndex = 0;
-        // Iterate candidates at the current cluster
-        auto it = clusterRefs.find(currentCluster);
-        if (it == clusterRefs.end())
-          break;
-        for (const auto& ref : it->second)
-        {
-          int cid = ref.first;
-          if (used[static_cast<std::size_t>(cid)])
-            continue;
-          // Ensure this curve belongs to the current wire
-          if (std::find(w.curves.begin(), w.curves.end(), cid) == w.curves.end())
-            continue;
-          // Prefer the lowest id for determinism
-          if (nextCurve == -1 || cid < nextCurve)
-          {
-            nextCurve = cid;
-            nextEndIndex = ref.second;  // which endpoint touches currentCluster
-          }
-        }
-
-        if (nextCurve == -1)
-          break;  // dead-end
-
-        used[static_cast<std::size_t>(nextCurve)] = 1;
-
-        // Orientation: if we are at endIndex 0, curve goes forward; if 1, reverse
-        bool reversed = (nextEndIndex == 1);
-        path.push_back(OrderedCurve{nextCurve, reversed});
-
-        // Advance to the other endpoint's cluster
-        int otherEnd = (nextEndIndex == 0) ? 1 : 0;
-        currentCluster = epCluster(nextCurve, otherEnd);
-
-        // Decrease degrees to bias next start toward remaining odd-degree clusters
-        degree[currentCluster]--;
+        path.push_back(OrderedCurve{curveId(static_cast<std::size_t>(it->curve)), it->reversed});
       }
-
-      if (!path.empty())
+      else if (!path.empty())
+      {
         paths.push_back(std::move(path));
-      else
-        break;
+        path.clear();
+      }
     }
+    if (!path.empty()) paths.push_back(std::move(path));
   }
-
   return paths;
 }
 
 std::vector<TopoDS_Wire> Sketch::toOcctWires(double tol) const
 {
+  CAD_TRACE_SCOPE("sketch", "Sketch::toOcctWires");
   auto paths = computeOrderedPaths(tol);
   std::vector<TopoDS_Wire> wires;
   wires.reserve(paths.size());
@@ -521,24 +703,26 @@ std::vector<TopoDS_Wire> Sketch::toOcctWires(double tol) const
     BRepBuilderAPI_MakeWire mw;
     for (const auto& oc : path)
     {
-      const auto& c = curves_.at(static_cast<std::size_t>(oc.id));
-      if (c.type == CurveType::Line)
+      const std::size_t pos = denseOf(oc.id);
+      const gp_Pnt2d    p1(xs_[pos * 2], ys_[pos * 2]);
+      const gp_Pnt2d    p2(xs_[pos * 2 + 1], ys_[pos * 2 + 1]);
+      if (types_[pos] == CurveType::Line)
       {
-        gp_Pnt2d a = oc.reversed ? c.line.p2 : c.line.p1;
-        gp_Pnt2d b = oc.reversed ? c.line.p1 : c.line.p2;
+        gp_Pnt2d a = oc.reversed ? p2 : p1;
+        gp_Pnt2d b = oc.reversed ? p1 : p2;
         BRepBuilderAPI_MakeEdge me(toPnt(a), toPnt(b));
         mw.Add(me.Edge());
       }
       else
       {
         // Build 3D circle in XY plane
-        const gp_Pnt2d& center = c.arc.center;
+        const gp_Pnt2d& center = arcCenters_[static_cast<std::size_t>(arcSlot_[pos])];
         gp_Ax2 ax2(gp_Pnt(center.X(), center.Y(), 0.0), gp::DZ());
-        double r = center.Distance(c.arc.p1);
+        double r = center.Distance(p1);
         gp_Circ circ(ax2, r);
 
-        gp_Pnt2d a2d = oc.reversed ? c.arc.p2 : c.arc.p1;
-        gp_Pnt2d b2d = oc.reversed ? c.arc.p1 : c.arc.p2;
+        gp_Pnt2d a2d = oc.reversed ? p2 : p1;
+        gp_Pnt2d b2d = oc.reversed ? p1 : p2;
 
         double u1 = angleOf(center, a2d);
         double u2 = angleOf(center, b2d);
@@ -564,123 +748,313 @@ std::vector<TopoDS_Wire> Sketch::toOcctWires(double tol) const
 //  L x1 y1 x2 y2
 //  A cx cy x1 y1 x2 y2 cw(0|1)
 // constraints M
-//  C aCurve aEnd bCurve bEnd
+//  C aCurve aEnd bCurve bEnd          coincident
+//  D aCurve aEnd bCurve bEnd value    distance
+//  H curve | V curve                  horizontal, vertical
+//  P aCurve bCurve | N aCurve bCurve  parallel, perpendicular
+//  T aCurve bCurve                    tangent
+//  R curve value                      radius
+//  F curve end x y                    fixed
+// slots S            (only once curves were removed: the id layout, so ids survive a reload)
+//  generation issued (per slot)
+// order N
+//  slot              (per curve, in the order above)
 std::string Sketch::serialize() const
 {
-  std::ostringstream os;
-  os << "curves " << curves_.size() << "\n";
-  for (const auto& c : curves_)
+  std::string out;
+  out.reserve(32 + types_.size() * 64 + constraints_.size() * 16);
+  TextCodec::Writer w(out);
+  w.text("curves ").num(static_cast<std::uint64_t>(types_.size())).ch('\n');
+  for (std::size_t i = 0; i < types_.size(); ++i)
   {
-    if (c.type == CurveType::Line)
+    const std::size_t k = i * 2;
+    if (types_[i] == CurveType::Line)
     {
-      os << "L " << c.line.p1.X() << ' ' << c.line.p1.Y() << ' '
-         << c.line.p2.X() << ' ' << c.line.p2.Y() << "\n";
+      w.text("L ").num(xs_[k]).ch(' ').num(ys_[k]).ch(' ')
+       .num(xs_[k + 1]).ch(' ').num(ys_[k + 1]).ch('\n');
     }
     else
     {
-      os << "A " << c.arc.center.X() << ' ' << c.arc.center.Y() << ' '
-         << c.arc.p1.X() << ' ' << c.arc.p1.Y() << ' '
-         << c.arc.p2.X() << ' ' << c.arc.p2.Y() << ' '
-         << (c.arc.clockwise ? 1 : 0) << "\n";
+      const std::size_t slot = static_cast<std::size_t>(arcSlot_[i]);
+      w.text("A ").num(arcCenters_[slot].X()).ch(' ').num(arcCenters_[slot].Y()).ch(' ')
+       .num(xs_[k]).ch(' ').num(ys_[k]).ch(' ')
+       .num(xs_[k + 1]).ch(' ').num(ys_[k + 1]).ch(' ')
+       .num(arcClockwise_[slot] ? 1 : 0).ch('\n');
     }
   }
-  os << "constraints " << constraints_.size() << "\n";
+  w.text("constraints ").num(static_cast<std::uint64_t>(constraints_.size())).ch('\n');
   for (const auto& k : constraints_)
   {
-    if (k.type == ConstraintType::Coincident)
+    switch (k.type)
     {
-      os << "C " << k.a.curve << ' ' << k.a.endIndex << ' ' << k.b.curve << ' ' << k.b.endIndex << "\n";
+      case ConstraintType::Coincident:
+      case ConstraintType::Distance:
+        w.text(k.type == ConstraintType::Coincident ? "C " : "D ").num(k.a.curve).ch(' ').num(k.a.endIndex).ch(' ')
+         .num(k.b.curve).ch(' ').num(k.b.endIndex);
+        if (k.type == ConstraintType::Distance) w.ch(' ').num(k.value);
+        break;
+      case ConstraintType::Horizontal: w.text("H ").num(k.a.curve); break;
+      case ConstraintType::Vertical: w.text("V ").num(k.a.curve); break;
+      case ConstraintType::Parallel: w.text("P ").num(k.a.curve).ch(' ').num(k.b.curve); break;
+      case ConstraintType::Perpendicular: w.text("N ").num(k.a.curve).ch(' ').num(k.b.curve); break;
+      case ConstraintType::Tangent: w.text("T ").num(k.a.curve).ch(' ').num(k.b.curve); break;
+      case ConstraintType::Radius: w.text("R ").num(k.a.curve).ch(' ').num(k.value); break;
+      case ConstraintType::Fixed:
+        w.text("F ").num(k.a.curve).ch(' ').num(k.a.endIndex).ch(' ').num(k.point.X()).ch(' ').num(k.point.Y());
+        break;
     }
+    w.ch('\n');
   }
-  return os.str();
+  bool identity = slots_.size() == types_.size();
+  for (std::size_t i = 0; identity && i < slots_.size(); ++i)
+    identity = idSlot_[i] == i && slots_[i].issued == 0;
+  if (!identity)
+  {
+    w.text("slots ").num(static_cast<std::uint64_t>(slots_.size())).ch('\n');
+    for (const Slot& sl : slots_)
+      w.num(static_cast<std::uint64_t>(sl.generation)).ch(' ').num(static_cast<std::uint64_t>(sl.issued)).ch('\n');
+    w.text("order ").num(static_cast<std::uint64_t>(idSlot_.size())).ch('\n');
+    for (std::uint32_t slot : idSlot_) w.num(static_cast<std::uint64_t>(slot)).ch('\n');
+  }
+  return out;
 }
 
 void Sketch::deserialize(const std::string& data)
 {
-  curves_.clear();
+  touch();
+  types_.clear();
+  arcSlot_.clear();
+  idSlot_.clear();
+  xs_.clear();
+  ys_.clear();
+  arcCenters_.clear();
+  arcClockwise_.clear();
+  arcCurve_.clear();
+  slots_.clear();
+  freeSlots_.clear();
   constraints_.clear();
-  std::istringstream is(data);
-  std::string head;
-  std::size_t n = 0;
-  if (is >> head >> n && head == "curves")
+  geometric_ = 0;
+  grid_.clear();
+  dirty_.clear();
+  uf_parent_.clear();
+  uf_next_.clear();
+  fullSolve_ = true;
+  TextCodec::TokenReader is(data);
+  std::string_view head;
+  std::uint64_t n = 0;
+  // Stops at the first malformed record, keeping what was read so far
+  if (is.next(head) && head == "curves" && is.next(n))
   {
-    for (std::size_t i = 0; i < n; ++i)
+    // Exact-size storage; a record takes at least 10 characters, which bounds a bogus count
+    const std::size_t expected = static_cast<std::size_t>(std::min<std::uint64_t>(n, data.size() / 10));
+    types_.reserve(expected);
+    arcSlot_.reserve(expected);
+    idSlot_.reserve(expected);
+    slots_.reserve(expected);
+    xs_.reserve(expected * 2);
+    ys_.reserve(expected * 2);
+    for (std::uint64_t i = 0; i < n; ++i)
     {
-      char typ; is >> typ;
+      char typ = 0;
+      if (!is.next(typ)) break;
       if (typ == 'L')
       {
-        double x1,y1,x2,y2; is >> x1 >> y1 >> x2 >> y2;
+        double x1, y1, x2, y2;
+        if (!(is.next(x1) && is.next(y1) && is.next(x2) && is.next(y2))) break;
         addLine(gp_Pnt2d(x1,y1), gp_Pnt2d(x2,y2));
       }
       else if (typ == 'A')
       {
-        double cx,cy,x1,y1,x2,y2; int cw; is >> cx >> cy >> x1 >> y1 >> x2 >> y2 >> cw;
+        double cx, cy, x1, y1, x2, y2; int cw;
+        if (!(is.next(cx) && is.next(cy) && is.next(x1) && is.next(y1) && is.next(x2) && is.next(y2)
+              && is.next(cw))) break;
         addArc(gp_Pnt2d(cx,cy), gp_Pnt2d(x1,y1), gp_Pnt2d(x2,y2), cw != 0);
       }
     }
   }
-  if (is >> head >> n && head == "constraints")
+  if (is.next(head) && head == "constraints" && is.next(n))
   {
-    for (std::size_t i = 0; i < n; ++i)
+    // Ids are only checked by the solve: they refer to the saved layout, applied below
+    for (std::uint64_t i = 0; i < n; ++i)
     {
-      char typ; is >> typ;
-      if (typ == 'C')
+      char typ = 0;
+      if (!is.next(typ)) break;
+      Constraint k;
+      bool       ok = true;
+      switch (typ)
       {
-        int ac, ae, bc, be; is >> ac >> ae >> bc >> be;
-        addCoincident(EndpointRef{ac, ae}, EndpointRef{bc, be});
+        case 'C':
+        case 'D':
+          k.type = typ == 'C' ? ConstraintType::Coincident : ConstraintType::Distance;
+          ok     = is.next(k.a.curve) && is.next(k.a.endIndex) && is.next(k.b.curve) && is.next(k.b.endIndex)
+                && (typ == 'C' || is.next(k.value));
+          break;
+        case 'H':
+        case 'V':
+          k.type = typ == 'H' ? ConstraintType::Horizontal : ConstraintType::Vertical;
+          ok     = is.next(k.a.curve);
+          k.b    = k.a;
+          break;
+        case 'P':
+        case 'N':
+        case 'T':
+          k.type = typ == 'P' ? ConstraintType::Parallel : typ == 'N' ? ConstraintType::Perpendicular : ConstraintType::Tangent;
+          ok     = is.next(k.a.curve) && is.next(k.b.curve);
+          break;
+        case 'R':
+          k.type = ConstraintType::Radius;
+          ok     = is.next(k.a.curve) && is.next(k.value);
+          k.b    = k.a;
+          break;
+        case 'F':
+        {
+          double x, y;
+          k.type  = ConstraintType::Fixed;
+          ok      = is.next(k.a.curve) && is.next(k.a.endIndex) && is.next(x) && is.next(y);
+          k.b     = k.a;
+          k.point = gp_Pnt2d(x, y);
+          break;
+        }
+        default: ok = false;
+      }
+      if (!ok) break;
+      pushConstraint(k);
+    }
+  }
+  // Curves were loaded under ids 0..n-1; a valid layout puts them back under their saved ids
+  std::uint64_t slotCount = 0, count = 0;
+  if (is.next(head) && head == "slots" && is.next(slotCount) && slotCount >= types_.size()
+      && slotCount <= data.size() / 4)
+  {
+    std::vector<Slot> slots(static_cast<std::size_t>(slotCount));
+    std::vector<std::uint32_t> order;
+    bool ok = true;
+    for (Slot& sl : slots)
+    {
+      std::uint64_t g = 0, issued = 0;
+      ok = ok && is.next(g) && is.next(issued) && g <= issued && issued < (std::uint64_t(1) << 31);
+      sl.generation = static_cast<std::uint32_t>(g);
+      sl.issued     = static_cast<std::uint32_t>(issued);
+      sl.position   = -1;
+    }
+    ok = ok && is.next(head) && head == "order" && is.next(count) && count == types_.size();
+    for (std::size_t i = 0; ok && i < types_.size(); ++i)
+    {
+      std::uint64_t slot = 0;
+      ok = is.next(slot) && slot < slots.size() && slots[static_cast<std::size_t>(slot)].position < 0;
+      if (ok) slots[static_cast<std::size_t>(slot)].position = static_cast<std::int32_t>(i);
+      order.push_back(static_cast<std::uint32_t>(slot));
+    }
+    if (ok)
+    {
+      slots_.swap(slots);
+      idSlot_.swap(order);
+      for (std::uint32_t s = 0; s < slots_.size(); ++s)
+      {
+        if (slots_[s].position >= 0) continue;
+        slots_[s].position = ~static_cast<std::int32_t>(freeSlots_.size());
+        freeSlots_.push_back(s);
       }
     }
   }
 }
 
 
-gp_Pnt2d Sketch::getEndpoint(const EndpointRef& r) const
+gp_Pnt2d Sketch::endpoint(const EndpointRef& r) const
 {
-  const auto& c = curves_.at(static_cast<std::size_t>(r.curve));
-  if (c.type == CurveType::Line)
-  {
-    return (r.endIndex == 0) ? c.line.p1 : c.line.p2;
-  }
-  else
-  {
-    return (r.endIndex == 0) ? c.arc.p1 : c.arc.p2;
-  }
+  const std::size_t key = endpointKey(r);
+  return gp_Pnt2d(xs_.at(key), ys_.at(key));
+}
+
+gp_Pnt2d Sketch::arcCenter(CurveId id) const
+{
+  return arcCenters_.at(static_cast<std::size_t>(arcSlot_[denseOf(id)]));
+}
+
+bool Sketch::arcClockwise(CurveId id) const
+{
+  return arcClockwise_.at(static_cast<std::size_t>(arcSlot_[denseOf(id)])) != 0;
+}
+
+Sketch::Curve Sketch::curve(CurveId id) const
+{
+  return curveAt(denseOf(id));
 }
 
-void Sketch::setEndpoint(const EndpointRef& r, const gp_Pnt2d& p)
+Sketch::Curve Sketch::curveAt(std::size_t position) const
 {
-  auto& c = curves_.at(static_cast<std::size_t>(r.curve));
+  Curve c;
+  c.type = types_.at(position);
+  const gp_Pnt2d p1(xs_[position * 2], ys_[position * 2]);
+  const gp_Pnt2d p2(xs_[position * 2 + 1], ys_[position * 2 + 1]);
   if (c.type == CurveType::Line)
   {
-    if (r.endIndex == 0)
-      c.line.p1 = p;
-    else
-      c.line.p2 = p;
+    c.line = Line{p1, p2};
   }
   else
   {
-    if (r.endIndex == 0)
-      c.arc.p1 = p;
-    else
-      c.arc.p2 = p;
+    const std::size_t arc = static_cast<std::size_t>(arcSlot_[position]);
+    c.arc = Arc{arcCenters_[arc], p1, p2, arcClockwise_[arc] != 0};
   }
+  return c;
+}
+
+bool Sketch::contains(CurveId id) const
+{
+  if (id < 0) return false;
+  const std::uint32_t slot = slotOf(id);
+  return slot < slots_.size() && slots_[slot].position >= 0 && slots_[slot].generation == generationOf(id);
+}
+
+std::size_t Sketch::denseOf(CurveId id) const
+{
+  if (!contains(id)) throw std::out_of_range("Sketch: unknown curve id");
+  return static_cast<std::size_t>(slots_[slotOf(id)].position);
+}
+
+Sketch::CurveId Sketch::curveId(std::size_t position) const
+{
+  const std::uint32_t slot = idSlot_.at(position);
+  return makeId(slot, slots_[slot].generation);
+}
+
+std::size_t Sketch::curveMemoryBytes() const
+{
+  return types_.capacity() * sizeof(CurveType) + arcSlot_.capacity() * sizeof(int)
+       + idSlot_.capacity() * sizeof(std::uint32_t) + (xs_.capacity() + ys_.capacity()) * sizeof(double)
+       + arcCenters_.capacity() * sizeof(gp_Pnt2d) + arcClockwise_.capacity() * sizeof(std::uint8_t)
+       + arcCurve_.capacity() * sizeof(int) + slots_.capacity() * sizeof(Slot)
+       + freeSlots_.capacity() * sizeof(std::uint32_t);
+}
+
+void Sketch::setEndpoint(std::size_t key, const gp_Pnt2d& p)
+{
+  grid_.move(static_cast<int>(key), p);
+  xs_[key] = p.X();
+  ys_[key] = p.Y();
 }
 
 void Sketch::ufInit(std::size_t n)
 {
   uf_parent_.resize(n);
+  uf_next_.resize(n);
   for (std::size_t i = 0; i < n; ++i)
+  {
     uf_parent_[i] = i;
+    uf_next_[i]   = i;
+  }
+  fullSolve_ = true;
 }
 
 std::size_t Sketch::ufFind(std::size_t i) const
 {
-  if (uf_parent_[i] == i)
-    return i;
-  // Path compression: mutable parent vector
-  auto root = ufFind(uf_parent_[i]);
-  const_cast<std::vector<std::size_t>&>(uf_parent_)[i] = root;
-  return root;
+  // Iterative path halving (mutable parent vector): no recursion depth on long chains
+  while (uf_parent_[i] != i)
+  {
+    uf_parent_[i] = uf_parent_[uf_parent_[i]];
+    i = uf_parent_[i];
+  }
+  return i;
 }
 
 void Sketch::ufUnion(std::size_t a, std::size_t b)
@@ -690,4 +1064,5 @@ void Sketch::ufUnion(std::size_t a, std::size_t b)
   if (a == b)
     return;
   uf_parent_[b] = a;
+  std::swap(uf_next_[a], uf_next_[b]); // splice the member cycles
 }
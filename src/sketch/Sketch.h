@@ -4,26 +4,42 @@
 #include <TopoDS_Wire.hxx>
 
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <optional>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "ConstraintSolver.h"
+#include "EndpointGrid.h"
+
 #include <DocumentItem.h>
 #include <Standard_DefineHandle.hxx>
 #include <Standard_Transient.hxx>
 
 // Lightweight 2D sketch container with simple constraint handling
-// - Stores lines and circular arcs in 2D (gp_Pnt2d)
-// - Supports Coincident endpoint constraints (union-find based)
+// - Stores lines and circular arcs in 2D as structure of arrays: endpoint x/y arrays indexed by
+//   endpoint key, a type tag per curve, and arc centers only for arcs; curves() materializes
+//   Curve values on access
+// - Curves live in a generational slot map: a CurveId stays valid until its curve is removed and
+//   is never reused for another curve; removal swaps the last curve into the hole (O(1)), so
+//   storage stays dense for the solver and wire export
+// - Coincident endpoint constraints weld endpoint clusters (union-find based); geometric constraints
+//   (distance, horizontal/vertical, parallel/perpendicular, tangent, radius, fixed) are then solved
+//   over the clusters and arc centers by ConstraintSolver's sparse damped Newton iteration
 // - Computes wires as connected sets of curves by shared endpoints
+// - Keeps the endpoint clusters, and after the first edit an endpoint hash grid, between solves,
+//   so a solve after a few edits only welds the touched endpoints (see lastSolveStats)
 class Sketch : public DocumentItem
 {
   DEFINE_STANDARD_RTTIEXT(Sketch, DocumentItem)
 public:
-  using CurveId = int;
+  // Slot index in the low 32 bits, slot generation above; ids of a sketch without removals are
+  // 0, 1, 2, ... in creation order
+  using CurveId = std::int64_t;
 
-  enum class CurveType
+  enum class CurveType : std::uint8_t
   {
     Line,
     Arc
@@ -44,6 +60,7 @@ public:
     bool clockwise{false};
   };
 
+  // Value view of one curve (the sketch does not store Curve objects)
   struct Curve
   {
     CurveType type{CurveType::Line};
@@ -60,9 +77,19 @@ public:
     int endIndex{0};
   };
 
+  // What a and b of a Constraint refer to: endpoints, or curves (endIndex unused). Constraints on
+  // one curve or endpoint repeat it in b
   enum class ConstraintType
   {
-    Coincident,
+    Coincident,    // endpoints a and b
+    Distance,      // endpoints a and b, value apart
+    Horizontal,    // line a
+    Vertical,      // line a
+    Parallel,      // lines a and b
+    Perpendicular, // lines a and b
+    Tangent,       // curves a and b, at least one an arc: the line or circle touches the circle
+    Radius,        // arc a, radius value
+    Fixed,         // endpoint a, pinned at point
   };
 
   struct Constraint
@@ -70,11 +97,13 @@ public:
     ConstraintType type{ConstraintType::Coincident};
     EndpointRef a{};
     EndpointRef b{};
+    double      value{0.0};
+    gp_Pnt2d    point{};
   };
 
   struct Wire
   {
-    std::vector<CurveId> curves;  // unordered list of connected curves
+    std::vector<CurveId> curves;  // connected curves in storage order
   };
 
   struct OrderedCurve
@@ -85,6 +114,57 @@ public:
 
   using OrderedPath = std::vector<OrderedCurve>;
 
+  struct SolveStats
+  {
+    bool        incremental{false}; // only the endpoints touched since the last solve were welded
+    std::size_t queried{0};         // endpoints looked up in the grid
+    std::size_t clusters{0};        // clusters whose position was re-averaged
+    // Geometric constraints (see ConstraintSolver::Stats)
+    std::size_t equations{0};
+    std::size_t iterations{0};
+    bool        converged{true};
+    double      residual{0.0};
+  };
+
+  // Read-only range over all curves in storage order, yielding Curve values
+  class CurveView
+  {
+  public:
+    class Iterator
+    {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type        = Curve;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = void;
+      using reference         = Curve;
+
+      Iterator(const Sketch* s, std::size_t i) : s_(s), i_(i) {}
+      Curve     operator*() const { return s_->curveAt(i_); }
+      Iterator& operator++()
+      {
+        ++i_;
+        return *this;
+      }
+      bool operator==(const Iterator& o) const { return i_ == o.i_; }
+      bool operator!=(const Iterator& o) const { return i_ != o.i_; }
+
+    private:
+      const Sketch* s_;
+      std::size_t   i_;
+    };
+
+    explicit CurveView(const Sketch* s) : s_(s) {}
+    std::size_t size() const { return s_->curveCount(); }
+    bool        empty() const { return size() == 0; }
+    Curve       operator[](std::size_t i) const { return s_->curveAt(i); } // storage position, not id
+    Iterator    begin() const { return Iterator(s_, 0); }
+    Iterator    end() const { return Iterator(s_, size()); }
+
+  private:
+    const Sketch* s_;
+  };
+
 public:
   Sketch() = default;
   explicit Sketch(DocumentItem::Id existingId) : DocumentItem(existingId) {}
@@ -98,42 +178,139 @@ public:
   CurveId addLine(const gp_Pnt2d& a, const gp_Pnt2d& b);
   CurveId addArc(const gp_Pnt2d& center, const gp_Pnt2d& a, const gp_Pnt2d& b, bool clockwise);
 
-  // Add constraints
+  // Remove a curve in O(1): its id turns invalid and constraints on it are ignored while it is
+  // gone. The last curve in storage order takes its position. False for an unknown id
+  bool removeCurve(CurveId id);
+  // Undo of removeCurve: bring a curve back under its old id, which must not be live. The id's
+  // slot is reclaimed in O(1), even after another curve used and released it
+  bool restoreCurve(CurveId id, const Curve& curve);
+
+  // Add constraints; curve arguments of the wrong type throw std::invalid_argument, unknown ids
+  // std::out_of_range
   void addCoincident(const EndpointRef& a, const EndpointRef& b);
+  void addDistance(const EndpointRef& a, const EndpointRef& b, double distance);
+  void addHorizontal(CurveId line);
+  void addVertical(CurveId line);
+  void addParallel(CurveId line1, CurveId line2);
+  void addPerpendicular(CurveId line1, CurveId line2);
+  void addTangent(CurveId curve1, CurveId curve2);
+  void addRadius(CurveId arc, double radius);
+  void addFixed(const EndpointRef& r); // pinned where the endpoint is now
+
+  // Move one endpoint; moving an endpoint out of a welded cluster makes the next solve a full one
+  void moveEndpoint(const EndpointRef& r, const gp_Pnt2d& p);
 
-  // Solve currently supports Coincident endpoint constraints only
+  // Weld endpoints within tol and apply Coincident constraints, then solve the geometric ones.
+  // After added curves, moved free endpoints and added constraints the weld is O(k) in the touched
+  // endpoints; a changed tol, a reload or a broken weld run the full O(n) pass. The geometric
+  // solve is O(m) in those constraints and only iterates on groups that are not yet satisfied.
   void solveConstraints(double tol = 1.0e-9);
+  const SolveStats& lastSolveStats() const { return solveStats_; }
 
-  // Compute wires by endpoint connectivity (after constraints solved)
+  // Compute wires by endpoint connectivity (after constraints solved), in O(n): wires are ordered
+  // by their first curve in storage order (creation order until curves are removed)
   std::vector<Wire> computeWires(double tol = 1.0e-9) const;
 
-  // Compute ordered paths for each connected component (may split into multiple paths if branching)
+  // Compute ordered paths for each connected component with an Eulerian (Hierholzer) walk: one path
+  // per component, or one per pair of odd-degree endpoint clusters when it branches. Deterministic:
+  // a walk starts at the lowest odd cluster and takes the lowest unused curve at each cluster.
   std::vector<OrderedPath> computeOrderedPaths(double tol = 1.0e-9) const;
 
   // Export ordered paths as OCCT wires in XY plane (Z=0)
   std::vector<TopoDS_Wire> toOcctWires(double tol = 1.0e-9) const;
 
-  // Access
-  const std::vector<Curve>& curves() const { return curves_; }
+  // Access; lookups by id throw std::out_of_range for ids that are not live
+  bool        contains(CurveId id) const;
+  std::size_t curveCount() const { return types_.size(); }
+  CurveId     curveId(std::size_t position) const; // id of the curve at a storage position
+  CurveType   curveType(CurveId id) const { return types_[denseOf(id)]; }
+  gp_Pnt2d    endpoint(const EndpointRef& r) const;
+  gp_Pnt2d    arcCenter(CurveId id) const; // arcs only: throws std::out_of_range for a line
+  bool        arcClockwise(CurveId id) const;
+  Curve       curve(CurveId id) const;
+  CurveView   curves() const { return CurveView(this); }
   const std::vector<Constraint>& constraints() const { return constraints_; }
 
+  // Heap bytes held by the curve storage (capacity, not size)
+  std::size_t curveMemoryBytes() const;
+
 private:
-  // Endpoint index into a flattened list (each curve contributes two endpoints)
-  std::size_t endpointKey(const EndpointRef& r) const { return static_cast<std::size_t>(r.curve) * 2 + (r.endIndex & 1); }
-  gp_Pnt2d getEndpoint(const EndpointRef& r) const;
-  void setEndpoint(const EndpointRef& r, const gp_Pnt2d& p);
+  // Slot map: a slot holds the storage position of its live curve, or its place in freeSlots_
+  struct Slot
+  {
+    std::uint32_t generation{0}; // of the live (or last) curve
+    std::uint32_t issued{0};     // highest generation handed out
+    std::int32_t  position{0};   // storage position when >= 0, else ~index into freeSlots_
+  };
+  static CurveId       makeId(std::uint32_t slot, std::uint32_t generation) { return static_cast<CurveId>(generation) << 32 | slot; }
+  static std::uint32_t slotOf(CurveId id) { return static_cast<std::uint32_t>(id & 0xffffffff); }
+  static std::uint32_t generationOf(CurveId id) { return static_cast<std::uint32_t>(id >> 32); }
+  std::size_t          denseOf(CurveId id) const; // throws std::out_of_range
 
-  // Union-Find for endpoint clustering
+  // Endpoint index into a flattened list (each curve contributes two endpoints at its storage position)
+  std::size_t endpointKey(const EndpointRef& r) const { return denseOf(r.curve) * 2 + (r.endIndex & 1); }
+  bool        liveConstraint(const Constraint& c) const { return contains(c.a.curve) && contains(c.b.curve); }
+  void        pushConstraint(const Constraint& c);
+  void        requireType(CurveId id, CurveType type, const char* what) const;
+  Curve       curveAt(std::size_t position) const;
+  CurveId     pushCurve(std::uint32_t slot, const Curve& c);
+  std::uint32_t allocateSlot();
+  void setEndpoint(std::size_t key, const gp_Pnt2d& p);
+
+  // Endpoint clusters (union-find representatives) in CSR form: cluster c holds the endpoint keys
+  // incident[offsets[c] .. offsets[c+1]), ascending; clusters are numbered by first appearance
+  struct Incidence
+  {
+    std::vector<int> clusterOf; // endpoint key -> cluster
+    std::vector<int> offsets;   // clusters + 1
+    std::vector<int> incident;  // endpoint keys grouped by cluster
+  };
+  Incidence buildIncidence() const;
+  // Index every endpoint in a grid sized for tol (kept up to date by later edits)
+  void buildGrid(double tol);
+  // Union endpoint 'key' with every endpoint closer than tol (per axis)
+  void weldEndpoint(std::size_t key, double tol);
+  // Union all endpoints closer than tol (per axis) with the snap-and-sort WeldKernel
+  void weldCoincident(double tol);
+  // Move every endpoint of the cluster rooted at 'root' to the cluster's mean
+  void averageCluster(std::size_t root);
+  // Solve the non-Coincident constraints over the current clusters
+  void solveGeometry();
+
+  // Union-Find for endpoint clustering; ufInit drops constraint unions, so the next solve is full
   void ufInit(std::size_t n);
   std::size_t ufFind(std::size_t i) const;
   void ufUnion(std::size_t a, std::size_t b);
 
 private:
-  std::vector<Curve> curves_{};
-  std::vector<Constraint> constraints_{};
+  // Curve storage by position: a type tag, an arc slot (-1 for lines) and the owning id slot; per
+  // endpoint key x and y
+  std::vector<CurveType>     types_{};
+  std::vector<int>           arcSlot_{};
+  std::vector<std::uint32_t> idSlot_{};
+  std::vector<double>        xs_{};
+  std::vector<double>        ys_{};
+  std::vector<gp_Pnt2d>      arcCenters_{}; // per arc slot
+  std::vector<std::uint8_t>  arcClockwise_{};
+  std::vector<int>           arcCurve_{};   // arc slot -> storage position
+  std::vector<Slot>          slots_{};
+  std::vector<std::uint32_t> freeSlots_{};
+  std::vector<Constraint>   constraints_{};
+  std::size_t               geometric_{0}; // constraints other than Coincident
 
   // mutable because computeWires groups by endpoint clusters without mutating geometry
   mutable std::vector<std::size_t> uf_parent_{};
+  // Members of a cluster form a cycle (union splices two cycles), so a cluster is walked in O(size)
+  std::vector<std::size_t> uf_next_{};
+
+  // Incremental solve state
+  EndpointGrid             grid_{};         // all endpoints, built by the full solve
+  std::vector<std::size_t> dirty_{};        // endpoint keys added or moved since the last solve
+  std::size_t              solvedConstraints_{0};
+  double                   solvedTol_{0.0};
+  bool                     fullSolve_{true};
+  SolveStats               solveStats_{};
+  ConstraintSolver         solver_{};       // kept for its buffers
 };
 
 // Enable OCCT handle for Sketch
@@ -0,0 +1,103 @@
+#include "WeldKernel.h"
+
+#include <algorithm>
+
+namespace
+{
+struct KeyIndex
+{
+  std::uint64_t key;
+  int           index;
+};
+
+// Stable LSD radix sort on 11-bit digits; digits that are equal for every key are skipped
+void radixSort(std::vector<KeyIndex>& items)
+{
+  constexpr int kBits = 11, kBuckets = 1 << kBits, kPasses = (64 + kBits - 1) / kBits;
+  std::vector<std::size_t> count(static_cast<std::size_t>(kBuckets) * kPasses, 0);
+  for (const KeyIndex& it : items)
+  {
+    for (int p = 0; p < kPasses; ++p) ++count[p * kBuckets + ((it.key >> (p * kBits)) & (kBuckets - 1))];
+  }
+  std::vector<KeyIndex> tmp(items.size());
+  for (int p = 0; p < kPasses; ++p)
+  {
+    std::size_t* c = &count[static_cast<std::size_t>(p) * kBuckets];
+    if (std::any_of(c, c + kBuckets, [&items](std::size_t n) { return n == items.size(); })) continue;
+    std::size_t sum = 0;
+    for (int b = 0; b < kBuckets; ++b)
+    {
+      const std::size_t n = c[b];
+      c[b] = sum;
+      sum += n;
+    }
+    for (const KeyIndex& it : items) tmp[c[(it.key >> (p * kBits)) & (kBuckets - 1)]++] = it;
+    items.swap(tmp);
+  }
+}
+} // namespace
+
+void WeldKernel::snap(const double* xs, const double* ys, std::size_t n, double originX, double originY, double cell,
+                      double* cx, double* cy)
+{
+  // Adding 1.5 * 2^52 rounds to the nearest integer without a branch or a libm call; one
+  // compare-and-subtract turns that into floor
+  const double inv   = 1.0 / cell;
+  const double magic = 6755399441055744.0;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const double u  = (xs[i] - originX) * inv;
+    const double v  = (ys[i] - originY) * inv;
+    const double ru = (u + magic) - magic;
+    const double rv = (v + magic) - magic;
+    cx[i] = ru - (ru > u ? 1.0 : 0.0);
+    cy[i] = rv - (rv > v ? 1.0 : 0.0);
+  }
+}
+
+void WeldKernel::build(const double* xs, const double* ys, std::size_t n, double cell)
+{
+  m_key.clear();
+  m_index.clear();
+  m_x.clear();
+  m_y.clear();
+  m_runs.clear();
+  m_cell = cell;
+  if (n == 0) return;
+
+  double minX = xs[0], maxX = xs[0], minY = ys[0], maxY = ys[0];
+  for (std::size_t i = 1; i < n; ++i)
+  {
+    minX = std::min(minX, xs[i]);
+    maxX = std::max(maxX, xs[i]);
+    minY = std::min(minY, ys[i]);
+    maxY = std::max(maxY, ys[i]);
+  }
+  // At most 2^30 cells per axis
+  m_cell = std::max(cell, std::max(maxX - minX, maxY - minY) / static_cast<double>(1 << 30));
+
+  std::vector<KeyIndex> items(n);
+  {
+    std::vector<double> cx(n), cy(n);
+    snap(xs, ys, n, minX, minY, m_cell, cx.data(), cy.data());
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      items[i] = KeyIndex{static_cast<std::uint64_t>(cx[i]) * kRow + static_cast<std::uint64_t>(cy[i]), static_cast<int>(i)};
+    }
+  }
+  radixSort(items);
+
+  m_key.resize(n);
+  m_index.resize(n);
+  m_x.resize(n);
+  m_y.resize(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    m_key[i]   = items[i].key;
+    m_index[i] = items[i].index;
+    m_x[i]     = xs[items[i].index];
+    m_y[i]     = ys[items[i].index];
+    if (i == 0 || m_key[i] != m_key[i - 1]) m_runs.push_back(i);
+  }
+  m_runs.push_back(n);
+}
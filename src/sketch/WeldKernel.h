@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bulk weld of a point set: snap to a grid, sort by cell, pair neighbouring cells
+// - snap() maps points to integer cell coordinates (held in doubles) with branch-free arithmetic
+//   over contiguous x/y arrays, which the compiler vectorizes
+// - build() packs each cell into a 64-bit key (x cell in the high bits), radix sorts the points by
+//   key and stores them in sorted order as flat arrays; forEachPair() then walks the cell runs
+//   once, pairing each cell with itself and its four forward neighbours: O(n) overall
+// - Cells are at least tol wide, so close points are never more than one cell apart. They are
+//   widened when needed to keep a cell coordinate within 30 bits of the bounding box
+class WeldKernel
+{
+public:
+  // cx/cy receive floor((x - originX) / cell), floor((y - originY) / cell); the quotients must be
+  // non-negative and below 2^51
+  static void snap(const double* xs, const double* ys, std::size_t n, double originX, double originY, double cell,
+                   double* cx, double* cy);
+
+  void   build(const double* xs, const double* ys, std::size_t n, double cell);
+  double cellSize() const { return m_cell; }
+
+  // visit(i, j) with i < j once for every pair of points closer than tol (<= cellSize) on each axis
+  template <typename Visitor>
+  void forEachPair(double tol, Visitor visit) const
+  {
+    const std::size_t runs = m_runs.empty() ? 0 : m_runs.size() - 1;
+    std::size_t       q    = 0; // first run at or after cell (cx + 1, cy - 1); only moves forward
+    for (std::size_t r = 0; r < runs; ++r)
+    {
+      const std::uint64_t key = m_key[m_runs[r]];
+      pairWithin(m_runs[r], m_runs[r + 1], tol, visit);
+      if (r + 1 < runs && m_key[m_runs[r + 1]] == key + 1)
+        pairAcross(m_runs[r], m_runs[r + 1], m_runs[r + 1], m_runs[r + 2], tol, visit);
+      const std::uint64_t lo = key + kRow - 1, hi = key + kRow + 1;
+      while (q < runs && m_key[m_runs[q]] < lo) ++q;
+      for (std::size_t k = q; k < runs && m_key[m_runs[k]] <= hi; ++k)
+        pairAcross(m_runs[r], m_runs[r + 1], m_runs[k], m_runs[k + 1], tol, visit);
+    }
+  }
+
+private:
+  // Key of cell (cx, cy) is cx * kRow + cy; cy stays below 2^30, so cy - 1 and cy + 1 never
+  // alias a cell of another column
+  static constexpr std::uint64_t kRow = std::uint64_t(1) << 31;
+
+  bool close(std::size_t i, std::size_t j, double tol) const
+  {
+    const double dx = m_x[i] - m_x[j], dy = m_y[i] - m_y[j];
+    return dx <= tol && dx >= -tol && dy <= tol && dy >= -tol;
+  }
+
+  template <typename Visitor>
+  void pairWithin(std::size_t b, std::size_t e, double tol, Visitor& visit) const
+  {
+    for (std::size_t i = b; i < e; ++i)
+      for (std::size_t j = i + 1; j < e; ++j)
+        if (close(i, j, tol)) emit(m_index[i], m_index[j], visit);
+  }
+
+  template <typename Visitor>
+  void pairAcross(std::size_t b0, std::size_t e0, std::size_t b1, std::size_t e1, double tol, Visitor& visit) const
+  {
+    for (std::size_t i = b0; i < e0; ++i)
+      for (std::size_t j = b1; j < e1; ++j)
+        if (close(i, j, tol)) emit(m_index[i], m_index[j], visit);
+  }
+
+  template <typename Visitor>
+  static void emit(int a, int b, Visitor& visit)
+  {
+    if (a < b)
+      visit(a, b);
+    else
+      visit(b, a);
+  }
+
+  double                     m_cell{0.0};
+  // Points in (key, index) order
+  std::vector<std::uint64_t> m_key;
+  std::vector<int>           m_index;
+  std::vector<double>        m_x, m_y;
+  std::vector<std::size_t>   m_runs; // start of each cell's run, then the end
+};
@@ -0,0 +1,34 @@
+#include "JsonString.h"
+
+#include <cstdio>
+
+namespace Json
+{
+void appendString(std::string& out, std::string_view s)
+{
+  out += '"';
+  for (char c : s)
+  {
+    switch (c)
+    {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+          out += buf;
+        }
+        else
+        {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+} // namespace Json
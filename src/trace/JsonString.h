@@ -0,0 +1,11 @@
+// JSON string literal escaping shared by the trace export and model reports (no dependencies)
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace Json
+{
+  // Appends s as a quoted JSON string: quotes, backslashes and control characters are escaped
+  void appendString(std::string& out, std::string_view s);
+}
@@ -0,0 +1,297 @@
+#include "Trace.h"
+#include "JsonString.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trace
+{
+namespace detail
+{
+std::atomic<bool> g_enabled{false};
+}
+
+namespace
+{
+struct Event
+{
+  const char*   category;
+  const char*   name;
+  std::uint64_t start; // ns
+  std::uint64_t end;   // ns
+};
+
+// One per tracing thread; the owner appends, exporters read under the same (uncontended) mutex
+struct ThreadBuffer
+{
+  std::mutex         mutex;
+  std::vector<Event> events; // ring storage, grows up to 'capacity'
+  std::size_t        capacity{0};
+  std::size_t        head{0}; // oldest event once the ring is full
+  std::size_t        dropped{0};
+  std::uint32_t      tid{0};
+  std::string        name;
+  bool               unexported{false}; // recorded since the last toChromeJson()
+
+  void reset(std::size_t newCapacity)
+  {
+    events.clear();
+    events.shrink_to_fit();
+    capacity = newCapacity;
+    head       = 0;
+    dropped    = 0;
+    unexported = false;
+  }
+
+  // Hand the buffer of an exited thread to a new thread with its own track; events that were
+  // never exported count as dropped
+  void recycle(std::uint32_t newTid, std::size_t newCapacity)
+  {
+    if (unexported) dropped += events.size();
+    events.clear();
+    capacity   = newCapacity;
+    head       = 0;
+    tid        = newTid;
+    unexported = false;
+    name.clear();
+  }
+
+  void push(const Event& e)
+  {
+    unexported = true;
+    if (events.size() < capacity)
+    {
+      events.push_back(e);
+      return;
+    }
+    if (capacity == 0) return;
+    events[head] = e;
+    head         = (head + 1) % capacity;
+    ++dropped;
+  }
+
+  template <typename F> void forEach(F&& f) const
+  {
+    for (std::size_t i = 0; i < events.size(); ++i) f(events[(head + i) % events.size()]);
+  }
+};
+
+struct Registry
+{
+  std::mutex                                 mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::size_t                                capacity{1u << 16};
+  std::uint32_t                              nextTid{1};
+};
+
+Registry& registry()
+{
+  static Registry* r = new Registry(); // never destroyed: threads may trace during static teardown
+  return *r;
+}
+
+std::chrono::steady_clock::time_point origin()
+{
+  static const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  return t0;
+}
+
+// Owner handle of the calling thread's buffer; releasing it marks the buffer reusable
+struct ThreadSlot
+{
+  std::shared_ptr<ThreadBuffer> buffer;
+};
+thread_local ThreadSlot t_slot;
+
+// Exited threads whose events wait for an export; beyond this, the oldest is recycled unexported
+// (TaskGraph starts fresh workers on every recompute)
+constexpr std::size_t kMaxRetainedBuffers = 64;
+
+ThreadBuffer& threadBuffer()
+{
+  if (t_slot.buffer) return *t_slot.buffer;
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  // Reuse the buffer of an exited thread (only the registry holds it) once its events were
+  // exported; the new owner gets a fresh track
+  ThreadBuffer* oldestRetained = nullptr;
+  std::size_t   retained       = 0;
+  for (const auto& b : r.buffers)
+  {
+    if (b.use_count() != 1) continue;
+    std::lock_guard<std::mutex> bufLock(b->mutex);
+    if (b->unexported)
+    {
+      if (!oldestRetained) oldestRetained = b.get();
+      ++retained;
+      continue;
+    }
+    b->recycle(r.nextTid++, r.capacity);
+    t_slot.buffer = b;
+    return *b;
+  }
+  if (retained >= kMaxRetainedBuffers)
+  {
+    for (const auto& b : r.buffers)
+    {
+      if (b.get() != oldestRetained) continue;
+      std::lock_guard<std::mutex> bufLock(b->mutex);
+      b->recycle(r.nextTid++, r.capacity);
+      t_slot.buffer = b;
+      return *b;
+    }
+  }
+  auto b      = std::make_shared<ThreadBuffer>();
+  b->capacity = r.capacity;
+  b->tid      = r.nextTid++;
+  r.buffers.push_back(b);
+  t_slot.buffer = b;
+  return *b;
+}
+
+// Nanoseconds as microseconds with three decimals (the trace format's time unit)
+void appendMicros(std::string& out, std::uint64_t ns)
+{
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%llu.%03u", static_cast<unsigned long long>(ns / 1000),
+                static_cast<unsigned>(ns % 1000));
+  out += buf;
+}
+} // namespace
+
+namespace detail
+{
+std::uint64_t now()
+{
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin());
+  return static_cast<std::uint64_t>(ns.count()) + 1;
+}
+
+void record(const char* category, const char* name, std::uint64_t start, std::uint64_t end)
+{
+  ThreadBuffer& b = threadBuffer();
+  std::lock_guard<std::mutex> lock(b.mutex);
+  b.push(Event{category, name, start, end});
+}
+} // namespace detail
+
+void setEnabled(bool on)
+{
+  detail::g_enabled.store(on, std::memory_order_relaxed);
+}
+
+void setThreadName(const char* name)
+{
+  ThreadBuffer& b = threadBuffer();
+  std::lock_guard<std::mutex> lock(b.mutex);
+  b.name       = name ? name : "";
+  b.unexported = true;
+}
+
+void setBufferCapacity(std::size_t events)
+{
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.capacity = events;
+}
+
+std::size_t bufferCapacity()
+{
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return r.capacity;
+}
+
+void clear()
+{
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::vector<std::shared_ptr<ThreadBuffer>> live;
+  for (auto& b : r.buffers)
+  {
+    if (b.use_count() == 1) continue; // owner thread exited
+    std::lock_guard<std::mutex> bufLock(b->mutex);
+    b->reset(r.capacity);
+    live.push_back(std::move(b));
+  }
+  r.buffers = std::move(live);
+}
+
+std::size_t eventCount()
+{
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::size_t n = 0;
+  for (const auto& b : r.buffers)
+  {
+    std::lock_guard<std::mutex> bufLock(b->mutex);
+    n += b->events.size();
+  }
+  return n;
+}
+
+std::size_t droppedCount()
+{
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::size_t n = 0;
+  for (const auto& b : r.buffers)
+  {
+    std::lock_guard<std::mutex> bufLock(b->mutex);
+    n += b->dropped;
+  }
+  return n;
+}
+
+std::string toChromeJson()
+{
+  std::string out = "{\"traceEvents\":[";
+  bool first = true;
+  auto next = [&out, &first]() {
+    out += first ? "\n" : ",\n";
+    first = false;
+  };
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (const auto& b : r.buffers)
+  {
+    std::lock_guard<std::mutex> bufLock(b->mutex);
+    b->unexported         = false;
+    const std::string tid = std::to_string(b->tid);
+    if (!b->name.empty())
+    {
+      next();
+      out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":";
+      Json::appendString(out, b->name);
+      out += "}}";
+    }
+    b->forEach([&](const Event& e) {
+      next();
+      out += "{\"name\":";
+      Json::appendString(out, e.name ? e.name : "");
+      out += ",\"cat\":";
+      Json::appendString(out, e.category ? e.category : "");
+      out += ",\"ph\":\"X\",\"ts\":";
+      appendMicros(out, e.start);
+      out += ",\"dur\":";
+      appendMicros(out, e.end - e.start);
+      out += ",\"pid\":1,\"tid\":" + tid + "}";
+    });
+  }
+  out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return out;
+}
+
+bool writeChromeJson(const std::string& path)
+{
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  if (!os) return false;
+  const std::string json = toChromeJson();
+  os.write(json.data(), static_cast<std::streamsize>(json.size()));
+  return static_cast<bool>(os);
+}
+} // namespace Trace
@@ -0,0 +1,82 @@
+// Span tracing for edit-to-frame profiling, exported as Chrome/Perfetto trace JSON (no Qt deps)
+#pragma once
+
+#ifndef CAD_ENABLE_TRACING
+#define CAD_ENABLE_TRACING 1
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// - CAD_TRACE_SCOPE(category, name) records one complete event ("ph":"X") for the enclosing scope
+// - Each thread appends to its own fixed-size ring buffer; when full, the oldest events are
+//   overwritten. Buffers of exited threads are kept (their events stay exportable); once
+//   exported, the next thread that starts tracing reuses one under a new tid. At most 64 exited
+//   buffers wait for an export: past that, the oldest is reused and its events count as dropped
+// - Recording is off until Trace::setEnabled(true); a span then costs one relaxed atomic load
+// - Category and name pointers are stored as-is: pass string literals or other strings that
+//   outlive the trace (e.g. Standard_Type::Name())
+// - With the CMake option CAD_ENABLE_TRACING=OFF the macro expands to nothing
+namespace Trace
+{
+  void setEnabled(bool on);
+  inline bool enabled();
+
+  // Name shown for the calling thread's track
+  void setThreadName(const char* name);
+  // Events kept per thread; applies to buffers created or cleared afterwards
+  void        setBufferCapacity(std::size_t events);
+  std::size_t bufferCapacity();
+
+  // Drop all recorded events (buffers of exited threads are released)
+  void        clear();
+  std::size_t eventCount();   // events currently held by all buffers
+  std::size_t droppedCount(); // events overwritten since the last clear()
+
+  // {"traceEvents":[...]} with timestamps in microseconds; load in chrome://tracing or Perfetto
+  std::string toChromeJson();
+  bool        writeChromeJson(const std::string& path);
+
+  namespace detail
+  {
+    extern std::atomic<bool> g_enabled;
+    std::uint64_t now(); // nanoseconds since the trace clock origin, never 0
+    void          record(const char* category, const char* name, std::uint64_t start, std::uint64_t end);
+  }
+
+  inline bool enabled()
+  {
+    return detail::g_enabled.load(std::memory_order_relaxed);
+  }
+
+  // RAII span; the event is recorded when the scope ends
+  class Span
+  {
+  public:
+    Span(const char* category, const char* name)
+      : m_category(category), m_name(name), m_start(enabled() ? detail::now() : 0)
+    {
+    }
+    ~Span()
+    {
+      if (m_start != 0) detail::record(m_category, m_name, m_start, detail::now());
+    }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+  private:
+    const char*   m_category;
+    const char*   m_name;
+    std::uint64_t m_start;
+  };
+}
+
+#define CAD_TRACE_CONCAT_IMPL(a, b) a##b
+#define CAD_TRACE_CONCAT(a, b) CAD_TRACE_CONCAT_IMPL(a, b)
+#if CAD_ENABLE_TRACING
+#define CAD_TRACE_SCOPE(category, name) ::Trace::Span CAD_TRACE_CONCAT(cadTraceSpan_, __LINE__)(category, name)
+#else
+#define CAD_TRACE_SCOPE(category, name) ((void)0)
+#endif
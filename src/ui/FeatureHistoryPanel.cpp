@@ -12,6 +12,8 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
+#include <QSignalBlocker>
+#include <QSlider>
 #include <QEvent>
 #include <QKeyEvent>
 #include <QMenu>
@@ -38,9 +40,16 @@ FeatureHistoryPanel::FeatureHistoryPanel(TabPage* page, QWidget* parent)
   m_list->setContextMenuPolicy(Qt::CustomContextMenu);
   lay->addWidget(m_list, 1);
 
+  // Rollback bar: dragging shows the model as of that timeline position
+  m_rollback = new QSlider(Qt::Horizontal, this);
+  m_rollback->setToolTip("Rollback: show the model as of this timeline position");
+  m_rollback->setRange(0, 0);
+  lay->addWidget(m_rollback);
+
   connect(m_list, &QListWidget::itemSelectionChanged, this, &FeatureHistoryPanel::onSelectionChanged);
   connect(m_btnRemove, &QPushButton::clicked, this, &FeatureHistoryPanel::onRemoveClicked);
   connect(m_list, &QListWidget::customContextMenuRequested, this, &FeatureHistoryPanel::onContextMenuRequested);
+  connect(m_rollback, &QSlider::valueChanged, this, &FeatureHistoryPanel::onRollbackMoved);
 }
 
 void FeatureHistoryPanel::refreshFromDocument()
@@ -49,16 +58,60 @@ void FeatureHistoryPanel::refreshFromDocument()
   m_rowHandles.Clear();
   if (m_page == nullptr) return;
   const auto& seq = m_page->doc().items();
+  std::shared_ptr<const RecomputeProfile> profile;
+  if (m_showTimings) profile = m_page->doc().lastProfile();
+  const int active = m_page->doc().rollbackPosition();
+  {
+    const QSignalBlocker block(m_rollback);
+    m_rollback->setRange(0, seq.Size());
+    m_rollback->setValue(active);
+  }
   int row = 0;
-  for (NCollection_Sequence<Handle(DocumentItem)>::Iterator it(seq); it.More(); it.Next())
+  for (Timeline::Iterator it(seq); it.More(); it.Next())
   {
     const Handle(DocumentItem)& di = it.Value();
     m_rowHandles.Append(di);
-    m_list->addItem(itemDisplayText(di));
+    QString text = itemDisplayText(di);
+    if (const RecomputeProfile::Entry* e = profile ? profile->find(di->id()) : nullptr)
+    {
+      if (e->produced())
+        text += QString("  (%1 ms%2)").arg(e->wallMs, 0, 'f', 1).arg(e->cacheHit() ? ", cached" : "");
+    }
+    m_list->addItem(text);
+    // Rolled-back items are listed greyed out
+    if (row >= active) m_list->item(row)->setForeground(palette().brush(QPalette::Disabled, QPalette::Text));
     ++row;
   }
 }
 
+void FeatureHistoryPanel::onRollbackMoved(int position)
+{
+  if (m_page == nullptr) return;
+  m_page->setRollbackPosition(position);
+  refreshFromDocument(); // markers over non-feature items produce no ChangeSet
+}
+
+void FeatureHistoryPanel::setShowTimings(bool on)
+{
+  m_showTimings = on;
+  if (m_page)
+  {
+    Document& doc = m_page->doc();
+    if (on && !doc.profiling())
+    {
+      doc.setProfiling(true);
+      m_enabledProfiling = true;
+    }
+    else if (!on && m_enabledProfiling)
+    {
+      // Profiling that was on already (e.g. requested by the profile export) stays on
+      doc.setProfiling(false);
+      m_enabledProfiling = false;
+    }
+  }
+  refreshFromDocument();
+}
+
 NCollection_Sequence<Handle(DocumentItem)> FeatureHistoryPanel::selectedItems() const
 {
   NCollection_Sequence<Handle(DocumentItem)> result;
@@ -169,8 +222,13 @@ void FeatureHistoryPanel::onContextMenuRequested(const QPoint& pos)
     }
   }
   QAction* actRemove = menu.addAction("Remove");
+  menu.addSeparator();
+  QAction* actTimings = menu.addAction("Show Timings");
+  actTimings->setCheckable(true);
+  actTimings->setChecked(m_showTimings);
   QAction* chosen = menu.exec(m_list->viewport()->mapToGlobal(pos));
   if (!chosen) return;
+  if (chosen == actTimings) { setShowTimings(!m_showTimings); return; }
   if (chosen == actRename) { doRenameSelected(); }
   else if (chosen == actRemove) { onRemoveClicked(); }
   else if (chosen == actToggle) { doToggleSuppressSelected(); }
@@ -208,8 +266,7 @@ void FeatureHistoryPanel::doToggleSuppressSelected()
   Handle(Feature) f = Handle(Feature)::DownCast(di);
   if (f.IsNull()) return;
   f->setSuppressed(!f->isSuppressed());
-  // Recompute document and resync viewer + list
+  // Recompute document; its ChangeSet resyncs viewer + list
   m_page->doc().recompute();
-  m_page->syncViewerFromDoc(true);
-  refreshFromDocument();
+  m_page->commitEdit(f->isSuppressed() ? "Suppress" : "Unsuppress");
 }
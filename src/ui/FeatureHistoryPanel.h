@@ -11,6 +11,7 @@
 
 class QListWidget;
 class QPushButton;
+class QSlider;
 class TabPage;
 
 class FeatureHistoryPanel : public QWidget
@@ -28,6 +29,11 @@ public:
   // Select a specific item in the list
   void selectItem(const Handle(DocumentItem)& it);
 
+  // Append the last recompute's per-feature timing to each row; document profiling is on while
+  // timings are shown, and turned off again unless it was already on
+  void setShowTimings(bool on);
+  bool showTimings() const { return m_showTimings; }
+
 signals:
   void requestRemoveSelected();
   void requestSelectItem(const Handle(DocumentItem)& it);
@@ -38,6 +44,7 @@ private slots:
   void onContextMenuRequested(const QPoint& pos);
   void doRenameSelected();
   void doToggleSuppressSelected();
+  void onRollbackMoved(int position);
 
 protected:
   bool eventFilter(QObject* obj, QEvent* ev) override;
@@ -49,6 +56,9 @@ private:
   TabPage*     m_page = nullptr;
   QListWidget* m_list = nullptr;
   QPushButton* m_btnRemove = nullptr;
+  QSlider*     m_rollback = nullptr; // timeline rollback marker: number of active items
   // Row -> Item handle mapping for current list state
   NCollection_Sequence<Handle(DocumentItem)> m_rowHandles;
+  bool m_showTimings = false;
+  bool m_enabledProfiling = false; // document profiling was turned on by setShowTimings()
 };
@@ -4,6 +4,7 @@
 
 #include <Standard_WarningsDisable.hxx>
 #include <QAction>
+#include <QFileDialog>
 #include <QTabWidget>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -14,16 +15,19 @@
 #include <Standard_Version.hxx>
 
 #include <Document.h>
+#include <UndoStack.h>
 #include <command/CreateBoxCommand.h>
 #include <dialog/CreateBoxDialog.h>
 #include <command/CreateCylinderCommand.h>
 #include <dialog/CreateCylinderDialog.h>
 #include <command/CreateExtrudeCommand.h>
 #include <dialog/CreateExtrudeDialog.h>
+#include <dialog/MemoryStatsDialog.h>
 // sketch for extrusion
 #include <Sketch.h>
 // model/viewer headers for sync helpers
 #include <Feature.h>
+#include <Trace.h>
 #include "TabPage.h"
 
 MainWindow::MainWindow()
@@ -119,6 +123,12 @@ void MainWindow::createMenuBar()
     file->addAction(actAddExtrude);
     connect(actAddExtrude, &QAction::triggered, [this]() { addExtrude(); });
   }
+  {
+    QAction* actAddSample = new QAction(file);
+    actAddSample->setText("Add Sample Parts");
+    file->addAction(actAddSample);
+    connect(actAddSample, &QAction::triggered, [this]() { addSample(); });
+  }
   {
     QAction* actMove = new QAction(file);
     actMove->setText("Move");
@@ -133,12 +143,62 @@ void MainWindow::createMenuBar()
     file->addAction(actCancelMove);
     connect(actCancelMove, &QAction::triggered, [this]() { TabPage* p = currentPage(); if (p) p->cancelMove(); });
   }
+  {
+    QAction* actProfile = new QAction(file);
+    actProfile->setText("Export Recompute Profile...");
+    file->addAction(actProfile);
+    connect(actProfile, &QAction::triggered, [this]() { exportRecomputeProfile(); });
+  }
+  {
+    // Checked: spans are recorded; unchecking asks where to save the Chrome trace
+    QAction* actTrace = new QAction(file);
+    actTrace->setText("Record Trace");
+    actTrace->setObjectName("actionRecordTrace");
+    actTrace->setCheckable(true);
+    actTrace->setEnabled(CAD_ENABLE_TRACING != 0);
+    file->addAction(actTrace);
+    connect(actTrace, &QAction::toggled, [this](bool on) { recordTrace(on); });
+  }
+  {
+    QAction* actMemory = new QAction(file);
+    actMemory->setText("Memory Statistics...");
+    actMemory->setObjectName("actionMemoryStats");
+    file->addAction(actMemory);
+    connect(actMemory, &QAction::triggered, [this]() {
+      TabPage* page = currentPage(); if (!page) return;
+      (new MemoryStatsDialog(page, this))->show();
+    });
+  }
   {
     QAction* quit = new QAction(file);
     quit->setText("Quit");
     file->addAction(quit);
     connect(quit, &QAction::triggered, [this]() { close(); });
   }
+  QMenu* edit = mbar->addMenu("&Edit");
+  {
+    QAction* undo = new QAction(edit);
+    undo->setText("Undo");
+    undo->setObjectName("actionUndo");
+    undo->setShortcut(QKeySequence::Undo);
+    edit->addAction(undo);
+    connect(undo, &QAction::triggered, [this]() { if (TabPage* p = currentPage()) p->undo(); });
+    QAction* redo = new QAction(edit);
+    redo->setText("Redo");
+    redo->setObjectName("actionRedo");
+    redo->setShortcut(QKeySequence::Redo);
+    edit->addAction(redo);
+    connect(redo, &QAction::triggered, [this]() { if (TabPage* p = currentPage()) p->redo(); });
+    // Show what will be undone/redone for the current tab
+    connect(edit, &QMenu::aboutToShow, [this, undo, redo]() {
+      TabPage* p = currentPage();
+      const UndoStack* stack = p ? &p->undoStack() : nullptr;
+      const bool canUndo = stack && stack->canUndo();
+      const bool canRedo = stack && stack->canRedo();
+      undo->setText(canUndo ? QString("Undo %1").arg(QString::fromStdString(stack->undoLabel())) : QString("Undo"));
+      redo->setText(canRedo ? QString("Redo %1").arg(QString::fromStdString(stack->redoLabel())) : QString("Redo"));
+    });
+  }
   setMenuBar(mbar);
 }
 
@@ -186,30 +246,31 @@ void MainWindow::createToolBar()
 void MainWindow::addBox()
 {
   TabPage* page = currentPage(); if (!page) return;
+  IdAllocator::Scope ids(page->doc().ids()); // new items continue this tab's id sequence
   CreateBoxDialog dlg(this);
   if (dlg.exec() != QDialog::Accepted) return;
 
   CreateBoxCommand cmd(dlg.dx(), dlg.dy(), dlg.dz());
   cmd.execute(page->doc());
-  page->syncViewerFromDoc(true);
-  page->refreshFeatureList();
+  page->commitEdit("Add Box");
 }
 
 void MainWindow::addCylinder()
 {
   TabPage* page = currentPage(); if (!page) return;
+  IdAllocator::Scope ids(page->doc().ids());
   CreateCylinderDialog dlg(this);
   if (dlg.exec() != QDialog::Accepted) return;
 
   CreateCylinderCommand cmd(dlg.radius(), dlg.height());
   cmd.execute(page->doc());
-  page->syncViewerFromDoc(true);
-  page->refreshFeatureList();
+  page->commitEdit("Add Cylinder");
 }
 
 void MainWindow::addExtrude()
 {
   TabPage* page = currentPage(); if (!page) return;
+  IdAllocator::Scope ids(page->doc().ids());
 
   // Ensure there is at least one sketch to pick; if none, create a sample rectangle sketch
   if (page->doc().sketches().empty())
@@ -244,12 +305,58 @@ void MainWindow::addExtrude()
   auto sketch = sketches.at(static_cast<std::size_t>(idx));
   CreateExtrudeCommand cmd(sketch, dlg.distance());
   cmd.execute(page->doc());
-  page->syncViewerFromDoc(true);
-  page->refreshFeatureList();
+  page->commitEdit("Add Extrude");
 }
 
 
 
+void MainWindow::addSample()
+{
+  TabPage* page = currentPage(); if (!page) return;
+  IdAllocator::Scope ids(page->doc().ids());
+  // Batch insert: one recompute, one ChangeSet and one undo step for all parts
+  Document::Transaction txn(page->doc());
+  for (int i = 0; i < 3; ++i)
+  {
+    CreateBoxCommand(10.0, 10.0, 10.0 + 5.0 * i).execute(page->doc());
+    CreateCylinderCommand(4.0, 10.0 + 5.0 * i).execute(page->doc());
+  }
+  txn.commit();
+  page->commitEdit("Add Sample Parts");
+}
+
+void MainWindow::exportRecomputeProfile()
+{
+  TabPage* page = currentPage(); if (!page) return;
+  const auto profile = page->doc().lastProfile();
+  if (!profile)
+  {
+    page->doc().setProfiling(true);
+    QMessageBox::information(this, "Recompute Profile", "Profiling is now enabled; the next recompute will be recorded.");
+    return;
+  }
+  const QString path = QFileDialog::getSaveFileName(this, "Export Recompute Profile", "recompute_profile.json",
+                                                    "JSON (*.json)");
+  if (path.isEmpty()) return;
+  if (!profile->writeJson(path.toStdString()))
+    QMessageBox::warning(this, "Recompute Profile", QString("Could not write %1").arg(path));
+}
+
+void MainWindow::recordTrace(bool on)
+{
+  if (on)
+  {
+    Trace::clear();
+    Trace::setEnabled(true);
+    return;
+  }
+  Trace::setEnabled(false);
+  const QString path = QFileDialog::getSaveFileName(this, "Save Trace", "cad_trace.json", "Chrome trace (*.json)");
+  if (!path.isEmpty() && !Trace::writeChromeJson(path.toStdString()))
+    QMessageBox::warning(this, "Trace", QString("Could not write %1").arg(path));
+  Trace::clear();
+}
+
 void MainWindow::syncViewerFromDoc(bool toUpdate)
 {
   TabPage* page = currentPage(); if (!page) return;
@@ -259,6 +366,8 @@ void MainWindow::syncViewerFromDoc(bool toUpdate)
 void MainWindow::addNewTab()
 {
   auto* page = new TabPage(this);
+  // Keep the GUI responsive during long booleans: recompute on a worker, show results when ready
+  page->setBackgroundRecompute(true);
   int idx = m_tabs->addTab(page, QString("Untitled %1").arg(m_tabs->count() + 1));
   m_tabs->setCurrentIndex(idx);
   // Initialize empty history list
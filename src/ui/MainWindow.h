@@ -29,6 +29,9 @@ private:
   void addBox();                    // Open dialog and add BoxFeature
   void addCylinder();               // Open dialog and add CylinderFeature
   void addExtrude();                // Open dialog, select sketch, add ExtrudeFeature
+  void addSample();                 // Add a few boxes/cylinders in one transaction
+  void exportRecomputeProfile();    // Write the last RecomputeProfile as JSON
+  void recordTrace(bool on);        // Start span recording / stop and save a Chrome trace
   void syncViewerFromDoc(bool toUpdate = true); // Rebuild AIS bodies from Document
   void addNewTab();                 // Add a new tab page
 
@@ -9,7 +9,11 @@
 #include <Standard_WarningsRestore.hxx>
 
 #include <Document.h>
+#include <FeatureResultCache.h>
+#include <UndoStack.h>
+#include <BackgroundRecompute.h>
 #include <Sketch.h>
+#include <Trace.h>
 #include <AIS_Shape.hxx>
 #include <MoveFeature.h>
 #include <gp_Quaternion.hxx>
@@ -34,6 +38,12 @@ TabPage::TabPage(QWidget* parent)
   split->setSizes({200, 800});
   lay->addWidget(split);
   m_doc = std::make_unique<Document>();
+  // Memoize feature results so suppress toggles, remove/re-add and repeated edits skip the kernel
+  m_doc->setResultCache(std::make_shared<FeatureResultCache>());
+  m_undo = std::make_unique<UndoStack>();
+  m_undo->reset(*m_doc);
+  // Every recompute/commit delivers one ChangeSet; the viewer only touches what it names
+  m_doc->addChangeListener([this](const Document::ChangeSet& cs) { applyChangeSet(cs); });
 
   // Connect panel actions
   connect(m_history, &FeatureHistoryPanel::requestRemoveSelected, [this]() {
@@ -41,6 +51,8 @@ TabPage::TabPage(QWidget* parent)
     auto sel = m_history->selectedItems();
     // Track sources of removed MoveFeatures to restore suppression when removing the last move
     std::vector<DocumentItem::Id> toUnsuppressIds;
+    // One recompute and one viewer update for the whole selection
+    Document::Transaction txn(*m_doc);
     for (NCollection_Sequence<Handle(DocumentItem)>::Iterator it(sel); it.More(); it.Next())
     {
       const Handle(DocumentItem)& di = it.Value();
@@ -59,32 +71,20 @@ TabPage::TabPage(QWidget* parent)
     // For each recorded source id, unsuppress the feature if no remaining MoveFeature still references it
     if (!toUnsuppressIds.empty())
     {
-      const auto& feats = m_doc->features();
       for (DocumentItem::Id sid : toUnsuppressIds)
       {
-        Handle(Feature) src;
-        for (NCollection_Sequence<Handle(Feature)>::Iterator fit(feats); fit.More(); fit.Next())
-        {
-          const Handle(Feature)& ff = fit.Value();
-          if (!ff.IsNull() && ff->id() == sid) { src = ff; break; }
-        }
+        Handle(Feature) src = Handle(Feature)::DownCast(m_doc->findItem(sid));
         if (src.IsNull()) continue;
         // Check if any MoveFeature still references this source id
-        bool stillReferenced = false;
-        for (NCollection_Sequence<Handle(Feature)>::Iterator fit(feats); fit.More(); fit.Next())
-        {
-          Handle(MoveFeature) remMf = Handle(MoveFeature)::DownCast(fit.Value());
-          if (!remMf.IsNull() && remMf->sourceId() == sid) { stillReferenced = true; break; }
-        }
+        const bool stillReferenced = !m_doc->dependents(sid).empty();
         if (!stillReferenced && src->isSuppressed())
         {
           src->setSuppressed(false);
         }
       }
     }
-    m_doc->recompute();
-    syncViewerFromDoc(true);
-    refreshFeatureList();
+    txn.commit();
+    commitEdit("Remove");
   });
   connect(m_history, &FeatureHistoryPanel::requestSelectItem, [this](const Handle(DocumentItem)& it) {
     if (Handle(Feature) f = Handle(Feature)::DownCast(it); !f.IsNull())
@@ -102,23 +102,83 @@ TabPage::TabPage(QWidget* parent)
   });
 }
 
-TabPage::~TabPage() = default;
+TabPage::~TabPage()
+{
+  // Join the worker before the document goes away
+  if (m_doc) m_doc->setRecomputeScheduler(Document::RecomputeScheduler());
+  m_bg.reset();
+}
+
+void TabPage::setBackgroundRecompute(bool on)
+{
+  if (on == backgroundRecompute()) return;
+  if (!on)
+  {
+    m_doc->setRecomputeScheduler(Document::RecomputeScheduler());
+    m_bg.reset();
+    return;
+  }
+  // The worker only signals; results are adopted on the GUI thread
+  m_bg = std::make_unique<BackgroundRecompute>([this]() {
+    QMetaObject::invokeMethod(this, [this]() { applyBackgroundResults(); }, Qt::QueuedConnection);
+  });
+  m_doc->setRecomputeScheduler([this](Document& d) { m_bg->request(d); });
+}
+
+void TabPage::applyBackgroundResults()
+{
+  if (m_bg) m_bg->apply(*m_doc); // notifies: applyChangeSet swaps in the new bodies
+}
+
+void TabPage::commitEdit(const QString& label)
+{
+  m_undo->commit(*m_doc, label.toStdString());
+}
+
+bool TabPage::undo()
+{
+  if (!m_undo->undo(*m_doc)) return false;
+  // Restored items keep their cached shapes, so this only runs features recorded while stale;
+  // it notifies, and only the items that differ are redisplayed
+  m_doc->recompute();
+  return true;
+}
+
+bool TabPage::redo()
+{
+  if (!m_undo->redo(*m_doc)) return false;
+  // Restored items keep their cached shapes, so this only runs features recorded while stale;
+  // it notifies, and only the items that differ are redisplayed
+  m_doc->recompute();
+  return true;
+}
+
+void TabPage::setRollbackPosition(int position)
+{
+  if (position == m_doc->rollbackPosition()) return;
+  m_doc->setRollbackPosition(position);
+  // Held results are reused; only features that went stale behind the marker are replayed
+  m_doc->recompute();
+}
 
 void TabPage::syncViewerFromDoc(bool toUpdate)
 {
+  CAD_TRACE_SCOPE("ui", "TabPage::syncViewerFromDoc");
   if (!m_viewer) return;
   m_featureToBody.Clear();
   m_bodyToFeature.Clear();
   m_sketchToHandle.clear();
+  m_bodyById.clear();
   m_viewer->clearBodies(false);
   m_viewer->clearSketches(false);
-  for (NCollection_Sequence<Handle(Feature)>::Iterator it(m_doc->features()); it.More(); it.Next())
+  for (Timeline::FeatureView::Iterator it(m_doc->features()); it.More(); it.Next())
   {
     const Handle(Feature)& f = it.Value(); if (f.IsNull()) continue;
-    if (f->isSuppressed()) continue; // do not display suppressed features
+    if (!m_doc->isDisplayed(f)) continue; // suppressed or past the rollback marker
     Handle(AIS_Shape) body = m_viewer->addShape(f->shape(), AIS_Shaded, 0, false);
     m_featureToBody.Add(f, body);
     m_bodyToFeature.Add(body, f);
+    m_bodyById[f->id()] = body;
   }
   // Display registered sketches after features
   for (const auto& sk : m_doc->sketches())
@@ -134,6 +194,66 @@ void TabPage::syncViewerFromDoc(bool toUpdate)
   }
 }
 
+void TabPage::applyChangeSet(const Document::ChangeSet& cs)
+{
+  CAD_TRACE_SCOPE("ui", "TabPage::applyChangeSet");
+  if (!m_viewer) return;
+  auto drop = [this](DocumentItem::Id id) {
+    auto it = m_bodyById.find(id);
+    if (it == m_bodyById.end()) return;
+    m_viewer->removeBody(it->second, false);
+    m_bodyById.erase(it);
+  };
+  auto show = [this](DocumentItem::Id id) {
+    Handle(Feature) f = Handle(Feature)::DownCast(m_doc->findItem(id));
+    if (f.IsNull() || !m_doc->isDisplayed(f)) return; // suppressed or past the rollback marker
+    if (f->shape().IsNull()) return;             // no result yet (background recompute pending)
+    m_bodyById[id] = m_viewer->addShape(f->shape(), AIS_Shaded, 0, false);
+  };
+  // A dirty feature is waiting for a background result: keep showing its last good body
+  auto pending = [this](DocumentItem::Id id) {
+    Handle(Feature) f = Handle(Feature)::DownCast(m_doc->findItem(id));
+    return !f.IsNull() && f->isDirty() && m_doc->isDisplayed(f) && m_bodyById.count(id) != 0;
+  };
+  for (DocumentItem::Id id : cs.removed) drop(id);
+  for (DocumentItem::Id id : cs.modified)
+  {
+    if (!pending(id)) drop(id);
+  }
+  for (DocumentItem::Id id : cs.added) show(id);
+  for (DocumentItem::Id id : cs.modified)
+  {
+    if (m_bodyById.count(id) == 0) show(id);
+  }
+  if (cs.sketchesChanged)
+  {
+    m_viewer->clearSketches(false);
+    m_sketchToHandle.clear();
+    for (const auto& sk : m_doc->sketches())
+    {
+      Handle(AIS_Shape) h = m_viewer->addSketch(sk);
+      if (!h.IsNull()) m_sketchToHandle[sk->id()] = h;
+    }
+  }
+  rebuildBodyMaps();
+  m_viewer->flushBodies();
+  refreshFeatureList();
+}
+
+void TabPage::rebuildBodyMaps()
+{
+  m_featureToBody.Clear();
+  m_bodyToFeature.Clear();
+  for (Timeline::FeatureView::Iterator it(m_doc->features()); it.More(); it.Next())
+  {
+    const Handle(Feature)& f = it.Value(); if (f.IsNull()) continue;
+    auto body = m_bodyById.find(f->id());
+    if (body == m_bodyById.end()) continue;
+    m_featureToBody.Add(f, body->second);
+    m_bodyToFeature.Add(body->second, f);
+  }
+}
+
 void TabPage::refreshFeatureList()
 {
   if (m_history) m_history->refreshFromDocument();
@@ -179,6 +299,7 @@ void TabPage::activateMove()
     const double ry = ay * r2d;
     const double rz = az * r2d;
 
+    IdAllocator::Scope ids(m_doc->ids());
     Handle(MoveFeature) mf = new MoveFeature();
     mf->setSourceId(src->id());
     // Store exact transform to avoid Euler reconstruction errors
@@ -190,8 +311,7 @@ void TabPage::activateMove()
     src->setSuppressed(true);
     m_doc->addFeature(mf);
     m_doc->recompute();
-    syncViewerFromDoc(true);
-    refreshFeatureList();
+    commitEdit("Move");
     // Disconnect to prevent multiple triggers on subsequent confirmations
     if (m_connManipFinished) { QObject::disconnect(m_connManipFinished); m_connManipFinished = QMetaObject::Connection(); }
   });
@@ -12,8 +12,10 @@
 #include <memory>
 #include <unordered_map>
 #include <DocumentItem.h>
+#include <Document.h>
 
-class Document;
+class UndoStack;
+class BackgroundRecompute;
 class OcctQOpenGLWidgetViewer;
 class FeatureHistoryPanel;
 
@@ -37,6 +39,14 @@ public:
   // Rebuild the feature history panel list from Document
   void refreshFeatureList();
 
+  // Incremental sync: replace only the bodies of added/removed/modified features, then redraw once.
+  // Registered as the document's change listener, so commands need no explicit resync.
+  void applyChangeSet(const Document::ChangeSet& cs);
+
+  // Move the timeline rollback marker (0 = before the first item, items().Size() = end) and show
+  // the model as of that position. Not recorded in the undo history.
+  void setRollbackPosition(int position);
+
   // Select a feature's AIS body in the viewer
   void selectFeatureInViewer(const Handle(Feature)& f);
 
@@ -45,12 +55,30 @@ public:
   void confirmMove();
   void cancelMove();
 
+  // Undo history: record an edit after mutating doc(); undo/redo restore cached results and resync
+  void commitEdit(const QString& label);
+  bool undo();
+  bool redo();
+  UndoStack& undoStack() { return *m_undo; }
+
+  // Background recompute: document recomputes run on a worker against a snapshot; the viewer keeps
+  // the last good shapes until results arrive (applied on the GUI thread). Off by default.
+  void setBackgroundRecompute(bool on);
+  bool backgroundRecompute() const { return m_bg != nullptr; }
+  // Adopt finished background results now (normally triggered from the worker via a queued call)
+  void applyBackgroundResults();
+
 private:
+  void rebuildBodyMaps(); // featureToBody/bodyToFeature from m_bodyById
+
   OcctQOpenGLWidgetViewer*                 m_viewer = nullptr; // OCCT viewer widget
   std::unique_ptr<Document>                m_doc;              // model document
+  std::unique_ptr<UndoStack>               m_undo;             // snapshot history of m_doc
+  std::unique_ptr<BackgroundRecompute>     m_bg;               // worker recompute (optional)
   TColStd_IndexedDataMapOfTransientTransient m_featureToBody;  // feature -> body
   TColStd_IndexedDataMapOfTransientTransient m_bodyToFeature;  // body -> feature
   std::unordered_map<DocumentItem::Id, Handle(AIS_Shape)> m_sketchToHandle; // sketch id -> AIS handle
+  std::unordered_map<DocumentItem::Id, Handle(AIS_Shape)> m_bodyById;       // feature id -> AIS body
   FeatureHistoryPanel*                     m_history = nullptr;// feature history panel
   QMetaObject::Connection                  m_connManipFinished; // manipulatorFinished connection
 };
@@ -0,0 +1,112 @@
+#include "MemoryStatsDialog.h"
+
+#include "TabPage.h"
+
+#include <Standard_WarningsDisable.hxx>
+#include <QDialogButtonBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <Standard_WarningsRestore.hxx>
+
+#include <Document.h>
+#include <MemoryReport.h>
+#include <UndoStack.h>
+
+namespace
+{
+QString formatBytes(std::size_t bytes)
+{
+  if (bytes < 1024) return QString("%1 B").arg(bytes);
+  if (bytes < 1024 * 1024) return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+  return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 2);
+}
+} // namespace
+
+MemoryStatsDialog::MemoryStatsDialog(TabPage* page, QWidget* parent)
+  : QDialog(parent), m_page(page)
+{
+  setWindowTitle("Memory Statistics");
+  setAttribute(Qt::WA_DeleteOnClose);
+
+  m_summary = new QLabel(this);
+  m_topN    = new QSpinBox(this);
+  m_topN->setRange(1, 1000);
+  m_topN->setValue(20);
+  m_topN->setPrefix("Top ");
+  QPushButton* btnRefresh = new QPushButton("Refresh", this);
+
+  m_table = new QTableWidget(this);
+  m_table->setColumnCount(8);
+  m_table->setHorizontalHeaderLabels({"Feature", "Type", "Attributed", "Exclusive", "Shared", "Topology", "Geometry", "Mesh"});
+  m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+  m_table->verticalHeader()->setVisible(false);
+  m_table->horizontalHeader()->setStretchLastSection(true);
+
+  QDialogButtonBox* btns = new QDialogButtonBox(QDialogButtonBox::Close, this);
+  connect(btns, &QDialogButtonBox::rejected, this, &QDialog::reject);
+  connect(btnRefresh, &QPushButton::clicked, this, &MemoryStatsDialog::refresh);
+  connect(m_topN, qOverload<int>(&QSpinBox::valueChanged), this, [this](int) { refresh(); });
+
+  QHBoxLayout* top = new QHBoxLayout();
+  top->addWidget(m_summary, 1);
+  top->addWidget(m_topN);
+  top->addWidget(btnRefresh);
+
+  QVBoxLayout* lay = new QVBoxLayout(this);
+  lay->addLayout(top);
+  lay->addWidget(m_table);
+  lay->addWidget(btns);
+  setLayout(lay);
+  resize(760, 420);
+  refresh();
+}
+
+void MemoryStatsDialog::refresh()
+{
+  if (!m_page) return;
+  const MemoryReport report = MemoryReport::build(m_page->doc(), &m_page->undoStack());
+  QString summary = QString("Total %1 — features %2 (topology %3, geometry %4, mesh %5), cache %6, undo %7")
+                      .arg(formatBytes(report.total()), formatBytes(report.features.total()),
+                           formatBytes(report.features.topology), formatBytes(report.features.geometry),
+                           formatBytes(report.features.mesh), formatBytes(report.cache.total()),
+                           formatBytes(report.undo.total()));
+  const Document& doc = m_page->doc();
+  if (doc.resultBudget() != 0)
+  {
+    const Document::EvictionStats st = doc.evictionStats();
+    summary += QString("\nBudget %1 — evicted %2 (compacted %3, %4 in blobs), rematerialized %5, released %6")
+                 .arg(formatBytes(doc.resultBudget()))
+                 .arg(st.evicted)
+                 .arg(st.compacted)
+                 .arg(formatBytes(st.compactBytes))
+                 .arg(st.rematerialized)
+                 .arg(formatBytes(st.releasedBytes));
+  }
+  m_summary->setText(summary);
+
+  const auto rows = report.top(static_cast<std::size_t>(m_topN->value()));
+  m_table->setRowCount(static_cast<int>(rows.size()));
+  for (int r = 0; r < static_cast<int>(rows.size()); ++r)
+  {
+    const MemoryReport::Entry& e = *rows[r];
+    QString label = e.name.empty() ? QString("#%1").arg(e.id) : QString::fromStdString(e.name);
+    if (e.suppressed) label += " (suppressed)";
+    if (e.evicted) label += e.compacted != 0 ? QString(" (compacted %1)").arg(formatBytes(e.compacted)) : QString(" (evicted)");
+    const QStringList cells = {label,
+                               QString::fromStdString(e.type),
+                               formatBytes(e.attributed),
+                               formatBytes(e.exclusive),
+                               formatBytes(e.shared()),
+                               formatBytes(e.reachable.topology),
+                               formatBytes(e.reachable.geometry),
+                               formatBytes(e.reachable.mesh)};
+    for (int c = 0; c < cells.size(); ++c) m_table->setItem(r, c, new QTableWidgetItem(cells[c]));
+  }
+  m_table->resizeColumnsToContents();
+}
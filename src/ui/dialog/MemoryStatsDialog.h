@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Standard_WarningsDisable.hxx>
+#include <QDialog>
+#include <QPointer>
+#include <Standard_WarningsRestore.hxx>
+
+class QLabel;
+class QSpinBox;
+class QTableWidget;
+class TabPage;
+
+// Debug panel: largest memory consumers of a tab's document (see MemoryReport)
+class MemoryStatsDialog : public QDialog
+{
+  Q_OBJECT
+public:
+  MemoryStatsDialog(TabPage* page, QWidget* parent = nullptr);
+
+  void refresh(); // rebuild the report and the table
+
+private:
+  QPointer<TabPage> m_page;    // the tab may close while the panel is open
+  QLabel*           m_summary; // document totals
+  QSpinBox*         m_topN;    // rows shown
+  QTableWidget*     m_table;   // top consumers by attributed bytes
+};
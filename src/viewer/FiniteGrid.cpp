@@ -11,6 +11,8 @@
 #include <Quantity_Color.hxx>
 #include <gp_Pnt.hxx>
 
+#include <Trace.h>
+
 IMPLEMENT_STANDARD_RTTIEXT(FiniteGrid, AIS_InteractiveObject)
 
 namespace {
@@ -178,6 +180,7 @@ void FiniteGrid::Compute(const Handle(PrsMgr_PresentationManager)&,
                            const Handle(Prs3d_Presentation)&         thePrs,
                            const Standard_Integer)
 {
+  CAD_TRACE_SCOPE("viewer", "FiniteGrid::Compute");
   thePrs->Clear();
   if (!m_Initialized || m_Step <= 0.0) return;
 
@@ -41,6 +41,7 @@
 #include <TopoDS_Wire.hxx>
 
 #include <Sketch.h>
+#include <Trace.h>
 
 class OcctQtFrameBuffer : public OpenGl_FrameBuffer
 {
@@ -474,6 +475,7 @@ void OcctQOpenGLWidgetViewer::updateView()
 
 void OcctQOpenGLWidgetViewer::paintGL()
 {
+  CAD_TRACE_SCOPE("viewer", "paintGL");
   if (m_view.IsNull() || m_view->Window().IsNull()) return;
   Aspect_Drawable aNativeWin = (Aspect_Drawable)winId();
 #ifdef _WIN32
@@ -614,6 +616,27 @@ void OcctQOpenGLWidgetViewer::clearBodies(bool theToUpdate)
   }
 }
 
+void OcctQOpenGLWidgetViewer::removeBody(const Handle(AIS_Shape)& theBody, bool theToUpdate)
+{
+  if (theBody.IsNull()) return;
+  for (int i = 1; i <= m_bodies.Size(); ++i)
+  {
+    if (m_bodies.Value(i) == theBody)
+    {
+      m_bodies.Remove(i);
+      break;
+    }
+  }
+  if (m_context->IsDisplayed(theBody)) m_context->Remove(theBody, false);
+  if (theToUpdate) flushBodies();
+}
+
+void OcctQOpenGLWidgetViewer::flushBodies()
+{
+  if (!m_view.IsNull()) { m_context->UpdateCurrentViewer(); m_view->Invalidate(); }
+  update();
+}
+
 // setBodiesVisible / toggleBodiesVisible removed per UI simplification
 Handle(AIS_Shape) OcctQOpenGLWidgetViewer::selectedShape() const
 {
@@ -74,6 +74,8 @@ public: // bodies management
                             Standard_Integer   theDispPriority = 0,
                             bool               theToUpdate = false);
   void clearBodies(bool theToUpdate = true); // erase all tracked bodies
+  void removeBody(const Handle(AIS_Shape)& theBody, bool theToUpdate = false); // erase one tracked body
+  void flushBodies(); // redraw after a batch of addBody/removeBody without update
   // Alias for clarity: add a shape into AIS context
   Handle(AIS_Shape) addShape(const TopoDS_Shape& theShape,
                              AIS_DisplayMode    theDispMode = AIS_Shaded,
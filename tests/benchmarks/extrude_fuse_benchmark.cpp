@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include <KernelAPI.h>
+
+#include <common/test_utils.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// The per-profile fuse loop was quadratic; clustered n-ary fuses keep 1000 profiles interactive
+TEST(ExtrudeFuseBenchmark, ClusteredProfiles_10_100_1000)
+{
+  for (int count : {10, 100, 1000})
+  {
+    // Grid cells of two overlapping 2x1 rectangles
+    std::vector<TopoDS_Wire> wires;
+    for (int c = 0; c < count / 2; ++c)
+    {
+      const double x = 5.0 * (c % 32);
+      const double y = 5.0 * (c / 32);
+      wires.push_back(rectWire(x, y, 2.0, 1.0));
+      wires.push_back(rectWire(x + 1.0, y, 2.0, 1.0));
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    const TopoDS_Shape shp = KernelAPI::extrude(wires, 5.0);
+    const auto t1 = std::chrono::steady_clock::now();
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+    std::cout << "[ bench    ] extrude " << count << " profiles: " << ms << " ms" << std::endl;
+    ASSERT_FALSE(shp.IsNull());
+    EXPECT_EQ(countSolids(shp), count / 2);
+  }
+}
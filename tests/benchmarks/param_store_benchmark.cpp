@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <Feature.h>
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace
+{
+// Byte-counting allocator to measure the heap footprint of the previous map-based storage
+std::size_t g_legacyHeapBytes = 0;
+
+template <class T>
+struct CountingAllocator
+{
+  using value_type = T;
+  CountingAllocator() = default;
+  template <class U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+  T* allocate(std::size_t n)
+  {
+    g_legacyHeapBytes += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n)
+  {
+    g_legacyHeapBytes -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+  template <class U>
+  bool operator==(const CountingAllocator<U>&) const { return true; }
+  template <class U>
+  bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+struct KeyHash
+{
+  std::size_t operator()(Feature::ParamKey k) const noexcept { return static_cast<std::size_t>(k); }
+};
+
+// Previous representation: one hash map per feature
+using LegacyValue = std::variant<int, double, TCollection_AsciiString>;
+using LegacyMap   = std::unordered_map<Feature::ParamKey, LegacyValue, KeyHash, std::equal_to<Feature::ParamKey>,
+                                     CountingAllocator<std::pair<const Feature::ParamKey, LegacyValue>>>;
+
+double legacyAsDouble(const LegacyMap& pm, Feature::ParamKey key, double defVal)
+{
+  auto it = pm.find(key);
+  if (it == pm.end()) return defVal;
+  if (std::holds_alternative<double>(it->second)) return std::get<double>(it->second);
+  if (std::holds_alternative<int>(it->second)) return static_cast<double>(std::get<int>(it->second));
+  return defVal;
+}
+} // namespace
+
+TEST(ParamStoreBenchmark, AccessorAndMemory_1M)
+{
+  const std::size_t n = 1000000;
+  using Key = Feature::ParamKey;
+
+  g_legacyHeapBytes = 0;
+  std::vector<LegacyMap> legacy(n);
+  std::vector<Feature::ParamMap> stores(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const double v = static_cast<double>(i % 97);
+    legacy[i][Key::Dx] = v;
+    legacy[i][Key::Dy] = v + 1.0;
+    legacy[i][Key::Dz] = v + 2.0;
+    stores[i].set(Key::Dx, v);
+    stores[i].set(Key::Dy, v + 1.0);
+    stores[i].set(Key::Dz, v + 2.0);
+  }
+  const std::size_t legacyBytes = sizeof(LegacyMap) * n + g_legacyHeapBytes;
+  const std::size_t storeBytes  = sizeof(Feature::ParamMap) * n; // no heap for numeric params
+
+  auto t0 = std::chrono::steady_clock::now();
+  double sumLegacy = 0.0;
+  for (const LegacyMap& pm : legacy)
+  {
+    sumLegacy += legacyAsDouble(pm, Key::Dx, 0.0) + legacyAsDouble(pm, Key::Dy, 0.0) + legacyAsDouble(pm, Key::Dz, 0.0);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  double sumStore = 0.0;
+  for (const Feature::ParamMap& pm : stores)
+  {
+    sumStore += pm.asDouble(Key::Dx, 0.0) + pm.asDouble(Key::Dy, 0.0) + pm.asDouble(Key::Dz, 0.0);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  const auto legacyMs = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+  const auto storeMs  = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+  std::cout << "[ bench    ] params 1M x3 reads: map " << legacyMs << " ms, inline " << storeMs << " ms" << std::endl;
+  std::cout << "[ bench    ] params 1M memory: map " << (legacyBytes >> 20) << " MiB, inline "
+            << (storeBytes >> 20) << " MiB" << std::endl;
+
+  EXPECT_DOUBLE_EQ(sumLegacy, sumStore);
+  EXPECT_LT(storeBytes, legacyBytes);
+}
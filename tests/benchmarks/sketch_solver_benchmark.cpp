@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include "Sketch.h"
+
+#include <common/sketch_scenes.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// 358 independent cells of 14 constraints, and one connected staircase of 5001
+TEST(SketchSolverBenchmark, Solve_5kConstraints)
+{
+  std::mt19937 rng(11);
+  Sketch cells;
+  for (int i = 0; i < 358; ++i) addConstrainedCell(cells, (i % 20) * 10.0, (i / 20) * 10.0, 0.05, rng);
+  Sketch stairs;
+  addStaircase(stairs, 2500, 0.05, rng);
+
+  for (Sketch* s : {&cells, &stairs})
+  {
+    const std::size_t constraints = s->constraints().size();
+    auto t0 = std::chrono::steady_clock::now();
+    s->solveConstraints();
+    auto t1 = std::chrono::steady_clock::now();
+    const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    const Sketch::SolveStats& st = s->lastSolveStats();
+    std::cout << "[ bench    ] sketch solve " << constraints << " constraints (" << st.equations << " equations): " << ms
+              << " ms, " << st.iterations << " factorizations, residual " << st.residual << std::endl;
+    EXPECT_TRUE(st.converged);
+  }
+}
@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include "Sketch.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+TEST(SketchWeldBenchmark, WeldThroughput_500k)
+{
+  // Polyline grid of 500k lines whose shared endpoints are off by less than tol
+  const int n = 500000, w = 1000;
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> jitter(-2e-7, 2e-7);
+  Sketch s;
+  for (int i = 0; i < n; ++i)
+  {
+    const double x = i % w, y = i / w;
+    s.addLine(gp_Pnt2d(x + jitter(rng), y + jitter(rng)), gp_Pnt2d(x + 1.0 + jitter(rng), y + jitter(rng)));
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  s.solveConstraints(1e-6);
+  auto t1 = std::chrono::steady_clock::now();
+  const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+  std::cout << "[ bench    ] sketch weld " << n << " lines: " << ms << " ms, " << 2.0 * n / ms / 1000.0
+            << " M endpoints/s, " << static_cast<double>(s.curveMemoryBytes()) / n << " bytes per line" << std::endl;
+  EXPECT_EQ(s.computeWires(1e-6).size(), static_cast<std::size_t>(n / w));
+}
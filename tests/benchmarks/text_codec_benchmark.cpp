@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <TextCodec.h>
+#include <Sketch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace
+{
+double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+double mbPerSec(std::size_t bytes, double seconds)
+{
+  return static_cast<double>(bytes) / (1024.0 * 1024.0) / std::max(seconds, 1e-9);
+}
+} // namespace
+
+TEST(TextCodecBenchmark, Throughput_MBps)
+{
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> coord(-1000.0, 1000.0);
+  Sketch s;
+  const int kCurves = 20000;
+  for (int i = 0; i < kCurves; ++i)
+  {
+    s.addLine(gp_Pnt2d(coord(rng), coord(rng)), gp_Pnt2d(coord(rng), coord(rng)));
+  }
+
+  // Encoding: Sketch::serialize (full precision)
+  auto t0 = std::chrono::steady_clock::now();
+  std::string blob;
+  const int kRounds = 5;
+  for (int r = 0; r < kRounds; ++r) blob = s.serialize();
+  const double encodeMBps = mbPerSec(blob.size() * kRounds, secondsSince(t0));
+
+  // Decoding: token scan + number parse of the same blob, without sketch bookkeeping
+  t0 = std::chrono::steady_clock::now();
+  double checksum = 0.0;
+  for (int r = 0; r < kRounds; ++r)
+  {
+    TextCodec::TokenReader tokens(blob);
+    std::string_view tok;
+    double v = 0.0;
+    while (tokens.next(tok))
+    {
+      if (TextCodec::parse(tok, v)) checksum += v;
+    }
+  }
+  const double decodeMBps = mbPerSec(blob.size() * kRounds, secondsSince(t0));
+
+  // Reference: the previous ostream/istream path at full precision
+  t0 = std::chrono::steady_clock::now();
+  std::string legacy;
+  {
+    std::ostringstream os;
+    os.precision(17);
+    for (const auto& c : s.curves())
+    {
+      os << "L " << c.line.p1.X() << ' ' << c.line.p1.Y() << ' ' << c.line.p2.X() << ' ' << c.line.p2.Y() << "\n";
+    }
+    legacy = os.str();
+  }
+  const double legacyEncodeMBps = mbPerSec(legacy.size(), secondsSince(t0));
+  t0 = std::chrono::steady_clock::now();
+  {
+    std::istringstream is(legacy);
+    char typ;
+    double x1, y1, x2, y2;
+    while (is >> typ >> x1 >> y1 >> x2 >> y2) checksum -= x1;
+  }
+  const double legacyDecodeMBps = mbPerSec(legacy.size(), secondsSince(t0));
+
+  Sketch s2;
+  t0 = std::chrono::steady_clock::now();
+  s2.deserialize(blob);
+  const double sketchLoadMs = secondsSince(t0) * 1000.0;
+  ASSERT_EQ(s2.curves().size(), static_cast<std::size_t>(kCurves));
+  EXPECT_EQ(s2.curves()[kCurves - 1].line.p2.Y(), s.curves()[kCurves - 1].line.p2.Y());
+
+  std::cout << "[ bench    ] text codec encode=" << encodeMBps << " MB/s decode=" << decodeMBps
+            << " MB/s (ostream " << legacyEncodeMBps << " MB/s, istream " << legacyDecodeMBps
+            << " MB/s) sketch load " << kCurves << " curves=" << sketchLoadMs << " ms"
+            << " checksum=" << checksum << std::endl;
+}
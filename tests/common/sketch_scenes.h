@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Sketch.h"
+
+#include <random>
+
+// Constrained sketches shared by the sketch solver tests and benchmarks
+
+// Rectangle with a rounded lid: 5 curves and 14 constraints; endpoints are off by up to 'jitter'
+inline void addConstrainedCell(Sketch& s, double ox, double oy, double jitter, std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> j(-jitter, jitter);
+  auto p = [&](double x, double y) { return gp_Pnt2d(x + j(rng), y + j(rng)); };
+  const double w = 4.0, h = 2.0;
+  auto l0 = s.addLine(p(ox, oy), p(ox + w, oy));
+  auto l1 = s.addLine(p(ox + w, oy), p(ox + w, oy + h));
+  auto l2 = s.addLine(p(ox + w, oy + h), p(ox, oy + h));
+  auto l3 = s.addLine(p(ox, oy + h), p(ox, oy));
+  auto a  = s.addArc(p(ox + 2.0, oy + 2.6), p(ox + 2.5, oy + 2.6), p(ox + 1.5, oy + 2.6), false);
+  s.addCoincident({l0, 1}, {l1, 0});
+  s.addCoincident({l1, 1}, {l2, 0});
+  s.addCoincident({l2, 1}, {l3, 0});
+  s.addCoincident({l3, 1}, {l0, 0});
+  s.addHorizontal(l0);
+  s.addVertical(l1);
+  s.addParallel(l2, l0);
+  s.addPerpendicular(l3, l0);
+  s.addDistance({l0, 0}, {l0, 1}, w);
+  s.addDistance({l1, 0}, {l1, 1}, h);
+  s.addFixed({l0, 0});
+  s.addRadius(a, 0.5);
+  s.addTangent(l2, a);
+  s.addDistance({a, 0}, {l2, 0}, 1.5);
+}
+
+// Connected staircase of alternating horizontal/vertical unit steps, each end off by up to 'jitter'
+inline void addStaircase(Sketch& s, int steps, double jitter, std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> j(-jitter, jitter);
+  gp_Pnt2d at(0, 0);
+  for (int i = 0; i < steps; ++i)
+  {
+    const gp_Pnt2d next(at.X() + (i % 2 == 0 ? 1.0 : 0.0) + j(rng), at.Y() + (i % 2 == 0 ? 0.0 : 1.0) + j(rng));
+    auto l = s.addLine(at, next);
+    if (i % 2 == 0)
+      s.addHorizontal(l);
+    else
+      s.addVertical(l);
+    s.addDistance({l, 0}, {l, 1}, 1.0);
+    if (i == 0) s.addFixed({l, 0});
+    at = next;
+  }
+}
@@ -1,21 +1,31 @@
 #pragma once
 
+#include <gtest/gtest.h>
+
 #include <TopExp_Explorer.hxx>
 #include <TopAbs_ShapeEnum.hxx>
 #include <TopoDS_Shape.hxx>
 #include <TopoDS.hxx>
+#include <TopoDS_Wire.hxx>
 
 #include <Bnd_Box.hxx>
 #include <BRepBndLib.hxx>
 #include <BRep_Tool.hxx>
 #include <BRepGProp.hxx>
 #include <GProp_GProps.hxx>
+#include <BRepBuilderAPI_MakePolygon.hxx>
+
+#include <gp_Pnt.hxx>
+#include <gp_Trsf.hxx>
+#include <gp_Quaternion.hxx>
+#include <gp_EulerSequence.hxx>
 
 #include <Geom_Surface.hxx>
 #include <GeomAdaptor_Surface.hxx>
 #include <GeomAbs_SurfaceType.hxx>
 
 #include <array>
+#include <cmath>
 
 // Count faces of a shape
 inline int countFaces(const TopoDS_Shape& shape)
@@ -32,6 +42,60 @@ inline std::array<double, 3> bboxExtents(const TopoDS_Shape& shape)
   return { xmax - xmin, ymax - ymin, zmax - zmin };
 }
 
+// Count solids of a shape
+inline int countSolids(const TopoDS_Shape& shape)
+{
+  int n = 0; for (TopExp_Explorer exp(shape, TopAbs_SOLID); exp.More(); exp.Next()) { ++n; } return n;
+}
+
+// Axis-aligned bounding box corners
+inline gp_Pnt bboxMin(const TopoDS_Shape& shape)
+{
+  Bnd_Box bb; BRepBndLib::Add(shape, bb);
+  Standard_Real xmin = 0, ymin = 0, zmin = 0, xmax = 0, ymax = 0, zmax = 0;
+  bb.Get(xmin, ymin, zmin, xmax, ymax, zmax);
+  return gp_Pnt(xmin, ymin, zmin);
+}
+
+inline gp_Pnt bboxCenter(const TopoDS_Shape& shape)
+{
+  Bnd_Box bb; BRepBndLib::Add(shape, bb);
+  Standard_Real xmin = 0, ymin = 0, zmin = 0, xmax = 0, ymax = 0, zmax = 0;
+  bb.Get(xmin, ymin, zmin, xmax, ymax, zmax);
+  return gp_Pnt(0.5 * (xmin + xmax), 0.5 * (ymin + ymax), 0.5 * (zmin + zmax));
+}
+
+// Component-wise point comparison
+inline void expectNear(const gp_Pnt& a, const gp_Pnt& b, double tol = 1.0e-6)
+{
+  EXPECT_NEAR(a.X(), b.X(), tol);
+  EXPECT_NEAR(a.Y(), b.Y(), tol);
+  EXPECT_NEAR(a.Z(), b.Z(), tol);
+}
+
+// Intrinsic XYZ rotation (degrees) that keeps point p fixed
+inline gp_Trsf rotateAroundPointXYZ(const gp_Pnt& p, double rxDeg, double ryDeg, double rzDeg)
+{
+  const double rx = rxDeg * (M_PI / 180.0);
+  const double ry = ryDeg * (M_PI / 180.0);
+  const double rz = rzDeg * (M_PI / 180.0);
+  gp_Quaternion q; q.SetEulerAngles(gp_Intrinsic_XYZ, rx, ry, rz);
+  // Translation that fixes point p: t = p - R * p
+  gp_Mat R = q.GetMatrix();
+  gp_XYZ px = p.XYZ();
+  gp_XYZ Rp = px; Rp.Multiply(R);
+  gp_Trsf tr; tr.SetTransformation(q, gp_Vec(px.X() - Rp.X(), px.Y() - Rp.Y(), px.Z() - Rp.Z()));
+  return tr;
+}
+
+// Closed axis-aligned rectangle in the XY plane
+inline TopoDS_Wire rectWire(double x, double y, double w, double h)
+{
+  BRepBuilderAPI_MakePolygon poly(gp_Pnt(x, y, 0.0), gp_Pnt(x + w, y, 0.0), gp_Pnt(x + w, y + h, 0.0),
+                                  gp_Pnt(x, y + h, 0.0), Standard_True);
+  return poly.Wire();
+}
+
 // Compute volume via mass properties
 inline double volume(const TopoDS_Shape& shape)
 {
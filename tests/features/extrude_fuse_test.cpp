@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <KernelAPI.h>
+
+#include <common/test_utils.h>
+
+#include <vector>
+
+namespace
+{
+// Profiles laid out on a grid: each cell holds two overlapping 2x1 rectangles (union area 3)
+std::vector<TopoDS_Wire> pairedProfiles(int count)
+{
+  std::vector<TopoDS_Wire> wires;
+  const int cells = count / 2;
+  const int perRow = 32;
+  for (int c = 0; c < cells; ++c)
+  {
+    const double x = 5.0 * (c % perRow);
+    const double y = 5.0 * (c / perRow);
+    wires.push_back(rectWire(x, y, 2.0, 1.0));
+    wires.push_back(rectWire(x + 1.0, y, 2.0, 1.0));
+  }
+  return wires;
+}
+} // namespace
+
+TEST(ExtrudeFuse, OverlappingChainFusesIntoOneSolid)
+{
+  // 10 rectangles, each overlapping the next: a single cluster fused in one n-ary pass
+  std::vector<TopoDS_Wire> wires;
+  for (int i = 0; i < 10; ++i) wires.push_back(rectWire(i * 1.0, 0.0, 2.0, 1.0));
+  const TopoDS_Shape shp = KernelAPI::extrude(wires, 2.0);
+  ASSERT_FALSE(shp.IsNull());
+  EXPECT_EQ(countSolids(shp), 1);
+  EXPECT_NEAR(volume(shp), 11.0 * 2.0, 1.0e-6);
+}
+
+TEST(ExtrudeFuse, DisjointClustersStaySeparateSolids)
+{
+  // Overlapping pairs merge; disjoint pairs stay separate solids (timings: tests/benchmarks)
+  const auto wires = pairedProfiles(100);
+  const TopoDS_Shape shp = KernelAPI::extrude(wires, 5.0);
+  ASSERT_FALSE(shp.IsNull());
+  EXPECT_EQ(countSolids(shp), 50);
+  EXPECT_NEAR(volume(shp), 50 * 3.0 * 5.0, 1.0e-4);
+}
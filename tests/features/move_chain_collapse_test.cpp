@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <BoxFeature.h>
+#include <MoveFeature.h>
+
+#include <BRepBuilderAPI_Transform.hxx>
+#include <common/test_utils.h>
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Box followed by a chain of moves; every link but the last is suppressed (UI drag pattern)
+std::vector<Handle(MoveFeature)> buildChain(Document& doc, Handle(BoxFeature)& base, int length)
+{
+  base = new BoxFeature(3.0, 4.0, 5.0);
+  doc.addFeature(base);
+  std::vector<Handle(MoveFeature)> chain;
+  Handle(Feature) prev = base;
+  for (int i = 0; i < length; ++i)
+  {
+    Handle(MoveFeature) mf = new MoveFeature(prev->id(), 1.0, 0.5 * i, 0.0, 0.0, 0.0, 10.0);
+    prev->setSuppressed(true);
+    doc.addFeature(mf);
+    chain.push_back(mf);
+    prev = mf;
+  }
+  return chain;
+}
+} // namespace
+
+TEST(MoveChainCollapse, ChainRunsAsSingleComposedTransform)
+{
+  Document doc;
+  Handle(BoxFeature) base;
+  const auto chain = buildChain(doc, base, 10);
+  doc.recompute();
+
+  // Only the base and the chain tail execute; the nine intermediate links are folded
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 2u);
+  EXPECT_EQ(doc.lastRecomputeStats().collapsed, 9u);
+  for (std::size_t i = 0; i + 1 < chain.size(); ++i)
+  {
+    EXPECT_TRUE(chain[i]->isDeferred());
+  }
+
+  gp_Trsf accum;
+  std::vector<gp_Trsf> prefix;
+  for (const auto& mf : chain)
+  {
+    accum = mf->transform() * accum;
+    prefix.push_back(accum);
+  }
+  expectNear(bboxCenter(chain.back()->shape()),
+             bboxCenter(BRepBuilderAPI_Transform(base->shape(), accum, true).Shape()));
+
+  // Intermediate results are still available on demand
+  const TopoDS_Shape mid = chain[4]->shape();
+  ASSERT_FALSE(mid.IsNull());
+  // Built on the side: the link stays folded and the next read returns the same shape
+  EXPECT_TRUE(chain[4]->isDeferred());
+  EXPECT_TRUE(chain[4]->shape().IsEqual(mid));
+  expectNear(bboxCenter(mid), bboxCenter(BRepBuilderAPI_Transform(base->shape(), prefix[4], true).Shape()));
+}
+
+TEST(MoveChainCollapse, SecondConsumerMaterializesLink)
+{
+  Document doc;
+  Handle(BoxFeature) base;
+  const auto chain = buildChain(doc, base, 6);
+  doc.recompute();
+  ASSERT_TRUE(chain[2]->isDeferred());
+
+  // A branch off a collapsed link makes it a real result again
+  Handle(MoveFeature) branch = new MoveFeature(chain[2]->id(), 0.0, 0.0, 7.0, 0.0, 0.0, 0.0);
+  doc.addFeature(branch);
+  doc.recompute();
+  EXPECT_FALSE(chain[2]->isDeferred());
+  // chain[2] composes chain[0..1] from the base, the tail composes chain[3..4] from chain[2]
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 3u);
+  EXPECT_EQ(doc.lastRecomputeStats().collapsed, 4u);
+  const gp_Pnt c2 = bboxCenter(chain[2]->shape());
+  const gp_Pnt cb = bboxCenter(branch->shape());
+  EXPECT_NEAR(cb.Z() - c2.Z(), 7.0, 1.0e-7);
+}
+
+TEST(MoveChainCollapse, ConcurrentReadsOfDeferredLinkAgree)
+{
+  Document doc;
+  Handle(BoxFeature) base;
+  const auto chain = buildChain(doc, base, 8);
+  doc.recompute();
+  ASSERT_TRUE(chain[6]->isDeferred());
+
+  // Reading link 6 also builds links 0..5; every reader gets the one shape
+  std::vector<TopoDS_Shape> seen(8);
+  std::vector<std::thread>  readers;
+  for (std::size_t t = 0; t < seen.size(); ++t)
+  {
+    readers.emplace_back([&, t]() { seen[t] = chain[6 - t % 2]->shape(); });
+  }
+  for (std::thread& r : readers) r.join();
+  for (std::size_t t = 0; t < seen.size(); ++t)
+  {
+    ASSERT_FALSE(seen[t].IsNull());
+    EXPECT_TRUE(seen[t].IsEqual(seen[t % 2])) << t;
+  }
+}
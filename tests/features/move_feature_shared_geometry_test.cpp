@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <BoxFeature.h>
+#include <MoveFeature.h>
+
+#include <BRepBuilderAPI_Transform.hxx>
+#include <common/test_utils.h>
+
+TEST(MoveFeatureSharedGeometry, RigidMoveSharesSourceTopology)
+{
+  Document doc;
+  Handle(BoxFeature) base = new BoxFeature(4.0, 5.0, 6.0);
+  doc.addFeature(base);
+  Handle(MoveFeature) mf = new MoveFeature(base->id(), 10.0, 0.0, 0.0, 0.0, 0.0, 90.0);
+  doc.addFeature(mf);
+  base->setSuppressed(true);
+  doc.recompute();
+
+  ASSERT_FALSE(mf->shape().IsNull());
+  // Same underlying TShape, only the location differs
+  EXPECT_TRUE(mf->shape().IsPartner(base->shape()));
+  EXPECT_NEAR(volume(mf->shape()), 4.0 * 5.0 * 6.0, 1.0e-6);
+
+  // Copy mode yields independent geometry at the same place
+  Handle(MoveFeature) copy = new MoveFeature(base->id(), 10.0, 0.0, 0.0, 0.0, 0.0, 90.0);
+  copy->setShareGeometry(false);
+  doc.addFeature(copy);
+  doc.recompute();
+  EXPECT_FALSE(copy->shape().IsPartner(base->shape()));
+  const gp_Pnt a = bboxMin(mf->shape());
+  const gp_Pnt b = bboxMin(copy->shape());
+  EXPECT_NEAR(a.X(), b.X(), 1.0e-7);
+  EXPECT_NEAR(a.Y(), b.Y(), 1.0e-7);
+  EXPECT_NEAR(a.Z(), b.Z(), 1.0e-7);
+}
+
+TEST(MoveFeatureSharedGeometry, LongChainKeepsSingleBRep)
+{
+  Document doc;
+  Handle(BoxFeature) base = new BoxFeature(2.0, 2.0, 2.0);
+  doc.addFeature(base);
+  doc.recompute();
+
+  Handle(Feature) prev = base;
+  gp_Trsf accum;
+  for (int i = 0; i < 140; ++i)
+  {
+    gp_Trsf delta;
+    delta.SetRotation(gp_Ax1(gp_Pnt(1.0, 1.0, 1.0), gp_Dir(0.0, 0.0, 1.0)), 0.01 * (i % 7));
+    gp_Trsf shift; shift.SetTranslation(gp_Vec(0.1, -0.05, 0.02));
+    delta = shift * delta;
+    accum = delta * accum;
+
+    Handle(MoveFeature) mf = new MoveFeature();
+    mf->setSourceId(prev->id());
+    mf->setDeltaTrsf(delta);
+    prev->setSuppressed(true);
+    doc.addFeature(mf);
+    doc.recompute();
+    EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+    prev = mf;
+  }
+
+  // Every link reuses the base TShape
+  for (Timeline::FeatureView::Iterator it(doc.features()); it.More(); it.Next())
+  {
+    EXPECT_TRUE(it.Value()->shape().IsPartner(base->shape()));
+  }
+  const gp_Pnt expected = bboxMin(BRepBuilderAPI_Transform(base->shape(), accum, true).Shape());
+  const gp_Pnt actual   = bboxMin(prev->shape());
+  EXPECT_NEAR(expected.X(), actual.X(), 1.0e-6);
+  EXPECT_NEAR(expected.Y(), actual.Y(), 1.0e-6);
+  EXPECT_NEAR(expected.Z(), actual.Z(), 1.0e-6);
+}
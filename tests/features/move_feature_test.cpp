@@ -4,16 +4,7 @@
 #include <BoxFeature.h>
 #include <MoveFeature.h>
 
-#include <Bnd_Box.hxx>
-#include <BRepBndLib.hxx>
-
-static gp_Pnt bboxCenter(const TopoDS_Shape& s)
-{
-  Bnd_Box bb; BRepBndLib::Add(s, bb);
-  Standard_Real xmin = 0, ymin = 0, zmin = 0, xmax = 0, ymax = 0, zmax = 0;
-  bb.Get(xmin, ymin, zmin, xmax, ymax, zmax);
-  return gp_Pnt(0.5*(xmin+xmax), 0.5*(ymin+ymax), 0.5*(zmin+zmax));
-}
+#include <common/test_utils.h>
 
 TEST(Model, MoveFeatureTranslatesShape)
 {
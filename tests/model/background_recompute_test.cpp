@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <BackgroundRecompute.h>
+#include <SpscQueue.h>
+#include <Document.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <MoveFeature.h>
+
+#include <Message_ProgressIndicator.hxx>
+#include <Message_ProgressScope.hxx>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Breaks once 'flag' is set
+class FlagIndicator : public Message_ProgressIndicator
+{
+public:
+  explicit FlagIndicator(const std::atomic<bool>& flag) : m_flag(flag) {}
+  Standard_Boolean UserBreak() override { return m_flag.load(); }
+  void Show(const Message_ProgressScope&, const Standard_Boolean) override {}
+
+private:
+  const std::atomic<bool>& m_flag;
+};
+
+// Box that requests cancellation while it executes
+class CancellingBox : public BoxFeature
+{
+public:
+  CancellingBox(std::atomic<bool>& flag) : BoxFeature(1.0, 1.0, 1.0), m_flag(flag) {}
+  void execute(const Message_ProgressRange& theRange = Message_ProgressRange()) override
+  {
+    BoxFeature::execute(theRange);
+    m_flag = true;
+  }
+
+private:
+  std::atomic<bool>& m_flag;
+};
+} // namespace
+
+TEST(BackgroundRecompute, SpscQueueKeepsOrderAcrossThreads)
+{
+  SpscQueue<int, 64> q;
+  const int n = 100000;
+  std::thread producer([&q]() {
+    for (int i = 0; i < n; ++i)
+    {
+      int v = i;
+      while (!q.push(v)) std::this_thread::yield();
+    }
+  });
+  int expected = 0, v = -1;
+  while (expected < n)
+  {
+    if (!q.pop(v)) continue;
+    ASSERT_EQ(v, expected);
+    ++expected;
+  }
+  producer.join();
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.pop(v));
+}
+
+TEST(BackgroundRecompute, CancelledRecomputeLeavesRemainingFeaturesDirty)
+{
+  std::atomic<bool> cancel{false};
+  Document doc;
+  doc.addFeature(new BoxFeature(1.0, 1.0, 1.0));
+  doc.addFeature(new CancellingBox(cancel));
+  for (int i = 0; i < 5; ++i) doc.addFeature(new BoxFeature(2.0 + i, 1.0, 1.0));
+
+  Handle(FlagIndicator) indicator = new FlagIndicator(cancel);
+  doc.recompute(indicator->Start());
+  const Document::RecomputeStats& st = doc.lastRecomputeStats();
+  EXPECT_EQ(st.executed, 1u);
+  EXPECT_EQ(st.cancelled, 6u); // the interrupted feature and everything after it
+  EXPECT_FALSE(doc.features().Value(1)->isDirty());
+  EXPECT_TRUE(doc.features().Value(2)->isDirty());
+  EXPECT_TRUE(doc.features().Value(7)->isDirty());
+
+  // A later recompute picks up where the cancelled one stopped
+  cancel = false;
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 6u);
+  EXPECT_EQ(doc.lastRecomputeStats().cancelled, 0u);
+}
+
+TEST(BackgroundRecompute, ResultsArriveThroughQueueAndKeepLastGoodShapes)
+{
+  Document doc;
+  Handle(BoxFeature) box = new BoxFeature(1.0, 2.0, 3.0);
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 4.0);
+  doc.addFeature(box);
+  doc.addFeature(cyl);
+  doc.recompute();
+  const TopoDS_Shape cylShape = cyl->shape();
+  const TopoDS_Shape oldBox   = box->shape();
+
+  std::vector<Document::ChangeSet> sets;
+  doc.addChangeListener([&sets](const Document::ChangeSet& cs) { sets.push_back(cs); });
+  std::atomic<int> ready{0};
+  BackgroundRecompute bg([&ready]() { ++ready; });
+  doc.setRecomputeScheduler([&bg](Document& d) { bg.request(d); });
+
+  box->setSize(5.0, 5.0, 5.0);
+  Handle(MoveFeature) mv = new MoveFeature();
+  mv->setSourceId(cyl->id());
+  mv->setTranslation(10.0, 0.0, 0.0);
+  doc.addFeature(mv);
+  doc.recompute(); // schedules; structural change is notified right away
+  ASSERT_EQ(sets.size(), 1u);
+  EXPECT_EQ(sets[0].added.size(), 1u);
+
+  ASSERT_TRUE(bg.waitIdle(10000));
+  EXPECT_GE(ready.load(), 1);
+  // Nothing changes on the document until the owner applies the results
+  EXPECT_TRUE(box->shape().IsSame(oldBox));
+  EXPECT_TRUE(box->isDirty());
+  EXPECT_TRUE(mv->shape().IsNull());
+
+  EXPECT_EQ(bg.apply(doc), 2u); // box + move; the cylinder was up to date
+  EXPECT_FALSE(box->isDirty());
+  EXPECT_FALSE(box->shape().IsSame(oldBox));
+  EXPECT_FALSE(mv->isDirty());
+  EXPECT_FALSE(mv->shape().IsNull());
+  EXPECT_TRUE(cyl->shape().IsSame(cylShape));
+  ASSERT_EQ(sets.size(), 2u);
+  EXPECT_EQ(sets[1].modified.size(), 2u);
+
+  // Everything is up to date: a synchronous recompute has nothing left to do
+  doc.setRecomputeScheduler(Document::RecomputeScheduler());
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 0u);
+}
+
+TEST(BackgroundRecompute, NewerEditsSupersedeAndStaleResultsAreDiscarded)
+{
+  Document doc;
+  std::vector<Handle(BoxFeature)> boxes;
+  for (int i = 0; i < 50; ++i)
+  {
+    boxes.push_back(new BoxFeature(1.0 + i, 1.0, 1.0));
+    doc.addFeature(boxes.back());
+  }
+  BackgroundRecompute bg;
+  for (int round = 0; round < 5; ++round)
+  {
+    for (auto& b : boxes) b->setSize(b->dx() + 1.0, 1.0, 1.0);
+    bg.request(doc);
+  }
+  // Edited after the last snapshot: its result must not be adopted
+  boxes[0]->setSize(100.0, 1.0, 1.0);
+  ASSERT_TRUE(bg.waitIdle(10000));
+  bg.apply(doc);
+
+  EXPECT_TRUE(boxes[0]->isDirty());
+  for (std::size_t i = 1; i < boxes.size(); ++i)
+  {
+    ASSERT_FALSE(boxes[i]->isDirty()) << i;
+  }
+  const BackgroundRecompute::Stats st = bg.stats();
+  EXPECT_EQ(st.requested, 5u);
+  EXPECT_EQ(st.completed + st.cancelled + st.superseded, st.requested);
+  EXPECT_GE(st.discarded, 1u);
+  EXPECT_EQ(bg.latestGeneration(), 5u);
+
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+}
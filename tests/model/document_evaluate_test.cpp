@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <MoveFeature.h>
+
+#include <vector>
+
+namespace
+{
+// Two independent branches: a box with a move of it, and a cylinder
+struct BranchDoc
+{
+  Document                doc;
+  Handle(BoxFeature)      box = new BoxFeature(1.0, 2.0, 3.0);
+  Handle(MoveFeature)     move;
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 4.0);
+
+  BranchDoc()
+  {
+    doc.addFeature(box);
+    move = new MoveFeature(box->id(), 5.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+    doc.addFeature(move);
+    doc.addFeature(cyl);
+  }
+};
+} // namespace
+
+TEST(DocumentEvaluate, ComputesOnlyTheRequestedClosure)
+{
+  BranchDoc d;
+  d.doc.evaluate({d.move->id()});
+  const Document::RecomputeStats& st = d.doc.lastRecomputeStats();
+  EXPECT_EQ(st.executed, 2u); // box + move
+  EXPECT_EQ(st.notNeeded, 1u);
+  EXPECT_FALSE(d.box->isDirty());
+  EXPECT_FALSE(d.move->isDirty());
+  EXPECT_FALSE(d.move->shape().IsNull());
+  EXPECT_TRUE(d.cyl->isDirty());
+  EXPECT_TRUE(d.cyl->shape().IsNull());
+}
+
+TEST(DocumentEvaluate, RepeatedRequestsExecuteOncePerChange)
+{
+  BranchDoc d;
+  d.doc.evaluate({d.move->id()});
+  d.doc.evaluate({d.move->id(), d.box->id()});
+  EXPECT_EQ(d.doc.lastRecomputeStats().executed, 0u);
+
+  // Only the edited feature and its consumer re-run
+  d.box->setSize(2.0, 2.0, 2.0);
+  d.doc.evaluate({d.move->id()});
+  EXPECT_EQ(d.doc.lastRecomputeStats().executed, 2u);
+  d.doc.evaluate({d.move->id()});
+  EXPECT_EQ(d.doc.lastRecomputeStats().executed, 0u);
+
+  d.doc.evaluate({d.cyl->id()});
+  EXPECT_EQ(d.doc.lastRecomputeStats().executed, 1u);
+  EXPECT_FALSE(d.cyl->shape().IsNull());
+}
+
+TEST(DocumentEvaluate, RequestedSuppressedFeatureIsComputed)
+{
+  BranchDoc d;
+  d.cyl->setSuppressed(true);
+  d.doc.recompute();
+  EXPECT_TRUE(d.cyl->isDirty()); // hidden, so the eager pass leaves it stale
+
+  d.doc.evaluate({d.cyl->id()});
+  EXPECT_EQ(d.doc.lastRecomputeStats().executed, 1u);
+  EXPECT_FALSE(d.cyl->isDirty());
+  EXPECT_FALSE(d.cyl->shape().IsNull());
+}
+
+TEST(DocumentEvaluate, RequestedCollapsedLinkIsMaterialized)
+{
+  BranchDoc d;
+  Handle(MoveFeature) second = new MoveFeature(d.move->id(), 0.0, 5.0, 0.0, 0.0, 0.0, 0.0);
+  d.doc.addFeature(second);
+  d.box->setSuppressed(true);
+  d.move->setSuppressed(true);
+  d.doc.recompute();
+  ASSERT_TRUE(d.move->isDeferred());
+
+  d.doc.evaluate({d.move->id()});
+  EXPECT_FALSE(d.move->isDeferred());
+  EXPECT_FALSE(d.move->shape().IsNull());
+  EXPECT_FALSE(second->shape().IsNull());
+}
+
+TEST(DocumentEvaluate, OnDemandRecomputeOnlyTracksStaleness)
+{
+  BranchDoc d;
+  d.doc.setEvaluationMode(Document::EvaluationMode::OnDemand);
+  std::vector<Document::ChangeSet> sets;
+  d.doc.addChangeListener([&sets](const Document::ChangeSet& cs) { sets.push_back(cs); });
+
+  d.doc.recompute();
+  EXPECT_EQ(d.doc.lastRecomputeStats().executed, 0u);
+  EXPECT_EQ(d.doc.lastRecomputeStats().notNeeded, 3u);
+  EXPECT_TRUE(d.box->isDirty());
+  ASSERT_EQ(sets.size(), 1u); // the additions are still notified
+
+  d.doc.evaluate({d.cyl->id()});
+  EXPECT_EQ(d.doc.lastRecomputeStats().executed, 1u);
+  ASSERT_EQ(sets.size(), 2u);
+  EXPECT_EQ(sets[1].modified.size(), 1u);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <ExtrudeFeature.h>
+#include <MoveFeature.h>
+#include <Sketch.h>
+
+#include <common/test_utils.h>
+
+namespace
+{
+std::shared_ptr<Sketch> makeRectSketch(double w, double h)
+{
+  auto sk = std::make_shared<Sketch>();
+  auto c1 = sk->addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(w, 0.0));
+  auto c2 = sk->addLine(gp_Pnt2d(w, 0.0), gp_Pnt2d(w, h));
+  auto c3 = sk->addLine(gp_Pnt2d(w, h), gp_Pnt2d(0.0, h));
+  auto c4 = sk->addLine(gp_Pnt2d(0.0, h), gp_Pnt2d(0.0, 0.0));
+  sk->addCoincident({c1, 1}, {c2, 0});
+  sk->addCoincident({c2, 1}, {c3, 0});
+  sk->addCoincident({c3, 1}, {c4, 0});
+  sk->addCoincident({c4, 1}, {c1, 0});
+  sk->solveConstraints();
+  return sk;
+}
+} // namespace
+
+TEST(DocumentIncremental, AppendExecutesOnlyNewFeature)
+{
+  Document doc;
+  for (int i = 0; i < 50; ++i)
+  {
+    doc.addFeature(new BoxFeature(1.0 + i, 2.0, 3.0));
+  }
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 50u);
+
+  doc.addFeature(new CylinderFeature(2.0, 4.0));
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+  EXPECT_EQ(doc.lastRecomputeStats().skipped, 50u);
+
+  // Nothing changed: nothing runs
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 0u);
+  EXPECT_EQ(doc.totalExecuted(), 51u);
+}
+
+TEST(DocumentIncremental, ParamEditReexecutesDownstreamChain)
+{
+  Document doc;
+  Handle(BoxFeature) other = new BoxFeature(5.0, 5.0, 5.0);
+  Handle(BoxFeature) base  = new BoxFeature(10.0, 10.0, 10.0);
+  doc.addFeature(other);
+  doc.addFeature(base);
+  Handle(MoveFeature) m1 = new MoveFeature(base->id(), 5.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  doc.addFeature(m1);
+  Handle(MoveFeature) m2 = new MoveFeature(m1->id(), 0.0, 5.0, 0.0, 0.0, 0.0, 0.0);
+  doc.addFeature(m2);
+  base->setSuppressed(true);
+  m1->setSuppressed(true);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 4u);
+
+  ASSERT_EQ(doc.dependents(base->id()).size(), 1u);
+  EXPECT_EQ(doc.dependents(base->id()).front(), m1->id());
+
+  // Editing the suppressed base must flow through both moves, but not touch the other box
+  base->setDx(20.0);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 3u);
+  EXPECT_NEAR(bboxExtents(m2->shape())[0], 20.0, 1.0e-7);
+
+  // Explicit dirty marking of a middle link re-executes only it and its consumer
+  doc.markDirty(m1);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 2u);
+}
+
+TEST(DocumentIncremental, SketchDirtyReexecutesExtrude)
+{
+  Document doc;
+  auto sk = makeRectSketch(10.0, 5.0);
+  doc.addSketch(sk);
+  Handle(ExtrudeFeature) ef = new ExtrudeFeature(sk->id(), 3.0);
+  doc.addFeature(ef);
+  doc.addFeature(new BoxFeature(1.0, 1.0, 1.0));
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 2u);
+  EXPECT_NEAR(volume(ef->shape()), 150.0, 1.0e-6);
+
+  doc.markSketchDirty(sk->id());
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+}
+
+TEST(DocumentIncremental, UnneededStaleFeatureRunsWhenUnsuppressed)
+{
+  Document doc;
+  Handle(BoxFeature) hidden = new BoxFeature(1.0, 2.0, 3.0);
+  hidden->setSuppressed(true);
+  doc.addFeature(hidden);
+  doc.recompute();
+  // Suppressed and unreferenced: not executed
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 0u);
+  EXPECT_TRUE(hidden->shape().IsNull());
+
+  hidden->setSuppressed(false);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+  EXPECT_FALSE(hidden->shape().IsNull());
+  EXPECT_FALSE(hidden->isDirty());
+}
+
+TEST(DocumentIncremental, ExtrudeRecomputedBeforeItsSketchRunsOnceBound)
+{
+  // Load order of a file that lists features before sketches, with a recompute in between
+  auto sk = makeRectSketch(10.0, 5.0);
+  Document doc;
+  Handle(ExtrudeFeature) ef = new ExtrudeFeature(sk->id(), 3.0);
+  doc.addFeature(ef);
+  doc.recompute();
+  EXPECT_TRUE(ef->shape().IsNull());
+
+  doc.addSketch(sk);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+  EXPECT_NEAR(volume(ef->shape()), 150.0, 1.0e-6);
+}
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <UndoStack.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <MoveFeature.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Box whose execute() takes a known minimum time, so checkpoint placement is deterministic
+class SlowBox : public BoxFeature
+{
+public:
+  explicit SlowBox(int ms) : BoxFeature(2.0, 3.0, 4.0), m_ms(ms) {}
+  void execute(const Message_ProgressRange& theRange = Message_ProgressRange()) override
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(m_ms));
+    BoxFeature::execute(theRange);
+  }
+
+private:
+  int m_ms;
+};
+
+bool contains(const std::vector<DocumentItem::Id>& ids, DocumentItem::Id id)
+{
+  return std::find(ids.begin(), ids.end(), id) != ids.end();
+}
+} // namespace
+
+TEST(DocumentRollback, RolledBackFeaturesAreNotRecomputed)
+{
+  Document doc;
+  Handle(BoxFeature) a = new BoxFeature(1.0, 1.0, 1.0);
+  Handle(BoxFeature) b = new BoxFeature(2.0, 1.0, 1.0);
+  Handle(CylinderFeature) c = new CylinderFeature(1.0, 2.0);
+  doc.addFeature(a);
+  doc.addFeature(b);
+  doc.addFeature(c);
+  EXPECT_FALSE(doc.hasRollback());
+  EXPECT_EQ(doc.rollbackPosition(), 3);
+
+  doc.setRollbackPosition(1);
+  EXPECT_TRUE(doc.hasRollback());
+  EXPECT_EQ(doc.rollbackPosition(), 1);
+  EXPECT_FALSE(doc.isRolledBack(a->id()));
+  EXPECT_TRUE(doc.isRolledBack(b->id()));
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+  EXPECT_EQ(doc.lastRecomputeStats().notNeeded, 2u);
+  EXPECT_TRUE(b->isDirty());
+
+  // Moving the marker to the end brings the rest up to date
+  doc.setRollbackPosition(3);
+  EXPECT_FALSE(doc.hasRollback());
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 2u);
+}
+
+TEST(DocumentRollback, ScrubbingReusesHeldResults)
+{
+  Document doc;
+  Handle(BoxFeature) a = new BoxFeature(1.0, 1.0, 1.0);
+  Handle(MoveFeature) m = new MoveFeature();
+  Handle(CylinderFeature) c = new CylinderFeature(1.0, 2.0);
+  doc.addFeature(a);
+  m->setSourceId(a->id());
+  m->setTranslation(5.0, 0.0, 0.0);
+  doc.addFeature(m);
+  doc.addFeature(c);
+  doc.recompute();
+  std::vector<Document::ChangeSet> sets;
+  doc.addChangeListener([&sets](const Document::ChangeSet& cs) { sets.push_back(cs); });
+
+  for (int position = 3; position-- > 0;)
+  {
+    doc.setRollbackPosition(position);
+    doc.recompute();
+    EXPECT_EQ(doc.lastRecomputeStats().executed, 0u) << position;
+  }
+  // Each step reported the feature that disappeared
+  ASSERT_EQ(sets.size(), 3u);
+  EXPECT_EQ(sets[0].modified, std::vector<DocumentItem::Id>{c->id()});
+  EXPECT_EQ(sets[2].modified, std::vector<DocumentItem::Id>{a->id()});
+
+  // Edits behind the marker replay only the stale features once they become active again
+  doc.setRollbackPosition(1);
+  a->setSize(3.0, 3.0, 3.0);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+  EXPECT_TRUE(m->isDirty());
+  doc.clearRollback();
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u); // the move; the cylinder is reused
+  EXPECT_FALSE(m->isDirty());
+}
+
+TEST(DocumentRollback, NewFeaturesAreInsertedAtTheMarker)
+{
+  Document doc;
+  Handle(BoxFeature) a = new BoxFeature(1.0, 1.0, 1.0);
+  Handle(BoxFeature) b = new BoxFeature(2.0, 1.0, 1.0);
+  doc.addFeature(a);
+  doc.addFeature(b);
+  doc.setRollbackPosition(1);
+
+  Handle(CylinderFeature) c = new CylinderFeature(1.0, 2.0);
+  doc.addFeature(c);
+  EXPECT_EQ(doc.indexOf(c->id()), 2);
+  EXPECT_EQ(doc.rollbackPosition(), 2);
+  EXPECT_TRUE(doc.isRolledBack(b->id()));
+
+  // Removing the marker item steps the marker back
+  doc.removeFeature(c);
+  EXPECT_TRUE(doc.hasRollback());
+  EXPECT_EQ(doc.rollbackPosition(), 1);
+  EXPECT_TRUE(doc.isRolledBack(b->id()));
+}
+
+TEST(DocumentRollback, MarkerSurvivesUndoAndTransactionRollback)
+{
+  Document doc;
+  UndoStack undo;
+  Handle(BoxFeature) a = new BoxFeature(1.0, 1.0, 1.0);
+  Handle(BoxFeature) b = new BoxFeature(2.0, 1.0, 1.0);
+  doc.addFeature(a);
+  doc.addFeature(b);
+  undo.reset(doc);
+  doc.setRollbackPosition(1);
+
+  doc.addFeature(new CylinderFeature(1.0, 2.0));
+  undo.commit(doc, "Cylinder");
+  ASSERT_TRUE(undo.undo(doc));
+  EXPECT_EQ(doc.items().Size(), 2);
+  EXPECT_EQ(doc.rollbackPosition(), 1); // back on the last surviving active item
+
+  {
+    Document::Transaction txn(doc);
+    doc.setRollbackPosition(0);
+    doc.addFeature(new CylinderFeature(2.0, 2.0));
+  }
+  EXPECT_EQ(doc.items().Size(), 2);
+  EXPECT_EQ(doc.rollbackPosition(), 1);
+}
+
+TEST(DocumentRollback, MarkerBeforeMoveShowsItsSource)
+{
+  Document doc;
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 2.0);
+  Handle(BoxFeature) hidden = new BoxFeature(1.0, 1.0, 1.0);
+  hidden->setSuppressed(true); // suppressed by the user, not by a Move
+  doc.addFeature(cyl);
+  doc.addFeature(hidden);
+  Handle(MoveFeature) mv = new MoveFeature();
+  mv->setSourceId(cyl->id());
+  mv->setTranslation(5.0, 0.0, 0.0);
+  cyl->setSuppressed(true); // as confirming a Move does
+  doc.addFeature(mv);
+  doc.recompute();
+  EXPECT_FALSE(doc.isDisplayed(cyl));
+  EXPECT_TRUE(doc.isDisplayed(mv));
+
+  std::vector<Document::ChangeSet> sets;
+  doc.addChangeListener([&sets](const Document::ChangeSet& cs) { sets.push_back(cs); });
+  doc.setRollbackPosition(2);
+  EXPECT_TRUE(doc.isDisplayed(cyl));
+  EXPECT_FALSE(doc.isDisplayed(hidden));
+  EXPECT_FALSE(doc.isDisplayed(mv));
+  doc.recompute();
+  EXPECT_FALSE(cyl->shape().IsNull());
+  ASSERT_EQ(sets.size(), 1u);
+  EXPECT_TRUE(contains(sets[0].modified, cyl->id()));
+  EXPECT_TRUE(contains(sets[0].modified, mv->id()));
+  EXPECT_TRUE(cyl->isSuppressed()); // the flag itself is untouched
+
+  // Passing the Move again hides the source
+  doc.clearRollback();
+  EXPECT_FALSE(doc.isDisplayed(cyl));
+  EXPECT_TRUE(doc.isDisplayed(mv));
+}
+
+TEST(DocumentRollback, CheckpointsBoundReplayOfEvictedResults)
+{
+  Document doc;
+  Handle(SlowBox) base = new SlowBox(30);
+  doc.addFeature(base);
+  Handle(MoveFeature) m1 = new MoveFeature(base->id(), 10.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  m1->setShareGeometry(false);
+  doc.addFeature(m1);
+  Handle(MoveFeature) m2 = new MoveFeature(m1->id(), 0.0, 10.0, 0.0, 0.0, 0.0, 0.0);
+  m2->setShareGeometry(false);
+  doc.addFeature(m2);
+  doc.setCheckpointInterval(10.0);
+  doc.setResultBudget(1, Document::EvictionMode::Drop);
+  doc.recompute();
+  EXPECT_TRUE(doc.checkpoints().empty()); // everything is displayed
+
+  // Rolled back to the top: the expensive base stays resident as a checkpoint, the cheap moves go
+  doc.setRollbackPosition(0);
+  doc.recompute();
+  const std::vector<DocumentItem::Id> pinned = doc.checkpoints();
+  EXPECT_TRUE(contains(pinned, base->id()));
+  EXPECT_FALSE(contains(pinned, m2->id()));
+  EXPECT_FALSE(base->isEvicted());
+  EXPECT_TRUE(m1->isEvicted());
+  EXPECT_TRUE(m2->isEvicted());
+
+  // Scrubbing forward replays the moves from the checkpoint, not the base
+  doc.clearRollback();
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 0u);
+  EXPECT_FALSE(m2->shape().IsNull());
+  EXPECT_EQ(base->rematerializeCount(), 0u);
+  EXPECT_GE(m1->rematerializeCount(), 1u);
+}
@@ -3,6 +3,9 @@
 #include <Document.h>
 #include <BoxFeature.h>
 #include <CylinderFeature.h>
+#include <Sketch.h>
+
+#include <memory>
 
 TEST(DocumentTimeline, AddInsertAndIterateItems)
 {
@@ -45,3 +48,29 @@ TEST(DocumentTimeline, AddInsertAndIterateItems)
   EXPECT_EQ(doc.features().Size(), 0);
 }
 
+
+TEST(DocumentTimeline, DuplicateIdsAreRejected)
+{
+  Document doc;
+  Handle(BoxFeature) a = new BoxFeature();
+  EXPECT_TRUE(doc.addFeature(a));
+  EXPECT_FALSE(doc.addFeature(a));
+  EXPECT_FALSE(doc.addItem(Handle(DocumentItem)(a)));
+  EXPECT_FALSE(doc.insertItem(1, Handle(DocumentItem)(a)));
+  EXPECT_FALSE(doc.addFeature(Handle(Feature)()));
+  EXPECT_EQ(doc.items().Size(), 1);
+  EXPECT_EQ(doc.features().Size(), 1);
+}
+
+TEST(DocumentTimeline, DuplicateRegistryIdsAreRejected)
+{
+  Document doc;
+  auto sk = std::make_shared<Sketch>();
+  EXPECT_TRUE(doc.addSketch(sk));
+  EXPECT_FALSE(doc.addSketch(sk));
+  EXPECT_FALSE(doc.addSketch(std::make_shared<Sketch>(sk->id())));
+  EXPECT_FALSE(doc.addItem(std::shared_ptr<DocumentItem>(std::make_shared<Sketch>(sk->id()))));
+  EXPECT_FALSE(doc.addSketch(nullptr));
+  ASSERT_EQ(doc.sketches().size(), 1u);
+  EXPECT_EQ(doc.findSketch(sk->id()), sk); // the first registration is kept
+}
@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <MoveFeature.h>
+#include <Sketch.h>
+
+#include <common/test_utils.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+struct Recorder
+{
+  std::vector<Document::ChangeSet> sets;
+  Document::ChangeListener fn() { return [this](const Document::ChangeSet& cs) { sets.push_back(cs); }; }
+};
+} // namespace
+
+TEST(DocumentTransaction, BatchInsertRecomputesAndNotifiesOnce)
+{
+  Document doc;
+  Recorder rec;
+  doc.addChangeListener(rec.fn());
+
+  const int n = 200;
+  const std::size_t executedBefore = doc.totalExecuted();
+  doc.beginTransaction();
+  for (int i = 0; i < n; ++i)
+  {
+    doc.addFeature(new BoxFeature(1.0 + i, 2.0, 3.0));
+    doc.recompute(); // deferred
+  }
+  EXPECT_TRUE(doc.inTransaction());
+  EXPECT_TRUE(rec.sets.empty());
+  EXPECT_EQ(doc.totalExecuted(), executedBefore);
+  doc.commitTransaction();
+
+  EXPECT_FALSE(doc.inTransaction());
+  EXPECT_EQ(doc.totalExecuted() - executedBefore, static_cast<std::size_t>(n));
+  ASSERT_EQ(rec.sets.size(), 1u);
+  EXPECT_EQ(rec.sets[0].added.size(), static_cast<std::size_t>(n));
+  EXPECT_TRUE(rec.sets[0].modified.empty());
+  EXPECT_TRUE(rec.sets[0].removed.empty());
+}
+
+TEST(DocumentTransaction, ChangeSetNamesOnlyTouchedItems)
+{
+  Document doc;
+  Handle(BoxFeature) a = new BoxFeature(1.0, 1.0, 1.0);
+  Handle(BoxFeature) b = new BoxFeature(2.0, 2.0, 2.0);
+  Handle(CylinderFeature) c = new CylinderFeature(1.0, 3.0);
+  doc.addFeature(a);
+  doc.addFeature(b);
+  doc.addFeature(c);
+  doc.recompute();
+
+  Recorder rec;
+  const int token = doc.addChangeListener(rec.fn());
+  doc.recompute(); // nothing changed
+  EXPECT_TRUE(rec.sets.empty());
+
+  {
+    Document::Transaction txn(doc);
+    b->setSize(5.0, 5.0, 5.0);
+    doc.removeFeature(c);
+    doc.addSketch(std::make_shared<Sketch>());
+    txn.commit();
+  }
+  ASSERT_EQ(rec.sets.size(), 1u);
+  const Document::ChangeSet& cs = rec.sets[0];
+  EXPECT_TRUE(cs.added.empty());
+  ASSERT_EQ(cs.modified.size(), 1u);
+  EXPECT_EQ(cs.modified[0], b->id());
+  ASSERT_EQ(cs.removed.size(), 1u);
+  EXPECT_EQ(cs.removed[0], c->id());
+  EXPECT_TRUE(cs.sketchesChanged);
+
+  doc.removeChangeListener(token);
+  a->setSize(3.0, 3.0, 3.0);
+  doc.recompute();
+  EXPECT_EQ(rec.sets.size(), 1u);
+}
+
+TEST(DocumentTransaction, RollbackRestoresItemsAndResults)
+{
+  Document doc;
+  Handle(BoxFeature) box = new BoxFeature(1.0, 2.0, 3.0);
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 4.0);
+  doc.addFeature(box);
+  doc.addFeature(cyl);
+  auto sk = std::make_shared<Sketch>();
+  sk->addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(1.0, 0.0));
+  doc.addSketch(sk);
+  doc.recompute();
+  const TopoDS_Shape boxShape = box->shape();
+  const std::string sketchBlob = sk->serialize();
+  const std::size_t executed = doc.totalExecuted();
+
+  Recorder rec;
+  doc.addChangeListener(rec.fn());
+  doc.beginTransaction();
+  box->setSize(9.0, 9.0, 9.0);
+  cyl->setSuppressed(true);
+  doc.removeFeature(cyl);
+  doc.addFeature(new BoxFeature(4.0, 4.0, 4.0));
+  sk->addLine(gp_Pnt2d(1.0, 0.0), gp_Pnt2d(1.0, 1.0));
+  doc.addSketch(std::make_shared<Sketch>());
+  doc.recompute();
+  doc.rollbackTransaction();
+
+  EXPECT_FALSE(doc.inTransaction());
+  EXPECT_TRUE(rec.sets.empty());
+  ASSERT_EQ(doc.items().Size(), 2);
+  EXPECT_EQ(doc.items().Value(1).get(), box.get()); // object identity is kept
+  EXPECT_EQ(doc.items().Value(2).get(), cyl.get());
+  EXPECT_DOUBLE_EQ(box->dx(), 1.0);
+  EXPECT_FALSE(cyl->isSuppressed());
+  EXPECT_TRUE(box->shape().IsSame(boxShape));
+  EXPECT_FALSE(box->isDirty());
+  ASSERT_EQ(doc.sketches().size(), 1u);
+  EXPECT_EQ(doc.sketches()[0], sk);
+  EXPECT_EQ(sk->serialize(), sketchBlob);
+  EXPECT_EQ(doc.findSketch(sk->id()), sk);
+
+  // Restored results are reused: nothing executes
+  doc.recompute();
+  EXPECT_EQ(doc.totalExecuted(), executed);
+}
+
+TEST(DocumentTransaction, RollbackKeepsCollapsedLinksFolded)
+{
+  // Box -> m1 -> m2 -> tail; box, m1 and m2 are suppressed, so m1 and m2 fold into the tail
+  Document doc;
+  Handle(BoxFeature) box = new BoxFeature(2.0, 3.0, 4.0);
+  doc.addFeature(box);
+  Handle(MoveFeature) m1   = new MoveFeature(box->id(), 1.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  doc.addFeature(m1);
+  Handle(MoveFeature) m2   = new MoveFeature(m1->id(), 0.0, 1.0, 0.0, 0.0, 0.0, 0.0);
+  doc.addFeature(m2);
+  Handle(MoveFeature) tail = new MoveFeature(m2->id(), 0.0, 0.0, 1.0, 0.0, 0.0, 0.0);
+  doc.addFeature(tail);
+  box->setSuppressed(true);
+  m1->setSuppressed(true);
+  m2->setSuppressed(true);
+  doc.recompute();
+  ASSERT_TRUE(m2->isDeferred());
+
+  doc.beginTransaction();
+  m2->setTranslation(0.0, 5.0, 0.0);
+  doc.rollbackTransaction();
+  EXPECT_TRUE(m2->isDeferred());
+  EXPECT_FALSE(m2->isDirty());
+
+  // The next fold still starts from the box, not from the restored link
+  tail->setTranslation(0.0, 0.0, 2.0);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().collapsed, 2u);
+  ASSERT_FALSE(tail->shape().IsNull());
+  EXPECT_NEAR(volume(tail->shape()), 24.0, 1.0e-6);
+}
+
+TEST(DocumentTransaction, NestedTransactionsCommitAtOutermost)
+{
+  Document doc;
+  Recorder rec;
+  doc.addChangeListener(rec.fn());
+
+  doc.beginTransaction();
+  doc.addFeature(new BoxFeature(1.0, 1.0, 1.0));
+  doc.beginTransaction();
+  doc.addFeature(new BoxFeature(2.0, 2.0, 2.0));
+  doc.commitTransaction();
+  EXPECT_TRUE(doc.inTransaction());
+  EXPECT_TRUE(rec.sets.empty());
+  doc.commitTransaction();
+  ASSERT_EQ(rec.sets.size(), 1u);
+  EXPECT_EQ(rec.sets[0].added.size(), 2u);
+
+  // An inner rollback aborts the whole batch; the outer level stays open and its commit reports it
+  doc.beginTransaction();
+  doc.addFeature(new BoxFeature(3.0, 3.0, 3.0));
+  doc.beginTransaction();
+  doc.addFeature(new BoxFeature(4.0, 4.0, 4.0));
+  doc.rollbackTransaction();
+  EXPECT_TRUE(doc.inTransaction());
+  EXPECT_TRUE(doc.transactionAborted());
+  EXPECT_EQ(doc.items().Size(), 2);
+  EXPECT_FALSE(doc.commitTransaction());
+  EXPECT_FALSE(doc.inTransaction());
+  EXPECT_FALSE(doc.transactionAborted());
+  EXPECT_EQ(doc.items().Size(), 2);
+  EXPECT_EQ(rec.sets.size(), 1u);
+
+  // The next batch starts clean
+  doc.beginTransaction();
+  doc.addFeature(new BoxFeature(5.0, 5.0, 5.0));
+  EXPECT_TRUE(doc.commitTransaction());
+  EXPECT_EQ(doc.items().Size(), 3);
+  EXPECT_EQ(rec.sets.size(), 2u);
+}
+
+TEST(DocumentTransaction, ScopedGuardSeesInnerRollback)
+{
+  Document doc;
+  Handle(BoxFeature) box = new BoxFeature(1.0, 2.0, 3.0);
+  doc.addFeature(box);
+  doc.recompute();
+
+  Document::Transaction outer(doc);
+  box->setSize(4.0, 4.0, 4.0);
+  {
+    Document::Transaction inner(doc); // destroyed without commit
+    doc.addFeature(new CylinderFeature(1.0, 1.0));
+  }
+  EXPECT_DOUBLE_EQ(box->dx(), 1.0);
+  EXPECT_EQ(doc.items().Size(), 1);
+  EXPECT_FALSE(outer.commit());
+  EXPECT_FALSE(doc.inTransaction());
+}
+
+TEST(DocumentTransaction, ScopedTransactionRollsBackOnException)
+{
+  Document doc;
+  Handle(BoxFeature) box = new BoxFeature(1.0, 2.0, 3.0);
+  doc.addFeature(box);
+  doc.recompute();
+
+  try
+  {
+    Document::Transaction txn(doc);
+    box->setSize(7.0, 7.0, 7.0);
+    doc.addFeature(new CylinderFeature(1.0, 1.0));
+    throw std::runtime_error("command failed");
+  }
+  catch (const std::runtime_error&)
+  {
+  }
+  EXPECT_FALSE(doc.inTransaction());
+  EXPECT_EQ(doc.items().Size(), 1);
+  EXPECT_DOUBLE_EQ(box->dx(), 1.0);
+}
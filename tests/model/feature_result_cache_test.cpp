@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <FeatureResultCache.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <ExtrudeFeature.h>
+#include <MoveFeature.h>
+#include <Sketch.h>
+
+#include <BRepPrimAPI_MakeBox.hxx>
+
+TEST(FeatureResultCache, ReAddedFeatureHitsCache)
+{
+  Document doc;
+  doc.setResultCache(std::make_shared<FeatureResultCache>());
+  Handle(BoxFeature) a = new BoxFeature(1.0, 2.0, 3.0);
+  doc.addFeature(a);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+  EXPECT_EQ(doc.lastRecomputeStats().cacheHits, 0u);
+
+  // Remove and add an equivalent feature: same kind and params, so no kernel call
+  doc.removeFeature(a);
+  Handle(BoxFeature) b = new BoxFeature(1.0, 2.0, 3.0);
+  doc.addFeature(b);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 0u);
+  EXPECT_EQ(doc.lastRecomputeStats().cacheHits, 1u);
+  EXPECT_TRUE(b->shape().IsSame(a->shape()));
+
+  const FeatureResultCache::Stats st = doc.resultCache()->stats();
+  EXPECT_EQ(st.hits, 1u);
+  EXPECT_EQ(st.misses, 1u);
+  EXPECT_EQ(st.entries, 1u);
+}
+
+TEST(FeatureResultCache, RevertedEditAndUpstreamKeys)
+{
+  Document doc;
+  doc.setResultCache(std::make_shared<FeatureResultCache>());
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 4.0);
+  doc.addFeature(cyl);
+  Handle(MoveFeature) mv = new MoveFeature(cyl->id(), 5.0, 0.0, 0.0, 0.0, 0.0, 30.0);
+  cyl->setSuppressed(true);
+  doc.addFeature(mv);
+  doc.recompute();
+  const TopoDS_Shape first = mv->shape();
+
+  // A different upstream result changes the move's key even though its own params are unchanged
+  cyl->set(2.0, 4.0);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 2u);
+  EXPECT_EQ(doc.lastRecomputeStats().cacheHits, 0u);
+
+  // Reverting the edit (undo) serves both results from the cache
+  cyl->set(1.0, 4.0);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 0u);
+  EXPECT_EQ(doc.lastRecomputeStats().cacheHits, 2u);
+  EXPECT_TRUE(mv->shape().IsSame(first));
+
+  // Exact manipulator deltas are part of the key
+  gp_Trsf delta; delta.SetTranslation(gp_Vec(0.0, 1.0, 0.0));
+  mv->setDeltaTrsf(delta);
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 1u);
+}
+
+TEST(FeatureResultCache, SketchEditInvalidatesExtrudeKey)
+{
+  auto sk = std::make_shared<Sketch>();
+  auto c1 = sk->addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(2.0, 0.0));
+  auto c2 = sk->addLine(gp_Pnt2d(2.0, 0.0), gp_Pnt2d(2.0, 1.0));
+  auto c3 = sk->addLine(gp_Pnt2d(2.0, 1.0), gp_Pnt2d(0.0, 0.0));
+  sk->addCoincident({c1, 1}, {c2, 0});
+  sk->addCoincident({c2, 1}, {c3, 0});
+  sk->addCoincident({c3, 1}, {c1, 0});
+  sk->solveConstraints();
+
+  Handle(ExtrudeFeature) ef = new ExtrudeFeature(sk->id(), 2.0);
+  ef->setSketch(sk);
+  const std::uint64_t before = ef->inputHash();
+  sk->addLine(gp_Pnt2d(5.0, 5.0), gp_Pnt2d(6.0, 5.0));
+  const std::uint64_t edited = ef->inputHash();
+  EXPECT_NE(edited, before);
+
+  // The memoized key follows distance edits, endpoint drags and a rebound copy of the profile
+  ef->setDistance(3.0);
+  EXPECT_NE(ef->inputHash(), edited);
+  ef->setDistance(2.0);
+  EXPECT_EQ(ef->inputHash(), edited);
+  sk->moveEndpoint({c1, 0}, gp_Pnt2d(-1.0, 0.0));
+  const std::uint64_t dragged = ef->inputHash();
+  EXPECT_NE(dragged, edited);
+  auto copy = std::make_shared<Sketch>();
+  copy->deserialize(sk->serialize());
+  ef->bindSketch(copy);
+  EXPECT_EQ(ef->inputHash(), dragged);
+
+  // Equal parameters give equal keys regardless of object identity
+  Handle(BoxFeature) a = new BoxFeature(1.0, 2.0, 3.0);
+  Handle(BoxFeature) b = new BoxFeature(1.0, 2.0, 3.0);
+  EXPECT_EQ(a->inputHash(), b->inputHash());
+  b->setDz(3.5);
+  EXPECT_NE(a->inputHash(), b->inputHash());
+}
+
+TEST(FeatureResultCache, EvictsLeastRecentlyUsedOverBudget)
+{
+  const TopoDS_Shape box = BRepPrimAPI_MakeBox(1.0, 1.0, 1.0).Shape();
+  const std::size_t perEntry = FeatureResultCache::estimateBytes(box);
+  FeatureResultCache cache(2 * perEntry);
+
+  cache.insert(1, box);
+  cache.insert(2, box);
+  TopoDS_Shape out;
+  ASSERT_TRUE(cache.find(1, out)); // 1 becomes most recently used
+  cache.insert(3, box);            // over budget: 2 is evicted
+
+  EXPECT_TRUE(cache.find(1, out));
+  EXPECT_FALSE(cache.find(2, out));
+  EXPECT_TRUE(cache.find(3, out));
+
+  const FeatureResultCache::Stats st = cache.stats();
+  EXPECT_EQ(st.entries, 2u);
+  EXPECT_EQ(st.evictions, 1u);
+  EXPECT_EQ(st.hits, 3u);
+  EXPECT_EQ(st.misses, 1u);
+  EXPECT_LE(st.bytes, cache.budget());
+
+  cache.setBudget(0);
+  EXPECT_EQ(cache.stats().entries, 0u);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <FeatureResultCache.h>
+#include <MemoryReport.h>
+#include <UndoStack.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <MoveFeature.h>
+
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
+
+TEST(MemoryReport, SingleFeatureOwnsItsShape)
+{
+  Document doc;
+  Handle(BoxFeature) box = new BoxFeature(1.0, 2.0, 3.0);
+  doc.addFeature(box);
+  doc.recompute();
+
+  const MemoryReport report = MemoryReport::build(doc);
+  ASSERT_EQ(report.entries.size(), 1u);
+  const MemoryReport::Entry& e = report.entries[0];
+  EXPECT_EQ(e.id, box->id());
+  EXPECT_EQ(e.type, "BoxFeature");
+  EXPECT_GT(e.reachable.topology, 0u);
+  EXPECT_GT(e.reachable.geometry, 0u);
+  EXPECT_EQ(e.reachable.mesh, 0u);
+  EXPECT_EQ(e.exclusive, e.reachable.total());
+  EXPECT_EQ(e.attributed, e.reachable.total());
+  EXPECT_EQ(e.shared(), 0u);
+  EXPECT_EQ(report.features.total(), e.reachable.total());
+  EXPECT_EQ(report.features.total(), MemoryReport::estimate(box->shape()).total());
+  // 1 solid + 1 shell + 6 faces + 6 wires + 12 edges + 8 vertices, plus the planes and lines
+  EXPECT_GE(e.objects, 34u + 6u + 12u);
+}
+
+TEST(MemoryReport, MeshIsCountedSeparately)
+{
+  const TopoDS_Shape box = BRepPrimAPI_MakeBox(1.0, 1.0, 1.0).Shape();
+  const MemoryReport::Bytes before = MemoryReport::estimate(box);
+  BRepMesh_IncrementalMesh mesher(box, 0.1);
+  const MemoryReport::Bytes after = MemoryReport::estimate(box);
+  EXPECT_EQ(before.mesh, 0u);
+  EXPECT_GT(after.mesh, 0u);
+  EXPECT_EQ(after.topology, before.topology);
+}
+
+TEST(MemoryReport, SharedSubShapesAreCountedOnce)
+{
+  Document doc;
+  Handle(BoxFeature) base = new BoxFeature(4.0, 5.0, 6.0);
+  doc.addFeature(base);
+  Handle(MoveFeature) mv = new MoveFeature(base->id(), 10.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  doc.addFeature(mv);
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 2.0);
+  doc.addFeature(cyl);
+  base->setSuppressed(true);
+  doc.recompute();
+
+  const MemoryReport report = MemoryReport::build(doc);
+  const MemoryReport::Entry* b = report.find(base->id());
+  const MemoryReport::Entry* m = report.find(mv->id());
+  const MemoryReport::Entry* c = report.find(cyl->id());
+  ASSERT_TRUE(b && m && c);
+  EXPECT_TRUE(b->suppressed);
+  // The rigid move only relocates the source's TShapes
+  EXPECT_EQ(m->reachable.total(), b->reachable.total());
+  EXPECT_EQ(m->exclusive, 0u);
+  EXPECT_EQ(b->exclusive, 0u);
+  EXPECT_EQ(m->shared(), m->reachable.total());
+  EXPECT_NEAR(static_cast<double>(b->attributed), b->reachable.total() / 2.0, 1.0);
+  EXPECT_EQ(c->exclusive, c->reachable.total());
+
+  // Document total: the box B-Rep once, plus the cylinder
+  EXPECT_EQ(report.features.total(), b->reachable.total() + c->reachable.total());
+  EXPECT_NEAR(static_cast<double>(b->attributed + m->attributed + c->attributed),
+              static_cast<double>(report.features.total()), 2.0);
+
+  const auto top = report.top(2);
+  ASSERT_EQ(top.size(), 2u);
+  EXPECT_GE(top[0]->attributed, top[1]->attributed);
+  EXPECT_EQ(report.top(10).size(), 3u);
+}
+
+TEST(MemoryReport, CacheAndUndoOnlyObjects)
+{
+  Document doc;
+  doc.setResultCache(std::make_shared<FeatureResultCache>());
+  UndoStack undo;
+  Handle(BoxFeature) a = new BoxFeature(1.0, 1.0, 1.0);
+  Handle(BoxFeature) b = new BoxFeature(2.0, 2.0, 2.0);
+  doc.addFeature(a);
+  doc.addFeature(b);
+  doc.recompute();
+  undo.reset(doc);
+
+  MemoryReport report = MemoryReport::build(doc, &undo);
+  EXPECT_EQ(report.cache.total(), 0u); // cached results are the live ones
+  EXPECT_EQ(report.undo.total(), 0u);
+
+  // The removed box stays alive in the cache and in the initial undo snapshot
+  const std::size_t removedBytes = MemoryReport::estimate(a->shape()).total();
+  doc.removeFeature(a);
+  undo.commit(doc, "Remove");
+  report = MemoryReport::build(doc, &undo);
+  EXPECT_EQ(report.entries.size(), 1u);
+  EXPECT_EQ(report.cache.total(), removedBytes);
+  EXPECT_EQ(report.undo.total(), 0u); // already counted as cache
+  EXPECT_EQ(report.total(), report.features.total() + removedBytes);
+
+  doc.resultCache()->clear();
+  report = MemoryReport::build(doc, &undo);
+  EXPECT_EQ(report.cache.total(), 0u);
+  EXPECT_EQ(report.undo.total(), removedBytes);
+}
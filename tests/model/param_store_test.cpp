@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <MoveFeature.h>
+
+TEST(ParamStore, SchemaDefaultsAndRoundTrip)
+{
+  Handle(MoveFeature) mf = new MoveFeature();
+  EXPECT_EQ(mf->params().size(), 6u);
+  for (const Feature::ParamSpec& spec : mf->paramSchema())
+  {
+    EXPECT_TRUE(mf->params().has(spec.key));
+  }
+  EXPECT_FALSE(mf->params().has(Feature::ParamKey::Dx));
+
+  Handle(BoxFeature) a = new BoxFeature(1.5, 2.0, 3.25);
+  a->params().set(Feature::ParamKey::Tx, TCollection_AsciiString("label")); // string param (side storage)
+  Handle(BoxFeature) b = new BoxFeature();
+  b->deserialize(a->serialize());
+  EXPECT_DOUBLE_EQ(b->dx(), 1.5);
+  EXPECT_DOUBLE_EQ(b->dz(), 3.25);
+  EXPECT_TRUE(b->params().isString(Feature::ParamKey::Tx));
+  EXPECT_EQ(a->inputHash(), b->inputHash());
+
+  // Int params read through the numeric accessor path
+  b->params().set(Feature::ParamKey::Radius, 7);
+  EXPECT_TRUE(b->params().isInt(Feature::ParamKey::Radius));
+  EXPECT_DOUBLE_EQ(b->params().asDouble(Feature::ParamKey::Radius, 0.0), 7.0);
+}
+
+TEST(ParamStore, AccessorsReadInlineStorage)
+{
+  Handle(CylinderFeature) cyl = new CylinderFeature(2.0, 5.0);
+  EXPECT_DOUBLE_EQ(cyl->radius(), 2.0);
+  EXPECT_DOUBLE_EQ(cyl->height(), 5.0);
+
+  Feature::ParamMap pm;
+  pm.set(Feature::ParamKey::Dx, 1.0);
+  pm.set(Feature::ParamKey::Radius, 3);
+  EXPECT_DOUBLE_EQ(pm.asDouble(Feature::ParamKey::Dx, 0.0), 1.0);
+  EXPECT_DOUBLE_EQ(pm.asDouble(Feature::ParamKey::Radius, 0.0), 3.0);
+  // Unset keys fall back to the default
+  EXPECT_DOUBLE_EQ(pm.asDouble(Feature::ParamKey::Dy, -1.0), -1.0);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <FeatureResultCache.h>
+#include <RecomputeProfile.h>
+#include <KernelAPI.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+TEST(RecomputeProfile, DisabledByDefault)
+{
+  Document doc;
+  doc.addFeature(new BoxFeature(1.0, 1.0, 1.0));
+  doc.recompute();
+  EXPECT_FALSE(doc.profiling());
+  EXPECT_FALSE(doc.lastProfile());
+}
+
+TEST(RecomputeProfile, OutcomesTimesAndTopology)
+{
+  Document doc;
+  doc.setProfiling(true);
+  doc.setResultCache(std::make_shared<FeatureResultCache>());
+  Handle(BoxFeature) box = new BoxFeature(1.0, 2.0, 3.0);
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 4.0);
+  doc.addFeature(box);
+  doc.addFeature(cyl);
+  doc.recompute();
+
+  auto profile = doc.lastProfile();
+  ASSERT_TRUE(profile);
+  ASSERT_EQ(profile->entries.size(), 2u);
+  const RecomputeProfile::Entry* e = profile->find(box->id());
+  ASSERT_NE(e, nullptr);
+  EXPECT_EQ(e->outcome, RecomputeProfile::Outcome::Executed);
+  EXPECT_EQ(e->type, "BoxFeature");
+  EXPECT_GE(e->kernelCalls, 1u);
+  EXPECT_GE(e->wallMs, 0.0);
+  EXPECT_GE(e->wallMs + 1e-3, e->kernelMs);
+  EXPECT_EQ(e->faces, 6);
+  EXPECT_EQ(e->edges, 12);
+  EXPECT_EQ(e->vertices, 8);
+  EXPECT_GE(profile->totalWallMs, 0.0);
+
+  // Only the edited box runs again; the cylinder is reused as-is
+  box->setSize(2.0, 2.0, 2.0);
+  doc.recompute();
+  profile = doc.lastProfile();
+  EXPECT_EQ(profile->find(box->id())->outcome, RecomputeProfile::Outcome::Executed);
+  EXPECT_EQ(profile->find(cyl->id())->outcome, RecomputeProfile::Outcome::UpToDate);
+  EXPECT_EQ(profile->find(cyl->id())->kernelCalls, 0u);
+
+  // Reverting the edit hits the result cache: no kernel call
+  box->setSize(1.0, 2.0, 3.0);
+  doc.recompute();
+  e = doc.lastProfile()->find(box->id());
+  EXPECT_EQ(e->outcome, RecomputeProfile::Outcome::CacheHit);
+  EXPECT_TRUE(e->cacheHit());
+  EXPECT_EQ(e->kernelCalls, 0u);
+  EXPECT_EQ(e->faces, 6);
+}
+
+TEST(RecomputeProfile, KernelThreadStatsCountOutermostCalls)
+{
+  const KernelAPI::ThreadStats before = KernelAPI::threadStats();
+  const TopoDS_Shape a = KernelAPI::makeBox(1.0, 1.0, 1.0);
+  const TopoDS_Shape b = KernelAPI::makeCylinder(0.5, 2.0);
+  KernelAPI::fuse(a, b);
+  const KernelAPI::ThreadStats after = KernelAPI::threadStats();
+  EXPECT_EQ(after.calls - before.calls, 3u);
+  EXPECT_GE(after.seconds, before.seconds);
+}
+
+TEST(RecomputeProfile, SlowestAndJsonReport)
+{
+  RecomputeProfile p;
+  p.totalWallMs = 12.5;
+  p.threads     = 2;
+  RecomputeProfile::Entry a;
+  a.id = 1; a.type = "BoxFeature"; a.name = "Box \"A\""; a.outcome = RecomputeProfile::Outcome::Executed;
+  a.wallMs = 2.0; a.kernelCalls = 1; a.faces = 6; a.edges = 12; a.vertices = 8;
+  RecomputeProfile::Entry b = a;
+  b.id = 2; b.name = "B"; b.wallMs = 9.25;
+  RecomputeProfile::Entry c = a;
+  c.id = 3; c.name = "C"; c.outcome = RecomputeProfile::Outcome::UpToDate; c.wallMs = 0.0;
+  p.entries = {a, b, c};
+
+  const auto top = p.slowest(2);
+  ASSERT_EQ(top.size(), 2u);
+  EXPECT_EQ(top[0]->id, 2u);
+  EXPECT_EQ(top[1]->id, 1u);
+  EXPECT_EQ(p.slowest(10).size(), 3u);
+
+  const std::string json = p.toJson();
+  EXPECT_NE(json.find("\"totalWallMs\":12.5"), std::string::npos);
+  EXPECT_NE(json.find("\"threads\":2"), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"Box \\\"A\\\"\""), std::string::npos);
+  EXPECT_NE(json.find("\"outcome\":\"executed\""), std::string::npos);
+  EXPECT_NE(json.find("\"outcome\":\"upToDate\""), std::string::npos);
+  EXPECT_NE(json.find("\"wallMs\":9.25"), std::string::npos);
+  EXPECT_NE(json.find("\"faces\":6"), std::string::npos);
+
+  const std::string path = ::testing::TempDir() + "recompute_profile_test.json";
+  ASSERT_TRUE(p.writeJson(path));
+  std::ifstream is(path, std::ios::binary);
+  std::stringstream ss;
+  ss << is.rdbuf();
+  EXPECT_EQ(ss.str(), json);
+  is.close();
+  std::remove(path.c_str());
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <MemoryReport.h>
+#include <UndoStack.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <MoveFeature.h>
+
+#include <common/test_utils.h>
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Suppressed box read by a copying move: the box B-Rep is held by the box alone
+struct CopyMoveDoc
+{
+  Document             doc;
+  Handle(BoxFeature)   base = new BoxFeature(2.0, 3.0, 4.0);
+  Handle(MoveFeature)  move;
+
+  CopyMoveDoc()
+  {
+    doc.addFeature(base);
+    move = new MoveFeature(base->id(), 10.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+    move->setShareGeometry(false);
+    doc.addFeature(move);
+    base->setSuppressed(true);
+  }
+};
+} // namespace
+
+TEST(ResultEviction, DisabledByDefault)
+{
+  CopyMoveDoc d;
+  d.doc.recompute();
+  EXPECT_EQ(d.doc.resultBudget(), 0u);
+  EXPECT_FALSE(d.base->isEvicted());
+  EXPECT_EQ(d.doc.evictionStats().evicted, 0u);
+}
+
+TEST(ResultEviction, CompactedSourceIsRebuiltOnAccess)
+{
+  CopyMoveDoc d;
+  d.doc.setResultBudget(1, Document::EvictionMode::Compact);
+  d.doc.recompute();
+
+  // Only the suppressed source goes; the displayed move stays resident
+  EXPECT_TRUE(d.base->isEvicted());
+  EXPECT_TRUE(d.base->heldShape().IsNull());
+  EXPECT_GT(d.base->compactedBytes(), 0u);
+  EXPECT_FALSE(d.move->isEvicted());
+  EXPECT_FALSE(d.move->shape().IsNull());
+  Document::EvictionStats st = d.doc.evictionStats();
+  EXPECT_EQ(st.evicted, 1u);
+  EXPECT_EQ(st.compacted, 1u);
+  EXPECT_GT(st.releasedBytes, 0u);
+  EXPECT_EQ(st.compactBytes, d.base->compactedBytes());
+  EXPECT_EQ(st.rematerialized, 0u);
+
+  const MemoryReport report = MemoryReport::build(d.doc);
+  EXPECT_TRUE(report.find(d.base->id())->evicted);
+  EXPECT_EQ(report.find(d.base->id())->reachable.total(), 0u);
+  EXPECT_EQ(report.compacted, d.base->compactedBytes());
+
+  // A consumer (or the viewer) asking for the shape gets it back
+  ASSERT_FALSE(d.base->shape().IsNull());
+  EXPECT_FALSE(d.base->isEvicted());
+  EXPECT_NEAR(volume(d.base->shape()), 24.0, 1.0e-6);
+  st = d.doc.evictionStats();
+  EXPECT_EQ(st.rematerialized, 1u);
+  EXPECT_EQ(st.compactBytes, 0u);
+}
+
+TEST(ResultEviction, DroppedSourceIsReexecuted)
+{
+  CopyMoveDoc d;
+  d.doc.setResultBudget(1, Document::EvictionMode::Drop);
+  d.doc.recompute();
+  EXPECT_TRUE(d.base->isEvicted());
+  EXPECT_EQ(d.base->compactedBytes(), 0u);
+  EXPECT_EQ(d.doc.evictionStats().compacted, 0u);
+
+  const std::size_t executed = d.doc.totalExecuted();
+  ASSERT_FALSE(d.base->shape().IsNull());
+  EXPECT_NEAR(volume(d.base->shape()), 24.0, 1.0e-6);
+  EXPECT_EQ(d.doc.evictionStats().rematerialized, 1u);
+  EXPECT_EQ(d.doc.totalExecuted(), executed); // outside recompute: not a recompute execution
+}
+
+TEST(ResultEviction, ConcurrentReadersRebuildOnce)
+{
+  CopyMoveDoc d;
+  d.doc.setResultBudget(1, Document::EvictionMode::Drop);
+  d.doc.recompute();
+  ASSERT_TRUE(d.base->isEvicted());
+
+  std::vector<TopoDS_Shape> seen(8);
+  std::vector<std::thread>  readers;
+  for (std::size_t t = 0; t < seen.size(); ++t)
+  {
+    readers.emplace_back([&, t]() { seen[t] = d.base->shape(); });
+  }
+  for (std::thread& r : readers) r.join();
+  EXPECT_EQ(d.base->rematerializeCount(), 1u);
+  for (const TopoDS_Shape& s : seen) EXPECT_TRUE(s.IsSame(seen[0]));
+  EXPECT_FALSE(d.base->isEvicted());
+}
+
+TEST(ResultEviction, EditAfterEvictionNeverRestoresStaleResult)
+{
+  CopyMoveDoc d;
+  d.doc.setResultBudget(1, Document::EvictionMode::Compact);
+  d.doc.recompute();
+  ASSERT_TRUE(d.base->isEvicted());
+
+  d.base->setSize(1.0, 1.0, 1.0);
+  d.doc.recompute();
+  EXPECT_NEAR(volume(d.move->shape()), 1.0, 1.0e-6);
+  EXPECT_TRUE(d.base->isEvicted()); // evicted again after producing the new result
+  EXPECT_NEAR(volume(d.base->shape()), 1.0, 1.0e-6);
+}
+
+TEST(ResultEviction, StaleEvictedResultIsExecutedOnAccess)
+{
+  CopyMoveDoc d;
+  d.doc.setResultBudget(1, Document::EvictionMode::Compact);
+  d.doc.recompute();
+  ASSERT_TRUE(d.base->isEvicted());
+
+  // Edited but not recomputed: the blob is outdated, the current parameters are used instead
+  d.base->setSize(1.0, 2.0, 3.0);
+  ASSERT_FALSE(d.base->shape().IsNull());
+  EXPECT_NEAR(volume(d.base->shape()), 6.0, 1.0e-6);
+  EXPECT_TRUE(d.base->isDirty()); // still replayed (with its consumer) by the next recompute
+}
+
+TEST(ResultEviction, SharedAndDisplayedResultsStayResident)
+{
+  Document doc;
+  Handle(BoxFeature) base = new BoxFeature(2.0, 2.0, 2.0);
+  doc.addFeature(base);
+  Handle(MoveFeature) move = new MoveFeature(base->id(), 5.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  doc.addFeature(move); // shares the box B-Rep: evicting the box would free nothing
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 3.0);
+  doc.addFeature(cyl);
+  base->setSuppressed(true);
+  doc.setResultBudget(1);
+  doc.recompute();
+
+  EXPECT_FALSE(base->isEvicted());
+  EXPECT_FALSE(move->isEvicted());
+  EXPECT_FALSE(cyl->isEvicted());
+  const Document::EvictionStats st = doc.evictionStats();
+  EXPECT_EQ(st.evicted, 0u);
+  EXPECT_GT(st.residentBytes, doc.resultBudget());
+}
+
+TEST(ResultEviction, GenerousBudgetKeepsEverything)
+{
+  CopyMoveDoc d;
+  d.doc.setResultBudget(std::size_t(1) << 30);
+  d.doc.recompute();
+  EXPECT_FALSE(d.base->isEvicted());
+  EXPECT_EQ(d.doc.enforceResultBudget(), 0u);
+  EXPECT_GT(d.doc.evictionStats().residentBytes, 0u);
+
+  // Unchanged results keep their estimate; only the re-executed move is walked again
+  const std::size_t estimated = d.doc.evictionStats().estimated;
+  const std::size_t resident  = d.doc.evictionStats().residentBytes;
+  d.doc.enforceResultBudget();
+  EXPECT_EQ(d.doc.evictionStats().estimated, estimated);
+  EXPECT_EQ(d.doc.evictionStats().residentBytes, resident);
+  d.move->setTranslation(0.0, 5.0, 0.0);
+  d.doc.recompute();
+  EXPECT_EQ(d.doc.evictionStats().estimated, estimated + 1);
+  EXPECT_EQ(d.doc.evictionStats().residentBytes, resident);
+}
+
+TEST(ResultEviction, UndoAcrossEvictionRecomputes)
+{
+  CopyMoveDoc d;
+  UndoStack undo;
+  d.doc.setResultBudget(1);
+  d.doc.recompute();
+  undo.reset(d.doc);
+  ASSERT_TRUE(d.base->isEvicted());
+
+  d.base->setSize(1.0, 1.0, 1.0);
+  d.doc.recompute();
+  undo.commit(d.doc, "Resize");
+  ASSERT_TRUE(undo.undo(d.doc));
+  d.doc.recompute();
+  // Items whose state changed are rebuilt by the undo: look them up again
+  Handle(Feature) base = Handle(Feature)::DownCast(d.doc.findItem(d.base->id()));
+  Handle(Feature) move = Handle(Feature)::DownCast(d.doc.findItem(d.move->id()));
+  ASSERT_FALSE(base.IsNull());
+  ASSERT_FALSE(move.IsNull());
+  EXPECT_NEAR(volume(move->shape()), 24.0, 1.0e-6);
+  EXPECT_NEAR(volume(base->shape()), 24.0, 1.0e-6);
+}
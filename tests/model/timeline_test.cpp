@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <Timeline.h>
+#include <Document.h>
+#include <BoxFeature.h>
+#include <Sketch.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+// Checks positional access, id index and feature view against a plain vector
+void expectMatches(const Timeline& tl, const std::vector<Handle(DocumentItem)>& ref)
+{
+  ASSERT_EQ(tl.Size(), static_cast<int>(ref.size()));
+  std::vector<Handle(Feature)> refFeatures;
+  int i = 0;
+  for (Timeline::Iterator it(tl); it.More(); it.Next(), ++i)
+  {
+    ASSERT_TRUE(it.Value() == ref[i]);
+    EXPECT_TRUE(tl.Value(i + 1) == ref[i]);
+    EXPECT_EQ(tl.IndexOf(ref[i]->id()), i + 1);
+    if (Handle(Feature) f = Handle(Feature)::DownCast(ref[i]); !f.IsNull()) refFeatures.push_back(f);
+  }
+  EXPECT_EQ(i, tl.Size());
+
+  const Timeline::FeatureView fv = tl.features();
+  ASSERT_EQ(fv.Size(), static_cast<int>(refFeatures.size()));
+  int k = 0;
+  for (Timeline::FeatureView::Iterator it(fv); it.More(); it.Next(), ++k)
+  {
+    EXPECT_TRUE(it.Value() == refFeatures[k]);
+    EXPECT_TRUE(fv.Value(k + 1) == refFeatures[k]);
+  }
+  EXPECT_EQ(k, fv.Size());
+}
+
+Handle(DocumentItem) makeItem(int i)
+{
+  // Every fourth item is a sketch, the rest are features
+  if (i % 4 == 3) return new Sketch();
+  return new BoxFeature(1.0 + i, 1.0, 1.0);
+}
+} // namespace
+
+TEST(Timeline, RandomEditsMatchReferenceSequence)
+{
+  Timeline tl;
+  std::vector<Handle(DocumentItem)> ref;
+  std::mt19937 rng(7);
+  for (int step = 0; step < 600; ++step)
+  {
+    const int op = static_cast<int>(rng() % 4);
+    if (op < 2 || ref.empty())
+    {
+      Handle(DocumentItem) item = makeItem(step);
+      const int pos = static_cast<int>(rng() % (ref.size() + 1)) + 1;
+      ASSERT_TRUE(tl.InsertBefore(pos, item));
+      ref.insert(ref.begin() + (pos - 1), item);
+    }
+    else if (op == 2)
+    {
+      const int pos = static_cast<int>(rng() % ref.size()) + 1;
+      tl.Remove(pos);
+      ref.erase(ref.begin() + (pos - 1));
+    }
+    else
+    {
+      const std::size_t pos = rng() % ref.size();
+      EXPECT_TRUE(tl.Remove(ref[pos]->id()));
+      EXPECT_TRUE(tl.Find(ref[pos]->id()).IsNull());
+      ref.erase(ref.begin() + pos);
+    }
+    if (step % 50 == 0) expectMatches(tl, ref);
+  }
+  expectMatches(tl, ref);
+
+  // Duplicate ids are rejected
+  if (!ref.empty())
+  {
+    EXPECT_FALSE(tl.Append(ref.front()));
+    EXPECT_EQ(tl.Size(), static_cast<int>(ref.size()));
+  }
+}
+
+TEST(Timeline, DocumentLookupsUseIndex)
+{
+  Document doc;
+  Handle(BoxFeature) a = new BoxFeature(1.0, 1.0, 1.0);
+  Handle(BoxFeature) b = new BoxFeature(2.0, 2.0, 2.0);
+  doc.addFeature(a);
+  doc.addFeature(b);
+  doc.insertItem(2, new Sketch());
+  EXPECT_EQ(doc.indexOf(b->id()), 3);
+  EXPECT_TRUE(doc.findItem(a->id()) == a);
+  EXPECT_EQ(doc.features().Size(), 2);
+  EXPECT_TRUE(doc.features().Last() == b);
+
+  doc.removeFeature(a);
+  EXPECT_EQ(doc.indexOf(a->id()), 0);
+  EXPECT_EQ(doc.indexOf(b->id()), 2);
+}
+
+TEST(Timeline, RandomEditsOnLargeTimelineKeepIndex)
+{
+  const int n = 100000;
+  Timeline tl;
+  std::vector<Handle(DocumentItem)> items;
+  items.reserve(n);
+  for (int i = 0; i < n; ++i)
+  {
+    items.push_back(makeItem(i));
+    tl.Append(items.back());
+  }
+
+  std::mt19937 rng(11);
+  for (int e = 0; e < 2000; ++e)
+  {
+    // Remove an item by id from the middle of the history and put it back elsewhere
+    const Handle(DocumentItem)& item = items[rng() % n];
+    tl.Remove(item->id());
+    tl.InsertBefore(static_cast<int>(rng() % tl.Size()) + 1, item);
+    (void)tl.features().Value(static_cast<int>(rng() % tl.features().Size()) + 1);
+  }
+
+  EXPECT_EQ(tl.Size(), n);
+  EXPECT_EQ(tl.features().Size(), n - n / 4);
+  for (const Handle(DocumentItem)& item : items)
+  {
+    ASSERT_EQ(tl.Value(tl.IndexOf(item->id())), item);
+  }
+}
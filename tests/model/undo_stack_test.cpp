@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <UndoStack.h>
+#include <Document.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <MoveFeature.h>
+#include <Sketch.h>
+
+TEST(UndoStack, StepCostIsProportionalToTheChange)
+{
+  Document doc;
+  const int n = 1000;
+  for (int i = 0; i < n; ++i) doc.addFeature(new BoxFeature(1.0 + i, 2.0, 3.0));
+  doc.recompute();
+
+  UndoStack undo;
+  undo.reset(doc);
+  EXPECT_EQ(undo.lastStats().newStates, static_cast<std::size_t>(n));
+  EXPECT_FALSE(undo.canUndo());
+
+  Handle(BoxFeature) box = Handle(BoxFeature)::DownCast(doc.items().Value(500));
+  box->setSize(7.0, 7.0, 7.0);
+  doc.recompute();
+  undo.commit(doc, "Resize");
+
+  // One new state; every chunk but the one holding the edited box is shared
+  const UndoStack::Stats& st = undo.lastStats();
+  EXPECT_EQ(st.items, static_cast<std::size_t>(n));
+  EXPECT_EQ(st.newStates, 1u);
+  EXPECT_EQ(st.chunks, (n + UndoStack::kChunkSize - 1) / UndoStack::kChunkSize);
+  EXPECT_EQ(st.sharedChunks, st.chunks - 1);
+  EXPECT_TRUE(undo.canUndo());
+  EXPECT_EQ(undo.undoLabel(), "Resize");
+
+  // A commit without changes shares everything
+  undo.commit(doc, "Nothing");
+  EXPECT_EQ(undo.lastStats().newStates, 0u);
+  EXPECT_EQ(undo.lastStats().sharedChunks, undo.lastStats().chunks);
+}
+
+TEST(UndoStack, UndoRedoRestoreCachedShapesWithoutRecompute)
+{
+  Document doc;
+  Handle(BoxFeature) box = new BoxFeature(1.0, 2.0, 3.0);
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 4.0);
+  doc.addFeature(box);
+  doc.addFeature(cyl);
+  auto sk = std::make_shared<Sketch>();
+  sk->addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(1.0, 0.0));
+  doc.addSketch(sk);
+  doc.recompute();
+  const TopoDS_Shape boxBefore = box->shape();
+
+  UndoStack undo;
+  undo.reset(doc);
+
+  box->setSize(5.0, 5.0, 5.0);
+  Handle(MoveFeature) mv = new MoveFeature();
+  mv->setSourceId(cyl->id());
+  mv->setTranslation(10.0, 0.0, 0.0);
+  cyl->setSuppressed(true);
+  doc.addFeature(mv);
+  doc.recompute();
+  undo.commit(doc, "Resize and move");
+  const TopoDS_Shape boxAfter  = box->shape();
+  const TopoDS_Shape moveAfter = mv->shape();
+  const std::size_t executedBefore = doc.totalExecuted();
+
+  ASSERT_TRUE(undo.undo(doc));
+  EXPECT_EQ(doc.items().Size(), 2);
+  EXPECT_EQ(doc.sketches().size(), 1u);
+  EXPECT_EQ(doc.sketches()[0], sk); // unchanged sketch object is reused
+  Handle(BoxFeature) box0 = Handle(BoxFeature)::DownCast(doc.items().Value(1));
+  Handle(CylinderFeature) cyl0 = Handle(CylinderFeature)::DownCast(doc.items().Value(2));
+  ASSERT_FALSE(box0.IsNull());
+  ASSERT_FALSE(cyl0.IsNull());
+  EXPECT_EQ(box0->id(), box->id());
+  EXPECT_DOUBLE_EQ(box0->dx(), 1.0);
+  EXPECT_FALSE(cyl0->isSuppressed());
+  EXPECT_TRUE(box0->shape().IsSame(boxBefore));
+  EXPECT_FALSE(box0->isDirty());
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 0u);
+
+  ASSERT_TRUE(undo.redo(doc));
+  ASSERT_EQ(doc.items().Size(), 3);
+  Handle(BoxFeature) box1 = Handle(BoxFeature)::DownCast(doc.items().Value(1));
+  Handle(MoveFeature) mv1 = Handle(MoveFeature)::DownCast(doc.items().Value(3));
+  ASSERT_FALSE(mv1.IsNull());
+  EXPECT_DOUBLE_EQ(box1->dx(), 5.0);
+  EXPECT_TRUE(box1->shape().IsSame(boxAfter));
+  EXPECT_TRUE(mv1->shape().IsEqual(moveAfter));
+  EXPECT_TRUE(Handle(Feature)::DownCast(doc.items().Value(2))->isSuppressed());
+  doc.recompute();
+  EXPECT_EQ(doc.lastRecomputeStats().executed, 0u);
+  EXPECT_EQ(doc.totalExecuted(), executedBefore);
+
+  // Editing after an undo drops the redo branch
+  ASSERT_TRUE(undo.undo(doc));
+  EXPECT_TRUE(undo.canRedo());
+  doc.addFeature(new BoxFeature(2.0, 2.0, 2.0));
+  doc.recompute();
+  undo.commit(doc, "Add Box");
+  EXPECT_FALSE(undo.canRedo());
+  EXPECT_EQ(undo.undoLabel(), "Add Box");
+  ASSERT_TRUE(undo.undo(doc));
+  EXPECT_EQ(doc.items().Size(), 2);
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <DocumentFile.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <ExtrudeFeature.h>
+#include <MoveFeature.h>
+#include <Sketch.h>
+
+#include <common/test_utils.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+std::string tempPath(const char* name)
+{
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Box, cylinder, a sketch-driven extrude and a move with an exact manipulator delta
+void buildDocument(Document& doc)
+{
+  doc.addFeature(new BoxFeature(1.0, 2.0, 3.0));
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.5, 4.0);
+  doc.addFeature(cyl);
+
+  auto sk = std::make_shared<Sketch>();
+  auto c1 = sk->addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(4.0, 0.0));
+  auto c2 = sk->addLine(gp_Pnt2d(4.0, 0.0), gp_Pnt2d(4.0, 2.0));
+  auto c3 = sk->addLine(gp_Pnt2d(4.0, 2.0), gp_Pnt2d(0.0, 2.0));
+  auto c4 = sk->addLine(gp_Pnt2d(0.0, 2.0), gp_Pnt2d(0.0, 0.0));
+  sk->addCoincident({c1, 1}, {c2, 0});
+  sk->addCoincident({c2, 1}, {c3, 0});
+  sk->addCoincident({c3, 1}, {c4, 0});
+  sk->addCoincident({c4, 1}, {c1, 0});
+  sk->solveConstraints();
+  doc.addSketch(sk);
+  doc.addFeature(new ExtrudeFeature(sk->id(), 3.0));
+
+  Handle(MoveFeature) mv = new MoveFeature();
+  mv->setSourceId(cyl->id());
+  gp_Trsf delta;
+  delta.SetRotation(gp_Ax1(gp_Pnt(0.0, 0.0, 0.0), gp_Dir(0.0, 0.0, 1.0)), 0.3);
+  mv->setDeltaTrsf(delta);
+  cyl->setSuppressed(true);
+  doc.addFeature(mv);
+  doc.recompute();
+}
+} // namespace
+
+TEST(DocumentFile, RoundTripWithEmbeddedShapes)
+{
+  Document doc;
+  buildDocument(doc);
+  const std::string path = tempPath("document_file_shapes.cdoc");
+  ASSERT_TRUE(DocumentFile::save(doc, path, true));
+
+  DocumentFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_TRUE(file.hasShapes());
+  EXPECT_EQ(file.size(), static_cast<std::size_t>(doc.items().Size()) + doc.sketches().size());
+
+  Document loaded;
+  ASSERT_TRUE(file.loadInto(loaded));
+  ASSERT_EQ(loaded.items().Size(), doc.items().Size());
+  ASSERT_EQ(loaded.sketches().size(), 1u);
+  for (int i = 1; i <= doc.items().Size(); ++i)
+  {
+    EXPECT_EQ(loaded.items().Value(i)->id(), doc.items().Value(i)->id());
+    EXPECT_EQ(loaded.items().Value(i)->kind(), doc.items().Value(i)->kind());
+  }
+
+  // Embedded results are adopted: nothing needs to run after load
+  loaded.recompute();
+  EXPECT_EQ(loaded.lastRecomputeStats().executed, 0u);
+  for (int i = 1; i <= doc.features().Size(); ++i)
+  {
+    EXPECT_NEAR(volume(loaded.features().Value(i)->shape()), volume(doc.features().Value(i)->shape()), 1.0e-6);
+  }
+
+  // The manipulator delta survives: the move result matches the original placement
+  Handle(MoveFeature) mv = Handle(MoveFeature)::DownCast(loaded.features().Last());
+  ASSERT_FALSE(mv.IsNull());
+  const auto a = bboxExtents(mv->shape());
+  const auto b = bboxExtents(doc.features().Last()->shape());
+  EXPECT_NEAR(a[0], b[0], 1.0e-7);
+  EXPECT_NEAR(a[1], b[1], 1.0e-7);
+  std::filesystem::remove(path);
+}
+
+TEST(DocumentFile, RoundTripWithoutShapesRecomputes)
+{
+  Document doc;
+  buildDocument(doc);
+  const std::string path = tempPath("document_file_plain.cdoc");
+  ASSERT_TRUE(DocumentFile::save(doc, path));
+
+  DocumentFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_FALSE(file.hasShapes());
+  Document loaded;
+  ASSERT_TRUE(file.loadInto(loaded));
+  loaded.recompute();
+  EXPECT_EQ(loaded.lastRecomputeStats().executed, static_cast<std::size_t>(doc.features().Size()));
+  for (int i = 1; i <= doc.features().Size(); ++i)
+  {
+    EXPECT_NEAR(volume(loaded.features().Value(i)->shape()), volume(doc.features().Value(i)->shape()), 1.0e-6);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST(DocumentFile, RejectsForeignAndTruncatedFiles)
+{
+  const std::string path = tempPath("document_file_bad.cdoc");
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "not a document";
+  }
+  DocumentFile file;
+  EXPECT_FALSE(file.open(path));
+  EXPECT_FALSE(file.open(tempPath("document_file_missing.cdoc")));
+
+  // Header claims more entries than the file holds
+  Document doc;
+  doc.addFeature(new BoxFeature(1.0, 1.0, 1.0));
+  ASSERT_TRUE(DocumentFile::save(doc, path));
+  std::filesystem::resize_file(path, DocumentFile::kHeaderSize + 10);
+  EXPECT_FALSE(file.open(path));
+  std::filesystem::remove(path);
+}
+
+TEST(DocumentFile, FailedLoadLeavesDocumentUntouched)
+{
+  const std::string path = tempPath("document_file_dup.cdoc");
+  {
+    Document doc;
+    doc.addFeature(new BoxFeature(1.0, 1.0, 1.0));
+    doc.addFeature(new BoxFeature(2.0, 2.0, 2.0));
+    ASSERT_TRUE(DocumentFile::save(doc, path));
+  }
+  // Give the second entry the id of the first
+  {
+    std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+    char id[8];
+    io.seekg(DocumentFile::kHeaderSize);
+    io.read(id, sizeof(id));
+    io.seekp(DocumentFile::kHeaderSize + DocumentFile::kEntrySize);
+    io.write(id, sizeof(id));
+  }
+
+  Document target;
+  Handle(CylinderFeature) cyl = new CylinderFeature(1.0, 2.0);
+  target.addFeature(cyl);
+  auto sk = std::make_shared<Sketch>();
+  target.addSketch(sk);
+  DocumentFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_FALSE(file.loadInto(target));
+  ASSERT_EQ(target.items().Size(), 1);
+  EXPECT_EQ(target.items().Value(1).get(), cyl.get());
+  EXPECT_EQ(target.findSketch(sk->id()), sk);
+  file.close();
+  std::filesystem::remove(path);
+}
+
+TEST(DocumentFile, OpenTouchesOnlyIndex_50k)
+{
+  const int n = 50000;
+  Document doc;
+  for (int i = 0; i < n; ++i) doc.addFeature(new BoxFeature(1.0 + i, 2.0, 3.0));
+  const DocumentItem::Id probeId = doc.items().Value(n / 2 + 1)->id();
+  const std::string path = tempPath("document_file_50k.cdoc");
+  ASSERT_TRUE(DocumentFile::save(doc, path));
+
+  DocumentFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(file.size(), static_cast<std::size_t>(n));
+  EXPECT_EQ(file.loadedItems(), 0u);
+
+  // Random access by id: only the requested item is materialized
+  const int index = file.indexOf(probeId);
+  ASSERT_EQ(index, n / 2);
+  Handle(BoxFeature) box = Handle(BoxFeature)::DownCast(file.loadItem(static_cast<std::size_t>(index)));
+  ASSERT_FALSE(box.IsNull());
+  EXPECT_EQ(box->id(), probeId);
+  EXPECT_DOUBLE_EQ(box->dx(), 1.0 + n / 2);
+  EXPECT_EQ(file.loadedItems(), 1u);
+
+  Document full;
+  ASSERT_TRUE(file.loadInto(full));
+  EXPECT_EQ(full.items().Size(), n);
+  file.close();
+  std::filesystem::remove(path);
+}
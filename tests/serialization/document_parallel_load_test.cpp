@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <Document.h>
+#include <DocumentFile.h>
+#include <IdAllocator.h>
+#include <BoxFeature.h>
+#include <CylinderFeature.h>
+#include <ExtrudeFeature.h>
+#include <MoveFeature.h>
+#include <Sketch.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::string tempPath(const char* name)
+{
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// n boxes/cylinders, a registered sketch with an extrude and a move; returns the largest id
+DocumentItem::Id buildDocument(Document& doc, int n)
+{
+  auto sk = std::make_shared<Sketch>();
+  sk->addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(4.0, 0.0));
+  sk->addLine(gp_Pnt2d(4.0, 0.0), gp_Pnt2d(4.0, 2.0));
+  doc.addSketch(sk);
+  for (int i = 0; i < n; ++i)
+  {
+    if (i % 2 == 0)
+      doc.addFeature(new BoxFeature(1.0 + i, 2.0, 3.0));
+    else
+      doc.addFeature(new CylinderFeature(0.5 + i, 4.0));
+  }
+  doc.addFeature(new ExtrudeFeature(sk->id(), 3.0));
+  Handle(MoveFeature) mv = new MoveFeature();
+  mv->setSourceId(doc.items().Value(1)->id());
+  mv->setTranslation(1.0, 2.0, 3.0);
+  doc.addFeature(mv);
+
+  DocumentItem::Id maxId = sk->id();
+  for (Timeline::Iterator it(doc.items()); it.More(); it.Next()) maxId = std::max(maxId, it.Value()->id());
+  return maxId;
+}
+
+void expectSameContents(const Document& a, const Document& b)
+{
+  ASSERT_EQ(a.items().Size(), b.items().Size());
+  ASSERT_EQ(a.sketches().size(), b.sketches().size());
+  for (int i = 1; i <= a.items().Size(); ++i)
+  {
+    ASSERT_EQ(a.items().Value(i)->id(), b.items().Value(i)->id());
+    ASSERT_EQ(a.items().Value(i)->kind(), b.items().Value(i)->kind());
+    ASSERT_EQ(a.items().Value(i)->serialize(), b.items().Value(i)->serialize());
+  }
+}
+} // namespace
+
+TEST(DocumentParallelLoad, FactoryTableIsFrozenAfterFirstCreate)
+{
+  ASSERT_TRUE(DocumentItem::create(DocumentItem::Kind::BoxFeature) != nullptr);
+  EXPECT_TRUE(DocumentItem::factoriesFrozen());
+  EXPECT_FALSE(DocumentItem::registerFactory(DocumentItem::Kind::BoxFeature,
+                                             []() -> DocumentItem* { return nullptr; }));
+  EXPECT_TRUE(DocumentItem::create(DocumentItem::Kind::BoxFeature) != nullptr);
+}
+
+TEST(DocumentParallelLoad, IdAllocatorReserveIsAtomicMax)
+{
+  IdAllocator ids;
+  std::vector<std::thread> pool;
+  std::vector<std::vector<IdAllocator::Id>> drawn(8);
+  for (int t = 0; t < 8; ++t)
+  {
+    pool.emplace_back([&ids, &drawn, t]() {
+      for (int i = 0; i < 1000; ++i)
+      {
+        ids.reserve(static_cast<IdAllocator::Id>(t * 1000 + i));
+        drawn[t].push_back(ids.allocate());
+      }
+    });
+  }
+  for (std::thread& th : pool) th.join();
+
+  std::vector<IdAllocator::Id> all;
+  for (const auto& d : drawn) all.insert(all.end(), d.begin(), d.end());
+  std::sort(all.begin(), all.end());
+  EXPECT_TRUE(std::adjacent_find(all.begin(), all.end()) == all.end()); // allocations never collide
+  EXPECT_GT(ids.peekNext(), 7999u);
+  EXPECT_GT(ids.peekNext(), all.back());
+
+  // Scopes nest and restore the previous allocator
+  IdAllocator other(500);
+  {
+    IdAllocator::Scope outer(ids);
+    EXPECT_EQ(&IdAllocator::current(), &ids);
+    {
+      IdAllocator::Scope inner(other);
+      Handle(BoxFeature) box = new BoxFeature();
+      EXPECT_EQ(box->id(), 500u);
+    }
+    EXPECT_EQ(&IdAllocator::current(), &ids);
+  }
+  EXPECT_EQ(&IdAllocator::current(), &IdAllocator::global());
+}
+
+TEST(DocumentParallelLoad, ParallelLoadMatchesSerialAndKeepsGlobalIds)
+{
+  Document doc;
+  const DocumentItem::Id maxId = buildDocument(doc, 4000);
+  const std::string path = tempPath("document_parallel_load.cdoc");
+  ASSERT_TRUE(DocumentFile::save(doc, path));
+
+  DocumentFile file;
+  ASSERT_TRUE(file.open(path));
+  const IdAllocator::Id globalBefore = IdAllocator::global().peekNext();
+
+  Document serial;
+  ASSERT_TRUE(file.loadInto(serial, 1));
+  Document parallel;
+  ASSERT_TRUE(file.loadInto(parallel, 4));
+
+  // Loading never touches the process-wide counter, and each document's space starts after its ids
+  EXPECT_EQ(IdAllocator::global().peekNext(), globalBefore);
+  EXPECT_EQ(serial.ids().peekNext(), maxId + 1);
+  EXPECT_EQ(parallel.ids().peekNext(), maxId + 1);
+  expectSameContents(doc, serial);
+  expectSameContents(serial, parallel);
+  file.close();
+  std::filesystem::remove(path);
+}
+
+TEST(DocumentParallelLoad, ConcurrentDocumentsHaveIndependentIdSpaces)
+{
+  Document a, b;
+  const DocumentItem::Id maxA = buildDocument(a, 600);
+  const DocumentItem::Id maxB = buildDocument(b, 900);
+  const std::string pathA = tempPath("document_parallel_a.cdoc");
+  const std::string pathB = tempPath("document_parallel_b.cdoc");
+  ASSERT_TRUE(DocumentFile::save(a, pathA));
+  ASSERT_TRUE(DocumentFile::save(b, pathB));
+
+  // Two "tabs" load at once, each with its own worker pool, then add one feature each
+  auto loadAndEdit = [](const std::string& path, Document& doc, DocumentItem::Id& newId) {
+    DocumentFile file;
+    if (!file.open(path) || !file.loadInto(doc, 3)) return;
+    IdAllocator::Scope ids(doc.ids());
+    Handle(BoxFeature) box = new BoxFeature(1.0, 1.0, 1.0);
+    doc.addFeature(box);
+    newId = box->id();
+  };
+  for (int round = 0; round < 3; ++round)
+  {
+    Document la, lb;
+    DocumentItem::Id newA = 0, newB = 0;
+    std::thread ta(loadAndEdit, std::cref(pathA), std::ref(la), std::ref(newA));
+    std::thread tb(loadAndEdit, std::cref(pathB), std::ref(lb), std::ref(newB));
+    ta.join();
+    tb.join();
+    ASSERT_EQ(la.items().Size(), a.items().Size() + 1);
+    ASSERT_EQ(lb.items().Size(), b.items().Size() + 1);
+    EXPECT_EQ(newA, maxA + 1);
+    EXPECT_EQ(newB, maxB + 1);
+  }
+  std::filesystem::remove(pathA);
+  std::filesystem::remove(pathB);
+}
@@ -3,6 +3,7 @@
 #include <Sketch.h>
 #include <BoxFeature.h>
 #include <ExtrudeFeature.h>
+#include <MoveFeature.h>
 
 TEST(Serialization, SketchRoundtrip)
 {
@@ -62,3 +63,20 @@ TEST(Serialization, ExtrudeSkIdRoundtrip)
   EXPECT_EQ(f->sketchId(), 1234u);
 }
 
+TEST(Serialization, MoveDeserializeIntoLiveObjectResetsOptionalFields)
+{
+  // An older state without delta or share mode, restored over a move that has both
+  Handle(MoveFeature) plain = new MoveFeature(7, 1.0, 2.0, 3.0, 0.0, 0.0, 0.0);
+  const std::string blob = plain->serialize();
+
+  Handle(MoveFeature) m = new MoveFeature();
+  gp_Trsf delta;
+  delta.SetTranslation(gp_Vec(5.0, 0.0, 0.0));
+  m->setDeltaTrsf(delta);
+  m->setShareGeometry(false);
+  m->deserialize(blob);
+  EXPECT_EQ(m->sourceId(), 7u);
+  EXPECT_EQ(m->deltaTrsf().Form(), gp_Identity);
+  EXPECT_TRUE(m->shareGeometry());
+  EXPECT_EQ(m->inputHash(), plain->inputHash());
+}
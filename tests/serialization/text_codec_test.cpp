@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <TextCodec.h>
+#include <Sketch.h>
+#include <BoxFeature.h>
+#include <MoveFeature.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+TEST(TextCodec, DoublesRoundTripInShortestForm)
+{
+  char buf[32];
+  auto fmt = [&buf](double v) { return std::string(buf, TextCodec::format(v, buf, sizeof(buf))); };
+  EXPECT_EQ(fmt(0.1), "0.1");
+  EXPECT_EQ(fmt(-2.5), "-2.5");
+  EXPECT_EQ(fmt(3.0), "3");
+
+  std::mt19937_64 rng(42);
+  for (int i = 0; i < 100000; ++i)
+  {
+    std::uint64_t bits = rng();
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    if (!std::isfinite(v)) continue;
+    double back = 0.0;
+    ASSERT_TRUE(TextCodec::parse(fmt(v), back)) << fmt(v);
+    ASSERT_EQ(back, v) << fmt(v);
+  }
+
+  double d = 0.0;
+  EXPECT_FALSE(TextCodec::parse("", d));
+  EXPECT_FALSE(TextCodec::parse("1.5x", d));
+  EXPECT_TRUE(TextCodec::parse("+2", d));
+  EXPECT_EQ(d, 2.0);
+  EXPECT_FALSE(TextCodec::parse("+", d));
+  EXPECT_FALSE(TextCodec::parse("+-3", d));
+  EXPECT_FALSE(TextCodec::parse("++3", d));
+  int n = 0;
+  EXPECT_FALSE(TextCodec::parse("99999999999", n));
+  EXPECT_FALSE(TextCodec::parse("+-3", n));
+
+  // Out of range: overflow saturates, underflow goes to zero with its sign
+  ASSERT_TRUE(TextCodec::parse("1e400", d));
+  EXPECT_TRUE(std::isinf(d) && d > 0.0);
+  ASSERT_TRUE(TextCodec::parse("-1e400", d));
+  EXPECT_TRUE(std::isinf(d) && d < 0.0);
+  ASSERT_TRUE(TextCodec::parse("1e-400", d));
+  EXPECT_EQ(d, 0.0);
+  ASSERT_TRUE(TextCodec::parse("-1e-400", d));
+  EXPECT_EQ(d, 0.0);
+  EXPECT_TRUE(std::signbit(d));
+}
+
+TEST(TextCodec, ReadersSliceTheInput)
+{
+  const std::string blob = "a=1\r\n\nb\\=c=x\\\\y\\=z\\nw\nnoequals\n";
+  std::vector<std::string> keys, values;
+  std::string text;
+  TextCodec::forEachKeyValue(blob, [&](std::string_view k, std::string_view v) {
+    keys.emplace_back(k);
+    TextCodec::unescape(v, text);
+    values.push_back(text);
+  });
+  ASSERT_EQ(keys.size(), 2u);
+  EXPECT_EQ(keys[0], "a");
+  EXPECT_EQ(values[0], "1");
+  EXPECT_EQ(keys[1], "b\\=c");
+  EXPECT_EQ(values[1], "x\\y=z\nw");
+
+  std::string out;
+  TextCodec::Writer(out).escaped("x\\y=z\nw");
+  EXPECT_EQ(out, "x\\\\y\\=z\\nw");
+
+  TextCodec::TokenReader tokens("  L 1.5\t-2 \n 7");
+  char c = 0;
+  double x = 0.0, y = 0.0;
+  int i = 0;
+  EXPECT_TRUE(tokens.next(c) && tokens.next(x) && tokens.next(y) && tokens.next(i));
+  EXPECT_EQ(c, 'L');
+  EXPECT_EQ(x, 1.5);
+  EXPECT_EQ(y, -2.0);
+  EXPECT_EQ(i, 7);
+  EXPECT_FALSE(tokens.next(i));
+}
+
+TEST(TextCodec, LegacyBlobsStillLoad)
+{
+  // Written by the previous ostream based serializers (6 significant digits, ints as p_)
+  Handle(BoxFeature) box = new BoxFeature();
+  box->deserialize("name=Old\\=Box\nsuppressed=1\np_0=3\np_1=4.5\np_2=1e+06\n");
+  EXPECT_STREQ(box->name().ToCString(), "Old=Box");
+  EXPECT_TRUE(box->isSuppressed());
+  EXPECT_EQ(box->params().asDouble(Feature::ParamKey::Dx, 0.0), 3.0);
+  EXPECT_EQ(box->params().asDouble(Feature::ParamKey::Dy, 0.0), 4.5);
+  EXPECT_EQ(box->params().asDouble(Feature::ParamKey::Dz, 0.0), 1e6);
+
+  Handle(MoveFeature) mv = new MoveFeature();
+  mv->deserialize("name=Move\nsuppressed=0\nsourceId=17\nshare=0\n"
+                  "delta=1 0 0 0.10000000000000001 0 1 0 0 0 0 1 -2.5\n");
+  EXPECT_EQ(mv->sourceId(), 17u);
+  EXPECT_EQ(mv->deltaTrsf().Value(1, 4), 0.1);
+  EXPECT_EQ(mv->deltaTrsf().Value(3, 4), -2.5);
+
+  Sketch s;
+  s.deserialize("curves 2\nL 0 0 10 0\nA 5 5 10 5 0 5 0\nconstraints 1\nC 0 1 1 0\n");
+  ASSERT_EQ(s.curves().size(), 2u);
+  EXPECT_EQ(s.curves()[1].type, Sketch::CurveType::Arc);
+  EXPECT_EQ(s.constraints().size(), 1u);
+}
+
+TEST(TextCodec, SketchCoordinatesAndIntParamsRoundTripExactly)
+{
+  Sketch s;
+  s.addLine(gp_Pnt2d(0.1 + 1e-9, 1.0 / 3.0), gp_Pnt2d(12345.678901234, -7e-12));
+  Sketch s2;
+  s2.deserialize(s.serialize());
+  ASSERT_EQ(s2.curves().size(), 1u);
+  EXPECT_EQ(s2.curves()[0].line.p1.X(), 0.1 + 1e-9);
+  EXPECT_EQ(s2.curves()[0].line.p1.Y(), 1.0 / 3.0);
+  EXPECT_EQ(s2.curves()[0].line.p2.X(), 12345.678901234);
+  EXPECT_EQ(s2.curves()[0].line.p2.Y(), -7e-12);
+
+  Handle(BoxFeature) a = new BoxFeature();
+  a->params().set(Feature::ParamKey::Dx, 4);
+  a->params().set(Feature::ParamKey::Dy, 2.0 / 3.0);
+  Handle(BoxFeature) b = new BoxFeature();
+  b->deserialize(a->serialize());
+  EXPECT_TRUE(b->params().isInt(Feature::ParamKey::Dx));
+  EXPECT_EQ(b->params().asDouble(Feature::ParamKey::Dy, 0.0), 2.0 / 3.0);
+}
@@ -4,9 +4,9 @@
 
 namespace
 {
-bool containsAll(const std::vector<int>& a, const std::vector<int>& expect)
+bool containsAll(const std::vector<Sketch::CurveId>& a, const std::vector<Sketch::CurveId>& expect)
 {
-  for (int v : expect)
+  for (Sketch::CurveId v : expect)
   {
     if (std::find(a.begin(), a.end(), v) == a.end())
       return false;
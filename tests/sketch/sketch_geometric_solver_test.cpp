@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include "ConstraintSolver.h"
+#include "Sketch.h"
+
+#include <common/sketch_scenes.h>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+constexpr double kEps = 1e-8;
+
+double distanceToLine(const gp_Pnt2d& p, const gp_Pnt2d& a, const gp_Pnt2d& b)
+{
+  const double ux = b.X() - a.X(), uy = b.Y() - a.Y();
+  return std::abs(ux * (p.Y() - a.Y()) - uy * (p.X() - a.X())) / std::sqrt(ux * ux + uy * uy);
+}
+} // namespace
+
+TEST(SketchGeometricSolverTest, RectangleFromSloppySketch)
+{
+  Sketch s;
+  auto l0 = s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(3.7, 0.2));
+  auto l1 = s.addLine(gp_Pnt2d(3.9, 0.1), gp_Pnt2d(4.2, 2.3));
+  auto l2 = s.addLine(gp_Pnt2d(4.1, 2.2), gp_Pnt2d(-0.2, 1.8));
+  auto l3 = s.addLine(gp_Pnt2d(-0.1, 2.0), gp_Pnt2d(0.1, 0.1));
+  s.addCoincident({l0, 1}, {l1, 0});
+  s.addCoincident({l1, 1}, {l2, 0});
+  s.addCoincident({l2, 1}, {l3, 0});
+  s.addCoincident({l3, 1}, {l0, 0});
+  s.addFixed({l0, 0}); // pinned at (0, 0); the coincident weld moves it, the solve brings it back
+  s.addHorizontal(l0);
+  s.addHorizontal(l2);
+  s.addVertical(l1);
+  s.addVertical(l3);
+  s.addDistance({l0, 0}, {l0, 1}, 4.0);
+  s.addDistance({l1, 0}, {l1, 1}, 2.0);
+  s.solveConstraints();
+
+  const Sketch::SolveStats& st = s.lastSolveStats();
+  EXPECT_TRUE(st.converged);
+  EXPECT_EQ(st.equations, 8u);
+  EXPECT_LT(st.residual, 1e-9);
+  EXPECT_NEAR(s.endpoint({l0, 0}).X(), 0.0, kEps);
+  EXPECT_NEAR(s.endpoint({l0, 0}).Y(), 0.0, kEps);
+  EXPECT_NEAR(s.endpoint({l1, 0}).X(), 4.0, kEps);
+  EXPECT_NEAR(s.endpoint({l1, 0}).Y(), 0.0, kEps);
+  EXPECT_NEAR(s.endpoint({l2, 0}).X(), 4.0, kEps);
+  EXPECT_NEAR(s.endpoint({l2, 0}).Y(), 2.0, kEps);
+  EXPECT_NEAR(s.endpoint({l3, 0}).X(), 0.0, kEps);
+  EXPECT_NEAR(s.endpoint({l3, 0}).Y(), 2.0, kEps);
+  // Coincident endpoints share one solver point, so they stay welded exactly
+  EXPECT_EQ(s.endpoint({l3, 1}).X(), s.endpoint({l0, 0}).X());
+  EXPECT_EQ(s.computeWires().size(), 1u);
+
+  // Satisfied constraints cost no iteration on the next solve
+  s.solveConstraints();
+  EXPECT_EQ(s.lastSolveStats().iterations, 0u);
+}
+
+TEST(SketchGeometricSolverTest, AnglesAndFreeGeometry)
+{
+  Sketch s;
+  auto base  = s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(3, 1));
+  auto par   = s.addLine(gp_Pnt2d(0, 2), gp_Pnt2d(-2, 3)); // close to antiparallel: stays so
+  auto perp  = s.addLine(gp_Pnt2d(5, 0), gp_Pnt2d(5.5, 2));
+  auto other = s.addLine(gp_Pnt2d(10, 10), gp_Pnt2d(11, 12));
+  s.addFixed({base, 0});
+  s.addFixed({base, 1});
+  s.addParallel(par, base);
+  s.addPerpendicular(perp, base);
+  s.solveConstraints();
+  ASSERT_TRUE(s.lastSolveStats().converged);
+
+  auto dir = [&s](Sketch::CurveId id) {
+    const gp_Pnt2d a = s.endpoint({id, 0}), b = s.endpoint({id, 1});
+    const double   len = a.Distance(b);
+    return gp_Pnt2d((b.X() - a.X()) / len, (b.Y() - a.Y()) / len);
+  };
+  const gp_Pnt2d d0 = dir(base), d1 = dir(par), d2 = dir(perp);
+  EXPECT_NEAR(d0.X(), 3.0 / std::sqrt(10.0), kEps); // pinned at both ends
+  EXPECT_NEAR(d0.X() * d1.Y() - d0.Y() * d1.X(), 0.0, kEps);
+  EXPECT_LT(d0.X() * d1.X() + d0.Y() * d1.Y(), 0.0);
+  EXPECT_NEAR(d0.X() * d2.X() + d0.Y() * d2.Y(), 0.0, kEps);
+  // Unconstrained curves are not touched
+  EXPECT_EQ(s.endpoint({other, 1}).Y(), 12.0);
+}
+
+TEST(SketchGeometricSolverTest, TangentsAndRadius)
+{
+  Sketch s;
+  auto line = s.addLine(gp_Pnt2d(-3, 0.3), gp_Pnt2d(3, -0.2));
+  auto arc  = s.addArc(gp_Pnt2d(0, 1.4), gp_Pnt2d(1.2, 1.4), gp_Pnt2d(-1.0, 1.5), false);
+  auto ring = s.addArc(gp_Pnt2d(3.5, 1.2), gp_Pnt2d(4.3, 1.2), gp_Pnt2d(3.5, 2.0), false);
+  s.addFixed({line, 0});
+  s.addFixed({line, 1});
+  s.addRadius(arc, 1.0);
+  s.addTangent(line, arc);
+  s.addTangent(arc, ring); // outer contact: the circles are apart at the start
+  s.solveConstraints();
+  ASSERT_TRUE(s.lastSolveStats().converged);
+
+  const gp_Pnt2d c = s.arcCenter(arc);
+  EXPECT_NEAR(c.Distance(s.endpoint({arc, 0})), 1.0, kEps);
+  EXPECT_NEAR(c.Distance(s.endpoint({arc, 1})), 1.0, kEps); // both ends stay on the circle
+  EXPECT_NEAR(distanceToLine(c, s.endpoint({line, 0}), s.endpoint({line, 1})), 1.0, kEps);
+  const gp_Pnt2d c2 = s.arcCenter(ring);
+  const double   r2 = c2.Distance(s.endpoint({ring, 0}));
+  EXPECT_NEAR(c2.Distance(s.endpoint({ring, 1})), r2, kEps);
+  EXPECT_NEAR(c.Distance(c2), 1.0 + r2, kEps);
+}
+
+TEST(SketchGeometricSolverTest, ConstraintsSurviveSerialization)
+{
+  std::mt19937 rng(5);
+  Sketch s;
+  addConstrainedCell(s, 0.0, 0.0, 0.05, rng);
+  s.solveConstraints();
+  ASSERT_TRUE(s.lastSolveStats().converged);
+
+  Sketch copy;
+  copy.deserialize(s.serialize());
+  ASSERT_EQ(copy.constraints().size(), s.constraints().size());
+  for (std::size_t i = 0; i < s.constraints().size(); ++i)
+  {
+    EXPECT_EQ(copy.constraints()[i].type, s.constraints()[i].type) << i;
+    EXPECT_EQ(copy.constraints()[i].value, s.constraints()[i].value) << i;
+  }
+  copy.solveConstraints();
+  EXPECT_EQ(copy.lastSolveStats().equations, s.lastSolveStats().equations);
+  EXPECT_EQ(copy.lastSolveStats().iterations, 0u);
+  EXPECT_EQ(copy.serialize(), s.serialize());
+}
+
+TEST(SketchGeometricSolverTest, RejectsMismatchedCurves)
+{
+  Sketch s;
+  auto line = s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0));
+  auto arc  = s.addArc(gp_Pnt2d(0, 1), gp_Pnt2d(1, 1), gp_Pnt2d(0, 2), false);
+  EXPECT_THROW(s.addHorizontal(arc), std::invalid_argument);
+  EXPECT_THROW(s.addParallel(line, arc), std::invalid_argument);
+  EXPECT_THROW(s.addTangent(line, line), std::invalid_argument);
+  EXPECT_THROW(s.addRadius(line, 1.0), std::invalid_argument);
+  EXPECT_THROW(s.addRadius(arc, -1.0), std::invalid_argument);
+  EXPECT_THROW(s.addVertical(Sketch::CurveId(42)), std::out_of_range);
+  EXPECT_THROW(s.addCoincident({line, 1}, {Sketch::CurveId(42), 0}), std::out_of_range);
+  EXPECT_THROW(s.addCoincident({Sketch::CurveId(42), 0}, {line, 0}), std::out_of_range);
+  EXPECT_TRUE(s.constraints().empty());
+}
+
+TEST(SketchGeometricSolverTest, ConflictingConstraintsReportFailure)
+{
+  Sketch s;
+  auto l = s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0.1));
+  s.addHorizontal(l);
+  s.addVertical(l);
+  s.addDistance({l, 0}, {l, 1}, 1.0);
+  s.solveConstraints();
+  EXPECT_FALSE(s.lastSolveStats().converged);
+  EXPECT_GT(s.lastSolveStats().residual, 0.1);
+}
+
+TEST(SketchGeometricSolverTest, SolverFactorsLongChains)
+{
+  // One component of 2000 equations: x_{i+1} - x_i = 1 as distances along a horizontal chain
+  ConstraintSolver solver;
+  const int n = 1000;
+  std::vector<int> pts;
+  for (int i = 0; i <= n; ++i) pts.push_back(solver.addPoint(i * 0.9, std::sin(i * 0.1)));
+  solver.addEquation(ConstraintSolver::Equation::FixX, pts[0], -1, -1, -1, 0.0);
+  solver.addEquation(ConstraintSolver::Equation::FixY, pts[0], -1, -1, -1, 0.0);
+  for (int i = 0; i < n; ++i)
+  {
+    solver.addEquation(ConstraintSolver::Equation::EqualY, pts[i], pts[i + 1]);
+    solver.addEquation(ConstraintSolver::Equation::Distance, pts[i], pts[i + 1], -1, -1, 1.0);
+  }
+  ASSERT_TRUE(solver.solve());
+  EXPECT_EQ(solver.stats().components, 1u);
+  EXPECT_LT(solver.stats().iterations, 20u);
+  EXPECT_NEAR(solver.x(pts[n]), n, 1e-6);
+  EXPECT_NEAR(solver.y(pts[n]), 0.0, 1e-9);
+}
+
+TEST(SketchGeometricSolverTest, FiveThousandConstraintsConvergeInFewSteps)
+{
+  // Timings of the same scenes: tests/benchmarks
+  std::mt19937 rng(11);
+  Sketch cells;
+  for (int i = 0; i < 358; ++i) addConstrainedCell(cells, (i % 20) * 10.0, (i / 20) * 10.0, 0.05, rng);
+  Sketch stairs;
+  addStaircase(stairs, 2500, 0.05, rng);
+  ASSERT_EQ(cells.constraints().size(), 5012u);
+  ASSERT_EQ(stairs.constraints().size(), 5001u);
+
+  // Each damped Newton step is one factorization; the bounds are a few steps per component
+  cells.solveConstraints();
+  EXPECT_TRUE(cells.lastSolveStats().converged);
+  EXPECT_LT(cells.lastSolveStats().residual, 1e-9);
+  EXPECT_LE(cells.lastSolveStats().iterations, 358u * 8u);
+  stairs.solveConstraints();
+  EXPECT_TRUE(stairs.lastSolveStats().converged);
+  EXPECT_LT(stairs.lastSolveStats().residual, 1e-9);
+  EXPECT_LT(stairs.lastSolveStats().iterations, 20u);
+  EXPECT_NEAR(stairs.endpoint({stairs.curveId(2499), 1}).X(), 1250.0, 1e-6);
+  EXPECT_NEAR(stairs.endpoint({stairs.curveId(2499), 1}).Y(), 1250.0, 1e-6);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "Sketch.h"
+
+#include <random>
+
+namespace
+{
+void expectSameGeometry(const Sketch& a, const Sketch& b)
+{
+  ASSERT_EQ(a.curves().size(), b.curves().size());
+  for (std::size_t i = 0; i < a.curves().size(); ++i)
+  {
+    const auto& la = a.curves()[i].line;
+    const auto& lb = b.curves()[i].line;
+    EXPECT_NEAR(la.p1.X(), lb.p1.X(), 1e-12) << i;
+    EXPECT_NEAR(la.p1.Y(), lb.p1.Y(), 1e-12) << i;
+    EXPECT_NEAR(la.p2.X(), lb.p2.X(), 1e-12) << i;
+    EXPECT_NEAR(la.p2.Y(), lb.p2.Y(), 1e-12) << i;
+  }
+}
+} // namespace
+
+TEST(SketchIncrementalSolveTest, AddedCurvesWeldOnlyTouchedEndpoints)
+{
+  const double tol = 1e-6;
+  Sketch s;
+  s.addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(10.0, 0.0));
+  s.solveConstraints(tol);
+  EXPECT_FALSE(s.lastSolveStats().incremental);
+
+  // Polyline grown one segment at a time, each start slightly off the previous end
+  for (int i = 1; i < 50; ++i)
+  {
+    s.addLine(gp_Pnt2d(10.0 * i + 1e-7, 0.0), gp_Pnt2d(10.0 * (i + 1), 0.0));
+    s.solveConstraints(tol);
+    const Sketch::SolveStats st = s.lastSolveStats();
+    ASSERT_TRUE(st.incremental) << i;
+    EXPECT_EQ(st.queried, 2u);
+    EXPECT_EQ(st.clusters, 2u);
+  }
+  EXPECT_EQ(s.computeWires(tol).size(), 1u);
+  ASSERT_EQ(s.computeOrderedPaths(tol).size(), 1u);
+  EXPECT_EQ(s.computeOrderedPaths(tol)[0].size(), 50u);
+
+  // Same geometry solved in one full pass from the serialized input
+  Sketch full;
+  full.addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(10.0, 0.0));
+  for (int i = 1; i < 50; ++i) full.addLine(gp_Pnt2d(10.0 * i + 1e-7, 0.0), gp_Pnt2d(10.0 * (i + 1), 0.0));
+  full.solveConstraints(tol);
+  expectSameGeometry(s, full);
+}
+
+TEST(SketchIncrementalSolveTest, NewConstraintsAndFreeMovesStayIncremental)
+{
+  Sketch s;
+  auto a = s.addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(1.0, 0.0));
+  auto b = s.addLine(gp_Pnt2d(5.0, 5.0), gp_Pnt2d(6.0, 5.0));
+  s.solveConstraints();
+
+  s.addCoincident({a, 1}, {b, 0});
+  s.solveConstraints();
+  EXPECT_TRUE(s.lastSolveStats().incremental);
+  EXPECT_EQ(s.lastSolveStats().queried, 0u);
+  EXPECT_EQ(s.lastSolveStats().clusters, 1u);
+  EXPECT_DOUBLE_EQ(s.curves()[a].line.p2.X(), 3.0);
+  EXPECT_DOUBLE_EQ(s.curves()[b].line.p1.Y(), 2.5);
+
+  // A free endpoint moved onto another one is welded by the next solve
+  auto c = s.addLine(gp_Pnt2d(20.0, 0.0), gp_Pnt2d(21.0, 0.0));
+  s.solveConstraints();
+  s.moveEndpoint({c, 0}, gp_Pnt2d(6.0, 5.0));
+  s.solveConstraints();
+  EXPECT_TRUE(s.lastSolveStats().incremental);
+  EXPECT_EQ(s.lastSolveStats().queried, 1u);
+  EXPECT_EQ(s.computeWires().size(), 1u);
+}
+
+TEST(SketchIncrementalSolveTest, MovingWeldedEndpointFallsBackToFullSolve)
+{
+  const double tol = 1e-6;
+  Sketch s;
+  auto a = s.addLine(gp_Pnt2d(0.0, 0.0), gp_Pnt2d(1.0, 0.0));
+  auto b = s.addLine(gp_Pnt2d(1.0, 0.0), gp_Pnt2d(2.0, 0.0));
+  s.solveConstraints(tol);
+  ASSERT_EQ(s.computeWires(tol).size(), 1u);
+
+  // Pulling a welded endpoint away splits the wire: only a full solve can undo the weld
+  s.moveEndpoint({b, 0}, gp_Pnt2d(1.5, 1.0));
+  s.solveConstraints(tol);
+  EXPECT_FALSE(s.lastSolveStats().incremental);
+  EXPECT_EQ(s.computeWires(tol).size(), 2u);
+  EXPECT_DOUBLE_EQ(s.curves()[a].line.p2.X(), 1.0);
+  EXPECT_DOUBLE_EQ(s.curves()[b].line.p1.Y(), 1.0);
+
+  // A different tolerance re-indexes everything too
+  s.solveConstraints(tol * 2);
+  EXPECT_FALSE(s.lastSolveStats().incremental);
+  s.solveConstraints(tol * 2);
+  EXPECT_TRUE(s.lastSolveStats().incremental);
+}
+
+TEST(SketchIncrementalSolveTest, IncrementalEditIsIndependentOfSketchSize)
+{
+  Sketch s;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> dist(-10000.0, 10000.0);
+  for (int i = 0; i < 200000; ++i)
+  {
+    const double x = dist(rng), y = dist(rng);
+    s.addLine(gp_Pnt2d(x, y), gp_Pnt2d(x + 1.0, y + 0.5));
+  }
+  s.solveConstraints();
+  EXPECT_FALSE(s.lastSolveStats().incremental);
+  EXPECT_EQ(s.lastSolveStats().queried, 400000u);
+
+  // An edit costs a handful of grid lookups, not a pass over 400k endpoints
+  const auto last = static_cast<Sketch::CurveId>(s.curves().size() - 1);
+  const gp_Pnt2d end = s.curves()[last].line.p2;
+  for (int i = 0; i < 100; ++i)
+  {
+    s.addLine(end, gp_Pnt2d(end.X() + i + 1.0, end.Y()));
+    s.solveConstraints();
+    ASSERT_TRUE(s.lastSolveStats().incremental);
+    EXPECT_EQ(s.lastSolveStats().queried, 2u);
+    EXPECT_LE(s.lastSolveStats().clusters, 2u);
+  }
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "Sketch.h"
+
+#include <stdexcept>
+
+TEST(SketchSlotMapTest, RemovalKeepsOtherIdsStable)
+{
+  Sketch s;
+  auto a = s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0));
+  auto b = s.addArc(gp_Pnt2d(1, 1), gp_Pnt2d(1, 0), gp_Pnt2d(2, 1), false);
+  auto c = s.addLine(gp_Pnt2d(2, 1), gp_Pnt2d(2, 5));
+  EXPECT_EQ(a, 0);
+  EXPECT_EQ(c, 2);
+
+  ASSERT_TRUE(s.removeCurve(a));
+  EXPECT_FALSE(s.removeCurve(a));
+  EXPECT_FALSE(s.contains(a));
+  EXPECT_THROW(s.curve(a), std::out_of_range);
+  EXPECT_EQ(s.curveCount(), 2u);
+  // The last curve took the freed storage position; ids did not move
+  EXPECT_EQ(s.curveId(0), c);
+  EXPECT_DOUBLE_EQ(s.endpoint({c, 1}).Y(), 5.0);
+  EXPECT_DOUBLE_EQ(s.arcCenter(b).X(), 1.0);
+
+  // The freed slot is reused under a new generation: the stale id stays dead
+  auto d = s.addLine(gp_Pnt2d(7, 7), gp_Pnt2d(8, 8));
+  EXPECT_NE(d, a);
+  EXPECT_FALSE(s.contains(a));
+  EXPECT_DOUBLE_EQ(s.curve(d).line.p1.X(), 7.0);
+
+  // Arc storage stays consistent when an arc is removed
+  ASSERT_TRUE(s.removeCurve(b));
+  EXPECT_EQ(s.curveType(c), Sketch::CurveType::Line);
+  EXPECT_EQ(s.curveCount(), 2u);
+}
+
+TEST(SketchSlotMapTest, RestoreBringsBackIdAndConstraints)
+{
+  const double tol = 1e-9;
+  Sketch s;
+  auto a = s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0));
+  auto b = s.addLine(gp_Pnt2d(1, 0.5), gp_Pnt2d(2, 0));
+  s.addCoincident({a, 1}, {b, 0});
+  s.solveConstraints(tol);
+  ASSERT_EQ(s.computeWires(tol).size(), 1u);
+
+  const Sketch::Curve saved = s.curve(b);
+  ASSERT_TRUE(s.removeCurve(b));
+  s.solveConstraints(tol); // the constraint on b is skipped
+  EXPECT_FALSE(s.lastSolveStats().incremental);
+  EXPECT_EQ(s.computeWires(tol).size(), 1u);
+
+  // Another curve takes and releases the slot meanwhile
+  auto tmp = s.addLine(gp_Pnt2d(9, 9), gp_Pnt2d(10, 9));
+  ASSERT_TRUE(s.removeCurve(tmp));
+  EXPECT_FALSE(s.restoreCurve(a, saved)); // live id
+  ASSERT_TRUE(s.restoreCurve(b, saved));
+  EXPECT_TRUE(s.contains(b));
+  EXPECT_FALSE(s.contains(tmp));
+  s.solveConstraints(tol);
+  const auto wires = s.computeWires(tol);
+  ASSERT_EQ(wires.size(), 1u);
+  EXPECT_EQ(wires[0].curves.size(), 2u);
+  const auto paths = s.computeOrderedPaths(tol);
+  ASSERT_EQ(paths.size(), 1u);
+  EXPECT_EQ(paths[0].size(), 2u);
+}
+
+TEST(SketchSlotMapTest, IdsSurviveSerialization)
+{
+  Sketch s;
+  auto a = s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0));
+  auto b = s.addLine(gp_Pnt2d(1, 0), gp_Pnt2d(1, 1));
+  auto c = s.addArc(gp_Pnt2d(0, 1), gp_Pnt2d(1, 1), gp_Pnt2d(0, 2), false);
+  // Without removals the blob keeps its original layout
+  EXPECT_EQ(s.serialize().find("slots"), std::string::npos);
+
+  s.removeCurve(a);
+  auto d = s.addLine(gp_Pnt2d(5, 5), gp_Pnt2d(6, 6));
+  s.removeCurve(b);
+  s.addCoincident({c, 0}, {d, 0});
+
+  Sketch copy;
+  copy.deserialize(s.serialize());
+  EXPECT_EQ(copy.curveCount(), 2u);
+  EXPECT_FALSE(copy.contains(a));
+  EXPECT_FALSE(copy.contains(b));
+  ASSERT_TRUE(copy.contains(c));
+  ASSERT_TRUE(copy.contains(d));
+  EXPECT_DOUBLE_EQ(copy.arcCenter(c).Y(), 1.0);
+  EXPECT_DOUBLE_EQ(copy.endpoint({d, 1}).X(), 6.0);
+  EXPECT_EQ(copy.serialize(), s.serialize());
+  // Freed slots keep their generations: a new curve does not revive a stale id
+  auto e = copy.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(0, 1));
+  EXPECT_NE(e, a);
+  EXPECT_NE(e, b);
+}
+
+TEST(SketchSlotMapTest, RemovingHalfOfLargeSketchKeepsIds)
+{
+  Sketch s;
+  const int n = 200000;
+  std::vector<Sketch::CurveId> ids;
+  ids.reserve(n);
+  for (int i = 0; i < n; ++i) ids.push_back(s.addLine(gp_Pnt2d(i, 0.0), gp_Pnt2d(i, 1.0)));
+  for (int i = 0; i < n; i += 2) ASSERT_TRUE(s.removeCurve(ids[static_cast<std::size_t>(i)]));
+  ASSERT_EQ(s.curveCount(), static_cast<std::size_t>(n / 2));
+  for (int i = 1; i < n; i += 2)
+  {
+    ASSERT_DOUBLE_EQ(s.endpoint({ids[static_cast<std::size_t>(i)], 0}).X(), i);
+  }
+}
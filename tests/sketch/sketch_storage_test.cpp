@@ -2,6 +2,8 @@
 
 #include "Sketch.h"
 
+#include <stdexcept>
+
 TEST(SketchStorageTest, AddLinesAndArcs)
 {
   Sketch s;
@@ -28,3 +30,42 @@ TEST(SketchStorageTest, AddLinesAndArcs)
   EXPECT_DOUBLE_EQ(curves[2].arc.center.Y(), 5.0);
   EXPECT_TRUE(curves[2].arc.clockwise);
 }
+
+TEST(SketchStorageTest, StructOfArraysAccessors)
+{
+  Sketch s;
+  auto l0 = s.addLine(gp_Pnt2d(1, 2), gp_Pnt2d(3, 4));
+  auto a0 = s.addArc(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0), gp_Pnt2d(0, 1), false);
+
+  EXPECT_EQ(s.curveCount(), 2u);
+  EXPECT_EQ(s.curveType(l0), Sketch::CurveType::Line);
+  EXPECT_EQ(s.curveType(a0), Sketch::CurveType::Arc);
+  EXPECT_DOUBLE_EQ(s.endpoint({l0, 1}).Y(), 4.0);
+  EXPECT_DOUBLE_EQ(s.endpoint({a0, 0}).X(), 1.0);
+  EXPECT_DOUBLE_EQ(s.arcCenter(a0).X(), 0.0);
+  EXPECT_FALSE(s.arcClockwise(a0));
+  EXPECT_THROW(s.arcCenter(l0), std::out_of_range);
+  EXPECT_THROW(s.endpoint({5, 0}), std::out_of_range);
+
+  int visited = 0;
+  for (const Sketch::Curve& c : s.curves())
+  {
+    EXPECT_EQ(c.type, visited == 0 ? Sketch::CurveType::Line : Sketch::CurveType::Arc);
+    ++visited;
+  }
+  EXPECT_EQ(visited, 2);
+}
+
+TEST(SketchStorageTest, LineStorageStaysCompact)
+{
+  Sketch s;
+  const int n = 10000;
+  for (int i = 0; i < n; ++i) s.addLine(gp_Pnt2d(i, 0.0), gp_Pnt2d(i + 1.0, 0.0));
+  // A reloaded sketch is stored at its exact size
+  Sketch copy;
+  copy.deserialize(s.serialize());
+  ASSERT_EQ(copy.curveCount(), static_cast<std::size_t>(n));
+  const double perCurve = static_cast<double>(copy.curveMemoryBytes()) / n;
+  // Four coordinates, a tag and an arc slot, plus the id slot and its slot map entry
+  EXPECT_LE(perCurve, 4 * sizeof(double) + sizeof(Sketch::CurveType) + sizeof(int) + 4 * sizeof(std::uint32_t));
+}
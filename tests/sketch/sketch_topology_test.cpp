@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include "Sketch.h"
+
+#include <vector>
+
+namespace
+{
+// End point of a curve as walked by an ordered path
+gp_Pnt2d walkEnd(const Sketch& s, const Sketch::OrderedCurve& oc, bool atStart)
+{
+  const Sketch::Line& l = s.curves()[oc.id].line;
+  return (atStart != oc.reversed) ? l.p1 : l.p2;
+}
+
+// Every curve appears once and consecutive curves of a path share an endpoint
+void expectValidCover(const Sketch& s, const std::vector<Sketch::OrderedPath>& paths)
+{
+  std::vector<int> seen(s.curves().size(), 0);
+  for (const auto& path : paths)
+  {
+    for (std::size_t k = 0; k < path.size(); ++k)
+    {
+      ++seen[path[k].id];
+      if (k == 0) continue;
+      const gp_Pnt2d a = walkEnd(s, path[k - 1], false);
+      const gp_Pnt2d b = walkEnd(s, path[k], true);
+      EXPECT_DOUBLE_EQ(a.X(), b.X());
+      EXPECT_DOUBLE_EQ(a.Y(), b.Y());
+    }
+  }
+  for (int n : seen) EXPECT_EQ(n, 1);
+}
+} // namespace
+
+TEST(SketchTopologyTest, WiresAreOrderedByLowestCurve)
+{
+  Sketch s;
+  s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0));     // 0: square
+  s.addLine(gp_Pnt2d(100, 0), gp_Pnt2d(101, 0)); // 1: isolated
+  s.addLine(gp_Pnt2d(1, 1), gp_Pnt2d(1, 0));     // 2: square, reversed
+  s.addLine(gp_Pnt2d(1, 1), gp_Pnt2d(0, 1));     // 3: square
+  s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(0, 1));     // 4: square, reversed
+  s.solveConstraints();
+
+  const auto wires = s.computeWires();
+  ASSERT_EQ(wires.size(), 2u);
+  EXPECT_EQ(wires[0].curves, (std::vector<Sketch::CurveId>{0, 2, 3, 4}));
+  EXPECT_EQ(wires[1].curves, (std::vector<Sketch::CurveId>{1}));
+
+  // Closed loop: one path from the lowest curve's start, orientations follow the walk
+  const auto paths = s.computeOrderedPaths();
+  ASSERT_EQ(paths.size(), 2u);
+  ASSERT_EQ(paths[0].size(), 4u);
+  EXPECT_EQ(paths[0][0].id, 0);
+  EXPECT_FALSE(paths[0][0].reversed);
+  EXPECT_EQ(paths[0][1].id, 2);
+  EXPECT_TRUE(paths[0][1].reversed);
+  EXPECT_EQ(paths[0][2].id, 3);
+  EXPECT_FALSE(paths[0][2].reversed);
+  EXPECT_EQ(paths[0][3].id, 4);
+  EXPECT_TRUE(paths[0][3].reversed);
+  expectValidCover(s, paths);
+}
+
+TEST(SketchTopologyTest, BranchingComponentSplitsIntoMinimalPaths)
+{
+  Sketch s;
+  // Four spokes and an edge closing two tips: the centre has degree 4, tips (1,0) and (0,1)
+  // degree 2, tips (-1,0) and (0,-1) degree 1
+  s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0));
+  s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(0, 1));
+  s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(-1, 0));
+  s.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(0, -1));
+  s.addLine(gp_Pnt2d(1, 0), gp_Pnt2d(0, 1));
+  s.solveConstraints();
+  const auto paths = s.computeOrderedPaths();
+  ASSERT_EQ(paths.size(), 1u); // two odd clusters: a single open trail
+  expectValidCover(s, paths);
+
+  // Three spokes: four odd clusters, two paths
+  Sketch t;
+  t.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(1, 0));
+  t.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(0, 1));
+  t.addLine(gp_Pnt2d(0, 0), gp_Pnt2d(-1, 0));
+  t.solveConstraints();
+  const auto tPaths = t.computeOrderedPaths();
+  ASSERT_EQ(tPaths.size(), 2u);
+  expectValidCover(t, tPaths);
+  // Deterministic: the same input gives the same walk
+  const auto again = t.computeOrderedPaths();
+  ASSERT_EQ(again.size(), tPaths.size());
+  for (std::size_t i = 0; i < again.size(); ++i)
+  {
+    ASSERT_EQ(again[i].size(), tPaths[i].size());
+    for (std::size_t k = 0; k < again[i].size(); ++k)
+    {
+      EXPECT_EQ(again[i][k].id, tPaths[i][k].id);
+      EXPECT_EQ(again[i][k].reversed, tPaths[i][k].reversed);
+    }
+  }
+}
+
+TEST(SketchTopologyTest, LongOpenChainIsOnePath)
+{
+  // A long chain walks in one pass (timings: tests/benchmarks)
+  const int n = 10000;
+  Sketch s;
+  for (int i = 0; i < n; ++i) s.addLine(gp_Pnt2d(i, 0.0), gp_Pnt2d(i + 1, 0.0));
+  s.solveConstraints();
+
+  const auto wires = s.computeWires();
+  const auto paths = s.computeOrderedPaths();
+  ASSERT_EQ(wires.size(), 1u);
+  ASSERT_EQ(paths.size(), 1u);
+  ASSERT_EQ(paths[0].size(), static_cast<std::size_t>(n));
+  EXPECT_EQ(paths[0].front().id, 0);
+  EXPECT_EQ(paths[0].back().id, n - 1);
+  EXPECT_FALSE(paths[0][n / 2].reversed);
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "WeldKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using Pairs = std::vector<std::pair<int, int>>;
+
+Pairs kernelPairs(const std::vector<double>& xs, const std::vector<double>& ys, double tol)
+{
+  WeldKernel k;
+  k.build(xs.data(), ys.data(), xs.size(), tol);
+  Pairs out;
+  k.forEachPair(tol, [&out](int a, int b) { out.emplace_back(a, b); });
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+Pairs brutePairs(const std::vector<double>& xs, const std::vector<double>& ys, double tol)
+{
+  Pairs out;
+  for (std::size_t i = 0; i < xs.size(); ++i)
+    for (std::size_t j = i + 1; j < xs.size(); ++j)
+      if (std::abs(xs[i] - xs[j]) <= tol && std::abs(ys[i] - ys[j]) <= tol)
+        out.emplace_back(static_cast<int>(i), static_cast<int>(j));
+  return out;
+}
+} // namespace
+
+TEST(SketchWeldKernelTest, SnapIsFloorOnTheGrid)
+{
+  const std::vector<double> xs{-1.5, -1.0, -0.25, 0.0, 0.25, 0.999, 1.0, 7.5};
+  std::vector<double>       cx(xs.size()), cy(xs.size());
+  WeldKernel::snap(xs.data(), xs.data(), xs.size(), -2.0, -2.0, 0.5, cx.data(), cy.data());
+  for (std::size_t i = 0; i < xs.size(); ++i)
+  {
+    EXPECT_EQ(cx[i], std::floor((xs[i] + 2.0) / 0.5)) << xs[i];
+    EXPECT_EQ(cy[i], cx[i]);
+  }
+}
+
+TEST(SketchWeldKernelTest, PairsMatchBruteForce)
+{
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> pos(-50.0, 50.0);
+  std::uniform_real_distribution<double> jitter(-1e-3, 1e-3);
+  const double tol = 1e-3;
+  std::vector<double> xs, ys;
+  // Clusters of nearly coincident points plus cells straddling the grid lines
+  for (int c = 0; c < 300; ++c)
+  {
+    const double x = pos(rng), y = pos(rng);
+    for (int k = 0; k < 1 + c % 4; ++k)
+    {
+      xs.push_back(x + jitter(rng));
+      ys.push_back(y + jitter(rng));
+    }
+  }
+  xs.push_back(0.0);
+  ys.push_back(0.0);
+  xs.push_back(-tol * 0.5);
+  ys.push_back(tol * 0.5);
+  EXPECT_EQ(kernelPairs(xs, ys, tol), brutePairs(xs, ys, tol));
+
+  // A far outlier widens the cells; results stay exact
+  xs.push_back(1.0e9);
+  ys.push_back(-1.0e9);
+  EXPECT_EQ(kernelPairs(xs, ys, tol), brutePairs(xs, ys, tol));
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <Trace.h>
+#include <JsonString.h>
+#include <Document.h>
+#include <BoxFeature.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+std::size_t countOf(const std::string& s, const std::string& what)
+{
+  std::size_t n = 0;
+  for (std::size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + what.size())) ++n;
+  return n;
+}
+
+// Leaves recording off and the buffers empty for the next test
+struct TraceGuard
+{
+  TraceGuard()
+  {
+    Trace::clear();
+    Trace::setEnabled(true);
+  }
+  ~TraceGuard()
+  {
+    Trace::setEnabled(false);
+    Trace::clear();
+  }
+};
+} // namespace
+
+TEST(Trace, JsonStringsAreEscaped)
+{
+  std::string out;
+  Json::appendString(out, "a\"b\\c\nd\re\tf\x01g");
+  out += ',';
+  Json::appendString(out, "");
+  EXPECT_EQ(out, "\"a\\\"b\\\\c\\nd\\re\\tf\\u0001g\",\"\"");
+}
+
+#if CAD_ENABLE_TRACING
+
+TEST(Trace, DisabledRecordsNothing)
+{
+  Trace::clear();
+  ASSERT_FALSE(Trace::enabled());
+  {
+    CAD_TRACE_SCOPE("test", "ignored");
+  }
+  EXPECT_EQ(Trace::eventCount(), 0u);
+}
+
+TEST(Trace, NestedSpansBecomeCompleteEvents)
+{
+  TraceGuard guard;
+  Trace::setThreadName("trace test");
+  {
+    CAD_TRACE_SCOPE("test", "outer");
+    {
+      CAD_TRACE_SCOPE("test", "inner \"quoted\"");
+    }
+  }
+  EXPECT_EQ(Trace::eventCount(), 2u);
+  const std::string json = Trace::toChromeJson();
+  EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0u);
+  EXPECT_EQ(countOf(json, "\"ph\":\"X\""), 2u);
+  EXPECT_NE(json.find("\"name\":\"outer\",\"cat\":\"test\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"inner \\\"quoted\\\"\""), std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"name\":\"trace test\"}"), std::string::npos);
+  // The inner span ends first, so it is recorded first
+  EXPECT_LT(json.find("inner"), json.find("outer"));
+}
+
+TEST(Trace, RingBufferKeepsNewestEvents)
+{
+  const std::size_t capacity = Trace::bufferCapacity();
+  Trace::setBufferCapacity(8);
+  {
+    TraceGuard guard;
+    for (int i = 0; i < 20; ++i)
+    {
+      CAD_TRACE_SCOPE("test", "tick");
+    }
+    EXPECT_EQ(Trace::eventCount(), 8u);
+    EXPECT_EQ(Trace::droppedCount(), 12u);
+  }
+  Trace::setBufferCapacity(capacity);
+  Trace::clear();
+  EXPECT_EQ(Trace::droppedCount(), 0u);
+}
+
+TEST(Trace, ThreadsGetTheirOwnTracks)
+{
+  TraceGuard guard;
+  {
+    CAD_TRACE_SCOPE("test", "main");
+  }
+  std::thread worker([]() {
+    Trace::setThreadName("worker");
+    CAD_TRACE_SCOPE("test", "work");
+  });
+  worker.join();
+  // Events of exited threads stay exportable
+  EXPECT_EQ(Trace::eventCount(), 2u);
+  const std::string json = Trace::toChromeJson();
+  const std::size_t mainPos = json.find("\"name\":\"main\"");
+  const std::size_t workPos = json.find("\"name\":\"work\"");
+  ASSERT_NE(mainPos, std::string::npos);
+  ASSERT_NE(workPos, std::string::npos);
+  auto tidAt = [&json](std::size_t pos) {
+    const std::size_t t = json.find("\"tid\":", pos);
+    return json.substr(t, json.find('}', t) - t);
+  };
+  EXPECT_NE(tidAt(mainPos), tidAt(workPos));
+}
+
+TEST(Trace, ExitedThreadBuffersAreReusedOnlyAfterExport)
+{
+  TraceGuard guard;
+  {
+    CAD_TRACE_SCOPE("test", "main");
+  }
+  auto runThread = [](const char* name, const char* span) {
+    std::thread t([name, span]() {
+      if (name) Trace::setThreadName(name);
+      CAD_TRACE_SCOPE("test", span);
+    });
+    t.join();
+  };
+  auto tidOf = [](const std::string& json, const char* span) {
+    const std::size_t pos = json.find(std::string("\"name\":\"") + span + "\"");
+    if (pos == std::string::npos) return std::string();
+    const std::size_t t = json.find("\"tid\":", pos);
+    return json.substr(t, json.find('}', t) - t);
+  };
+
+  // Not exported yet: the second thread must not land on the first one's track
+  runThread("first thread", "first");
+  runThread(nullptr, "second");
+  EXPECT_EQ(Trace::eventCount(), 3u);
+  const std::string before = Trace::toChromeJson();
+  EXPECT_NE(tidOf(before, "first"), tidOf(before, "second"));
+  EXPECT_EQ(countOf(before, "first thread"), 1u);
+
+  // Exported: a new thread recycles the first buffer, with a fresh tid and no inherited name
+  runThread(nullptr, "third");
+  EXPECT_EQ(Trace::eventCount(), 3u);
+  const std::string after = Trace::toChromeJson();
+  EXPECT_EQ(after.find("\"name\":\"first\""), std::string::npos);
+  EXPECT_EQ(countOf(after, "first thread"), 0u);
+  const std::string third = tidOf(after, "third");
+  ASSERT_FALSE(third.empty());
+  EXPECT_NE(third, tidOf(before, "main"));
+  EXPECT_NE(third, tidOf(before, "first"));
+  EXPECT_NE(third, tidOf(before, "second"));
+}
+
+TEST(Trace, UnexportedExitedBuffersAreCapped)
+{
+  TraceGuard guard;
+  {
+    CAD_TRACE_SCOPE("test", "main");
+  }
+  // One short-lived thread per recompute task, never exported: 64 buffers wait, older ones recycle
+  for (int i = 0; i < 100; ++i)
+  {
+    std::thread t([]() { CAD_TRACE_SCOPE("test", "worker"); });
+    t.join();
+  }
+  EXPECT_EQ(Trace::eventCount(), 1u + 64u);
+  EXPECT_EQ(Trace::droppedCount(), 100u - 64u);
+}
+
+TEST(Trace, RecomputeEmitsModelFeatureAndKernelSpans)
+{
+  TraceGuard guard;
+  Document doc;
+  doc.addFeature(new BoxFeature(1.0, 2.0, 3.0));
+  doc.recompute();
+  const std::string json = Trace::toChromeJson();
+  EXPECT_NE(json.find("\"name\":\"Document::recompute\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"BoxFeature\",\"cat\":\"feature\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"KernelAPI::makeBox\",\"cat\":\"kernel\""), std::string::npos);
+
+  const std::string path = ::testing::TempDir() + "trace_test.json";
+  ASSERT_TRUE(Trace::writeChromeJson(path));
+  std::ifstream is(path, std::ios::binary);
+  std::stringstream ss;
+  ss << is.rdbuf();
+  EXPECT_EQ(ss.str(), json);
+  is.close();
+  std::remove(path.c_str());
+}
+
+#else
+
+TEST(Trace, CompiledOut)
+{
+  TraceGuard guard;
+  {
+    CAD_TRACE_SCOPE("test", "removed");
+  }
+  EXPECT_EQ(Trace::eventCount(), 0u);
+}
+
+#endif
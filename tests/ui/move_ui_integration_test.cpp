@@ -8,31 +8,9 @@
 #include <MoveFeature.h>
 #include <OcctQOpenGLWidgetViewer.h>
 
-#include <Bnd_Box.hxx>
-#include <BRepBndLib.hxx>
 #include <gp_Quaternion.hxx>
 #include <gp_EulerSequence.hxx>
-
-static gp_Pnt bboxCenter(const TopoDS_Shape& s)
-{
-  Bnd_Box bb; BRepBndLib::Add(s, bb);
-  Standard_Real xmin=0, ymin=0, zmin=0, xmax=0, ymax=0, zmax=0;
-  bb.Get(xmin, ymin, zmin, xmax, ymax, zmax);
-  return gp_Pnt(0.5*(xmin+xmax), 0.5*(ymin+ymax), 0.5*(zmin+zmax));
-}
-
-static gp_Trsf rotateAroundPointXYZ(const gp_Pnt& p, double rxDeg, double ryDeg, double rzDeg)
-{
-  const double rx = rxDeg * (M_PI / 180.0);
-  const double ry = ryDeg * (M_PI / 180.0);
-  const double rz = rzDeg * (M_PI / 180.0);
-  gp_Quaternion q; q.SetEulerAngles(gp_Intrinsic_XYZ, rx, ry, rz);
-  gp_Mat R = q.GetMatrix();
-  gp_XYZ px = p.XYZ();
-  gp_XYZ Rp = px; Rp.Multiply(R);
-  gp_Trsf tr; tr.SetTransformation(q, gp_Vec(px.X() - Rp.X(), px.Y() - Rp.Y(), px.Z() - Rp.Z()));
-  return tr;
-}
+#include <common/test_utils.h>
 
 TEST(UI_Move, ConfirmCombinedRotationAddsSingleMoveWithCorrectDelta)
 {